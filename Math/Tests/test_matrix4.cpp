@@ -1,3 +1,4 @@
+#include <cmath>
 #include <iostream>
 
 #include <QString>
@@ -284,6 +285,128 @@ namespace GLDemo
             QVERIFY(expResult == (m_matrix1 + m_matrix2));
         }
 
+
+        /**
+         * A translated, rotated and scaled matrix, as TRS, with the given scale along each
+         * axis.
+         */
+        static Matrix4f makeAffine(const Vector3f& scale, Matrix3f& rotation)
+        {
+            rotation.fromAxisAngle(0.8f, Vector3f(1.0f, 2.0f, 2.0f) / 3.0f);
+            Matrix4f m;
+            m.toIdentity();
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    m(i,j) = rotation(i,j) * scale[j];
+                }
+            }
+            m(0,3) = 1.0f;
+            m(1,3) = -2.0f;
+            m(2,3) = 3.0f;
+            return m;
+        }
+
+
+        static bool near(const Matrix3f& a, const Matrix3f& b)
+        {
+            for (int i = 0; i < 9; ++i)
+            {
+                if (std::fabs(a[i] - b[i]) > 1.0e-4f)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+
+        /**
+         * Scales differing by orders of magnitude still converge on the rotation.
+         */
+        void  testPolarDecomposition()
+        {
+            Matrix3f expectedRotation;
+            Matrix4f m = makeAffine(Vector3f(1000.0f, 1000.0f, 1000.0f), expectedRotation);
+
+            Matrix3f scale;
+            Matrix3f rotation;
+            Vector3f translation;
+            m.polarDecomposition(scale, rotation, translation);
+            QVERIFY(near(rotation, expectedRotation));
+            QVERIFY(std::fabs(scale(0,0) - 1000.0f) < 0.1f);
+            QVERIFY(std::fabs(scale(0,1)) < 0.1f);
+            QVERIFY(translation == Vector3f(1.0f, -2.0f, 3.0f));
+
+            // A reflection ends up in the scale, not the rotation.
+            m = makeAffine(Vector3f(-0.001f, -0.001f, -0.001f), expectedRotation);
+            m.polarDecomposition(scale, rotation, translation);
+            QVERIFY(near(rotation, expectedRotation));
+            QVERIFY(std::fabs(scale(1,1) + 0.001f) < 1.0e-6f);
+        }
+
+
+        /**
+         *
+         */
+        void  testAffineDecomposition()
+        {
+            Matrix3f expectedRotation;
+            Matrix4f m = makeAffine(Vector3f(2.0f, 0.5f, 7.0f), expectedRotation);
+
+            Vector3f scale;
+            Matrix3f rotation;
+            Vector3f shear;
+            Vector3f translation;
+            QVERIFY(m.affineDecomposition(scale, rotation, shear, translation));
+            QVERIFY((scale - Vector3f(2.0f, 0.5f, 7.0f)).length() < 1.0e-4f);
+            QVERIFY(near(rotation, expectedRotation));
+            QVERIFY(translation == Vector3f(1.0f, -2.0f, 3.0f));
+
+            // Reflections become negative scales, leaving a proper rotation.
+            m = makeAffine(Vector3f(2.0f, 0.5f, -7.0f), expectedRotation);
+            QVERIFY(m.affineDecomposition(scale, rotation, shear, translation));
+            QVERIFY(rotation.determinant() > 0.0f);
+            Matrix4f rebuilt;
+            rebuilt.toIdentity();
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    rebuilt(i,j) = rotation(i,j) * scale[j];
+                }
+                rebuilt(i,3) = translation[i];
+            }
+            QVERIFY(rebuilt == m);
+
+            // Shear is found, and rebuilds the matrix along with the rest.
+            Matrix4f sheared;
+            sheared.toIdentity();
+            sheared(0,1) = 0.5f;
+            sheared(1,2) = -0.25f;
+            m = m * sheared;
+            QVERIFY(!m.affineDecomposition(scale, rotation, shear, translation));
+            Matrix3f shearMatrix;
+            shearMatrix.toIdentity();
+            shearMatrix(0,1) = shear[0];
+            shearMatrix(0,2) = shear[1];
+            shearMatrix(1,2) = shear[2];
+            Matrix3f scaleMatrix;
+            for (int i = 0; i < 3; ++i)
+            {
+                scaleMatrix(i,i) = scale[i];
+            }
+            Matrix3f upper = rotation * shearMatrix * scaleMatrix;
+            for (int i = 0; i < 3; ++i)
+            {
+                for (int j = 0; j < 3; ++j)
+                {
+                    QVERIFY(std::fabs(upper(i,j) - m(i,j)) < 1.0e-4f);
+                }
+            }
+        }
+
     };
 }
 
@@ -0,0 +1,162 @@
+#include <cmath>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Math/mathdefs.h"
+#include "Math/matrix3.h"
+#include "Math/quaternion.h"
+#include "Math/vector3.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestQuaternion : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        static bool near(const Vector3f& a, const Vector3f& b)
+        {
+            return (a - b).length() < 1.0e-5f;
+        }
+
+        static bool near(const Matrix3f& a, const Matrix3f& b)
+        {
+            for (int i = 0; i < 9; ++i)
+            {
+                if (std::fabs(a[i] - b[i]) > 1.0e-5f)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * Same rotation; q and -q both count.
+         */
+        static bool sameRotation(const Quaternionf& a, const Quaternionf& b)
+        {
+            return std::fabs(std::fabs(a.dot(b)) - 1.0f) < 1.0e-5f;
+        }
+
+    private slots:
+        /**
+         *
+         */
+        void testDefaultConstructor()
+        {
+            Quaternionf q;
+            QVERIFY(q == Quaternionf(1.0f, 0.0f, 0.0f, 0.0f));
+            QVERIFY(near(q.rotate(Vector3f(1.0f, 2.0f, 3.0f)), Vector3f(1.0f, 2.0f, 3.0f)));
+        }
+
+
+        /**
+         * Rotating by a quaternion matches rotating by the matrix for the same axis and
+         * angle, and converting either way gives the other.
+         */
+        void testMatrixConversion()
+        {
+            // Includes angles past pi, whose matrices have negative traces.
+            const float angles[] = { 0.3f, 1.5f, 3.0f, 3.1f, 4.5f };
+            const Vector3f axes[] = { Vector3f(1.0f, 0.0f, 0.0f), Vector3f(0.0f, 1.0f, 0.0f),
+                                      Vector3f(0.0f, 0.0f, 1.0f), Vector3f(1.0f, -2.0f, 3.0f).unitVector() };
+            const Vector3f v(0.5f, -1.0f, 2.0f);
+            for (int a = 0; a < 5; ++a)
+            {
+                for (int x = 0; x < 4; ++x)
+                {
+                    Matrix3f m;
+                    m.fromAxisAngle(angles[a], axes[x]);
+                    Quaternionf q;
+                    q.fromAxisAngle(angles[a], axes[x]);
+                    QVERIFY(near(q.rotate(v), m * v));
+
+                    Matrix3f fromQ;
+                    q.toRotationMatrix(fromQ);
+                    QVERIFY(near(fromQ, m));
+                    QVERIFY(sameRotation(Quaternionf(m), q));
+                }
+            }
+        }
+
+
+        /**
+         * Quaternions compose in the same order as matrices do.
+         */
+        void testMultiply()
+        {
+            Matrix3f ma;
+            Matrix3f mb;
+            ma.fromAxisAngle(0.7f, Vector3f(0.0f, 0.0f, 1.0f));
+            mb.fromAxisAngle(1.2f, Vector3f(1.0f, 1.0f, 0.0f).unitVector());
+            Quaternionf a(ma);
+            Quaternionf b(mb);
+
+            const Vector3f v(1.0f, 2.0f, 3.0f);
+            QVERIFY(near((a * b).rotate(v), ma * (mb * v)));
+            QVERIFY(near((a * b).rotate(v), a.rotate(b.rotate(v))));
+            QVERIFY(sameRotation(a * a.conjugate(), Quaternionf()));
+            QVERIFY(sameRotation((a * 2.0f).inverse() * 2.0f, a.conjugate()));
+        }
+
+
+        /**
+         *
+         */
+        void testAxisAngle()
+        {
+            Quaternionf q;
+            q.fromAxisAngle(2.0f, Vector3f(0.0f, 1.0f, 0.0f));
+            float angle = 0.0f;
+            Vector3f axis;
+            q.toAxisAngle(angle, axis);
+            QVERIFY(std::fabs(angle - 2.0f) < 1.0e-5f);
+            QVERIFY(near(axis, Vector3f(0.0f, 1.0f, 0.0f)));
+        }
+
+
+        /**
+         * Interpolation runs along the shortest arc, at a constant speed for slerp.
+         */
+        void testInterpolation()
+        {
+            const Vector3f axis(0.0f, 0.0f, 1.0f);
+            Quaternionf a;
+            Quaternionf b;
+            a.fromAxisAngle(0.2f, axis);
+            b.fromAxisAngle(1.4f, axis);
+
+            for (int i = 0; i <= 4; ++i)
+            {
+                float t = i / 4.0f;
+                Quaternionf expected;
+                expected.fromAxisAngle(0.2f + 1.2f * t, axis);
+                QVERIFY(sameRotation(Quaternionf::slerp(a, b, t), expected));
+
+                // Same path, though not the same speed.
+                Quaternionf n = Quaternionf::nlerp(a, b, t);
+                QVERIFY(std::fabs(n.length() - 1.0f) < 1.0e-5f);
+                QVERIFY(std::fabs(n.x()) < 1.0e-5f && std::fabs(n.y()) < 1.0e-5f);
+            }
+
+            // Taking -b, the same rotation, must not send it the long way round.
+            QVERIFY(sameRotation(Quaternionf::slerp(a, -b, 0.5f), Quaternionf::slerp(a, b, 0.5f)));
+            QVERIFY(sameRotation(Quaternionf::nlerp(a, -b, 0.5f), Quaternionf::nlerp(a, b, 0.5f)));
+
+            // Nearly identical rotations don't divide by zero.
+            QVERIFY(sameRotation(Quaternionf::slerp(a, a, 0.5f), a));
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestQuaternion)
+#include "test_quaternion.moc"
@@ -0,0 +1,119 @@
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Math/matrix3.h"
+#include "Math/matrix4.h"
+#include "Math/vector3.h"
+#include "Math/vector4.h"
+
+
+namespace GLDemo
+{
+
+    // Copies of vectors and matrices, and of arrays of them, are plain memory copies.
+    static_assert(std::is_trivially_copyable<Vector3f>::value, "Vector3f is not trivially copyable");
+    static_assert(std::is_trivially_copyable<Vector4d>::value, "Vector4d is not trivially copyable");
+    static_assert(std::is_trivially_copyable<Matrix3f>::value, "Matrix3f is not trivially copyable");
+    static_assert(std::is_trivially_copyable<Matrix4f>::value, "Matrix4f is not trivially copyable");
+
+    // Arithmetic on constants is done by the compiler.
+    constexpr Vector3f s_a(1.0f, 2.0f, 3.0f);
+    constexpr Vector3f s_b(4.0f, 5.0f, 6.0f);
+    static_assert((s_a + s_b * 2.0f).z() == 15.0f, "constexpr vector arithmetic");
+    static_assert(s_a.dot(s_b) == 32.0f, "constexpr dot product");
+    static_assert(s_a.cross(s_b).x() == -3.0f, "constexpr cross product");
+    static_assert(Matrix4f::createIdentity().trace() == 4.0f, "constexpr identity");
+    static_assert((Matrix3f::createIdentity() * 2.0f * Matrix3f::createIdentity())(1,1) == 2.0f,
+                  "constexpr matrix arithmetic");
+
+
+    /**
+     * \internal
+     */
+    class TestVector3 : public QObject
+    {
+        Q_OBJECT
+
+    private slots:
+        /**
+         * Default construction and the factories still give zero and identity.
+         */
+        void testConstruction()
+        {
+            Vector3f v;
+            QCOMPARE(v, Vector3f(0.0f, 0.0f, 0.0f));
+            QCOMPARE(Vector3f::zero(), Vector3f(0.0f, 0.0f, 0.0f));
+
+            Matrix4f zero;
+            Matrix4f identity = Matrix4f::createIdentity();
+            for (int row = 0; row < 4; ++row)
+            {
+                for (int col = 0; col < 4; ++col)
+                {
+                    QCOMPARE(zero(row, col), 0.0f);
+                    QCOMPARE(identity(row, col), row == col ? 1.0f : 0.0f);
+                }
+            }
+            QVERIFY(Matrix4f::zero() == zero);
+
+            // Components left uninitialised can still be written as normal.
+            Vector3f u(Uninitialized);
+            u.x() = 1.0f;
+            u.y() = 2.0f;
+            u.z() = 3.0f;
+            QCOMPARE(u, s_a);
+        }
+
+
+        /**
+         *
+         */
+        void testArithmetic()
+        {
+            Vector3f a(s_a);
+            Vector3f b(s_b);
+            QCOMPARE(a + b, Vector3f(5.0f, 7.0f, 9.0f));
+            QCOMPARE(b - a, Vector3f(3.0f, 3.0f, 3.0f));
+            QCOMPARE(-a, Vector3f(-1.0f, -2.0f, -3.0f));
+            QCOMPARE(2.0f * a, Vector3f(2.0f, 4.0f, 6.0f));
+            QCOMPARE(b / 2.0f, Vector3f(2.0f, 2.5f, 3.0f));
+
+            a += b;
+            QCOMPARE(a, Vector3f(5.0f, 7.0f, 9.0f));
+            a -= b;
+            a *= 3.0f;
+            QCOMPARE(a, Vector3f(3.0f, 6.0f, 9.0f));
+            a /= 3.0f;
+            QCOMPARE(a, s_a);
+        }
+
+
+        /**
+         * Copying an array of vectors as raw memory gives the same vectors.
+         */
+        void testMemoryCopy()
+        {
+            std::vector<Vector3f> source;
+            for (int i = 0; i < 10; ++i)
+            {
+                source.push_back(Vector3f(float(i), float(i * 2), float(i * 3)));
+            }
+
+            std::vector<Vector3f> copy(source.size());
+            std::memcpy(&copy[0], &source[0], sizeof(Vector3f) * source.size());
+            for (int i = 0; i < 10; ++i)
+            {
+                QCOMPARE(copy[i], source[i]);
+            }
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestVector3)
+#include "test_vector3.moc"
@@ -0,0 +1,238 @@
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Math/mathdefs.h"
+#include "Math/matrix3.h"
+#include "Math/matrix4.h"
+#include "Math/vector3soa.h"
+#include "Math/vector4.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestVector3SoA : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        /**
+         * \internal A position interleaved with other data, as in a vertex.
+         */
+        struct Interleaved
+        {
+            float    m_before;
+            Vector3f m_position;
+            float    m_after;
+        };
+
+        static float random(float minimum, float maximum)
+        {
+            return minimum + (maximum - minimum) * std::rand() / RAND_MAX;
+        }
+
+        static Vector3f randomVector()
+        {
+            return Vector3f(random(-10.0f, 10.0f), random(-10.0f, 10.0f), random(-10.0f, 10.0f));
+        }
+
+        static bool near(float a, float b)
+        {
+            return std::fabs(a - b) <= 1.0e-4f * std::max(1.0f, std::max(std::fabs(a), std::fabs(b)));
+        }
+
+        static bool near(const Vector3f& a, const Vector3f& b)
+        {
+            return near(a.x(), b.x()) && near(a.y(), b.y()) && near(a.z(), b.z());
+        }
+
+        static Matrix4f randomMatrix()
+        {
+            float data[16];
+            for (int i = 0; i < 16; ++i)
+            {
+                data[i] = random(-2.0f, 2.0f);
+            }
+            return Matrix4f(data);
+        }
+
+    private slots:
+        /**
+         * Sizes either side of a multiple of four, so that both the SIMD groups and the
+         * leftovers are checked.
+         */
+        void testTransformPoints()
+        {
+            const int counts[] = { 0, 3, 4, 37 };
+            for (int c = 0; c < 4; ++c)
+            {
+                const int count = counts[c];
+                std::srand(count + 1);
+
+                Vector3SoA points;
+                for (int i = 0; i < count; ++i)
+                {
+                    points.push_back(randomVector());
+                }
+                QCOMPARE(points.size(), count);
+
+                Matrix4f m = randomMatrix();
+                Vector3SoA out;
+                std::vector<float> w;
+                points.transformPoints(m, out, w);
+                QCOMPARE(out.size(), count);
+                QCOMPARE(static_cast<int>(w.size()), count);
+                for (int i = 0; i < count; ++i)
+                {
+                    Vector3f p = points.get(i);
+                    Vector4f expected = m * Vector4f(p.x(), p.y(), p.z(), 1.0f);
+                    QVERIFY(near(out.get(i), Vector3f(expected.x(), expected.y(), expected.z())));
+                    QVERIFY(near(w[i], expected.w()));
+                }
+
+                // Transforming in place gives the same result.
+                Vector3SoA copy(points);
+                copy.transformPoints(m, copy);
+                for (int i = 0; i < count; ++i)
+                {
+                    QVERIFY(near(copy.get(i), out.get(i)));
+                }
+            }
+        }
+
+
+        /**
+         *
+         */
+        void testTransformVectors()
+        {
+            std::srand(5);
+            Vector3SoA vectors;
+            for (int i = 0; i < 23; ++i)
+            {
+                vectors.push_back(randomVector());
+            }
+
+            Matrix3f m;
+            for (int i = 0; i < 9; ++i)
+            {
+                m[i] = random(-2.0f, 2.0f);
+            }
+
+            Vector3SoA out;
+            vectors.transformVectors(m, out);
+            for (int i = 0; i < vectors.size(); ++i)
+            {
+                QVERIFY(near(out.get(i), m * vectors.get(i)));
+            }
+        }
+
+
+        /**
+         * Vectors become unit length, apart from zero ones, in and out of SIMD groups.
+         */
+        void testNormalize()
+        {
+            std::srand(7);
+            Vector3SoA vectors;
+            for (int i = 0; i < 11; ++i)
+            {
+                vectors.push_back(randomVector());
+            }
+            vectors.set(2, Vector3f(0.0f, 0.0f, 0.0f));
+            vectors.set(9, Vector3f(0.0f, 0.0f, 0.0f));
+
+            Vector3SoA original(vectors);
+            vectors.normalize();
+            for (int i = 0; i < vectors.size(); ++i)
+            {
+                if (i == 2 || i == 9)
+                {
+                    QCOMPARE(vectors.get(i).length(), 0.0f);
+                    continue;
+                }
+                QVERIFY(near(vectors.get(i), original.get(i).unitVector()));
+            }
+        }
+
+
+        /**
+         *
+         */
+        void testComputeBound()
+        {
+            Vector3f minimum(1.0f, 2.0f, 3.0f);
+            Vector3f maximum(minimum);
+            Vector3SoA points;
+            QVERIFY(!points.computeBound(minimum, maximum));
+            QVERIFY(near(minimum, Vector3f(1.0f, 2.0f, 3.0f)));
+
+            std::srand(9);
+            const float huge = std::numeric_limits<float>::max();
+            Vector3f expectedMinimum(huge, huge, huge);
+            Vector3f expectedMaximum(-huge, -huge, -huge);
+            for (int count = 1; count <= 9; ++count)
+            {
+                Vector3f p = randomVector();
+                points.push_back(p);
+                for (int axis = 0; axis < 3; ++axis)
+                {
+                    expectedMinimum[axis] = std::min(expectedMinimum[axis], p[axis]);
+                    expectedMaximum[axis] = std::max(expectedMaximum[axis], p[axis]);
+                }
+
+                QVERIFY(points.computeBound(minimum, maximum));
+                QCOMPARE(minimum, expectedMinimum);
+                QCOMPARE(maximum, expectedMaximum);
+            }
+        }
+
+
+        /**
+         * Vectors interleaved with other data are copied in and out without touching it.
+         */
+        void testGatherScatter()
+        {
+            std::srand(11);
+            Interleaved items[6];
+            for (int i = 0; i < 6; ++i)
+            {
+                items[i].m_before = static_cast<float>(i);
+                items[i].m_position = randomVector();
+                items[i].m_after = static_cast<float>(-i);
+            }
+
+            Vector3SoA points;
+            points.gather(&items[0].m_position, 6, sizeof(Interleaved));
+            QCOMPARE(points.size(), 6);
+            for (int i = 0; i < 6; ++i)
+            {
+                QCOMPARE(points.get(i), items[i].m_position);
+            }
+
+            Matrix4f scale;
+            scale.toIdentity();
+            scale(0,0) = 2.0f;
+            points.transformPoints(scale, points);
+            points.scatter(&items[0].m_position, sizeof(Interleaved));
+            for (int i = 0; i < 6; ++i)
+            {
+                QCOMPARE(items[i].m_position, points.get(i));
+                QCOMPARE(items[i].m_before, static_cast<float>(i));
+                QCOMPARE(items[i].m_after, static_cast<float>(-i));
+            }
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestVector3SoA)
+#include "test_vector3soa.moc"
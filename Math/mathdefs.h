@@ -8,6 +8,14 @@
 namespace GLDemo
 {
 
+    /**
+     * Passed to a vector or matrix constructor to leave its components uninitialised,
+     * for when every one of them is about to be written anyway. Default construction
+     * still gives zero.
+     */
+    enum UninitializedTag { Uninitialized };
+
+
     /**
      * \brief General purpose Math class designed to provide general purpose math
      *        functions so that we can swap between single / double precision if necessary.
@@ -16,9 +16,9 @@ namespace GLDemo
         typedef MatrixN<Matrix2<Real>, Real, 2> MatrixBase;
 
     public:
-        Matrix2();
-        Matrix2(const Real m[], bool transposeM);
-        Matrix2(const Matrix2&);
+        constexpr Matrix2();
+        explicit Matrix2(UninitializedTag) : MatrixBase(Uninitialized) {}
+        constexpr Matrix2(const Real m[], bool transposeM);
 
         //Algebraic operations specific to 2D
         using MatrixN<Matrix2<Real>, Real, 2>::operator*;
@@ -42,7 +42,7 @@ namespace GLDemo
      * Initialises a new 2x2 matrix as a zero matrix.
      */
     template<class Real>
-    Matrix2<Real>::Matrix2() :
+    constexpr Matrix2<Real>::Matrix2() :
         MatrixBase()
     {
     }
@@ -53,22 +53,12 @@ namespace GLDemo
      * the transpose of the original matrix.
      */
     template<class Real>
-    Matrix2<Real>::Matrix2(const Real m[], bool transposeM) :
+    constexpr Matrix2<Real>::Matrix2(const Real m[], bool transposeM) :
         MatrixBase(m, transposeM)
     {
     }
 
 
-    /**
-     *
-     */
-    template<class Real>
-    Matrix2<Real>::Matrix2(const Matrix2<Real>& m) :
-        MatrixBase(m)
-    {
-    }
-
-
     /**
      * Pre-multiplies a vector with this matrix. The vector is treated as a column
      * vector.
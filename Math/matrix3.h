@@ -18,9 +18,9 @@ namespace GLDemo
         typedef MatrixN<Matrix3<Real>, Real, 3> MatrixBase;
 
     public:
-        Matrix3();
-        Matrix3(const Real m[], bool transposeM = false);
-        Matrix3(const Matrix3&);
+        constexpr Matrix3();
+        explicit Matrix3(UninitializedTag) : MatrixBase(Uninitialized) {}
+        constexpr Matrix3(const Real m[], bool transposeM = false);
 
         //Algebraic operations specific to 3D
         using MatrixN<Matrix3<Real>, Real, 3>::operator*;
@@ -45,10 +45,10 @@ namespace GLDemo
 
 
     /**
-     * Initialises a new 3x3 matrix as the identity matrix.
+     * Initialises a new 3x3 matrix as the zero matrix.
      */
     template<class Real>
-    Matrix3<Real>::Matrix3() :
+    constexpr Matrix3<Real>::Matrix3() :
         MatrixBase()
     {
     }
@@ -59,22 +59,12 @@ namespace GLDemo
      * the transpose of the original matrix.
      */
     template<class Real>
-    Matrix3<Real>::Matrix3(const Real m[], bool transposeM) :
+    constexpr Matrix3<Real>::Matrix3(const Real m[], bool transposeM) :
         MatrixBase(m, transposeM)
     {
     }
 
 
-    /**
-     *
-     */
-    template<class Real>
-    Matrix3<Real>::Matrix3(const Matrix3<Real>& m) :
-        MatrixBase(m)
-    {
-    }
-
-
     /**
      *
      */
@@ -20,9 +20,9 @@ namespace GLDemo
         typedef MatrixN<Matrix4<Real>, Real, 4> MatrixBase;
 
     public:
-        Matrix4();
-        Matrix4(const Real m[], bool transposeM = false);
-        Matrix4(const Matrix4&);
+        constexpr Matrix4();
+        explicit Matrix4(UninitializedTag) : MatrixBase(Uninitialized) {}
+        constexpr Matrix4(const Real m[], bool transposeM = false);
 
         //Algebraic operations specific to 4D
         using MatrixN<Matrix4<Real>, Real, 4>::operator*;
@@ -40,8 +40,13 @@ namespace GLDemo
         void makeReflection(const Vector3<Real>& axis);
 
         void polarDecomposition(Matrix3<Real>& scale, Matrix3<Real>& rotation, Vector3<Real>& translation) const;
+        bool affineDecomposition(Vector3<Real>& scale, Matrix3<Real>& rotation, Vector3<Real>& shear,
+                                 Vector3<Real>& translation) const;
 
     private:
+        // Scaled Newton iteration converges well within this for any invertible matrix.
+        static const int s_maxPolarIterations = 20;
+
         Real cofactor(int i, int j) const;
     };
 
@@ -50,10 +55,10 @@ namespace GLDemo
 
 
     /**
-     * Initialises a new 4x4 matrix as the identity matrix.
+     * Initialises a new 4x4 matrix as the zero matrix.
      */
     template<class Real>
-    Matrix4<Real>::Matrix4() :
+    constexpr Matrix4<Real>::Matrix4() :
         MatrixBase()
     {
     }
@@ -64,22 +69,12 @@ namespace GLDemo
      * the transpose of the original matrix.
      */
     template<class Real>
-    Matrix4<Real>::Matrix4(const Real m[], bool transposeM) :
+    constexpr Matrix4<Real>::Matrix4(const Real m[], bool transposeM) :
         MatrixBase(m, transposeM)
     {
     }
 
 
-    /**
-     *
-     */
-    template<class Real>
-    Matrix4<Real>::Matrix4(const Matrix4<Real>& m) :
-        MatrixBase(m)
-    {
-    }
-
-
     /**
      * Pre-multiplies the specified vector with this matrix. The matrix is
      * assumed to be a column-vector, not a row-vector.
@@ -258,8 +253,11 @@ namespace GLDemo
      * \param translation Matrix in which to store the computed translation
      *
      * Uses polar decomposition to deduce the various components of this matrix, assuming
-     * that it is a 4x4 affine transformation. This function is expensive, so it is
-     * recommended to store and maintain the original components wherever possible.
+     * that it is a 4x4 affine transformation, such that the upper 3x3 is rotation * scale,
+     * with scale symmetric. The rotation is found by Newton iteration, scaled so that it
+     * converges in a handful of steps whatever the scale, and never runs for more than
+     * s_maxPolarIterations. Where the matrix is known not to be sheared,
+     * affineDecomposition() is cheaper still.
      */
     template<class Real>
     void Matrix4<Real>::polarDecomposition(Matrix3<Real>& scale, Matrix3<Real>& rotation, Vector3<Real>& translation) const
@@ -268,7 +266,6 @@ namespace GLDemo
         translation[1] = (*this)(1,3);
         translation[2] = (*this)(2,3);
 
-        Matrix3<Real> zeroM;
         Matrix3<Real> input3;
         for (int i = 0; i < 3; ++i)
         {
@@ -278,30 +275,108 @@ namespace GLDemo
             }
         }
 
-        rotation.toZero();
-        Matrix3<Real> temp = input3;
-        int count = 0;
-
-        while (!Math<Real>::FEqual((temp - rotation).frobeniusNormSquared(), (Real)0.0))
+        rotation = input3;
+        for (int iteration = 0; iteration < s_maxPolarIterations; ++iteration)
         {
-            rotation = temp;
-            temp = (Real)0.5 * (rotation + rotation.transpose().inverse());
-            ++count;
+            Real det = rotation.determinant();
+            if (Math<Real>::FAbs(det) <= Math<Real>::Epsilon())
+            {
+                break;
+            }
+
+            // X' = (gX + X^-T / g) / 2, with g chosen to balance the norms of the two terms.
+            Matrix3<Real> invTranspose = rotation.adjoint().transpose() / det;
+            Real gamma = Math<Real>::Sqrt(Math<Real>::Sqrt(invTranspose.frobeniusNormSquared() / rotation.frobeniusNormSquared()));
+            Matrix3<Real> next = (Real)0.5 * (rotation * gamma + invTranspose / gamma);
+
+            Real change = (next - rotation).frobeniusNormSquared();
+            rotation = next;
+            if (change <= Math<Real>::Epsilon() * Math<Real>::Epsilon() * rotation.frobeniusNormSquared())
+            {
+                break;
+            }
         }
 
-        rotation = temp;
-        //TODO: fix this comparison function to perform correct floating point comparison
+        // A reflection is left in the scale, so that the rotation is a proper one.
         if (rotation.determinant() < (Real)0.0)
         {
-            temp(0,0) = (Real)-1.0;
-            temp(1,1) = (Real)-1.0;
-            temp(2,2) = (Real)-1.0;
-
-            rotation = rotation * temp;
+            rotation = -rotation;
         }
 
         rotation.orthonormalize();
-        scale = rotation.inverse() * input3;
+        scale = rotation.transposeTimes(input3);
+    }
+
+
+    /**
+     * \param scale       Set to the scale along each axis. Negative if the matrix reflects.
+     * \param rotation    Set to the rotation.
+     * \param shear       Set to the shear of x by y, x by z and y by z, in that order.
+     * \param translation Set to the translation.
+     * \return True if there is no shear, so that scale, rotation and translation alone
+     *         give this matrix.
+     *
+     * Splits an affine transformation into a translation, rotation, shear and scale,
+     * applied in the reverse of that order, such that the upper 3x3 is
+     *
+     *     rotation * [ 1  xy  xz ] * diag(scale)
+     *                [ 0  1   yz ]
+     *                [ 0  0   1  ]
+     *
+     * The columns are orthonormalized by Gram-Schmidt, which is closed form, so the cost
+     * is fixed, unlike polarDecomposition(). Any reflection is made a negative scale on
+     * every axis. Singular matrices leave the rotation for their zero axes undefined.
+     */
+    template<class Real>
+    bool Matrix4<Real>::affineDecomposition(Vector3<Real>& scale, Matrix3<Real>& rotation, Vector3<Real>& shear,
+                                            Vector3<Real>& translation) const
+    {
+        translation[0] = (*this)(0,3);
+        translation[1] = (*this)(1,3);
+        translation[2] = (*this)(2,3);
+
+        Vector3<Real> x((*this)(0,0), (*this)(1,0), (*this)(2,0));
+        Vector3<Real> y((*this)(0,1), (*this)(1,1), (*this)(2,1));
+        Vector3<Real> z((*this)(0,2), (*this)(1,2), (*this)(2,2));
+
+        scale[0] = x.normalize();
+        shear[0] = x.dot(y);
+        y -= x * shear[0];
+        scale[1] = y.normalize();
+        shear[1] = x.dot(z);
+        z -= x * shear[1];
+        shear[2] = y.dot(z);
+        z -= y * shear[2];
+        scale[2] = z.normalize();
+
+        // Shears were measured against the scaled axes; make them relative.
+        if (scale[1] != (Real)0.0)
+        {
+            shear[0] /= scale[1];
+        }
+        if (scale[2] != (Real)0.0)
+        {
+            shear[1] /= scale[2];
+            shear[2] /= scale[2];
+        }
+
+        if (x.dot(y.cross(z)) < (Real)0.0)
+        {
+            scale = -scale;
+            x = -x;
+            y = -y;
+            z = -z;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            rotation(i,0) = x[i];
+            rotation(i,1) = y[i];
+            rotation(i,2) = z[i];
+        }
+
+        return Math<Real>::FEqual(shear[0], (Real)0.0) && Math<Real>::FEqual(shear[1], (Real)0.0) &&
+               Math<Real>::FEqual(shear[2], (Real)0.0);
     }
 
 }
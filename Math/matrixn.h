@@ -2,6 +2,7 @@
 #define GLDEMO_MATRIX_N_H
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
 
 #include "mathdefs.h"
@@ -21,23 +22,27 @@ namespace GLDemo
      *
      * No actual virtual functions are used; subclasses are only forced to implement 'IMPL' functions
      * called by the baseclass template functions, such as AdjointImpl and DeterminantImpl.
+     *
+     * Like VectorN, matrices are trivially copyable and their construction and arithmetic are
+     * constexpr. Default construction gives the zero matrix; pass Uninitialized to skip that.
      */
     template<class Derived, class Real, int N>
     class MatrixN
     {
     public:
-        MatrixN();
-        MatrixN(const Real m[], bool transposeM = false);
-        MatrixN(const MatrixN&);
+        constexpr MatrixN();
+        explicit MatrixN(UninitializedTag) {}
+        constexpr MatrixN(const Real m[], bool transposeM = false);
 
-        // Alternative constructor for creating an identiy matrix
-        static Derived createIdentity();
+        // Alternative constructors for creating identity and zero matrices
+        static constexpr Derived createIdentity();
+        static constexpr Derived zero() { return Derived(); }
 
         //Access operations
-        Real  operator[](int i) const        { assert(i < TOTAL_ELEMENTS); return m_components[i]; }
-        Real& operator[](int i)              { assert(i < TOTAL_ELEMENTS); return m_components[i]; }
-        Real  operator()(int row, int col) const { assert(row < N && col < N); return m_components[row + col * N]; }
-        Real& operator()(int row, int col)       { assert(row < N && col < N); return m_components[row + col * N]; }
+        constexpr Real  operator[](int i) const        { assert(i < TOTAL_ELEMENTS); return m_components[i]; }
+        constexpr Real& operator[](int i)              { assert(i < TOTAL_ELEMENTS); return m_components[i]; }
+        constexpr Real  operator()(int row, int col) const { assert(row < N && col < N); return m_components[row + col * N]; }
+        constexpr Real& operator()(int row, int col)       { assert(row < N && col < N); return m_components[row + col * N]; }
 
         const Real* toPointer() const  { return (Real*)this; }
         Real* toPointer()              { return (Real*)this; }
@@ -51,18 +56,18 @@ namespace GLDemo
         bool operator!=(const MatrixN& m) const;
 
         //Algebraic operations
-        Derived operator+(const Derived& m) const;
-        Derived operator-(const Derived& m) const;
-        Derived operator*(const Derived& m) const;
-        Derived operator*(const Real& s) const;
+        constexpr Derived operator+(const Derived& m) const;
+        constexpr Derived operator-(const Derived& m) const;
+        constexpr Derived operator*(const Derived& m) const;
+        constexpr Derived operator*(const Real& s) const;
 
-        Derived operator/(const Real& s) const;
-        Derived operator-() const;
+        constexpr Derived operator/(const Real& s) const;
+        constexpr Derived operator-() const;
 
-        Derived& operator+=(const Derived& m);
-        Derived& operator-=(const Derived& m);
-        Derived& operator*=(const Real& s);
-        Derived& operator/=(const Real& s);
+        constexpr Derived& operator+=(const Derived& m);
+        constexpr Derived& operator-=(const Derived& m);
+        constexpr Derived& operator*=(const Real& s);
+        constexpr Derived& operator/=(const Real& s);
 
         void toRowEschelonForm ();
         void toReducedRowEschelonForm ();
@@ -71,11 +76,11 @@ namespace GLDemo
 
         // Geometric operations
         Derived inverse() const;
-        Derived transpose() const;
+        constexpr Derived transpose() const;
         Derived transposeTimes(const Derived& m) const;
         Derived timesTranspose(const Derived& m) const;
 
-        Real trace() const;
+        constexpr Real trace() const;
 
         // "Virtual" functions (CRTP)
         Real determinant() const { return static_cast<const Derived*>(this)->determinantImpl(); }
@@ -87,7 +92,7 @@ namespace GLDemo
         void rowMajor (Real* out) const;
 
         // Friend functions for commutative operations
-        friend Derived operator* (const Real& s, const Derived& m) { return m * s; }
+        friend constexpr Derived operator* (const Real& s, const Derived& m) { return m * s; }
         friend std::ostream& operator<< (std::ostream& stream, const MatrixN<Derived, Real, N>& m)
         {
             stream << "{ " << std::endl;
@@ -115,7 +120,7 @@ namespace GLDemo
      * Constructs a new identity matrix.
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::createIdentity()
+    constexpr Derived MatrixN<Derived, Real, N>::createIdentity()
     {
         Derived result;
         for (int i = 0; i < TOTAL_ELEMENTS; i += N + 1)
@@ -130,9 +135,9 @@ namespace GLDemo
      * Initialises a new NxN matrix as a null (zero) matrix.
      */
     template<class Derived, class Real, int N>
-    inline MatrixN<Derived, Real, N>::MatrixN()
+    constexpr MatrixN<Derived, Real, N>::MatrixN() :
+        m_components()
     {
-        std::memset(m_components, 0, sizeof(Real) * TOTAL_ELEMENTS);
     }
 
 
@@ -141,7 +146,8 @@ namespace GLDemo
      * the transpose of the original matrix.
      */
     template<class Derived, class Real, int N>
-    MatrixN<Derived, Real, N>::MatrixN(const Real m[], bool transposeM)
+    constexpr MatrixN<Derived, Real, N>::MatrixN(const Real m[], bool transposeM) :
+        m_components()
     {
         if (transposeM)
         {
@@ -157,21 +163,14 @@ namespace GLDemo
         else
         {
             //no transpose, just copy as-if binary array
-            std::memcpy(m_components, m, sizeof(Real) * TOTAL_ELEMENTS);
+            for (int i = 0; i < TOTAL_ELEMENTS; ++i)
+            {
+                m_components[i] = m[i];
+            }
         }
     }
 
 
-    /**
-     * Creates a new copy of a MatrixN.
-     */
-    template<class Derived, class Real, int N>
-    inline MatrixN<Derived, Real, N>::MatrixN(const MatrixN<Derived, Real, N>& m)
-    {
-        std::memcpy(m_components, m.toPointer(), sizeof(Real) * TOTAL_ELEMENTS);
-    }
-
-
     /**
      *
      */
@@ -247,15 +246,15 @@ namespace GLDemo
      *
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::operator+ (const Derived& m) const
+    constexpr Derived MatrixN<Derived, Real, N>::operator+ (const Derived& m) const
     {
-        Real result[TOTAL_ELEMENTS];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
-            result[i] = m_components[i] + m[i];
+            result[i] += m[i];
         }
 
-        return Derived(result, false);
+        return result;
     }
 
 
@@ -263,15 +262,15 @@ namespace GLDemo
      *
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::operator- (const Derived& m) const
+    constexpr Derived MatrixN<Derived, Real, N>::operator- (const Derived& m) const
     {
-        Real result[TOTAL_ELEMENTS];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
-            result[i] = m_components[i] - m[i];
+            result[i] -= m[i];
         }
 
-        return Derived(result, false);
+        return result;
     }
 
 
@@ -283,7 +282,7 @@ namespace GLDemo
      * \param m The matrix to premultiply with this matrix.
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::operator* (const Derived& m) const
+    constexpr Derived MatrixN<Derived, Real, N>::operator* (const Derived& m) const
     {
         Derived result;
         for (int row = 0; row < N; ++row)
@@ -308,15 +307,15 @@ namespace GLDemo
      * \param s  The scalar value to multiply with.
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::operator* (const Real& s) const
+    constexpr Derived MatrixN<Derived, Real, N>::operator* (const Real& s) const
     {
-        Real result[TOTAL_ELEMENTS];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
-            result[i] = m_components[i] * s;
+            result[i] *= s;
         }
 
-        return Derived(result, false);
+        return result;
     }
 
 
@@ -324,15 +323,15 @@ namespace GLDemo
      * Divide this matrix by a scalar value.
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::operator/ (const Real& s) const
+    constexpr Derived MatrixN<Derived, Real, N>::operator/ (const Real& s) const
     {
-        Real result[TOTAL_ELEMENTS];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
-            result[i] = m_components[i] / s;
+            result[i] /= s;
         }
 
-        return Derived(result, false);
+        return result;
     }
 
 
@@ -340,15 +339,15 @@ namespace GLDemo
      * Returns this matrix multiplied by the scalar -1.
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::operator- () const
+    constexpr Derived MatrixN<Derived, Real, N>::operator- () const
     {
-        Real result[TOTAL_ELEMENTS];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
-            result[i] = -m_components[i];
+            result[i] = -result[i];
         }
 
-        return Derived(result, false);
+        return result;
     }
 
 
@@ -359,7 +358,7 @@ namespace GLDemo
      * \return A reference to this matrix.
      */
     template<class Derived, class Real, int N>
-    Derived& MatrixN<Derived, Real, N>::operator+= (const Derived& m)
+    constexpr Derived& MatrixN<Derived, Real, N>::operator+= (const Derived& m)
     {
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
@@ -377,7 +376,7 @@ namespace GLDemo
      * \return A reference to this matrix.
      */
     template<class Derived, class Real, int N>
-    Derived& MatrixN<Derived, Real, N>::operator-= (const Derived& m)
+    constexpr Derived& MatrixN<Derived, Real, N>::operator-= (const Derived& m)
     {
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
@@ -395,7 +394,7 @@ namespace GLDemo
      * \return A reference to this matrix.
      */
     template<class Derived, class Real, int N>
-    Derived& MatrixN<Derived, Real, N>::operator*= (const Real& s)
+    constexpr Derived& MatrixN<Derived, Real, N>::operator*= (const Real& s)
     {
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
@@ -413,7 +412,7 @@ namespace GLDemo
      * \return A reference to this matrix.
      */
     template<class Derived, class Real, int N>
-    Derived& MatrixN<Derived, Real, N>::operator/= (const Real& s)
+    constexpr Derived& MatrixN<Derived, Real, N>::operator/= (const Real& s)
     {
         for (int i = 0; i < TOTAL_ELEMENTS; ++i)
         {
@@ -596,7 +595,7 @@ namespace GLDemo
      * \return The transpose of this matrix.
      */
     template<class Derived, class Real, int N>
-    Derived MatrixN<Derived, Real, N>::transpose() const
+    constexpr Derived MatrixN<Derived, Real, N>::transpose() const
     {
         Derived transpose;
         for (int row = 0; row < N; ++row)
@@ -645,7 +644,7 @@ namespace GLDemo
      * \return The trace (sum of the diagonal) of this matrix.
      */
     template<class Derived, class Real, int N>
-    Real MatrixN<Derived, Real, N>::trace() const
+    constexpr Real MatrixN<Derived, Real, N>::trace() const
     {
         Real trace = 0;
         for (int i = 0; i < TOTAL_ELEMENTS; i += N + 1)
@@ -0,0 +1,413 @@
+#ifndef GLDEMO_QUATERNION_H
+#define GLDEMO_QUATERNION_H
+
+#include "mathdefs.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace GLDemo
+{
+
+    /**
+     * The Quaternion class represents a rotation in 3 dimensions as a unit quaternion,
+     * w + xi + yj + zk. It is templated so that it can be used with any numeric type,
+     * notably floats or doubles.
+     *
+     * Quaternions are a third the size of a rotation matrix, compose with 16 multiplies
+     * rather than 27, and interpolate smoothly, which makes them a better fit than
+     * Matrix3 for rotations that are combined or animated. Rotations compose in the same
+     * order as matrices: (a * b).rotate(v) == a.rotate(b.rotate(v)).
+     */
+    template<class Real>
+    class Quaternion
+    {
+    public:
+        Quaternion();
+        Quaternion(const Real& w, const Real& x, const Real& y, const Real& z);
+        explicit Quaternion(const Matrix3<Real>& rotation);
+
+        //Access Operations
+        Real  w() const { return m_w; }
+        Real& w()       { return m_w; }
+        Real  x() const { return m_x; }
+        Real& x()       { return m_x; }
+        Real  y() const { return m_y; }
+        Real& y()       { return m_y; }
+        Real  z() const { return m_z; }
+        Real& z()       { return m_z; }
+
+        //Comparison operations
+        bool operator==(const Quaternion& q) const;
+        bool operator!=(const Quaternion& q) const { return !(*this == q); }
+
+        //Algebraic operations
+        Quaternion operator*(const Quaternion& q) const;
+        Quaternion operator+(const Quaternion& q) const;
+        Quaternion operator-(const Quaternion& q) const;
+        Quaternion operator*(const Real& s) const;
+        Quaternion operator-() const;
+
+        Real dot(const Quaternion& q) const;
+        Real length() const;
+        Real lengthSquared() const;
+        Real normalize();
+        Quaternion conjugate() const;
+        Quaternion inverse() const;
+
+        //Geometric operations
+        Vector3<Real> rotate(const Vector3<Real>& v) const;
+
+        Quaternion& fromAxisAngle(const Real& angle, const Vector3<Real>& axis);
+        void toAxisAngle(Real& angle, Vector3<Real>& axis) const;
+        Quaternion& fromRotationMatrix(const Matrix3<Real>& m);
+        void toRotationMatrix(Matrix3<Real>& m) const;
+
+        static Quaternion slerp(const Quaternion& a, const Quaternion& b, const Real& t);
+        static Quaternion nlerp(const Quaternion& a, const Quaternion& b, const Real& t);
+
+        friend Quaternion operator* (const Real& s, const Quaternion& q) { return q * s; }
+        friend std::ostream& operator<<(std::ostream& stream, const Quaternion& q)
+        {
+            stream << "{ " << q.m_w << " " << q.m_x << " " << q.m_y << " " << q.m_z << " }";
+            return stream;
+        }
+
+    private:
+        Real m_w;
+        Real m_x;
+        Real m_y;
+        Real m_z;
+    };
+
+    typedef Quaternion<float> Quaternionf;
+    typedef Quaternion<double> Quaterniond;
+
+
+    /**
+     * Initialises a new quaternion as the identity rotation.
+     */
+    template<class Real>
+    inline Quaternion<Real>::Quaternion() :
+        m_w(1),
+        m_x(0),
+        m_y(0),
+        m_z(0)
+    {
+    }
+
+
+    /**
+     *
+     */
+    template<class Real>
+    inline Quaternion<Real>::Quaternion(const Real& w, const Real& x, const Real& y, const Real& z) :
+        m_w(w),
+        m_x(x),
+        m_y(y),
+        m_z(z)
+    {
+    }
+
+
+    /**
+     * Creates the quaternion for the rotation matrix \a rotation.
+     */
+    template<class Real>
+    inline Quaternion<Real>::Quaternion(const Matrix3<Real>& rotation)
+    {
+        fromRotationMatrix(rotation);
+    }
+
+
+    /**
+     * Determine whether two quaternions are approximately equal. Note that q and -q are
+     * the same rotation, but are not equal.
+     */
+    template<class Real>
+    inline bool Quaternion<Real>::operator==(const Quaternion<Real>& q) const
+    {
+        return Math<Real>::FEqual(m_w, q.m_w) && Math<Real>::FEqual(m_x, q.m_x) &&
+               Math<Real>::FEqual(m_y, q.m_y) && Math<Real>::FEqual(m_z, q.m_z);
+    }
+
+
+    /**
+     * The Hamilton product; the rotation by \a q followed by the rotation by this one.
+     */
+    template<class Real>
+    inline Quaternion<Real> Quaternion<Real>::operator*(const Quaternion<Real>& q) const
+    {
+        return Quaternion(m_w * q.m_w - m_x * q.m_x - m_y * q.m_y - m_z * q.m_z,
+                          m_w * q.m_x + m_x * q.m_w + m_y * q.m_z - m_z * q.m_y,
+                          m_w * q.m_y - m_x * q.m_z + m_y * q.m_w + m_z * q.m_x,
+                          m_w * q.m_z + m_x * q.m_y - m_y * q.m_x + m_z * q.m_w);
+    }
+
+
+    template<class Real>
+    inline Quaternion<Real> Quaternion<Real>::operator+(const Quaternion<Real>& q) const
+    {
+        return Quaternion(m_w + q.m_w, m_x + q.m_x, m_y + q.m_y, m_z + q.m_z);
+    }
+
+
+    template<class Real>
+    inline Quaternion<Real> Quaternion<Real>::operator-(const Quaternion<Real>& q) const
+    {
+        return Quaternion(m_w - q.m_w, m_x - q.m_x, m_y - q.m_y, m_z - q.m_z);
+    }
+
+
+    template<class Real>
+    inline Quaternion<Real> Quaternion<Real>::operator*(const Real& s) const
+    {
+        return Quaternion(m_w * s, m_x * s, m_y * s, m_z * s);
+    }
+
+
+    template<class Real>
+    inline Quaternion<Real> Quaternion<Real>::operator-() const
+    {
+        return Quaternion(-m_w, -m_x, -m_y, -m_z);
+    }
+
+
+    template<class Real>
+    inline Real Quaternion<Real>::dot(const Quaternion<Real>& q) const
+    {
+        return m_w * q.m_w + m_x * q.m_x + m_y * q.m_y + m_z * q.m_z;
+    }
+
+
+    template<class Real>
+    inline Real Quaternion<Real>::length() const
+    {
+        return Math<Real>::Sqrt(lengthSquared());
+    }
+
+
+    template<class Real>
+    inline Real Quaternion<Real>::lengthSquared() const
+    {
+        return dot(*this);
+    }
+
+
+    /**
+     * Makes the quaternion unit length. Returns the length used to normalize it.
+     */
+    template<class Real>
+    inline Real Quaternion<Real>::normalize()
+    {
+        Real origLength = length();
+        if (Math<Real>::FEqual(origLength, (Real)0.0))
+        {
+            return (Real)0.0;
+        }
+
+        Real invLength = 1 / origLength;
+        m_w *= invLength;
+        m_x *= invLength;
+        m_y *= invLength;
+        m_z *= invLength;
+        return origLength;
+    }
+
+
+    /**
+     * For a unit quaternion, the conjugate is the inverse rotation.
+     */
+    template<class Real>
+    inline Quaternion<Real> Quaternion<Real>::conjugate() const
+    {
+        return Quaternion(m_w, -m_x, -m_y, -m_z);
+    }
+
+
+    /**
+     * The inverse of a quaternion of any length. For rotations, conjugate() is cheaper.
+     */
+    template<class Real>
+    inline Quaternion<Real> Quaternion<Real>::inverse() const
+    {
+        return conjugate() * (1 / lengthSquared());
+    }
+
+
+    /**
+     * Rotates the vector \a v. The quaternion must be unit length. Uses
+     * v' = v + 2w(q x v) + 2q x (q x v), for the vector part q, which is cheaper than
+     * converting to a matrix first.
+     */
+    template<class Real>
+    inline Vector3<Real> Quaternion<Real>::rotate(const Vector3<Real>& v) const
+    {
+        const Vector3<Real> axis(m_x, m_y, m_z);
+        const Vector3<Real> t = axis.cross(v) * (Real)2;
+        return v + t * m_w + axis.cross(t);
+    }
+
+
+    /**
+     * \param angle  The angle to rotate by, in radians.
+     * \param axis   The axis to rotate about. Must be unit length.
+     *
+     * Rotates by the same amount as Matrix3::fromAxisAngle().
+     */
+    template<class Real>
+    Quaternion<Real>& Quaternion<Real>::fromAxisAngle(const Real& angle, const Vector3<Real>& axis)
+    {
+        Real halfAngle = angle / 2;
+        Real s = Math<Real>::Sin(halfAngle);
+        m_w = Math<Real>::Cos(halfAngle);
+        m_x = axis.x() * s;
+        m_y = axis.y() * s;
+        m_z = axis.z() * s;
+        return *this;
+    }
+
+
+    /**
+     * \param angle  Set to the angle rotated by, in radians, between 0 and 2 pi.
+     * \param axis   Set to the axis rotated about. Arbitrary if the angle is zero.
+     */
+    template<class Real>
+    void Quaternion<Real>::toAxisAngle(Real& angle, Vector3<Real>& axis) const
+    {
+        Real sinHalfAngle = Math<Real>::Sqrt(m_x * m_x + m_y * m_y + m_z * m_z);
+        if (sinHalfAngle <= Math<Real>::Epsilon())
+        {
+            angle = 0;
+            axis = Vector3<Real>(1, 0, 0);
+            return;
+        }
+
+        angle = 2 * std::atan2(sinHalfAngle, m_w);
+        axis = Vector3<Real>(m_x, m_y, m_z) / sinHalfAngle;
+    }
+
+
+    /**
+     * \param m  A rotation matrix; orthonormal, with a determinant of one.
+     *
+     * Uses Shepperd's method, taking the square root of whichever of the diagonal terms
+     * is largest, so that it never divides by something close to zero.
+     */
+    template<class Real>
+    Quaternion<Real>& Quaternion<Real>::fromRotationMatrix(const Matrix3<Real>& m)
+    {
+        const Real trace = m(0,0) + m(1,1) + m(2,2);
+        if (trace > 0)
+        {
+            Real s = Math<Real>::Sqrt(trace + 1) * 2;   // 4w
+            m_w = s / 4;
+            m_x = (m(2,1) - m(1,2)) / s;
+            m_y = (m(0,2) - m(2,0)) / s;
+            m_z = (m(1,0) - m(0,1)) / s;
+        }
+        else if (m(0,0) > m(1,1) && m(0,0) > m(2,2))
+        {
+            Real s = Math<Real>::Sqrt(1 + m(0,0) - m(1,1) - m(2,2)) * 2;   // 4x
+            m_w = (m(2,1) - m(1,2)) / s;
+            m_x = s / 4;
+            m_y = (m(0,1) + m(1,0)) / s;
+            m_z = (m(0,2) + m(2,0)) / s;
+        }
+        else if (m(1,1) > m(2,2))
+        {
+            Real s = Math<Real>::Sqrt(1 + m(1,1) - m(0,0) - m(2,2)) * 2;   // 4y
+            m_w = (m(0,2) - m(2,0)) / s;
+            m_x = (m(0,1) + m(1,0)) / s;
+            m_y = s / 4;
+            m_z = (m(1,2) + m(2,1)) / s;
+        }
+        else
+        {
+            Real s = Math<Real>::Sqrt(1 + m(2,2) - m(0,0) - m(1,1)) * 2;   // 4z
+            m_w = (m(1,0) - m(0,1)) / s;
+            m_x = (m(0,2) + m(2,0)) / s;
+            m_y = (m(1,2) + m(2,1)) / s;
+            m_z = s / 4;
+        }
+
+        normalize();
+        return *this;
+    }
+
+
+    /**
+     * \param m  Set to the rotation matrix for this quaternion, which must be unit length.
+     */
+    template<class Real>
+    void Quaternion<Real>::toRotationMatrix(Matrix3<Real>& m) const
+    {
+        const Real xx = m_x * m_x;
+        const Real yy = m_y * m_y;
+        const Real zz = m_z * m_z;
+        const Real xy = m_x * m_y;
+        const Real xz = m_x * m_z;
+        const Real yz = m_y * m_z;
+        const Real wx = m_w * m_x;
+        const Real wy = m_w * m_y;
+        const Real wz = m_w * m_z;
+
+        m(0,0) = 1 - 2 * (yy + zz);
+        m(0,1) = 2 * (xy - wz);
+        m(0,2) = 2 * (xz + wy);
+        m(1,0) = 2 * (xy + wz);
+        m(1,1) = 1 - 2 * (xx + zz);
+        m(1,2) = 2 * (yz - wx);
+        m(2,0) = 2 * (xz - wy);
+        m(2,1) = 2 * (yz + wx);
+        m(2,2) = 1 - 2 * (xx + yy);
+    }
+
+
+    /**
+     * \param a  The rotation at \a t = 0.
+     * \param b  The rotation at \a t = 1.
+     * \param t  How far to go from \a a to \a b.
+     * \return The rotation a fraction \a t of the way from \a a to \a b, along the
+     *         shortest arc, at a constant angular speed.
+     */
+    template<class Real>
+    Quaternion<Real> Quaternion<Real>::slerp(const Quaternion<Real>& a, const Quaternion<Real>& b, const Real& t)
+    {
+        // q and -q are the same rotation; take whichever is nearer, for the shorter arc.
+        Real cosAngle = a.dot(b);
+        Quaternion<Real> end = b;
+        if (cosAngle < 0)
+        {
+            cosAngle = -cosAngle;
+            end = -b;
+        }
+
+        // Nearly parallel rotations fall back to a normalized linear blend, which is
+        // indistinguishable there and avoids dividing by the sine of a tiny angle.
+        if (cosAngle > 1 - Math<Real>::Epsilon() * 10)
+        {
+            return nlerp(a, end, t);
+        }
+
+        Real angle = Math<Real>::ACos(cosAngle);
+        Real invSin = 1 / Math<Real>::Sin(angle);
+        return a * (Math<Real>::Sin((1 - t) * angle) * invSin) + end * (Math<Real>::Sin(t * angle) * invSin);
+    }
+
+
+    /**
+     * \return The normalized linear blend of \a a and \a b, along the shortest arc. This
+     *         follows the same path as slerp(), much more cheaply, but not at a constant
+     *         speed; good enough for blending nearby rotations, such as animation keys.
+     */
+    template<class Real>
+    Quaternion<Real> Quaternion<Real>::nlerp(const Quaternion<Real>& a, const Quaternion<Real>& b, const Real& t)
+    {
+        Quaternion<Real> result = (a.dot(b) < 0) ? a * (1 - t) - b * t : a * (1 - t) + b * t;
+        result.normalize();
+        return result;
+    }
+
+}
+
+#endif
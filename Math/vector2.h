@@ -14,15 +14,16 @@ namespace GLDemo
         typedef VectorN<Vector2<Real>, Real, 2> VectorBase;
 
     public:
-        Vector2();
-        Vector2(const Real v[]);
-        Vector2(const Real& x, const Real& y);
+        constexpr Vector2();
+        explicit Vector2(UninitializedTag) : VectorBase(Uninitialized) {}
+        constexpr Vector2(const Real v[]);
+        constexpr Vector2(const Real& x, const Real& y);
 
         //Access Operations
-        Real  x() const { return VectorBase::operator[](0); }
-        Real& x()       { return VectorBase::operator[](0); }
-        Real  y() const { return VectorBase::operator[](1); }
-        Real& y()       { return VectorBase::operator[](1); }
+        constexpr Real  x() const { return VectorBase::operator[](0); }
+        constexpr Real& x()       { return VectorBase::operator[](0); }
+        constexpr Real  y() const { return VectorBase::operator[](1); }
+        constexpr Real& y()       { return VectorBase::operator[](1); }
 
         //Geometric Operations Specific to 2D
         Vector2 perp() const;
@@ -37,21 +38,21 @@ namespace GLDemo
     typedef Vector2<double> Vector2d;
 
     template<class Real>
-    inline Vector2<Real>::Vector2() :
+    constexpr Vector2<Real>::Vector2() :
         VectorBase()
     {
     }
 
 
     template<class Real>
-    inline Vector2<Real>::Vector2(const Real v[]) :
+    constexpr Vector2<Real>::Vector2(const Real v[]) :
         VectorBase(v)
     {
     }
 
 
     template<class Real>
-    inline Vector2<Real>::Vector2(const Real& vx, const Real& vy) :
+    constexpr Vector2<Real>::Vector2(const Real& vx, const Real& vy) :
         VectorBase()
     {
         x() = vx;
@@ -17,20 +17,23 @@ namespace GLDemo
         typedef VectorN<Vector3<Real>, Real, 3> VectorBase;
 
     public:
-        Vector3();
-        Vector3(const Real v[]);
-        Vector3(const Real& x, const Real& y, const Real& z);
+        constexpr Vector3();
+        explicit Vector3(UninitializedTag) : VectorBase(Uninitialized) {}
+        constexpr Vector3(const Real v[]);
+        constexpr Vector3(const Real& x, const Real& y, const Real& z);
+        template<class OtherReal>
+        explicit constexpr Vector3(const Vector3<OtherReal>& v);
 
         //Access Operations
-        Real  x() const	{ return VectorBase::operator[](0); }
-        Real& x()		{ return VectorBase::operator[](0); }
-        Real  y() const	{ return VectorBase::operator[](1); }
-        Real& y()		{ return VectorBase::operator[](1); }
-        Real  z() const	{ return VectorBase::operator[](2); }
-        Real& z()		{ return VectorBase::operator[](2); }
+        constexpr Real  x() const	{ return VectorBase::operator[](0); }
+        constexpr Real& x()		{ return VectorBase::operator[](0); }
+        constexpr Real  y() const	{ return VectorBase::operator[](1); }
+        constexpr Real& y()		{ return VectorBase::operator[](1); }
+        constexpr Real  z() const	{ return VectorBase::operator[](2); }
+        constexpr Real& z()		{ return VectorBase::operator[](2); }
 
         //Geometric Operations Specific to 3D
-        Vector3 cross(const Vector3& v) const;
+        constexpr Vector3 cross(const Vector3& v) const;
         Vector3 unitCross(const Vector3& v) const;
 
         static void orthonormalize(Vector3& u, Vector3& v, Vector3& w);
@@ -42,21 +45,21 @@ namespace GLDemo
     typedef Vector3<double> Vector3d;
 
     template<class Real>
-    Vector3<Real>::Vector3() :
+    constexpr Vector3<Real>::Vector3() :
         VectorBase()
     {
     }
 
 
     template<class Real>
-    Vector3<Real>::Vector3(const Real v[]) :
+    constexpr Vector3<Real>::Vector3(const Real v[]) :
         VectorBase(v)
     {
     }
 
 
     template<class Real>
-    Vector3<Real>::Vector3(const Real& vx, const Real& vy, const Real& vz) :
+    constexpr Vector3<Real>::Vector3(const Real& vx, const Real& vy, const Real& vz) :
         VectorBase()
     {
         x() = vx;
@@ -65,8 +68,22 @@ namespace GLDemo
     }
 
 
+    /**
+     * Converts a vector of another precision, such as a Vector3d to a Vector3f.
+     */
+    template<class Real>
+    template<class OtherReal>
+    constexpr Vector3<Real>::Vector3(const Vector3<OtherReal>& v) :
+        VectorBase()
+    {
+        x() = static_cast<Real>(v.x());
+        y() = static_cast<Real>(v.y());
+        z() = static_cast<Real>(v.z());
+    }
+
+
     template<class Real>
-    inline Vector3<Real> Vector3<Real>::cross(const Vector3<Real>& v) const
+    constexpr Vector3<Real> Vector3<Real>::cross(const Vector3<Real>& v) const
     {
         return Vector3((*this)[1] * v[2] - (*this)[2] * v[1],
                        (*this)[2] * v[0] - (*this)[0] * v[2],
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "vector3soa.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLDEMO_SOA_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace GLDemo
+{
+    namespace
+    {
+        /**
+         * \internal The vector \a i strides of \a stride bytes on from another.
+         */
+        const Vector3f& strided(const Vector3f* first, int i, std::size_t stride)
+        {
+            return *reinterpret_cast<const Vector3f*>(reinterpret_cast<const char*>(first) + i * stride);
+        }
+
+        Vector3f& strided(Vector3f* first, int i, std::size_t stride)
+        {
+            return *reinterpret_cast<Vector3f*>(reinterpret_cast<char*>(first) + i * stride);
+        }
+
+
+        /**
+         * \internal Transforms the points from \a begin onwards, one at a time. This is
+         *           every point without SSE, and those left over after the last full group
+         *           of four with it.
+         */
+        void transformPointsScalar(const Matrix4f& m, int begin, int end,
+                                   const float* x, const float* y, const float* z,
+                                   float* outX, float* outY, float* outZ, float* outW)
+        {
+            for (int i = begin; i < end; ++i)
+            {
+                const float px = x[i];
+                const float py = y[i];
+                const float pz = z[i];
+                outX[i] = m(0,0) * px + m(0,1) * py + m(0,2) * pz + m(0,3);
+                outY[i] = m(1,0) * px + m(1,1) * py + m(1,2) * pz + m(1,3);
+                outZ[i] = m(2,0) * px + m(2,1) * py + m(2,2) * pz + m(2,3);
+                if (outW)
+                {
+                    outW[i] = m(3,0) * px + m(3,1) * py + m(3,2) * pz + m(3,3);
+                }
+            }
+        }
+
+
+        /**
+         * \internal Transforms points by a matrix, writing the fourth row only if \a outW
+         *           is given.
+         */
+        void transformPointStreams(const Matrix4f& m, int count, const float* x, const float* y, const float* z,
+                                   float* outX, float* outY, float* outZ, float* outW)
+        {
+            int i = 0;
+#ifdef GLDEMO_SOA_SSE2
+            __m128 row[4][4];
+            for (int r = 0; r < 4; ++r)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    row[r][c] = _mm_set1_ps(m(r,c));
+                }
+            }
+
+            const int rows = outW ? 4 : 3;
+            float* out[4] = { outX, outY, outZ, outW };
+            for (; i + 4 <= count; i += 4)
+            {
+                const __m128 px = _mm_loadu_ps(x + i);
+                const __m128 py = _mm_loadu_ps(y + i);
+                const __m128 pz = _mm_loadu_ps(z + i);
+                for (int r = 0; r < rows; ++r)
+                {
+                    __m128 sum = _mm_add_ps(_mm_mul_ps(row[r][0], px), _mm_mul_ps(row[r][1], py));
+                    sum = _mm_add_ps(sum, _mm_add_ps(_mm_mul_ps(row[r][2], pz), row[r][3]));
+                    _mm_storeu_ps(out[r] + i, sum);
+                }
+            }
+#endif
+            transformPointsScalar(m, i, count, x, y, z, outX, outY, outZ, outW);
+        }
+    }
+
+
+    /**
+     * Creates an empty array.
+     */
+    Vector3SoA::Vector3SoA() :
+        m_x(),
+        m_y(),
+        m_z()
+    {
+    }
+
+
+    /**
+     * Creates an array of zero vectors.
+     */
+    Vector3SoA::Vector3SoA(int size) :
+        m_x(size),
+        m_y(size),
+        m_z(size)
+    {
+    }
+
+
+    /**
+     * Vectors added by growing the array are zero.
+     */
+    void Vector3SoA::resize(int size)
+    {
+        m_x.resize(size);
+        m_y.resize(size);
+        m_z.resize(size);
+    }
+
+
+    /**
+     *
+     */
+    void Vector3SoA::reserve(int size)
+    {
+        m_x.reserve(size);
+        m_y.reserve(size);
+        m_z.reserve(size);
+    }
+
+
+    /**
+     *
+     */
+    void Vector3SoA::clear()
+    {
+        m_x.clear();
+        m_y.clear();
+        m_z.clear();
+    }
+
+
+    /**
+     *
+     */
+    void Vector3SoA::push_back(const Vector3f& v)
+    {
+        m_x.push_back(v.x());
+        m_y.push_back(v.y());
+        m_z.push_back(v.z());
+    }
+
+
+    /**
+     * \param first   The first vector to copy.
+     * \param count   The number of vectors to copy.
+     * \param stride  Bytes from one vector to the next, so that a member of an array of
+     *                structures can be copied, such as the positions of an array of
+     *                Vertex.
+     *
+     * Replaces the contents of the array with copies of the vectors.
+     */
+    void Vector3SoA::gather(const Vector3f* first, int count, std::size_t stride)
+    {
+        resize(count);
+        for (int i = 0; i < count; ++i)
+        {
+            const Vector3f& v = strided(first, i, stride);
+            m_x[i] = v.x();
+            m_y[i] = v.y();
+            m_z[i] = v.z();
+        }
+    }
+
+
+    /**
+     * \param first   Where to copy the first vector to. There must be room for size()
+     *                vectors.
+     * \param stride  Bytes from one vector to the next.
+     */
+    void Vector3SoA::scatter(Vector3f* first, std::size_t stride) const
+    {
+        for (int i = 0; i < size(); ++i)
+        {
+            Vector3f& v = strided(first, i, stride);
+            v.x() = m_x[i];
+            v.y() = m_y[i];
+            v.z() = m_z[i];
+        }
+    }
+
+
+    /**
+     * \param m    The matrix to transform by. Its last row is ignored, so it should be an
+     *             affine transform.
+     * \param out  Set to the transformed points, and resized to match.
+     */
+    void Vector3SoA::transformPoints(const Matrix4f& m, Vector3SoA& out) const
+    {
+        out.resize(size());
+        transformPointStreams(m, size(), x(), y(), z(), out.x(), out.y(), out.z(), 0);
+    }
+
+
+    /**
+     * \param m    The matrix to transform by, which may be a projection.
+     * \param out  Set to the x, y and z of the transformed points, before any divide by w.
+     * \param w    Set to the w of the transformed points.
+     */
+    void Vector3SoA::transformPoints(const Matrix4f& m, Vector3SoA& out, std::vector<float>& w) const
+    {
+        out.resize(size());
+        w.resize(size());
+        transformPointStreams(m, size(), x(), y(), z(), out.x(), out.y(), out.z(), w.empty() ? 0 : &w[0]);
+    }
+
+
+    /**
+     * \param m    The matrix to transform by. For normals, this should be the inverse
+     *             transpose of the matrix the points are transformed by.
+     * \param out  Set to the transformed vectors, and resized to match.
+     */
+    void Vector3SoA::transformVectors(const Matrix3f& m, Vector3SoA& out) const
+    {
+        out.resize(size());
+        const int count = size();
+        const float* vx = x();
+        const float* vy = y();
+        const float* vz = z();
+        float* outX = out.x();
+        float* outY = out.y();
+        float* outZ = out.z();
+
+        int i = 0;
+#ifdef GLDEMO_SOA_SSE2
+        __m128 row[3][3];
+        for (int r = 0; r < 3; ++r)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                row[r][c] = _mm_set1_ps(m(r,c));
+            }
+        }
+
+        float* outs[3] = { outX, outY, outZ };
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 px = _mm_loadu_ps(vx + i);
+            const __m128 py = _mm_loadu_ps(vy + i);
+            const __m128 pz = _mm_loadu_ps(vz + i);
+            for (int r = 0; r < 3; ++r)
+            {
+                __m128 sum = _mm_add_ps(_mm_mul_ps(row[r][0], px), _mm_mul_ps(row[r][1], py));
+                _mm_storeu_ps(outs[r] + i, _mm_add_ps(sum, _mm_mul_ps(row[r][2], pz)));
+            }
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const float px = vx[i];
+            const float py = vy[i];
+            const float pz = vz[i];
+            outX[i] = m(0,0) * px + m(0,1) * py + m(0,2) * pz;
+            outY[i] = m(1,0) * px + m(1,1) * py + m(1,2) * pz;
+            outZ[i] = m(2,0) * px + m(2,1) * py + m(2,2) * pz;
+        }
+    }
+
+
+    /**
+     * Makes every vector unit length. Zero vectors are left as they are.
+     */
+    void Vector3SoA::normalize()
+    {
+        const int count = size();
+        float* vx = x();
+        float* vy = y();
+        float* vz = z();
+
+        int i = 0;
+#ifdef GLDEMO_SOA_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 px = _mm_loadu_ps(vx + i);
+            const __m128 py = _mm_loadu_ps(vy + i);
+            const __m128 pz = _mm_loadu_ps(vz + i);
+            __m128 length = _mm_mul_ps(px, px);
+            length = _mm_add_ps(length, _mm_mul_ps(py, py));
+            length = _mm_sqrt_ps(_mm_add_ps(length, _mm_mul_ps(pz, pz)));
+
+            // Scaling a zero vector by zero, rather than by the infinite reciprocal of its
+            // length, keeps it zero.
+            const __m128 scale = _mm_and_ps(_mm_cmpgt_ps(length, zero), _mm_div_ps(one, length));
+            _mm_storeu_ps(vx + i, _mm_mul_ps(px, scale));
+            _mm_storeu_ps(vy + i, _mm_mul_ps(py, scale));
+            _mm_storeu_ps(vz + i, _mm_mul_ps(pz, scale));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const float length = std::sqrt(vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i]);
+            if (length > 0.0f)
+            {
+                const float scale = 1.0f / length;
+                vx[i] *= scale;
+                vy[i] *= scale;
+                vz[i] *= scale;
+            }
+        }
+    }
+
+
+    /**
+     * \param minimum  Set to the smallest of each component.
+     * \param maximum  Set to the largest of each component.
+     * \return False, leaving the bounds unchanged, if the array is empty.
+     */
+    bool Vector3SoA::computeBound(Vector3f& minimum, Vector3f& maximum) const
+    {
+        const int count = size();
+        if (count == 0)
+        {
+            return false;
+        }
+
+        const float* streams[3] = { x(), y(), z() };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float* values = streams[axis];
+            float lowest = values[0];
+            float highest = values[0];
+
+            int i = 0;
+#ifdef GLDEMO_SOA_SSE2
+            if (count >= 4)
+            {
+                __m128 low = _mm_loadu_ps(values);
+                __m128 high = low;
+                for (i = 4; i + 4 <= count; i += 4)
+                {
+                    const __m128 v = _mm_loadu_ps(values + i);
+                    low = _mm_min_ps(low, v);
+                    high = _mm_max_ps(high, v);
+                }
+
+                float lows[4];
+                float highs[4];
+                _mm_storeu_ps(lows, low);
+                _mm_storeu_ps(highs, high);
+                lowest = std::min(std::min(lows[0], lows[1]), std::min(lows[2], lows[3]));
+                highest = std::max(std::max(highs[0], highs[1]), std::max(highs[2], highs[3]));
+            }
+#endif
+            for (; i < count; ++i)
+            {
+                lowest = std::min(lowest, values[i]);
+                highest = std::max(highest, values[i]);
+            }
+
+            minimum[axis] = lowest;
+            maximum[axis] = highest;
+        }
+        return true;
+    }
+
+}
@@ -0,0 +1,67 @@
+#ifndef GLDEMO_VECTOR3SOA_H
+#define GLDEMO_VECTOR3SOA_H
+
+#include <cstddef>
+#include <vector>
+
+#include "matrix3.h"
+#include "matrix4.h"
+#include "vector3.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \brief An array of 3D vectors stored as a structure of arrays: one stream each for
+     *        the x, y and z components.
+     *
+     * Vector3 and Matrix4 work on one vector at a time. Laid out like this instead, a
+     * whole array of points can be transformed, normalized or bounded by kernels that
+     * handle four vectors per instruction with SSE where it is available, and fall back
+     * to plain loops elsewhere. Each kernel has the same results either way, give or take
+     * rounding.
+     *
+     * Outputs may be the same array as the input, to work in place.
+     */
+    class Vector3SoA
+    {
+    public:
+        Vector3SoA();
+        explicit Vector3SoA(int size);
+
+        int   size() const          { return static_cast<int>(m_x.size()); }
+        bool  empty() const         { return m_x.empty(); }
+        void  resize(int size);
+        void  reserve(int size);
+        void  clear();
+
+        const float* x() const      { return m_x.empty() ? 0 : &m_x[0]; }
+        float*       x()            { return m_x.empty() ? 0 : &m_x[0]; }
+        const float* y() const      { return m_y.empty() ? 0 : &m_y[0]; }
+        float*       y()            { return m_y.empty() ? 0 : &m_y[0]; }
+        const float* z() const      { return m_z.empty() ? 0 : &m_z[0]; }
+        float*       z()            { return m_z.empty() ? 0 : &m_z[0]; }
+
+        Vector3f get(int i) const   { return Vector3f(m_x[i], m_y[i], m_z[i]); }
+        void     set(int i, const Vector3f& v) { m_x[i] = v.x(); m_y[i] = v.y(); m_z[i] = v.z(); }
+        void     push_back(const Vector3f& v);
+
+        void gather(const Vector3f* first, int count, std::size_t stride = sizeof(Vector3f));
+        void scatter(Vector3f* first, std::size_t stride = sizeof(Vector3f)) const;
+
+        // Batch kernels
+        void transformPoints(const Matrix4f& m, Vector3SoA& out) const;
+        void transformPoints(const Matrix4f& m, Vector3SoA& out, std::vector<float>& w) const;
+        void transformVectors(const Matrix3f& m, Vector3SoA& out) const;
+        void normalize();
+        bool computeBound(Vector3f& minimum, Vector3f& maximum) const;
+
+    private:
+        std::vector<float> m_x;
+        std::vector<float> m_y;
+        std::vector<float> m_z;
+    };
+
+}
+
+#endif
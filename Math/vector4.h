@@ -18,19 +18,20 @@ namespace GLDemo
        typedef VectorN<Vector4<Real>, Real, 4> VectorBase;
 
     public:
-        Vector4();
-        Vector4(const Real v[]);
-        Vector4(const Real& x, const Real& y, const Real& z, const Real& w);
+        constexpr Vector4();
+        explicit Vector4(UninitializedTag) : VectorBase(Uninitialized) {}
+        constexpr Vector4(const Real v[]);
+        constexpr Vector4(const Real& x, const Real& y, const Real& z, const Real& w);
 
         //Access Operations
-        Real  x() const { return VectorBase::operator[](0); }
-        Real& x()       { return VectorBase::operator[](0); }
-        Real  y() const { return VectorBase::operator[](1); }
-        Real& y()       { return VectorBase::operator[](1); }
-        Real  z() const { return VectorBase::operator[](2); }
-        Real& z()       { return VectorBase::operator[](2); }
-        Real  w() const { return VectorBase::operator[](3); }
-        Real& w()       { return VectorBase::operator[](3); }
+        constexpr Real  x() const { return VectorBase::operator[](0); }
+        constexpr Real& x()       { return VectorBase::operator[](0); }
+        constexpr Real  y() const { return VectorBase::operator[](1); }
+        constexpr Real& y()       { return VectorBase::operator[](1); }
+        constexpr Real  z() const { return VectorBase::operator[](2); }
+        constexpr Real& z()       { return VectorBase::operator[](2); }
+        constexpr Real  w() const { return VectorBase::operator[](3); }
+        constexpr Real& w()       { return VectorBase::operator[](3); }
 
         //Geometric Operations Specific to 3D
         Vector4 cross(const Vector4& v) const;
@@ -44,21 +45,21 @@ namespace GLDemo
 
 
     template<class Real>
-    Vector4<Real>::Vector4() :
+    constexpr Vector4<Real>::Vector4() :
         VectorBase()
     {
     }
 
 
     template<class Real>
-    Vector4<Real>::Vector4(const Real v[]) :
+    constexpr Vector4<Real>::Vector4(const Real v[]) :
         VectorBase(v)
     {
     }
 
 
     template<class Real>
-    Vector4<Real>::Vector4(const Real& vx, const Real& vy, const Real& vz, const Real& vw) :
+    constexpr Vector4<Real>::Vector4(const Real& vx, const Real& vy, const Real& vz, const Real& vw) :
         VectorBase()
     {
         x() = vx;
@@ -1,8 +1,9 @@
 #ifndef GLDEMO_VECTORN_H
 #define GLDEMO_VECTORN_H
 
-#include <iostream>
 #include <cassert>
+#include <cstring>
+#include <iostream>
 
 #include "mathdefs.h"
 
@@ -14,17 +15,23 @@ namespace GLDemo
      * used with any numeric type. It also implements the Curiously Recurring Template Pattern,
      * in order to allow specific types (Vector2 / Vector3 etc) to inherit from this class without
      * having to define general vector arithmetic or virtual functions.
+     *
+     * Vectors are trivially copyable, so arrays of them (and of classes made of them, such as
+     * Vertex) can be copied and reallocated as raw memory. Construction and arithmetic are
+     * constexpr, so vectors built from constants are computed at compile time.
      */
     template<class Derived, class Real, int N>
     class VectorN
     {
     public:
-        VectorN();
-        VectorN(const VectorN& v);
-        VectorN(const Real* v);
+        constexpr VectorN();
+        explicit VectorN(UninitializedTag) {}
+        constexpr VectorN(const Real* v);
+
+        static constexpr Derived zero() { return Derived(); }
 
-        Real  operator[](int i) const { assert(i < N); return m_components[i]; }
-        Real& operator[](int i)       { assert(i < N); return m_components[i]; }
+        constexpr Real  operator[](int i) const { assert(i < N); return m_components[i]; }
+        constexpr Real& operator[](int i)       { assert(i < N); return m_components[i]; }
 
         Real*       toPointer()       { return (Real*)this; }
         const Real* toPointer() const { return (Real*)this; }
@@ -38,23 +45,21 @@ namespace GLDemo
         bool operator!= (const Derived& v) const;
 
         //Algebraic Operations
-        Derived operator+ (const Derived& v) const;
-        Derived operator- (const Derived& v) const;
-        Derived operator* (const Real& s) const;
-        Derived operator/ (const Real& s) const;
-        Derived operator- () const;
+        constexpr Derived operator+ (const Derived& v) const;
+        constexpr Derived operator- (const Derived& v) const;
+        constexpr Derived operator* (const Real& s) const;
+        constexpr Derived operator/ (const Real& s) const;
+        constexpr Derived operator- () const;
 
-        Derived& operator+= (const Derived& v);
-        Derived& operator-= (const Derived& v);
-        Derived& operator*= (const Real& s);
-        Derived& operator/= (const Real& s);
-
-        Derived& operator= (const Derived& v);
+        constexpr Derived& operator+= (const Derived& v);
+        constexpr Derived& operator-= (const Derived& v);
+        constexpr Derived& operator*= (const Real& s);
+        constexpr Derived& operator/= (const Real& s);
 
         //Geometric Operations
         Real length() const;
         Real squaredLength() const;
-        Real dot(const VectorN& v) const;
+        constexpr Real dot(const VectorN& v) const;
         Real normalize();
 
         Real scalarProjection(const VectorN& v) const;
@@ -63,7 +68,7 @@ namespace GLDemo
 
         void    toZero();
 
-        friend Derived operator* (const Real& s, const Derived& v) { return v * s; }
+        friend constexpr Derived operator* (const Real& s, const Derived& v) { return v * s; }
         friend std::ostream& operator<<(std::ostream& stream, const Derived& v)
         {
             stream << "{ ";
@@ -79,24 +84,24 @@ namespace GLDemo
     };
 
 
+    /**
+     * Creates a zero vector.
+     */
     template<class Derived, class Real, int N>
-    VectorN<Derived, Real, N>::VectorN()
-    {
-        std::memset(m_components, 0, sizeof(Real) * N);
-    }
-
-
-    template<class Derived, class Real, int N>
-    VectorN<Derived, Real, N>::VectorN(const VectorN& v)
+    constexpr VectorN<Derived, Real, N>::VectorN() :
+        m_components()
     {
-        std::memcpy(m_components, v.toPointer(), sizeof(Real) * N);
     }
 
 
     template<class Derived, class Real, int N>
-    VectorN<Derived, Real, N>::VectorN(const Real v[])
+    constexpr VectorN<Derived, Real, N>::VectorN(const Real v[]) :
+        m_components()
     {
-        std::memcpy(m_components, v, sizeof(Real) * N);
+        for (int i = 0; i < N; ++i)
+        {
+            m_components[i] = v[i];
+        }
     }
 
 
@@ -168,67 +173,67 @@ namespace GLDemo
 
 
     template<class Derived, class Real, int N>
-    inline Derived VectorN<Derived, Real, N>::operator+ (const Derived& v) const
+    constexpr Derived VectorN<Derived, Real, N>::operator+ (const Derived& v) const
     {
-        Real result[N];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < N; ++i)
         {
-            result[i] = m_components[i] + v[i];
+            result[i] += v[i];
         }
 
-        return Derived(result);
+        return result;
     }
 
 
     template<class Derived, class Real, int N>
-    inline Derived VectorN<Derived, Real, N>::operator- (const Derived& v) const
+    constexpr Derived VectorN<Derived, Real, N>::operator- (const Derived& v) const
     {
-        Real result[N];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < N; ++i)
         {
-            result[i] = m_components[i] - v[i];
+            result[i] -= v[i];
         }
 
-        return Derived(result);
+        return result;
     }
 
 
     template<class Derived, class Real, int N>
-    inline Derived VectorN<Derived, Real, N>::operator* (const Real& s) const
+    constexpr Derived VectorN<Derived, Real, N>::operator* (const Real& s) const
     {
-        Real result[N];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < N; ++i)
         {
-            result[i] = m_components[i] * s;
+            result[i] *= s;
         }
 
-        return Derived(result);
+        return result;
     }
 
 
     template<class Derived, class Real, int N>
-    inline Derived VectorN<Derived, Real, N>::operator/ (const Real& s) const
+    constexpr Derived VectorN<Derived, Real, N>::operator/ (const Real& s) const
     {
-        Real result[N];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < N; ++i)
         {
-            result[i] = m_components[i] / s;
+            result[i] /= s;
         }
 
-        return Derived(result);
+        return result;
     }
 
 
     template<class Derived, class Real, int N>
-    inline Derived VectorN<Derived, Real, N>::operator- () const
+    constexpr Derived VectorN<Derived, Real, N>::operator- () const
     {
-        Real result[N];
+        Derived result(static_cast<const Derived&>(*this));
         for (int i = 0; i < N; ++i)
         {
-            result[i] = -m_components[i];
+            result[i] = -result[i];
         }
 
-        return Derived(result);
+        return result;
     }
 
 
@@ -236,7 +241,7 @@ namespace GLDemo
 
 
     template<class Derived, class Real, int N>
-    inline Derived& VectorN<Derived, Real, N>::operator+= (const Derived& v)
+    constexpr Derived& VectorN<Derived, Real, N>::operator+= (const Derived& v)
     {
         for (int i = 0; i < N; ++i)
         {
@@ -248,7 +253,7 @@ namespace GLDemo
 
 
     template<class Derived, class Real, int N>
-    inline Derived& VectorN<Derived, Real, N>::operator-= (const Derived& v)
+    constexpr Derived& VectorN<Derived, Real, N>::operator-= (const Derived& v)
     {
         for (int i = 0; i < N; ++i)
         {
@@ -260,7 +265,7 @@ namespace GLDemo
 
 
     template<class Derived, class Real, int N>
-    inline Derived& VectorN<Derived, Real, N>::operator*= (const Real& s)
+    constexpr Derived& VectorN<Derived, Real, N>::operator*= (const Real& s)
     {
         for (int i = 0; i < N; ++i)
         {
@@ -272,7 +277,7 @@ namespace GLDemo
 
 
     template<class Derived, class Real, int N>
-    inline Derived& VectorN<Derived, Real, N>::operator/= (const Real& s)
+    constexpr Derived& VectorN<Derived, Real, N>::operator/= (const Real& s)
     {
         for (int i = 0; i < N; ++i)
         {
@@ -283,18 +288,6 @@ namespace GLDemo
     }
 
 
-    template<class Derived, class Real, int N>
-    inline Derived& VectorN<Derived, Real, N>::operator= (const Derived& v)
-    {
-        for (int i = 0; i < N; ++i)
-        {
-            m_components[i] = v.m_components[i];
-        }
-
-        return *static_cast<Derived*>(this);
-    }
-
-
     template<class Derived, class Real, int N>
     inline Real VectorN<Derived, Real, N>::length() const
     {
@@ -320,7 +313,7 @@ namespace GLDemo
 
 
     template<class Derived, class Real, int N>
-    inline Real VectorN<Derived, Real, N>::dot(const VectorN& v) const
+    constexpr Real VectorN<Derived, Real, N>::dot(const VectorN& v) const
     {
         Real total = m_components[0] * v[0];
         for (int i = 1; i < N; ++i)
@@ -372,7 +365,7 @@ namespace GLDemo
     template<class Derived, class Real, int N>
     void VectorN<Derived, Real, N>::toZero()
     {
-        memset(m_components, 0, sizeof(Real) * N);
+        std::memset(m_components, 0, sizeof(Real) * N);
     }
 
 
@@ -0,0 +1,118 @@
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Math/matrix4.h"
+#include "Scene/boundingbox.h"
+#include "Scene/cubemesh.h"
+#include "Renderer/occlusionbuffer.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestOcclusionBuffer : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        /**
+         * Returns the world matrix of a cube flattened into a wall facing the camera.
+         */
+        static Matrix4f wall(float halfSize, float z)
+        {
+            Matrix4f m;
+            m.toIdentity();
+            m(0,0) = halfSize;
+            m(1,1) = halfSize;
+            m(2,2) = 0.01f;
+            m(2,3) = z;
+            return m;
+        }
+
+        PtrMesh  m_cube;
+        Matrix4f m_proj;
+
+    private slots:
+        /**
+         * Initiate the test case
+         */
+        void initTestCase()
+        {
+            m_cube = PtrMesh(new CubeMesh("Occluder"));
+            m_proj.makePerspectiveProjectionFOV(90.0f, 1.0f, 1.0f, 100.0f);
+        }
+
+
+        /**
+         *
+         */
+        void testEmpty()
+        {
+            OcclusionBuffer buffer(64, 64);
+            buffer.begin(m_proj, OcclusionBuffer::OccluderList());
+            buffer.wait();
+            QVERIFY(buffer.getDepth(32, 32) == 1.0f);
+            QVERIFY(!buffer.isOccluded(BoundingBox(Vector3f(-1.0f, -1.0f, -12.0f), Vector3f(1.0f, 1.0f, -10.0f))));
+        }
+
+
+        /**
+         *
+         */
+        void testWall()
+        {
+            OcclusionBuffer buffer(64, 64);
+            OcclusionBuffer::OccluderList occluders;
+            occluders.push_back(OcclusionBuffer::Occluder(m_cube.data(), wall(2.0f, -5.0f)));
+            buffer.begin(m_proj, occluders);
+            buffer.wait();
+
+            // Only boxes entirely behind the wall, within its outline, are occluded.
+            QVERIFY(buffer.isOccluded(BoundingBox(Vector3f(-0.5f, -0.5f, -12.0f), Vector3f(0.5f, 0.5f, -10.0f))));
+            QVERIFY(!buffer.isOccluded(BoundingBox(Vector3f(-0.5f, -0.5f, -4.0f), Vector3f(0.5f, 0.5f, -3.0f))));
+            QVERIFY(!buffer.isOccluded(BoundingBox(Vector3f(-5.0f, -5.0f, -12.0f), Vector3f(5.0f, 5.0f, -10.0f))));
+            QVERIFY(!buffer.isOccluded(BoundingBox(Vector3f(30.0f, -1.0f, -40.0f), Vector3f(32.0f, 1.0f, -38.0f))));
+
+            // Boxes crossing the near plane are never occluded.
+            QVERIFY(!buffer.isOccluded(BoundingBox(Vector3f(-0.5f, -0.5f, -12.0f), Vector3f(0.5f, 0.5f, 1.0f))));
+        }
+
+
+        /**
+         *
+         */
+        void testNearPlaneClipping()
+        {
+            // A floor running from behind the camera into the distance.
+            Matrix4f floor;
+            floor.toIdentity();
+            floor(0,0) = 10.0f;
+            floor(1,1) = 0.01f;
+            floor(2,2) = 10.0f;
+            floor(1,3) = -1.0f;
+
+            OcclusionBuffer buffer(64, 64);
+            OcclusionBuffer::OccluderList occluders;
+            occluders.push_back(OcclusionBuffer::Occluder(m_cube.data(), floor));
+            buffer.begin(m_proj, occluders);
+            buffer.wait();
+
+            QVERIFY(buffer.isOccluded(BoundingBox(Vector3f(-1.0f, -5.0f, -8.0f), Vector3f(1.0f, -3.0f, -6.0f))));
+            QVERIFY(!buffer.isOccluded(BoundingBox(Vector3f(-1.0f, 1.0f, -8.0f), Vector3f(1.0f, 2.0f, -6.0f))));
+
+            // Entirely behind the near plane, the wall leaves the buffer empty.
+            occluders[0] = OcclusionBuffer::Occluder(m_cube.data(), wall(10.0f, 0.0f));
+            buffer.begin(m_proj, occluders);
+            buffer.wait();
+            QVERIFY(buffer.getDepth(32, 32) == 1.0f);
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestOcclusionBuffer)
+#include "test_occlusionbuffer.moc"
@@ -0,0 +1,165 @@
+#include "depthshader.h"
+#include "glutils.h"
+
+namespace GLDemo
+{
+    DepthShader::DepthShader() :
+        Shader(),
+        m_failed(false),
+        m_foundUniforms(false),
+        m_locMatWorldViewProj(-1),
+        m_indirectProgram(),
+        m_indirectFailed(false),
+        m_locIndirectDrawOffset(-1)
+    {
+    }
+
+
+    DepthShader::~DepthShader()
+    {
+    }
+
+
+    /**
+     * Binds the program, waiting for it if it is still being built.
+     */
+    bool DepthShader::activate(const Matrix4f& view)
+    {
+        Q_UNUSED(view);
+
+        if (!m_foundUniforms)
+        {
+            if (!prepare() || !waitForProgram(m_program) || !isReady())
+            {
+                m_failed = true;
+                return false;
+            }
+        }
+
+        m_program->bind();
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * Starts building the program in the background.
+     */
+    bool DepthShader::prepare()
+    {
+        if (m_failed)
+        {
+            return false;
+        }
+
+        if (!m_program)
+        {
+            initializeGLFunctions();
+            if (!beginCompileAndLink(m_program, ":/shaders/depthshader.vert", ":/shaders/depthshader.frag"))
+            {
+                m_failed = true;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    /**
+     *
+     */
+    bool DepthShader::isReady()
+    {
+        if (m_foundUniforms)
+        {
+            return true;
+        }
+
+        if (!m_program || m_failed)
+        {
+            return false;
+        }
+
+        switch (getProgramStatus(m_program))
+        {
+        case ProgramPending:
+            return false;
+        case ProgramLinked:
+            m_locMatWorldViewProj = m_program->uniformLocation("matWorldViewProj");
+            m_foundUniforms = true;
+            return true;
+        default:
+            m_failed = true;
+            return false;
+        }
+    }
+
+
+    /**
+     *
+     */
+    void DepthShader::programsReloaded()
+    {
+        m_failed = false;
+        m_foundUniforms = false;
+        isReady();
+
+        if (m_indirectProgram)
+        {
+            m_indirectFailed = false;
+            m_locIndirectDrawOffset = m_indirectProgram->uniformLocation("drawOffset");
+        }
+    }
+
+
+    /**
+     * Depth doesn't depend on the material, so there is nothing to set.
+     */
+    bool DepthShader::setMaterial(const Material&)
+    {
+        return true;
+    }
+
+
+    /**
+     * \pre The shader must be active.
+     */
+    bool DepthShader::setTransforms(const Matrix4f&, const Matrix4f&, const Matrix4f& worldViewProj)
+    {
+        glUniformMatrix4fv(m_locMatWorldViewProj, 1, false, worldViewProj.toPointer());
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * Binds the indirect variant of the program, compiling it the first time it is needed.
+     */
+    bool DepthShader::activateIndirect(const Matrix4f& view, int firstDraw)
+    {
+        Q_UNUSED(view);
+
+        if (!m_indirectProgram)
+        {
+            if (m_indirectFailed)
+            {
+                return false;
+            }
+
+            initializeGLFunctions();
+
+            if (!compileAndLink(m_indirectProgram, ":/shaders/depthshader_indirect.vert", ":/shaders/depthshader_indirect.frag"))
+            {
+                m_indirectProgram.clear();
+                m_indirectFailed = true;
+                return false;
+            }
+
+            m_locIndirectDrawOffset = m_indirectProgram->uniformLocation("drawOffset");
+        }
+
+        m_indirectProgram->bind();
+        m_indirectProgram->setUniformValue(m_locIndirectDrawOffset, firstDraw);
+        return GL_GOOD_STATE();
+    }
+
+}
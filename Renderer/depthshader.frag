@@ -0,0 +1,7 @@
+#version 120
+
+void main()
+{
+    // Color writes are disabled during the depth pre-pass, so only the depth test matters.
+    gl_FragColor = vec4(0.0);
+}
@@ -0,0 +1,50 @@
+#ifndef GLDEMO_DEPTHSHADER_H
+#define GLDEMO_DEPTHSHADER_H
+
+#include <QGLShaderProgram>
+#include <QGLFunctions>
+
+#include "shader.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \brief Draws only the depth of a model, for the renderer's depth pre-pass.
+     *
+     * Ignores materials, and of the transforms only uses the world-view-projection matrix.
+     */
+    class DepthShader : public Shader, protected QGLFunctions
+    {
+    public:
+        DepthShader();
+        ~DepthShader();
+
+        virtual bool activate(const Matrix4f& view);
+        virtual bool setMaterial(const Material& material);
+        virtual bool setTransforms(const Matrix4f& worldView,
+                                   const Matrix4f& worldViewInvTranspose,
+                                   const Matrix4f& worldViewProj);
+        virtual bool activateIndirect(const Matrix4f& view, int firstDraw);
+        virtual bool prepare();
+        virtual bool isReady();
+
+    protected:
+        virtual void programsReloaded();
+
+    private:
+        bool m_failed;
+        bool m_foundUniforms;
+        int  m_locMatWorldViewProj;
+
+        PtrShaderProgram  m_indirectProgram;
+        bool              m_indirectFailed;
+        int               m_locIndirectDrawOffset;
+
+        DepthShader(const DepthShader&);
+        DepthShader& operator=(const DepthShader&);
+    };
+
+}
+
+#endif
@@ -0,0 +1,17 @@
+#version 120
+
+/**
+ * Transforms positions only, for drawing depth without color. gl_Position must be
+ * computed exactly as in the shaders of the main pass, so that both passes produce the
+ * same depth for the same surface.
+ */
+invariant gl_Position;
+
+uniform mat4 matWorldViewProj;
+
+attribute vec4 vertPosition;
+
+void main()
+{
+    gl_Position = matWorldViewProj * vertPosition;
+}
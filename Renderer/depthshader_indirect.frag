@@ -0,0 +1,8 @@
+#version 430
+
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = vec4(0.0);
+}
@@ -0,0 +1,30 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+/**
+ * Variant of depthshader.vert for multi-draw indirect submission, reading the transform
+ * of each draw from the per-draw storage buffer like lambertshader_indirect.vert.
+ */
+invariant gl_Position;
+
+struct DrawData
+{
+    mat4 matWorldView;
+    mat4 matWorldViewInvTranspose;
+    mat4 matWorldViewProj;
+    int  materialIndex;
+};
+
+layout(std430, binding = 0) readonly buffer PerDrawData
+{
+    DrawData draws[];
+};
+
+uniform int drawOffset;
+
+in vec4 vertPosition;
+
+void main()
+{
+    gl_Position = draws[drawOffset + gl_DrawIDARB].matWorldViewProj * vertPosition;
+}
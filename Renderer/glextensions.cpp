@@ -0,0 +1,328 @@
+#include <cassert>
+#include <cctype>
+#include <iostream>
+
+#include <QGLContext>
+#include <QString>
+
+#include "glextensions.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        /**
+         * \internal Suffixes tried, in order, when resolving an entry point. The core
+         *           name comes first so that we prefer it whenever the driver has it.
+         */
+        const char* const s_entryPointSuffixes[] = { "", "ARB", "KHR", "EXT", "NV", "APPLE", "OES", 0 };
+    }
+
+
+    /**
+     * Creates an empty set of extension functions. Nothing is usable until
+     * initialize() has been called with a current context.
+     */
+    GLExtensions::GLExtensions() :
+        glGenVertexArrays(0),
+        glBindVertexArray(0),
+        glDeleteVertexArrays(0),
+        glMultiDrawElementsIndirect(0),
+        glBindBufferBase(0),
+        glCopyBufferSubData(0),
+        glDrawRangeElements(0),
+        glPrimitiveRestartIndex(0),
+        glGetProgramBinary(0),
+        glProgramBinary(0),
+        glProgramParameteri(0),
+        glMaxShaderCompilerThreads(0),
+        glGenQueries(0),
+        glDeleteQueries(0),
+        glBeginQuery(0),
+        glEndQuery(0),
+        glGetQueryObjectuiv(0),
+        glBeginConditionalRender(0),
+        glEndConditionalRender(0),
+        glMapBufferRange(0),
+        glUnmapBuffer(0),
+        glClearBufferuiv(0),
+        glFenceSync(0),
+        glGetSynciv(0),
+        glDeleteSync(0),
+        m_extensions(),
+        m_majorVersion(0),
+        m_minorVersion(0),
+        m_hasVertexArrayObjects(false),
+        m_hasMultiDrawIndirect(false),
+        m_hasFixedIndexRestart(false),
+        m_hasProgramBinary(false),
+        m_occlusionQueryTarget(0),
+        m_hasAsyncReadback(false)
+    {
+    }
+
+
+    /**
+     * \param context The context to resolve the functions from. Must be current.
+     * \return True if the context could be queried. Individual features may still be
+     *         unavailable; check the relevant has*() function before using them.
+     */
+    bool GLExtensions::initialize(const QGLContext* context)
+    {
+        if (!context)
+        {
+            std::cout << "ERROR: Cannot resolve OpenGL extensions without a current context." << std::endl;
+            return false;
+        }
+
+        readVersion();
+        readExtensions(context);
+
+        m_hasVertexArrayObjects = isVersionAtLeast(3, 0) ||
+                                  hasExtension("GL_ARB_vertex_array_object") ||
+                                  hasExtension("GL_APPLE_vertex_array_object") ||
+                                  hasExtension("GL_OES_vertex_array_object");
+        if (m_hasVertexArrayObjects)
+        {
+            glGenVertexArrays    = reinterpret_cast<PFNGLGENVERTEXARRAYSPROC>(resolve(context, "glGenVertexArrays"));
+            glBindVertexArray    = reinterpret_cast<PFNGLBINDVERTEXARRAYPROC>(resolve(context, "glBindVertexArray"));
+            glDeleteVertexArrays = reinterpret_cast<PFNGLDELETEVERTEXARRAYSPROC>(resolve(context, "glDeleteVertexArrays"));
+            m_hasVertexArrayObjects = glGenVertexArrays && glBindVertexArray && glDeleteVertexArrays;
+        }
+
+        // Indirect submission reads per-draw data from a storage buffer indexed by gl_DrawID,
+        // which needs shader draw parameters on top of GL 4.3 (or the equivalent extensions).
+        m_hasMultiDrawIndirect = m_hasVertexArrayObjects &&
+                                 hasExtension("GL_ARB_shader_draw_parameters") &&
+                                 (isVersionAtLeast(4, 3) ||
+                                  (hasExtension("GL_ARB_multi_draw_indirect") &&
+                                   hasExtension("GL_ARB_shader_storage_buffer_object") &&
+                                   hasExtension("GL_ARB_copy_buffer")));
+        if (m_hasMultiDrawIndirect)
+        {
+            glMultiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(resolve(context, "glMultiDrawElementsIndirect"));
+            glBindBufferBase            = reinterpret_cast<PFNGLBINDBUFFERBASEPROC>(resolve(context, "glBindBufferBase"));
+            glCopyBufferSubData         = reinterpret_cast<PFNGLCOPYBUFFERSUBDATAPROC>(resolve(context, "glCopyBufferSubData"));
+            m_hasMultiDrawIndirect = glMultiDrawElementsIndirect && glBindBufferBase && glCopyBufferSubData;
+        }
+
+        // Windows only exports GL 1.1 directly, so even this long-standing entry point is resolved.
+        glDrawRangeElements = 0;
+        if (isVersionAtLeast(1, 2) || hasExtension("GL_EXT_draw_range_elements"))
+        {
+            glDrawRangeElements = reinterpret_cast<PFNGLDRAWRANGEELEMENTSPROC>(resolve(context, "glDrawRangeElements"));
+        }
+
+        // Prefer the fixed restart index (GL 4.3, ES 3.0), which needs no extra state.
+        m_hasFixedIndexRestart = isVersionAtLeast(4, 3) || hasExtension("GL_ARB_ES3_compatibility");
+        glPrimitiveRestartIndex = 0;
+        if (!m_hasFixedIndexRestart && isVersionAtLeast(3, 1))
+        {
+            glPrimitiveRestartIndex = reinterpret_cast<PFNGLPRIMITIVERESTARTINDEXPROC>(resolve(context, "glPrimitiveRestartIndex"));
+        }
+
+        // Drivers may support program binaries but offer no formats to store them in.
+        m_hasProgramBinary = isVersionAtLeast(4, 1) ||
+                             hasExtension("GL_ARB_get_program_binary") ||
+                             hasExtension("GL_OES_get_program_binary");
+        if (m_hasProgramBinary)
+        {
+            GLint numFormats = 0;
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+            glGetProgramBinary  = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(resolve(context, "glGetProgramBinary"));
+            glProgramBinary     = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(resolve(context, "glProgramBinary"));
+            glProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(resolve(context, "glProgramParameteri"));
+            m_hasProgramBinary = numFormats > 0 && glGetProgramBinary && glProgramBinary;
+        }
+
+        glMaxShaderCompilerThreads = 0;
+        if (hasExtension("GL_KHR_parallel_shader_compile") || hasExtension("GL_ARB_parallel_shader_compile"))
+        {
+            glMaxShaderCompilerThreads = reinterpret_cast<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(resolve(context, "glMaxShaderCompilerThreads"));
+        }
+
+        // Boolean queries are preferred; sample counts are all that older contexts offer.
+        m_occlusionQueryTarget = 0;
+        if (isVersionAtLeast(3, 3) || hasExtension("GL_ARB_occlusion_query2") || hasExtension("GL_EXT_occlusion_query_boolean"))
+        {
+            m_occlusionQueryTarget = GL_ANY_SAMPLES_PASSED;
+        }
+        else if (isVersionAtLeast(1, 5) || hasExtension("GL_ARB_occlusion_query"))
+        {
+            m_occlusionQueryTarget = GL_SAMPLES_PASSED;
+        }
+        if (m_occlusionQueryTarget)
+        {
+            glGenQueries        = reinterpret_cast<PFNGLGENQUERIESPROC>(resolve(context, "glGenQueries"));
+            glDeleteQueries     = reinterpret_cast<PFNGLDELETEQUERIESPROC>(resolve(context, "glDeleteQueries"));
+            glBeginQuery        = reinterpret_cast<PFNGLBEGINQUERYPROC>(resolve(context, "glBeginQuery"));
+            glEndQuery          = reinterpret_cast<PFNGLENDQUERYPROC>(resolve(context, "glEndQuery"));
+            glGetQueryObjectuiv = reinterpret_cast<PFNGLGETQUERYOBJECTUIVPROC>(resolve(context, "glGetQueryObjectuiv"));
+            if (!glGenQueries || !glDeleteQueries || !glBeginQuery || !glEndQuery || !glGetQueryObjectuiv)
+            {
+                m_occlusionQueryTarget = 0;
+            }
+        }
+
+        glBeginConditionalRender = 0;
+        glEndConditionalRender = 0;
+        if (m_occlusionQueryTarget && (isVersionAtLeast(3, 0) || hasExtension("GL_NV_conditional_render")))
+        {
+            glBeginConditionalRender = reinterpret_cast<PFNGLBEGINCONDITIONALRENDERPROC>(resolve(context, "glBeginConditionalRender"));
+            glEndConditionalRender   = reinterpret_cast<PFNGLENDCONDITIONALRENDERPROC>(resolve(context, "glEndConditionalRender"));
+            if (!glEndConditionalRender)
+            {
+                glBeginConditionalRender = 0;
+            }
+        }
+
+        m_hasAsyncReadback = isVersionAtLeast(3, 2) || (isVersionAtLeast(3, 0) && hasExtension("GL_ARB_sync"));
+        if (m_hasAsyncReadback)
+        {
+            glMapBufferRange = reinterpret_cast<PFNGLMAPBUFFERRANGEPROC>(resolve(context, "glMapBufferRange"));
+            glUnmapBuffer    = reinterpret_cast<PFNGLUNMAPBUFFERPROC>(resolve(context, "glUnmapBuffer"));
+            glClearBufferuiv = reinterpret_cast<PFNGLCLEARBUFFERUIVPROC>(resolve(context, "glClearBufferuiv"));
+            glFenceSync      = reinterpret_cast<PFNGLFENCESYNCPROC>(resolve(context, "glFenceSync"));
+            glGetSynciv      = reinterpret_cast<PFNGLGETSYNCIVPROC>(resolve(context, "glGetSynciv"));
+            glDeleteSync     = reinterpret_cast<PFNGLDELETESYNCPROC>(resolve(context, "glDeleteSync"));
+            m_hasAsyncReadback = glMapBufferRange && glUnmapBuffer && glClearBufferuiv &&
+                                 glFenceSync && glGetSynciv && glDeleteSync;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * \param index The index value that should restart strips. Must be 0xFFFFFFFF, the
+     *              fixed restart index for unsigned int indices, on contexts that only
+     *              support fixed index restart.
+     * \pre hasPrimitiveRestart() must be true and the context must be current.
+     */
+    void GLExtensions::enablePrimitiveRestart(GLuint index)
+    {
+        if (m_hasFixedIndexRestart)
+        {
+            assert(index == 0xFFFFFFFFu);
+            glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        }
+        else
+        {
+            glEnable(GL_PRIMITIVE_RESTART);
+            glPrimitiveRestartIndex(index);
+        }
+    }
+
+
+    /**
+     * \return True if the context version is at least \a major.\a minor.
+     */
+    bool GLExtensions::isVersionAtLeast(int major, int minor) const
+    {
+        return m_majorVersion > major || (m_majorVersion == major && m_minorVersion >= minor);
+    }
+
+
+    /**
+     * \param name The full name of the extension, e.g. "GL_ARB_vertex_array_object".
+     * \return True if the context advertises the extension.
+     */
+    bool GLExtensions::hasExtension(const char* name) const
+    {
+        // The list is stored space-delimited with a leading and trailing space, so
+        // matching the padded name avoids false positives on common prefixes.
+        QByteArray padded(" ");
+        padded.append(name);
+        padded.append(" ");
+        return m_extensions.contains(padded);
+    }
+
+
+    /**
+     * \internal Tries each of the known vendor suffixes in turn, returning the first
+     *           entry point the context knows about, or null if there is none.
+     */
+    void* GLExtensions::resolve(const QGLContext* context, const char* name) const
+    {
+        for (int i = 0; s_entryPointSuffixes[i]; ++i)
+        {
+            void* function = context->getProcAddress(QString(name) + s_entryPointSuffixes[i]);
+            if (function)
+            {
+                return function;
+            }
+        }
+
+        return 0;
+    }
+
+
+    /**
+     * \internal Parses the major and minor version from GL_VERSION. The string starts with
+     *           the version number on desktop GL, but is prefixed with "OpenGL ES " on ES.
+     */
+    void GLExtensions::readVersion()
+    {
+        m_majorVersion = m_minorVersion = 0;
+
+        const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+        if (!version)
+        {
+            return;
+        }
+
+        while (*version && !std::isdigit(static_cast<unsigned char>(*version)))
+        {
+            ++version;
+        }
+        while (std::isdigit(static_cast<unsigned char>(*version)))
+        {
+            m_majorVersion = m_majorVersion * 10 + (*version++ - '0');
+        }
+        if (*version == '.')
+        {
+            ++version;
+            while (std::isdigit(static_cast<unsigned char>(*version)))
+            {
+                m_minorVersion = m_minorVersion * 10 + (*version++ - '0');
+            }
+        }
+    }
+
+
+    /**
+     * \internal Reads the extension list. Core profile contexts no longer accept
+     *           GL_EXTENSIONS in glGetString, so the indexed query is used where it exists.
+     */
+    void GLExtensions::readExtensions(const QGLContext* context)
+    {
+        m_extensions = " ";
+
+        PFNGLGETSTRINGIPROC getStringi = 0;
+        if (isVersionAtLeast(3, 0))
+        {
+            getStringi = reinterpret_cast<PFNGLGETSTRINGIPROC>(context->getProcAddress("glGetStringi"));
+        }
+
+        if (getStringi)
+        {
+            GLint numExtensions = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+            for (GLint i = 0; i < numExtensions; ++i)
+            {
+                m_extensions.append(reinterpret_cast<const char*>(getStringi(GL_EXTENSIONS, i)));
+                m_extensions.append(" ");
+            }
+        }
+        else
+        {
+            const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+            if (extensions)
+            {
+                m_extensions.append(extensions);
+                m_extensions.append(" ");
+            }
+        }
+    }
+
+}
@@ -0,0 +1,116 @@
+#ifndef GLDEMO_GLEXTENSIONS_H
+#define GLDEMO_GLEXTENSIONS_H
+
+#include <QByteArray>
+#include <QGLFunctions>
+
+class QGLContext;
+
+namespace GLDemo
+{
+
+    /**
+     * \brief Resolves the OpenGL entry points that are not exposed by QGLFunctions.
+     *
+     * QGLFunctions only covers the OpenGL ES 2.0 feature set, so anything beyond that
+     * (vertex array objects, for example) must be looked up from the current context.
+     * Each feature is only reported as available if the context version or extension
+     * string advertises it, as some platforms happily return addresses for entry points
+     * the driver does not actually implement.
+     */
+    class GLExtensions
+    {
+    public:
+        GLExtensions();
+
+        bool initialize(const QGLContext* context);
+
+        int  getMajorVersion() const { return m_majorVersion; }
+        int  getMinorVersion() const { return m_minorVersion; }
+        bool isVersionAtLeast(int major, int minor) const;
+        bool hasExtension(const char* name) const;
+
+        bool hasVertexArrayObjects() const  { return m_hasVertexArrayObjects; }
+        bool hasMultiDrawIndirect() const   { return m_hasMultiDrawIndirect; }
+        bool hasDrawRangeElements() const   { return glDrawRangeElements != 0; }
+        bool hasPrimitiveRestart() const    { return m_hasFixedIndexRestart || glPrimitiveRestartIndex != 0; }
+        bool hasProgramBinary() const       { return m_hasProgramBinary; }
+        bool hasParallelShaderCompile() const { return glMaxShaderCompilerThreads != 0; }
+        bool hasOcclusionQueries() const    { return m_occlusionQueryTarget != 0; }
+        bool hasConditionalRender() const   { return glBeginConditionalRender != 0; }
+        bool hasAsyncReadback() const       { return m_hasAsyncReadback; }
+
+        /**
+         * The query target to use for occlusion queries; GL_ANY_SAMPLES_PASSED where
+         * supported, as it lets the driver stop counting at the first sample.
+         */
+        GLenum getOcclusionQueryTarget() const { return m_occlusionQueryTarget; }
+
+        void enablePrimitiveRestart(GLuint index);
+
+        // Vertex array objects (GL 3.0, ARB/APPLE/OES_vertex_array_object)
+        PFNGLGENVERTEXARRAYSPROC     glGenVertexArrays;
+        PFNGLBINDVERTEXARRAYPROC     glBindVertexArray;
+        PFNGLDELETEVERTEXARRAYSPROC  glDeleteVertexArrays;
+
+        // Indirect submission (GL 4.3 + ARB_shader_draw_parameters)
+        PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect;
+        PFNGLBINDBUFFERBASEPROC            glBindBufferBase;
+        PFNGLCOPYBUFFERSUBDATAPROC         glCopyBufferSubData;
+
+        // Range-checked draws (GL 1.2, ES 3.0)
+        PFNGLDRAWRANGEELEMENTSPROC     glDrawRangeElements;
+
+        // Primitive restart with a configurable index (GL 3.1)
+        PFNGLPRIMITIVERESTARTINDEXPROC glPrimitiveRestartIndex;
+
+        // Program binaries (GL 4.1, ARB/OES_get_program_binary)
+        PFNGLGETPROGRAMBINARYPROC   glGetProgramBinary;
+        PFNGLPROGRAMBINARYPROC      glProgramBinary;
+        PFNGLPROGRAMPARAMETERIPROC  glProgramParameteri;
+
+        // Background shader compilation (KHR/ARB_parallel_shader_compile)
+        PFNGLMAXSHADERCOMPILERTHREADSKHRPROC glMaxShaderCompilerThreads;
+
+        // Occlusion queries (GL 1.5, ARB_occlusion_query, EXT_occlusion_query_boolean)
+        PFNGLGENQUERIESPROC         glGenQueries;
+        PFNGLDELETEQUERIESPROC      glDeleteQueries;
+        PFNGLBEGINQUERYPROC         glBeginQuery;
+        PFNGLENDQUERYPROC           glEndQuery;
+        PFNGLGETQUERYOBJECTUIVPROC  glGetQueryObjectuiv;
+
+        // Conditional rendering (GL 3.0, NV_conditional_render)
+        PFNGLBEGINCONDITIONALRENDERPROC glBeginConditionalRender;
+        PFNGLENDCONDITIONALRENDERPROC   glEndConditionalRender;
+
+        // Reading back integer render targets through pixel buffers, without waiting on
+        // the GPU (GL 3.0 + ARB_sync, core in GL 3.2)
+        PFNGLMAPBUFFERRANGEPROC   glMapBufferRange;
+        PFNGLUNMAPBUFFERPROC      glUnmapBuffer;
+        PFNGLCLEARBUFFERUIVPROC   glClearBufferuiv;
+        PFNGLFENCESYNCPROC        glFenceSync;
+        PFNGLGETSYNCIVPROC        glGetSynciv;
+        PFNGLDELETESYNCPROC       glDeleteSync;
+
+    private:
+        void* resolve(const QGLContext* context, const char* name) const;
+        void  readVersion();
+        void  readExtensions(const QGLContext* context);
+
+        QByteArray m_extensions;
+        int        m_majorVersion;
+        int        m_minorVersion;
+        bool       m_hasVertexArrayObjects;
+        bool       m_hasMultiDrawIndirect;
+        bool       m_hasFixedIndexRestart;
+        bool       m_hasProgramBinary;
+        GLenum     m_occlusionQueryTarget;
+        bool       m_hasAsyncReadback;
+
+        GLExtensions(const GLExtensions&);
+        GLExtensions& operator=(const GLExtensions&);
+    };
+
+}
+
+#endif
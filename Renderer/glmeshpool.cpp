@@ -0,0 +1,251 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <list>
+
+#include <QGLContext>
+
+#include "Scene/mesh.h"
+#include "glextensions.h"
+#include "glmeshpool.h"
+#include "glrenderer.h"
+#include "glutils.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        // Initial sizes of the shared buffers. They double whenever they run out of room.
+        const int s_initialVertexCapacity = 64 * 1024;
+        const int s_initialIndexCapacity  = 256 * 1024;
+    }
+
+
+    /**
+     *
+     */
+    GLMeshPool::GLMeshPool() :
+        m_extensions(0),
+        m_vertexArray(0),
+        m_vertexBuffer(0),
+        m_indexBuffer(0),
+        m_numVertices(0),
+        m_numIndices(0),
+        m_vertexCapacity(0),
+        m_indexCapacity(0)
+    {
+    }
+
+
+    /**
+     * \pre The context the pool was initialized with must be current.
+     */
+    GLMeshPool::~GLMeshPool()
+    {
+        if (m_vertexArray)
+        {
+            m_extensions->glDeleteVertexArrays(1, &m_vertexArray);
+        }
+        if (m_vertexBuffer)
+        {
+            glDeleteBuffers(1, &m_vertexBuffer);
+        }
+        if (m_indexBuffer)
+        {
+            glDeleteBuffers(1, &m_indexBuffer);
+        }
+    }
+
+
+    /**
+     * \param extensions The resolved extensions of the current context. Vertex array
+     *                   objects and buffer copies must be supported.
+     * \return True if the shared buffers were created.
+     */
+    bool GLMeshPool::initialize(GLExtensions& extensions)
+    {
+        if (m_vertexArray)
+        {
+            return true;
+        }
+
+        if (!extensions.hasVertexArrayObjects() || !extensions.hasMultiDrawIndirect())
+        {
+            std::cout << "ERROR: The mesh pool requires vertex array objects and buffer copies." << std::endl;
+            return false;
+        }
+
+        initializeGLFunctions();
+        m_extensions = &extensions;
+        m_extensions->glGenVertexArrays(1, &m_vertexArray);
+        return reserve(s_initialVertexCapacity, s_initialIndexCapacity);
+    }
+
+
+    /**
+     * \param mesh        The mesh to copy into the pool.
+     * \param baseVertex  Set to the offset of the mesh's first vertex within the pool.
+     * \param firstIndex  Set to the offset of the mesh's first index within the pool.
+     *
+     * Appends the vertices and the indices of every element list of the mesh, in the
+     * order of Mesh::getElementLists(), so a range of the mesh's own index data can be
+     * located by adding its offset to \a firstIndex.
+     */
+    bool GLMeshPool::addMesh(Mesh& mesh, GLint& baseVertex, GLuint& firstIndex)
+    {
+        assert(m_vertexArray);
+
+        std::vector<Vertex>& vertices = mesh.getVertices();
+        std::list<ElementList>& elementLists = mesh.getElementLists();
+        int numIndices = 0;
+        for (std::list<ElementList>::iterator elIter = elementLists.begin(); elIter != elementLists.end(); ++elIter)
+        {
+            numIndices += elIter->getIndices().size();
+        }
+
+        if (!reserve(m_numVertices + vertices.size(), m_numIndices + numIndices))
+        {
+            return false;
+        }
+
+        baseVertex = m_numVertices;
+        firstIndex = m_numIndices;
+
+        if (!vertices.empty())
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+            glBufferSubData(GL_ARRAY_BUFFER, m_numVertices * sizeof(Vertex), vertices.size() * sizeof(Vertex), &vertices.front());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            m_numVertices += vertices.size();
+        }
+
+        // Write through the copy-write target, so that the element array binding of
+        // whichever vertex array happens to be bound is left alone.
+        glBindBuffer(GL_COPY_WRITE_BUFFER, m_indexBuffer);
+        for (std::list<ElementList>::iterator elIter = elementLists.begin(); elIter != elementLists.end(); ++elIter)
+        {
+            std::vector<unsigned>& indices = elIter->getIndices();
+            if (indices.empty())
+            {
+                continue;
+            }
+
+            glBufferSubData(GL_COPY_WRITE_BUFFER, m_numIndices * sizeof(unsigned), indices.size() * sizeof(unsigned), &indices.front());
+            m_numIndices += indices.size();
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * Binds the vertex array referencing the shared buffers.
+     */
+    void GLMeshPool::bind()
+    {
+        m_extensions->glBindVertexArray(m_vertexArray);
+    }
+
+
+    /**
+     *
+     */
+    void GLMeshPool::release()
+    {
+        m_extensions->glBindVertexArray(0);
+    }
+
+
+    /**
+     * \internal Ensures the buffers can hold at least the requested number of vertices and
+     *           indices, reallocating and copying the existing contents on the GPU if not.
+     */
+    bool GLMeshPool::reserve(int numVertices, int numIndices)
+    {
+        bool changed = false;
+
+        if (numVertices > m_vertexCapacity)
+        {
+            int capacity = std::max(numVertices, std::max(2 * m_vertexCapacity, s_initialVertexCapacity));
+            if (!growBuffer(m_vertexBuffer, m_numVertices * sizeof(Vertex), capacity * sizeof(Vertex)))
+            {
+                return false;
+            }
+            m_vertexCapacity = capacity;
+            changed = true;
+        }
+
+        if (numIndices > m_indexCapacity)
+        {
+            int capacity = std::max(numIndices, std::max(2 * m_indexCapacity, s_initialIndexCapacity));
+            if (!growBuffer(m_indexBuffer, m_numIndices * sizeof(unsigned), capacity * sizeof(unsigned)))
+            {
+                return false;
+            }
+            m_indexCapacity = capacity;
+            changed = true;
+        }
+
+        // The vertex array references buffer names, so it has to be rebuilt after a reallocation.
+        if (changed)
+        {
+            m_extensions->glBindVertexArray(m_vertexArray);
+            bindVertexAttributes();
+            m_extensions->glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * \internal Replaces \a buffer with a new buffer of \a newCapacityBytes, preserving the
+     *           first \a usedBytes of its contents.
+     */
+    bool GLMeshPool::growBuffer(GLuint& buffer, int usedBytes, int newCapacityBytes)
+    {
+        GLuint newBuffer = 0;
+        glGenBuffers(1, &newBuffer);
+        if (!newBuffer)
+        {
+            std::cout << "ERROR: Failed to create mesh pool buffer." << std::endl;
+            return false;
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, newCapacityBytes, 0, GL_STATIC_DRAW);
+
+        if (buffer)
+        {
+            if (usedBytes > 0)
+            {
+                glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+                m_extensions->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            }
+            glDeleteBuffers(1, &buffer);
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        buffer = newBuffer;
+        return true;
+    }
+
+
+    /**
+     * \internal Records the attribute layout and the index buffer into the bound vertex array.
+     */
+    void GLMeshPool::bindVertexAttributes()
+    {
+        int stride = 8 * sizeof(GLfloat);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        glVertexAttribPointer(GLRenderer::Position, 3, GL_FLOAT, false, stride, 0);
+        glVertexAttribPointer(GLRenderer::Normal, 3, GL_FLOAT, false, stride, (GLvoid*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(GLRenderer::Position);
+        glEnableVertexAttribArray(GLRenderer::Normal);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    }
+
+}
@@ -0,0 +1,53 @@
+#ifndef GLDEMO_GLMESHPOOL_H
+#define GLDEMO_GLMESHPOOL_H
+
+#include <QGLFunctions>
+
+namespace GLDemo
+{
+    class GLExtensions;
+    class Mesh;
+
+    /**
+     * \brief A shared vertex and index buffer that static meshes are sub-allocated from.
+     *
+     * Keeping all mesh data in the one pair of buffers means a single vertex array can be
+     * bound for any number of meshes, which is what allows them to be drawn with one
+     * multi-draw call. Meshes keep their own indices; draws add the base vertex returned
+     * from addMesh() when fetching vertices. Allocations are never freed, as meshes are
+     * only ever added to the renderer's cache.
+     */
+    class GLMeshPool : protected QGLFunctions
+    {
+    public:
+        GLMeshPool();
+        ~GLMeshPool();
+
+        bool initialize(GLExtensions& extensions);
+
+        bool addMesh(Mesh& mesh, GLint& baseVertex, GLuint& firstIndex);
+
+        void bind();
+        void release();
+
+    private:
+        bool reserve(int numVertices, int numIndices);
+        bool growBuffer(GLuint& buffer, int usedBytes, int newCapacityBytes);
+        void bindVertexAttributes();
+
+        GLExtensions* m_extensions;
+        GLuint        m_vertexArray;
+        GLuint        m_vertexBuffer;
+        GLuint        m_indexBuffer;
+        int           m_numVertices;
+        int           m_numIndices;
+        int           m_vertexCapacity;
+        int           m_indexCapacity;
+
+        GLMeshPool(const GLMeshPool&);
+        GLMeshPool& operator=(const GLMeshPool&);
+    };
+
+}
+
+#endif
@@ -1,62 +1,358 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <list>
+#include <vector>
 
 #include <QGLFunctions>
 #include <QGLBuffer>
+#include <QGLContext>
 #include <QPaintDevice>
 #include <QSharedPointer>
 #include <QColor>
+#include <QHash>
 #include <QMap>
 
 #include "Scene/transformation.h"
 #include "Scene/camera.h"
+#include "Scene/cubemesh.h"
 #include "Scene/scene.h"
 #include "Scene/mesh.h"
 #include "Scene/meshinstance.h"
 #include "Scene/helpers.h"
 #include "Math/matrix4.h"
+#include "depthshader.h"
 #include "glrenderer.h"
+#include "glextensions.h"
+#include "glmeshpool.h"
 #include "glutils.h"
+#include "idshader.h"
+#include "material.h"
+#include "occlusionbuffer.h"
 #include "shader.h"
+#include "shadercompiler.h"
+#include "shaderreloader.h"
 
 namespace GLDemo
 {
     namespace
     {
+        // Frames between the occlusion queries of an item that was last found visible.
+        const unsigned s_visibleQueryInterval = 4;
+
+        // Frames after which the occlusion query of an item no longer drawn is deleted.
+        const unsigned s_occlusionStateLifetime = 120;
+
+        // A coarser level of detail is only switched to once its error is this fraction of
+        // the threshold, so that instances near the switching distance don't flicker.
+        const float s_lodHysteresis = 0.75f;
+
+        // Frames after which the level of detail of an instance no longer drawn is forgotten.
+        const unsigned s_lodStateLifetime = 120;
+
+        // Width of the CPU occlusion buffer. Its height follows the aspect ratio of the view.
+        const int s_occlusionBufferWidth = 256;
+
         /**
-         * \internal Class representing GL buffer data for a particular element type.
-         *           Used to cache the buffer data associated with a particular mesh.
+         * \internal Class representing a range of a mesh's index buffer holding a
+         *           particular element type. Each ElementList of the mesh maps to one range.
          */
         class IndexBufferData
         {
         public:
-            IndexBufferData(ElementList::ElementType type, const QGLBuffer& buffer, int numIndices) :
+            IndexBufferData(ElementList::ElementType type, size_t offset, int numIndices, GLuint minVertex, GLuint maxVertex) :
                 m_type(type),
-                m_indexData(buffer),
-                m_numIndices(numIndices)
+                m_offset(offset),
+                m_numIndices(numIndices),
+                m_minVertex(minVertex),
+                m_maxVertex(maxVertex)
             {
             }
 
             // Make these public so they can be cheaply accessed from the cache item.
             ElementList::ElementType m_type;
-            QGLBuffer                m_indexData;
+            size_t                   m_offset;      // In bytes from the start of the index buffer
             int                      m_numIndices;
+            GLuint                   m_minVertex;   // Smallest and largest vertex referenced by the range,
+            GLuint                   m_maxVertex;   // passed to the driver as a vertex fetch hint.
         };
 
         typedef std::list<IndexBufferData> IndexDataList;
 
         /**
          * \internal Class for caching GL mesh data once it's been created.
+         *
+         * All element lists of the mesh share a single index buffer so that it can be
+         * captured in the vertex array object along with the attribute bindings. As the
+         * renderer only has a single vertex layout (see GLRenderer::VertexAttributeLocation),
+         * one vertex array per mesh is all that is needed.
          */
         class CachedMesh
         {
         public:
-            CachedMesh(const QString& meshId) : m_meshId(meshId) {}
+            CachedMesh(const Name& meshId) :
+                m_meshId(meshId),
+                m_vertexArray(0),
+                m_clusters(),
+                m_clusterRanges(),
+                m_unclusteredRanges(),
+                m_pooled(false),
+                m_poolBaseVertex(0),
+                m_poolFirstIndex(0)
+            {
+            }
 
             // Make these public so they can be cheaply accessed from the cache item.
-            QString       m_meshId;
+            Name          m_meshId;
             QGLBuffer     m_vertexData;
-            IndexDataList m_indexData;
+            QGLBuffer     m_indexData;
+            IndexDataList m_indexRanges;
+            GLuint        m_vertexArray;    // Zero if vertex array objects are unsupported
+
+            // The clusters of the mesh's triangles, each with its own range, and the ranges
+            // of the element lists that aren't clustered. Only used for culling clusters.
+            MeshClusterList               m_clusters;
+            std::vector<IndexBufferData>  m_clusterRanges;
+            IndexDataList                 m_unclusteredRanges;
+
+            // Location of the mesh within the shared mesh pool, once it has been added to it.
+            bool          m_pooled;
+            GLint         m_poolBaseVertex;
+            GLuint        m_poolFirstIndex;
+        };
+
+        /**
+         * \internal Visibility of a mesh instance, as found by occlusion queries in earlier
+         *           frames. Results are only read once the GPU has them, so the CPU never
+         *           waits on a query.
+         */
+        class OcclusionState
+        {
+        public:
+            OcclusionState() :
+                m_query(0),
+                m_queryPending(false),
+                m_visible(true),
+                m_lastFrame(0),
+                m_nextTestFrame(0)
+            {
+            }
+
+            GLuint   m_query;
+            bool     m_queryPending;    // Issued, but the result hasn't been read yet
+            bool     m_visible;
+            unsigned m_lastFrame;       // Last frame the instance was queued in
+            unsigned m_nextTestFrame;   // When a visible instance should next be checked
+        };
+
+        // Keyed by MeshInstance::getId(), as a new instance may be given the address of
+        // one deleted since it was drawn.
+        typedef QMap<unsigned, OcclusionState> OcclusionStateMap;
+
+        /**
+         * \internal The level of detail an instance was last drawn with.
+         */
+        class LodState
+        {
+        public:
+            LodState() :
+                m_level(0),
+                m_lastFrame(0)
+            {
+            }
+
+            int      m_level;
+            unsigned m_lastFrame;
+        };
+
+        typedef QMap<unsigned, LodState> LodStateMap;       // Keyed by MeshInstance::getId()
+
+        /**
+         * \internal
+         * \return True if the box lies entirely outside the view frustum, found by checking
+         *         whether all its corners are beyond the same clip plane.
+         */
+        bool isOutsideFrustum(const BoundingBox& box, const Matrix4f& worldViewProj)
+        {
+            int outside[6] = { 0, 0, 0, 0, 0, 0 };
+            const Vector3f& lo = box.getMinimum();
+            const Vector3f& hi = box.getMaximum();
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                Vector4f clip(worldViewProj * Vector4f((corner & 1) ? hi.x() : lo.x(),
+                                                       (corner & 2) ? hi.y() : lo.y(),
+                                                       (corner & 4) ? hi.z() : lo.z(), 1.0f));
+                outside[0] += clip.x() < -clip.w() ? 1 : 0;
+                outside[1] += clip.x() >  clip.w() ? 1 : 0;
+                outside[2] += clip.y() < -clip.w() ? 1 : 0;
+                outside[3] += clip.y() >  clip.w() ? 1 : 0;
+                outside[4] += clip.z() < -clip.w() ? 1 : 0;
+                outside[5] += clip.z() >  clip.w() ? 1 : 0;
+            }
+
+            for (int plane = 0; plane < 6; ++plane)
+            {
+                if (outside[plane] == 8)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * \internal A mesh instance queued for drawing in the current frame.
+         */
+        class RenderItem
+        {
+        public:
+            RenderItem(const MeshInstance* instance, CachedMesh* mesh, const Material* material, Shader* shader, float depth) :
+                m_instance(instance),
+                m_mesh(mesh),
+                m_material(material),
+                m_shader(shader),
+                m_depth(depth),
+                m_occlusion(0),
+                m_occluded(false),
+                m_firstRange(0),
+                m_numRanges(-1)
+            {
+            }
+
+            // Orders items so that each shader is activated once, and each material set once
+            // within it. Items sharing both are drawn nearest first.
+            bool operator<(const RenderItem& other) const
+            {
+                if (m_shader != other.m_shader)
+                {
+                    return m_shader < other.m_shader;
+                }
+                if (m_material != other.m_material)
+                {
+                    return m_material < other.m_material;
+                }
+                return m_depth < other.m_depth;
+            }
+
+            const MeshInstance* m_instance;
+            CachedMesh*         m_mesh;
+            const Material*     m_material;
+            Shader*             m_shader;
+            float               m_depth;    // Distance in front of the camera, used for sorting
+            OcclusionState*     m_occlusion;
+            bool                m_occluded; // Hidden as of the latest query result
+
+            // The ranges of GLRendererImpl::m_visibleRanges to draw, once clusters have been
+            // culled. A negative count draws every range of the mesh.
+            int                 m_firstRange;
+            int                 m_numRanges;
+        };
+
+        /**
+         * \internal Orders items nearest first, regardless of shader and material.
+         */
+        struct NearestFirst
+        {
+            bool operator()(const RenderItem& a, const RenderItem& b) const
+            {
+                return a.m_depth < b.m_depth;
+            }
+        };
+
+        typedef std::vector<RenderItem> RenderQueue;
+
+        /**
+         * \internal One element range of a queued item, as drawn by indirect submission.
+         *           These are sorted so that draws sharing a shader and primitive type end
+         *           up next to each other and can be issued as one multi-draw call.
+         */
+        class IndirectDraw
+        {
+        public:
+            IndirectDraw(const RenderItem* item, const IndexBufferData* range) :
+                m_item(item),
+                m_range(range)
+            {
+            }
+
+            bool operator<(const IndirectDraw& other) const
+            {
+                if (m_item->m_shader != other.m_item->m_shader)
+                {
+                    return m_item->m_shader < other.m_item->m_shader;
+                }
+                if (m_range->m_type != other.m_range->m_type)
+                {
+                    return m_range->m_type < other.m_range->m_type;
+                }
+                return m_item->m_depth < other.m_item->m_depth;
+            }
+
+            const RenderItem*       m_item;
+            const IndexBufferData*  m_range;
+        };
+
+        /**
+         * \internal Layout of a command in GL_DRAW_INDIRECT_BUFFER, as defined by OpenGL.
+         */
+        struct DrawElementsIndirectCommand
+        {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint  baseVertex;
+            GLuint baseInstance;
+        };
+
+        /**
+         * \internal Per-draw transforms read by indirect shaders. Must match the std430
+         *           layout of DrawData in lambertshader_indirect.vert, including the
+         *           padding of the struct to a multiple of 16 bytes.
+         */
+        struct DrawData
+        {
+            GLfloat matWorldView[16];
+            GLfloat matWorldViewInvTranspose[16];
+            GLfloat matWorldViewProj[16];
+            GLint   materialIndex;
+            GLint   padding[3];
+        };
+
+        /**
+         * \internal Material parameters read by indirect shaders. Must match the std430
+         *           layout of MaterialData in lambertshader_indirect.frag.
+         */
+        struct MaterialData
+        {
+            GLfloat diffuseColor[4];
+            GLfloat ambientColor[4];
+        };
+
+        typedef QMap<const Material*, int> MaterialIndexMap;
+
+        /**
+         * \internal A run of consecutive indirect commands drawn with one call.
+         */
+        struct IndirectBatch
+        {
+            Shader* shader;
+            GLenum  type;
+            int     first;
+            int     count;
         };
+
+
+        /**
+         * \internal Occlusion queries can't be issued within indirect draws, so the two
+         *           options don't mix; say so rather than quietly dropping one.
+         */
+        void warnIfOcclusionCullingIgnored(GLRenderer::SubmissionMode mode, bool occlusionCulling)
+        {
+            if (mode == GLRenderer::IndirectSubmission && occlusionCulling)
+            {
+                std::cout << "WARNING: Occlusion culling is ignored with indirect submission." << std::endl;
+            }
+        }
     }
 
     /**
@@ -68,7 +364,7 @@ namespace GLDemo
     class GLRendererImpl : public QGLFunctions
     {
     public:
-        typedef QMap<QString, CachedMesh> MeshDataCache;
+        typedef QHash<Name, CachedMesh> MeshDataCache;
 
         GLRendererImpl(const GLRendererImpl&);
         GLRendererImpl& operator=(const GLRendererImpl&);
@@ -76,12 +372,61 @@ namespace GLDemo
         GLRenderer&    m_renderer;
         QPaintDevice&  m_paintDevice;
         MeshDataCache  m_meshCache;
+        GLExtensions   m_extensions;
+        GLMeshPool     m_meshPool;
+        RenderQueue    m_renderQueue;
+        GLRenderer::SubmissionMode m_submissionMode;
+        GLuint         m_indirectBuffer;
+        GLuint         m_drawDataBuffer;
+        GLuint         m_materialBuffer;
+        std::vector<IndirectDraw>                 m_indirectDraws;
+        std::vector<DrawElementsIndirectCommand>  m_indirectCommands;
+        std::vector<DrawData>                     m_drawData;
+        std::vector<MaterialData>                 m_materialData;
+        MaterialIndexMap                          m_materialIndices;
+        std::vector<PtrShader>                    m_shadersToPrepare;
+        PtrMaterial    m_fallbackMaterial;
+        QSharedPointer<DepthShader>               m_depthShader;
+        QSharedPointer<IdShader>                  m_idShader;
+        OcclusionStateMap                         m_occlusionStates;
+        CachedMesh     m_boxMesh;
+        bool           m_occlusionCulling;
+        unsigned       m_frame;
+        int            m_occludedCount;
+        OcclusionBuffer                           m_occlusionBuffer;
+        OcclusionBuffer::OccluderList             m_occluders;
+        bool           m_softwareCulling;
+        bool           m_testOccluders;
+        LodStateMap    m_lodStates;
+        std::vector<IndexBufferData>              m_visibleRanges;
+        bool           m_clusterCulling;
+        int            m_culledClusterCount;
+        float          m_lodThreshold;
+        float          m_lodPixelsPerUnit;
+        bool           m_hasPendingShaders;
+        bool           m_hasPendingReloads;
+        std::vector<IndirectBatch>                m_indirectBatches;
+        bool           m_pickRequested;
+        int            m_pickX;
+        int            m_pickY;
+        GLuint         m_pickFramebuffer;
+        GLuint         m_pickColorBuffer;
+        GLuint         m_pickDepthBuffer;
+        GLuint         m_pickPixelBuffer;
+        bool           m_pickTargetsFailed;
+        GLsync         m_pickFence;     // Set while a pick's result is on its way back
+        std::vector<const MeshInstance*>          m_pickInstances;
+        const Scene*   m_pickScene;     // The scene the pick was drawn from, and its generation
+        int            m_pickGeneration;
+        bool           m_hasPickResult;
+        const MeshInstance* m_pickResult;
         int            m_width;
         int            m_height;
         bool           m_initialized;
         Matrix4f       m_matProj;
         Matrix4f       m_matView;
-        Matrix4f       m_matViewInv;
+        Matrix4f       m_matViewRelative;   // The view with the camera moved to the origin
+        WorldVector3   m_eye;               // Instance matrices are built relative to this
         Camera*        m_camera;
 
         GLRendererImpl(GLRenderer& renderer, QPaintDevice& device);
@@ -90,6 +435,45 @@ namespace GLDemo
         void  setCamera(Camera* camera);
 
         bool  process(const MeshInstance& instance);
+        bool  uploadMesh(Mesh& mesh, CachedMesh& cachedMesh);
+        bool  addIndexRanges(const ElementList& elements, size_t offset, size_t numVertices, IndexDataList& ranges) const;
+        void  addClusterRanges(const ElementList& elements, size_t offset, CachedMesh& cachedMesh) const;
+        void  bindVertexAttributes(CachedMesh& cachedMesh);
+        bool  useIndirectSubmission();
+
+        void  computeMatrices(const MeshInstance& instance, Matrix4f& worldView,
+                              Matrix4f& worldViewInvTranspose, Matrix4f& worldViewProj) const;
+        float computeDepth(const MeshInstance& instance) const;
+        BoundingBox getRelativeBound(const BoundingBox& bound) const;
+        bool  submitDirect(const Scene& scene);
+        bool  drawDepthPrePass();
+        bool  drawQueue(bool occluded);
+        bool  drawDirect(const RenderItem& item, Shader& shader);
+        void  drawMesh(CachedMesh& glMesh, const RenderItem* item = 0);
+        void  drawRange(const IndexBufferData& range);
+        bool  submitIndirect(const Scene& scene);
+        bool  useDepthPrePass(const Scene& scene);
+        void  beginMainPass(bool afterDepthPrePass);
+        void  endMainPass(bool afterDepthPrePass);
+        bool  useOcclusionCulling();
+        void  updateOcclusionStates();
+        bool  queryOccludedBounds(bool afterDepthPrePass);
+        void  releaseOcclusionStates(bool all);
+        void  beginOcclusionBuffer(const Scene& scene);
+        bool  isHiddenByOccluders(const MeshInstance& instance);
+        int   selectLod(const MeshInstance& instance, const Mesh& mesh);
+        bool  cullClusters(const MeshInstance& instance, const CachedMesh& glMesh, RenderItem& item);
+        void  releaseLodStates();
+        void  prepareShaders();
+        void  removePendingItems();
+        int   addMaterialData(const Material& material);
+
+        bool  requestPick(int x, int y);
+        bool  canPick();
+        bool  createPickTargets();
+        void  releasePickTargets();
+        bool  drawPickPass();
+        void  readPickResult();
 
         void  setupViewport(int x, int y, int width, int height);
         bool  setupMatrices(Scene& scene);
@@ -109,6 +493,40 @@ namespace GLDemo
     GLRendererImpl::GLRendererImpl(GLRenderer& renderer, QPaintDevice& device) :
         m_renderer(renderer),
         m_paintDevice(device),
+        m_submissionMode(GLRenderer::DirectSubmission),
+        m_indirectBuffer(0),
+        m_drawDataBuffer(0),
+        m_materialBuffer(0),
+        m_boxMesh("OcclusionBox"),
+        m_occlusionCulling(false),
+        m_frame(0),
+        m_occludedCount(0),
+        m_occlusionBuffer(),
+        m_occluders(),
+        m_softwareCulling(false),
+        m_testOccluders(false),
+        m_lodStates(),
+        m_visibleRanges(),
+        m_clusterCulling(true),
+        m_culledClusterCount(0),
+        m_lodThreshold(1.0f),
+        m_lodPixelsPerUnit(0.0f),
+        m_hasPendingShaders(false),
+        m_hasPendingReloads(false),
+        m_pickRequested(false),
+        m_pickX(0),
+        m_pickY(0),
+        m_pickFramebuffer(0),
+        m_pickColorBuffer(0),
+        m_pickDepthBuffer(0),
+        m_pickPixelBuffer(0),
+        m_pickTargetsFailed(false),
+        m_pickFence(0),
+        m_pickInstances(),
+        m_pickScene(0),
+        m_pickGeneration(0),
+        m_hasPickResult(false),
+        m_pickResult(0),
         m_width(device.width()),
         m_height(device.height()),
         m_initialized(false),
@@ -122,9 +540,42 @@ namespace GLDemo
      */
     GLRendererImpl::~GLRendererImpl()
     {
+        // The compiler's worker contexts share objects with ours, so stop them first.
+        ShaderCompiler::instance().shutdown();
+
         // We don't need to worry about cleaning up our allocated QGLBuffers,
         // as the destructor of the QGLBuffer object does this for us, according
-        // to the Qt documentation.
+        // to the Qt documentation. Vertex arrays are ours to delete though.
+        if (m_extensions.hasVertexArrayObjects())
+        {
+            for (MeshDataCache::iterator meshIter = m_meshCache.begin(); meshIter != m_meshCache.end(); ++meshIter)
+            {
+                if (meshIter->m_vertexArray)
+                {
+                    m_extensions.glDeleteVertexArrays(1, &meshIter->m_vertexArray);
+                }
+            }
+            if (m_boxMesh.m_vertexArray)
+            {
+                m_extensions.glDeleteVertexArrays(1, &m_boxMesh.m_vertexArray);
+            }
+        }
+
+        releaseOcclusionStates(true);
+        releasePickTargets();
+
+        if (m_indirectBuffer)
+        {
+            glDeleteBuffers(1, &m_indirectBuffer);
+        }
+        if (m_drawDataBuffer)
+        {
+            glDeleteBuffers(1, &m_drawDataBuffer);
+        }
+        if (m_materialBuffer)
+        {
+            glDeleteBuffers(1, &m_materialBuffer);
+        }
     }
 
 
@@ -140,8 +591,18 @@ namespace GLDemo
         const float zFar        = m_camera->getFarPlaneDistance();
 
         m_matProj.makePerspectiveProjectionFOV(fov, aspectRatio, zNear, zFar);
+
+        // Height on screen, in pixels, of one unit at a distance of one unit.
+        m_lodPixelsPerUnit = m_height / (2.0f * Math<float>::Tan(fov * Math<float>::PI / 360.0f));
         m_camera->toViewMatrix(m_matView);
-        m_matViewInv = m_matView.inverse();
+
+        // Instances are placed relative to the camera in the precision of the world, so
+        // their matrices stay precise however far the camera is from the origin.
+        const Transformation& cameraWorld = m_camera->getWorldTransformation();
+        m_eye = cameraWorld.getPreciseTranslation();
+        Matrix4f matCamera;
+        cameraWorld.toMatrix(matCamera, m_eye);
+        m_matViewRelative = matCamera.inverse();
         return true;
     }
 
@@ -166,170 +627,1526 @@ namespace GLDemo
 
 
     /**
-     * \param instance  The mesh instance to process
-     *
-     * Processes a mesh instance, generating the appropriate OpenGL data structures
-     * if the mesh hasn't before been rendered.
+     * \param instance  The mesh instance to process
+     *
+     * Processes a mesh instance, generating the appropriate OpenGL data structures
+     * if the mesh hasn't before been rendered.
+     */
+    bool  GLRendererImpl::process(const MeshInstance& instance)
+    {
+        PtrMesh ptrMesh = instance.getMesh();
+        if (ptrMesh.isNull())
+        {
+            std::cout << "ERROR: Mesh " << instance.instanceName() << " contents are invalid." << std::endl;
+            return false;
+        }
+        Mesh& mesh = ptrMesh->getLod(selectLod(instance, *ptrMesh));
+
+        // Check to see whether buffers exist for our mesh data, and if not, we create them.
+        MeshDataCache::iterator meshIter = m_meshCache.find(mesh.getName());
+        if (m_meshCache.end() == meshIter)
+        {
+            CachedMesh cachedMesh(mesh.getName());
+            if (!uploadMesh(mesh, cachedMesh))
+            {
+                return false;
+            }
+
+            meshIter = m_meshCache.insert(mesh.getName(), cachedMesh);
+        }
+
+        // Meshes drawn indirectly also need a copy in the shared pool.
+        CachedMesh& glMesh = *meshIter;
+        if (!glMesh.m_pooled && useIndirectSubmission())
+        {
+            if (!m_meshPool.addMesh(mesh, glMesh.m_poolBaseVertex, glMesh.m_poolFirstIndex))
+            {
+                return false;
+            }
+            glMesh.m_pooled = true;
+        }
+
+        const PtrMaterial& ptrMaterial = instance.getMaterial();
+        if (ptrMaterial.isNull() || ptrMaterial->getShader().isNull())
+        {
+            std::cout << "ERROR: Mesh instance must have a material with a valid shader in order to be rendered." << std::endl;
+            return false;
+        }
+
+        // Drawing is deferred until the whole scene has been processed, so that the
+        // queue can be submitted in whichever order suits the submission mode.
+        RenderItem item(&instance, &glMesh, ptrMaterial.data(), ptrMaterial->getShader().data(), computeDepth(instance));
+        if (m_clusterCulling && !glMesh.m_clusters.empty() && !cullClusters(instance, glMesh, item))
+        {
+            return true;
+        }
+        m_renderQueue.push_back(item);
+        return true;
+    }
+
+
+    /**
+     * \return False if nothing of the instance is left to draw.
+     *
+     * Leaves out the clusters of the mesh that face away from the camera or are outside
+     * the view, and records the ranges of those that are left with the item. Runs of
+     * neighbouring visible clusters are drawn as one range.
+     */
+    bool  GLRendererImpl::cullClusters(const MeshInstance& instance, const CachedMesh& glMesh, RenderItem& item)
+    {
+        Matrix4f matWorldView;
+        Matrix4f matWorldViewInvTranspose;
+        Matrix4f matWorldViewProj;
+        computeMatrices(instance, matWorldView, matWorldViewInvTranspose, matWorldViewProj);
+
+        // Cones are tested in the space of the mesh, where the camera is at the translation
+        // of the inverse world-view matrix. A mirroring transform turns the triangles
+        // inside out, so their cones no longer say which way they face.
+        const Transformation& world = instance.getWorldTransformation();
+        Vector3f eye(matWorldViewInvTranspose(3, 0), matWorldViewInvTranspose(3, 1), matWorldViewInvTranspose(3, 2));
+        const Vector3f& scale = world.getScale();
+        bool testCones = scale.x() * scale.y() * scale.z() > 0.0f;
+
+        item.m_firstRange = static_cast<int>(m_visibleRanges.size());
+        m_visibleRanges.insert(m_visibleRanges.end(), glMesh.m_unclusteredRanges.begin(), glMesh.m_unclusteredRanges.end());
+
+        bool lastVisible = false;
+        for (size_t i = 0; i < glMesh.m_clusters.size(); ++i)
+        {
+            const MeshCluster& cluster = glMesh.m_clusters[i];
+            if ((testCones && cluster.isBackFacing(eye)) || isOutsideFrustum(cluster.getBound(), matWorldViewProj))
+            {
+                ++m_culledClusterCount;
+                lastVisible = false;
+                continue;
+            }
+
+            const IndexBufferData& range = glMesh.m_clusterRanges[i];
+            if (lastVisible)
+            {
+                IndexBufferData& merged = m_visibleRanges.back();
+                merged.m_numIndices += range.m_numIndices;
+                merged.m_minVertex = std::min(merged.m_minVertex, range.m_minVertex);
+                merged.m_maxVertex = std::max(merged.m_maxVertex, range.m_maxVertex);
+            }
+            else
+            {
+                m_visibleRanges.push_back(range);
+            }
+            lastVisible = true;
+        }
+
+        item.m_numRanges = static_cast<int>(m_visibleRanges.size()) - item.m_firstRange;
+        return item.m_numRanges > 0;
+    }
+
+
+    /**
+     * \return The distance of the instance in front of the camera, measured to the centre
+     *         of its world bound. Instances without a bound are measured to their origin.
+     */
+    float  GLRendererImpl::computeDepth(const MeshInstance& instance) const
+    {
+        const BoundingBox& bound = instance.getWorldBound();
+        Vector3f center = bound.isEmpty() ?
+            Vector3f(instance.getWorldTransformation().getPreciseTranslation() - m_eye) :
+            getRelativeBound(bound).getCenter();
+        Vector4f viewPos(m_matViewRelative * Vector4f(center.x(), center.y(), center.z(), 1.0f));
+
+        // The camera looks down the negative z axis of view space.
+        return -viewPos.z();
+    }
+
+
+    /**
+     * \return The bound moved so that the camera is at the origin, to go with the view
+     *         matrix and instance matrices that are relative to it.
+     */
+    BoundingBox  GLRendererImpl::getRelativeBound(const BoundingBox& bound) const
+    {
+        if (bound.isEmpty())
+        {
+            return bound;
+        }
+        return BoundingBox(Vector3f(WorldVector3(bound.getMinimum()) - m_eye),
+                           Vector3f(WorldVector3(bound.getMaximum()) - m_eye));
+    }
+
+
+    /**
+     * \return The coarsest level of detail of the mesh whose error, projected onto the
+     *         screen at the instance's distance from the camera, is within the threshold.
+     *         Each instance remembers its level, which only gets coarser once the next
+     *         level is comfortably within the threshold.
+     */
+    int  GLRendererImpl::selectLod(const MeshInstance& instance, const Mesh& mesh)
+    {
+        const BoundingBox& bound = instance.getWorldBound();
+        if (mesh.getNumLods() == 1 || m_lodThreshold <= 0.0f || bound.isEmpty())
+        {
+            return 0;
+        }
+
+        // Measure to the nearest point of the bound, so nothing within it is too coarse.
+        // Relative to the camera, that is the origin clamped to the bound.
+        const BoundingBox relative = getRelativeBound(bound);
+        Vector3f nearest;
+        for (int i = 0; i < 3; ++i)
+        {
+            nearest[i] = std::min(std::max(0.0f, relative.getMinimum()[i]), relative.getMaximum()[i]);
+        }
+        float distance = std::max(nearest.length(), m_camera->getNearPlaneDistance());
+
+        // Errors are in the units of the mesh, so grow with the instance's scale.
+        const Vector3f& scale = instance.getWorldTransformation().getScale();
+        float maxScale = std::max(std::fabs(scale.x()), std::max(std::fabs(scale.y()), std::fabs(scale.z())));
+        float pixelsPerUnit = m_lodPixelsPerUnit * maxScale / distance;
+
+        LodState& state = m_lodStates[instance.getId()];
+        state.m_lastFrame = m_frame;
+
+        int level = std::min(state.m_level, mesh.getNumLods() - 1);
+        while (level > 0 && mesh.getLodError(level) * pixelsPerUnit > m_lodThreshold)
+        {
+            --level;
+        }
+        while (level + 1 < mesh.getNumLods() &&
+               mesh.getLodError(level + 1) * pixelsPerUnit <= m_lodThreshold * s_lodHysteresis)
+        {
+            ++level;
+        }
+
+        state.m_level = level;
+        return level;
+    }
+
+
+    /**
+     * Forgets the levels of detail of instances that haven't been drawn for a while.
+     */
+    void  GLRendererImpl::releaseLodStates()
+    {
+        LodStateMap::iterator iter = m_lodStates.begin();
+        while (iter != m_lodStates.end())
+        {
+            if (iter->m_lastFrame + s_lodStateLifetime < m_frame)
+            {
+                iter = m_lodStates.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+
+    /**
+     * \return True if queued draws should be submitted with multi-draw indirect calls.
+     *         Initializes the shared mesh pool on first use.
+     */
+    bool  GLRendererImpl::useIndirectSubmission()
+    {
+        return m_submissionMode == GLRenderer::IndirectSubmission &&
+               m_extensions.hasMultiDrawIndirect() &&
+               m_meshPool.initialize(m_extensions);
+    }
+
+
+    /**
+     * Computes the transforms of a mesh instance with respect to the current camera. The
+     * world matrix is relative to the camera, so that instances far from the origin don't
+     * jitter as the camera moves; the results are the same as with the absolute one.
+     */
+    void  GLRendererImpl::computeMatrices(const MeshInstance& instance, Matrix4f& matWorldView,
+                                          Matrix4f& matWorldViewInvTranspose, Matrix4f& matWorldViewProj) const
+    {
+        Matrix4f matWorld;
+        instance.getWorldTransformation().toMatrix(matWorld, m_eye);
+        matWorldView = m_matViewRelative * matWorld;
+        matWorldViewInvTranspose = matWorldView.inverse().transpose();
+        matWorldViewProj = m_matProj * matWorldView;
+    }
+
+
+    /**
+     * Draws every queued item with its own set of draw calls. Items are normally grouped by
+     * shader and then by material, so that each program is bound and each material's
+     * parameters are set only once per frame. A scene sorting front to back trades that
+     * for drawing the nearest items first, wherever they switch shader or material.
+     */
+    bool  GLRendererImpl::submitDirect(const Scene& scene)
+    {
+        bool culling = useOcclusionCulling();
+        if (culling)
+        {
+            updateOcclusionStates();
+        }
+        else
+        {
+            releaseOcclusionStates(true);
+        }
+
+        bool prePass = useDepthPrePass(scene);
+        if (prePass)
+        {
+            // The pre-pass uses one shader for everything, so it can always go front to back.
+            std::stable_sort(m_renderQueue.begin(), m_renderQueue.end(), NearestFirst());
+            if (!drawDepthPrePass())
+            {
+                return false;
+            }
+        }
+
+        // With the depth already laid down, the order of the main pass makes no difference
+        // to overdraw, so it may as well minimise state changes.
+        if (scene.getOpaqueSortMode() == Scene::SortFrontToBack && !prePass)
+        {
+            std::stable_sort(m_renderQueue.begin(), m_renderQueue.end(), NearestFirst());
+        }
+        else
+        {
+            std::stable_sort(m_renderQueue.begin(), m_renderQueue.end());
+        }
+
+        beginMainPass(prePass);
+        bool success = drawQueue(false);
+
+        // Hidden items are drawn last, each only if its bounding box turns out to be
+        // visible after everything else. Without conditional rendering they are left out
+        // until a query shows them, which can take a frame or two.
+        if (success && m_occludedCount > 0)
+        {
+            success = queryOccludedBounds(prePass);
+            if (success && m_extensions.hasConditionalRender())
+            {
+                // They were left out of the pre-pass, so lay down their own depth.
+                if (prePass)
+                {
+                    glDepthMask(GL_TRUE);
+                }
+                success = drawQueue(true);
+                if (prePass)
+                {
+                    glDepthMask(GL_FALSE);
+                }
+            }
+        }
+        endMainPass(prePass);
+
+        return success;
+    }
+
+
+    /**
+     * \param occluded  Whether to draw the items hidden as of the latest occlusion query
+     *                  results, or the rest of the queue.
+     *
+     * Hidden items are drawn conditionally on the query of their bounding box. Visible
+     * items are now and then drawn inside a query, to find out when they become hidden.
+     */
+    bool  GLRendererImpl::drawQueue(bool occluded)
+    {
+        bool success = true;
+        const Shader* activeShader = 0;
+        const Material* activeMaterial = 0;
+        for (RenderQueue::const_iterator iter = m_renderQueue.begin(); success && iter != m_renderQueue.end(); ++iter)
+        {
+            if (iter->m_occluded != occluded)
+            {
+                continue;
+            }
+
+            if (iter->m_shader != activeShader)
+            {
+                if (!iter->m_shader->activate(m_matView))
+                {
+                    std::cout << "ERROR: Failed to activate shader." << std::endl;
+                    success = false;
+                    break;
+                }
+                activeShader = iter->m_shader;
+                activeMaterial = 0;
+            }
+
+            if (iter->m_material != activeMaterial)
+            {
+                if (!iter->m_shader->setMaterial(*iter->m_material))
+                {
+                    std::cout << "ERROR: Failed to set material." << std::endl;
+                    success = false;
+                    break;
+                }
+                activeMaterial = iter->m_material;
+            }
+
+            OcclusionState* state = iter->m_occlusion;
+            if (occluded)
+            {
+                // Waits on the GPU only; the CPU carries on issuing commands.
+                m_extensions.glBeginConditionalRender(state->m_query, GL_QUERY_WAIT);
+                success = drawDirect(*iter, *iter->m_shader);
+                m_extensions.glEndConditionalRender();
+            }
+            else if (state && !state->m_queryPending && state->m_nextTestFrame <= m_frame)
+            {
+                m_extensions.glBeginQuery(m_extensions.getOcclusionQueryTarget(), state->m_query);
+                success = drawDirect(*iter, *iter->m_shader);
+                m_extensions.glEndQuery(m_extensions.getOcclusionQueryTarget());
+                state->m_queryPending = true;
+            }
+            else
+            {
+                success = drawDirect(*iter, *iter->m_shader);
+            }
+        }
+
+        return success;
+    }
+
+
+    /**
+     * Draws the depth of every queued item, with color writes disabled. Items hidden as
+     * of the latest occlusion query results are left out; the main pass only draws them
+     * if their bounding boxes turn out to be visible.
+     */
+    bool  GLRendererImpl::drawDepthPrePass()
+    {
+        if (!m_depthShader->activate(m_matView))
+        {
+            std::cout << "ERROR: Failed to activate depth shader." << std::endl;
+            return false;
+        }
+
+        bool success = true;
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        for (RenderQueue::const_iterator iter = m_renderQueue.begin(); success && iter != m_renderQueue.end(); ++iter)
+        {
+            if (!iter->m_occluded)
+            {
+                success = drawDirect(*iter, *m_depthShader);
+            }
+        }
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        return success;
+    }
+
+
+    /**
+     * \return True if the scene asks for a depth pre-pass and the depth shader is ready.
+     *         Until it is, frames are drawn without one rather than waiting for it.
+     */
+    bool  GLRendererImpl::useDepthPrePass(const Scene& scene)
+    {
+        return scene.isDepthPrePassEnabled() && m_depthShader && m_depthShader->prepare() && m_depthShader->isReady();
+    }
+
+
+    /**
+     * \param afterDepthPrePass  True if the depth of everything drawn has already been
+     *                           written by the pre-pass.
+     *
+     * After a pre-pass only the nearest surface of each pixel passes the depth test, so
+     * the expensive shaders never run for hidden fragments. The depth buffer already holds
+     * the right values, so it need not be written again.
+     */
+    void  GLRendererImpl::beginMainPass(bool afterDepthPrePass)
+    {
+        if (afterDepthPrePass)
+        {
+            glDepthFunc(GL_LEQUAL);
+            glDepthMask(GL_FALSE);
+        }
+    }
+
+
+    /**
+     *
+     */
+    void  GLRendererImpl::endMainPass(bool afterDepthPrePass)
+    {
+        if (afterDepthPrePass)
+        {
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LESS);
+        }
+    }
+
+
+    /**
+     * \return True if occlusion culling is switched on and the context can do it. Bounding
+     *         boxes are drawn with the depth shader, so culling waits until it is ready.
+     */
+    bool  GLRendererImpl::useOcclusionCulling()
+    {
+        if (!m_occlusionCulling || !m_extensions.hasOcclusionQueries() ||
+            !m_depthShader || !m_depthShader->prepare() || !m_depthShader->isReady())
+        {
+            return false;
+        }
+
+        if (m_boxMesh.m_indexRanges.empty())
+        {
+            CubeMesh box("OcclusionBox");
+            if (!uploadMesh(box, m_boxMesh))
+            {
+                m_occlusionCulling = false;
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    /**
+     * Reads the results of the queries issued in earlier frames, where the GPU has them,
+     * and marks the queued items that were found to be hidden. Items seen for the first
+     * time, or whose bounding box contains the camera, are always taken to be visible.
+     */
+    void  GLRendererImpl::updateOcclusionStates()
+    {
+        // Anything within the near plane distance of the camera could be clipped, which
+        // would make its bounding box look hidden when it isn't. Bounds are tested relative
+        // to the camera, which is then at the origin.
+        const Vector3f cameraPos(0.0f, 0.0f, 0.0f);
+        float nearDistance = m_camera->getNearPlaneDistance();
+        Vector3f nearExtents(nearDistance, nearDistance, nearDistance);
+
+        for (RenderQueue::iterator iter = m_renderQueue.begin(); iter != m_renderQueue.end(); ++iter)
+        {
+            OcclusionStateMap::iterator stateIter = m_occlusionStates.find(iter->m_instance->getId());
+            if (stateIter == m_occlusionStates.end())
+            {
+                stateIter = m_occlusionStates.insert(iter->m_instance->getId(), OcclusionState());
+                m_extensions.glGenQueries(1, &stateIter->m_query);
+
+                // Spread the checks of visible items over several frames.
+                stateIter->m_nextTestFrame = m_frame + m_occlusionStates.size() % s_visibleQueryInterval;
+            }
+
+            OcclusionState& state = *stateIter;
+            state.m_lastFrame = m_frame;
+            if (state.m_queryPending)
+            {
+                GLuint available = GL_FALSE;
+                m_extensions.glGetQueryObjectuiv(state.m_query, GL_QUERY_RESULT_AVAILABLE, &available);
+                if (available)
+                {
+                    GLuint samples = 0;
+                    m_extensions.glGetQueryObjectuiv(state.m_query, GL_QUERY_RESULT, &samples);
+                    state.m_visible = samples > 0;
+                    state.m_queryPending = false;
+                    if (state.m_visible)
+                    {
+                        state.m_nextTestFrame = m_frame + s_visibleQueryInterval;
+                    }
+                }
+            }
+
+            const BoundingBox bound = getRelativeBound(iter->m_instance->getWorldBound());
+            if (bound.isEmpty() ||
+                BoundingBox(bound.getMinimum() - nearExtents, bound.getMaximum() + nearExtents).contains(cameraPos))
+            {
+                state.m_visible = true;
+            }
+
+            iter->m_occlusion = &state;
+            iter->m_occluded = !state.m_visible;
+            if (iter->m_occluded)
+            {
+                ++m_occludedCount;
+            }
+        }
+
+        if (m_frame % s_occlusionStateLifetime == 0)
+        {
+            releaseOcclusionStates(false);
+        }
+    }
+
+
+    /**
+     * \param afterDepthPrePass  True if the depth buffer is already read-only.
+     *
+     * Issues a query for the bounding box of each hidden item, against the depth of the
+     * visible items drawn so far. Nothing is written while the boxes are drawn.
+     */
+    bool  GLRendererImpl::queryOccludedBounds(bool afterDepthPrePass)
+    {
+        if (!m_depthShader->activate(m_matView))
+        {
+            std::cout << "ERROR: Failed to activate depth shader." << std::endl;
+            return false;
+        }
+
+        // The camera may be looking at the inside of a box from behind its front faces.
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthMask(GL_FALSE);
+        glDisable(GL_CULL_FACE);
+
+        Matrix4f matBox;
+        Matrix4f identity;
+        identity.toIdentity();
+        for (RenderQueue::const_iterator iter = m_renderQueue.begin(); iter != m_renderQueue.end(); ++iter)
+        {
+            // A box still being tested from an earlier frame keeps that query.
+            if (!iter->m_occluded || iter->m_occlusion->m_queryPending)
+            {
+                continue;
+            }
+
+            // The box mesh spans -1 to 1, so scale it by the extents of the bound.
+            const BoundingBox bound = getRelativeBound(iter->m_instance->getWorldBound());
+            Vector3f center = bound.getCenter();
+            Vector3f extents = bound.getExtents();
+            matBox.toIdentity();
+            for (int i = 0; i < 3; ++i)
+            {
+                matBox(i, i) = extents[i];
+                matBox(i, 3) = center[i];
+            }
+            m_depthShader->setTransforms(identity, identity, m_matProj * m_matViewRelative * matBox);
+
+            m_extensions.glBeginQuery(m_extensions.getOcclusionQueryTarget(), iter->m_occlusion->m_query);
+            drawMesh(m_boxMesh);
+            m_extensions.glEndQuery(m_extensions.getOcclusionQueryTarget());
+            iter->m_occlusion->m_queryPending = true;
+        }
+
+        glEnable(GL_CULL_FACE);
+        glDepthMask(afterDepthPrePass ? GL_FALSE : GL_TRUE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * Starts drawing the scene's occluders into the CPU occlusion buffer, if software
+     * occlusion culling is enabled.
+     */
+    void  GLRendererImpl::beginOcclusionBuffer(const Scene& scene)
+    {
+        const Scene::OccluderList& occluders = scene.getOccluders();
+        m_testOccluders = m_softwareCulling && !occluders.empty();
+        if (!m_testOccluders)
+        {
+            return;
+        }
+
+        m_occluders.clear();
+        for (Scene::OccluderList::const_iterator iter = occluders.begin(); iter != occluders.end(); ++iter)
+        {
+            const PtrMesh& mesh = (*iter)->getOccluderMesh();
+            if (mesh)
+            {
+                Matrix4f matWorld;
+                (*iter)->getWorldTransformation().toMatrix(matWorld, m_eye);
+                m_occluders.push_back(OcclusionBuffer::Occluder(mesh.data(), matWorld));
+            }
+        }
+
+        // Occluders and the bounds tested against them are relative to the camera, like
+        // the instances of the main pass.
+        m_occlusionBuffer.begin(m_matProj * m_matViewRelative, m_occluders);
+    }
+
+
+    /**
+     * \return True if the world bound of the instance is hidden behind the occluders
+     *         drawn into the CPU occlusion buffer this frame. Waits for the occluders to
+     *         be drawn the first time it is called in a frame.
+     */
+    bool  GLRendererImpl::isHiddenByOccluders(const MeshInstance& instance)
+    {
+        if (!m_testOccluders)
+        {
+            return false;
+        }
+
+        m_occlusionBuffer.wait();
+        if (m_occlusionBuffer.isOccluded(getRelativeBound(instance.getWorldBound())))
+        {
+            ++m_occludedCount;
+            return true;
+        }
+        return false;
+    }
+
+
+    /**
+     * \param all  If false, only the state of instances that haven't been drawn for a
+     *             while is released.
+     */
+    void  GLRendererImpl::releaseOcclusionStates(bool all)
+    {
+        OcclusionStateMap::iterator iter = m_occlusionStates.begin();
+        while (iter != m_occlusionStates.end())
+        {
+            if (all || iter->m_lastFrame + s_occlusionStateLifetime < m_frame)
+            {
+                m_extensions.glDeleteQueries(1, &iter->m_query);
+                iter = m_occlusionStates.erase(iter);
+            }
+            else
+            {
+                ++iter;
+            }
+        }
+    }
+
+
+    /**
+     * \param item    The queued item to draw.
+     * \param shader  The shader to draw it with; the item's own, or the depth shader.
+     *
+     * \pre The shader must be active, with the item's material set.
+     */
+    bool  GLRendererImpl::drawDirect(const RenderItem& item, Shader& shader)
+    {
+        CachedMesh& glMesh = *item.m_mesh;
+
+        // Compute our matrices and hand them to the shader.
+        Matrix4f matWorldView;
+        Matrix4f matWorldViewInvTranspose;
+        Matrix4f matWorldViewProj;
+        computeMatrices(*item.m_instance, matWorldView, matWorldViewInvTranspose, matWorldViewProj);
+        if (!shader.setTransforms(matWorldView, matWorldViewInvTranspose, matWorldViewProj))
+        {
+            std::cout << "ERROR: Failed to set shader transforms." << std::endl;
+            return false;
+        }
+
+        drawMesh(glMesh, &item);
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * \param glMesh  The mesh to draw.
+     * \param item    The queued item the mesh is drawn for, if any. Only the ranges left
+     *                after culling its clusters are drawn; without an item, every element
+     *                range of the mesh is.
+     */
+    void  GLRendererImpl::drawMesh(CachedMesh& glMesh, const RenderItem* item)
+    {
+        // With a vertex array, all attribute and index buffer state is restored in one go.
+        if (glMesh.m_vertexArray)
+        {
+            m_extensions.glBindVertexArray(glMesh.m_vertexArray);
+        }
+        else
+        {
+            bindVertexAttributes(glMesh);
+        }
+
+        // Now render each set of elements.
+        if (item && item->m_numRanges >= 0)
+        {
+            for (int i = 0; i < item->m_numRanges; ++i)
+            {
+                drawRange(m_visibleRanges[item->m_firstRange + i]);
+            }
+        }
+        else
+        {
+            for (IndexDataList::const_iterator iIter = glMesh.m_indexRanges.begin(); iIter != glMesh.m_indexRanges.end(); ++iIter)
+            {
+                drawRange(*iIter);
+            }
+        }
+
+        // Don't leave the vertex array bound, or later buffer binds would be captured by it.
+        if (glMesh.m_vertexArray)
+        {
+            m_extensions.glBindVertexArray(0);
+        }
+    }
+
+
+    /**
+     * \param range  The element range to draw from the currently bound index buffer.
+     *
+     * Uses glDrawRangeElements where available. Knowing the range of vertices up front
+     * lets the driver fetch only those vertices, rather than scanning the indices first.
+     */
+    void  GLRendererImpl::drawRange(const IndexBufferData& range)
+    {
+        if (m_extensions.hasDrawRangeElements())
+        {
+            m_extensions.glDrawRangeElements(range.m_type, range.m_minVertex, range.m_maxVertex,
+                                             range.m_numIndices, GL_UNSIGNED_INT, (GLvoid*)range.m_offset);
+        }
+        else
+        {
+            glDrawElements(range.m_type, range.m_numIndices, GL_UNSIGNED_INT, (GLvoid*)range.m_offset);
+        }
+    }
+
+
+    /**
+     * Draws the queue with one glMultiDrawElementsIndirect call per shader and primitive
+     * type. The commands, the per-draw transforms and the parameters of every material used
+     * in the frame are written into three buffers up front; each shader then finds its
+     * transforms using gl_DrawID, and its material through the index stored with them.
+     *
+     * Draws within each call are always nearest first, whatever the scene's opaque sort
+     * mode, as ordering them any other way would split the calls. Occlusion queries need
+     * a draw call of their own for each item, so occlusion culling is not done here
+     * either; see GLRenderer::setOcclusionCulling(). Software occlusion culling and
+     * cluster culling still apply, as they happen while the queue is built. A depth
+     * pre-pass replays the same calls with the depth shader.
+     */
+    bool  GLRendererImpl::submitIndirect(const Scene& scene)
+    {
+        releaseOcclusionStates(true);
+
+        // Flatten the queue into one draw per element range, grouped by shader and type.
+        m_indirectDraws.clear();
+        for (RenderQueue::const_iterator iter = m_renderQueue.begin(); iter != m_renderQueue.end(); ++iter)
+        {
+            if (iter->m_numRanges >= 0)
+            {
+                for (int i = 0; i < iter->m_numRanges; ++i)
+                {
+                    m_indirectDraws.push_back(IndirectDraw(&*iter, &m_visibleRanges[iter->m_firstRange + i]));
+                }
+                continue;
+            }
+
+            const IndexDataList& ranges = iter->m_mesh->m_indexRanges;
+            for (IndexDataList::const_iterator rIter = ranges.begin(); rIter != ranges.end(); ++rIter)
+            {
+                m_indirectDraws.push_back(IndirectDraw(&*iter, &*rIter));
+            }
+        }
+        std::stable_sort(m_indirectDraws.begin(), m_indirectDraws.end());
+
+        if (m_indirectDraws.empty())
+        {
+            return true;
+        }
+
+        m_indirectCommands.resize(m_indirectDraws.size());
+        m_drawData.resize(m_indirectDraws.size());
+        m_indirectBatches.clear();
+        m_materialData.clear();
+        m_materialIndices.clear();
+
+        Matrix4f matWorldView;
+        Matrix4f matWorldViewInvTranspose;
+        Matrix4f matWorldViewProj;
+        const MeshInstance* lastInstance = 0;
+        for (size_t i = 0; i < m_indirectDraws.size(); ++i)
+        {
+            const IndirectDraw& draw = m_indirectDraws[i];
+            const CachedMesh& glMesh = *draw.m_item->m_mesh;
+
+            DrawElementsIndirectCommand& command = m_indirectCommands[i];
+            command.count = draw.m_range->m_numIndices;
+            command.instanceCount = 1;
+            command.firstIndex = glMesh.m_poolFirstIndex + draw.m_range->m_offset / sizeof(unsigned);
+            command.baseVertex = glMesh.m_poolBaseVertex;
+            command.baseInstance = 0;
+
+            // Instances with several element lists only need their matrices computed once.
+            if (draw.m_item->m_instance != lastInstance)
+            {
+                computeMatrices(*draw.m_item->m_instance, matWorldView, matWorldViewInvTranspose, matWorldViewProj);
+                lastInstance = draw.m_item->m_instance;
+            }
+            DrawData& data = m_drawData[i];
+            std::memcpy(data.matWorldView, matWorldView.toPointer(), sizeof(data.matWorldView));
+            std::memcpy(data.matWorldViewInvTranspose, matWorldViewInvTranspose.toPointer(), sizeof(data.matWorldViewInvTranspose));
+            std::memcpy(data.matWorldViewProj, matWorldViewProj.toPointer(), sizeof(data.matWorldViewProj));
+            data.materialIndex = addMaterialData(*draw.m_item->m_material);
+
+            GLenum type = draw.m_range->m_type;
+            if (m_indirectBatches.empty() ||
+                m_indirectBatches.back().shader != draw.m_item->m_shader ||
+                m_indirectBatches.back().type != type)
+            {
+                IndirectBatch batch = { draw.m_item->m_shader, type, static_cast<int>(i), 0 };
+                m_indirectBatches.push_back(batch);
+            }
+            ++m_indirectBatches.back().count;
+        }
+
+        // Re-specify the buffers each frame so the driver can hand us fresh storage
+        // rather than waiting on draws from the previous frame still reading them.
+        if (!m_indirectBuffer)
+        {
+            glGenBuffers(1, &m_indirectBuffer);
+            glGenBuffers(1, &m_drawDataBuffer);
+            glGenBuffers(1, &m_materialBuffer);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectCommands.size() * sizeof(DrawElementsIndirectCommand),
+                     &m_indirectCommands.front(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawDataBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_drawData.size() * sizeof(DrawData), &m_drawData.front(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_materialBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_materialData.size() * sizeof(MaterialData), &m_materialData.front(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        m_extensions.glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GLRenderer::PerDrawData, m_drawDataBuffer);
+        m_extensions.glBindBufferBase(GL_SHADER_STORAGE_BUFFER, GLRenderer::MaterialData, m_materialBuffer);
+
+        bool success = true;
+        bool prePass = useDepthPrePass(scene);
+        m_meshPool.bind();
+        if (prePass)
+        {
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            for (std::vector<IndirectBatch>::const_iterator bIter = m_indirectBatches.begin(); bIter != m_indirectBatches.end(); ++bIter)
+            {
+                if (!m_depthShader->activateIndirect(m_matView, bIter->first))
+                {
+                    std::cout << "ERROR: Failed to activate depth shader for indirect submission." << std::endl;
+                    success = false;
+                    break;
+                }
+
+                m_extensions.glMultiDrawElementsIndirect(bIter->type, GL_UNSIGNED_INT,
+                                                         (GLvoid*)(bIter->first * sizeof(DrawElementsIndirectCommand)),
+                                                         bIter->count, 0);
+            }
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        }
+
+        beginMainPass(prePass);
+        for (std::vector<IndirectBatch>::const_iterator bIter = m_indirectBatches.begin(); success && bIter != m_indirectBatches.end(); ++bIter)
+        {
+            if (!bIter->shader->activateIndirect(m_matView, bIter->first))
+            {
+                std::cout << "ERROR: Failed to activate shader for indirect submission." << std::endl;
+                success = false;
+                break;
+            }
+
+            m_extensions.glMultiDrawElementsIndirect(bIter->type, GL_UNSIGNED_INT,
+                                                     (GLvoid*)(bIter->first * sizeof(DrawElementsIndirectCommand)),
+                                                     bIter->count, 0);
+        }
+        endMainPass(prePass);
+        m_meshPool.release();
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+        return success && GL_GOOD_STATE();
+    }
+
+
+    /**
+     * \param material  A material used by a draw in the current frame.
+     * \return The index of the material's parameters in this frame's material buffer,
+     *         adding them the first time the material is seen.
+     */
+    int  GLRendererImpl::addMaterialData(const Material& material)
+    {
+        MaterialIndexMap::const_iterator iter = m_materialIndices.find(&material);
+        if (iter != m_materialIndices.end())
+        {
+            return *iter;
+        }
+
+        const QColor& diffuse = material.getDiffuseColor();
+        const QColor& ambient = material.getAmbientColor();
+        MaterialData data =
+        {
+            { static_cast<GLfloat>(diffuse.redF()), static_cast<GLfloat>(diffuse.greenF()),
+              static_cast<GLfloat>(diffuse.blueF()), static_cast<GLfloat>(diffuse.alphaF()) },
+            { static_cast<GLfloat>(ambient.redF()), static_cast<GLfloat>(ambient.greenF()),
+              static_cast<GLfloat>(ambient.blueF()), static_cast<GLfloat>(ambient.alphaF()) }
+        };
+
+        int index = static_cast<int>(m_materialData.size());
+        m_materialData.push_back(data);
+        m_materialIndices.insert(&material, index);
+        return index;
+    }
+
+
+    /**
+     * \param mesh        The mesh to upload.
+     * \param cachedMesh  The cache entry to store the created GL objects in.
+     *
+     * Creates the vertex and index buffers for a mesh, along with a vertex array capturing
+     * the attribute bindings where the context supports them.
+     */
+    bool  GLRendererImpl::uploadMesh(Mesh& mesh, CachedMesh& cachedMesh)
+    {
+        // Qt does shallow copy, so we can copy buffers around in "shallow" manner.
+        // Start by creating our vertex data.
+        {
+            QGLBuffer vbo(QGLBuffer::VertexBuffer);
+            vbo.setUsagePattern(QGLBuffer::StreamDraw);
+            if ( !vbo.create() )
+            {
+                std::cout << "ERROR: Failed to create vertex buffer object." << std::endl;
+                return false;
+            }
+
+            vbo.bind();
+            std::vector<Vertex>& vertices = mesh.getVertices();
+            vbo.allocate(&vertices.front(), vertices.size() * sizeof(Vertex));
+            cachedMesh.m_vertexData = vbo;
+        }
+
+        // Now process the elements, packing every list into the one index buffer.
+        std::list<ElementList>& elementLists = mesh.getElementLists();
+        int totalIndices = 0;
+        for (std::list<ElementList>::iterator elIter = elementLists.begin(); elIter != elementLists.end(); ++elIter)
+        {
+            totalIndices += elIter->getIndices().size();
+        }
+
+        {
+            QGLBuffer ibo(QGLBuffer::IndexBuffer);
+            ibo.setUsagePattern(QGLBuffer::StreamDraw);
+            if ( !ibo.create() )
+            {
+                std::cout << "ERROR: Failed to create index buffer object." << std::endl;
+                return false;
+            }
+
+            ibo.bind();
+            ibo.allocate(totalIndices * sizeof(unsigned));
+
+            size_t offset = 0;
+            for (std::list<ElementList>::iterator elIter = elementLists.begin(); elIter != elementLists.end(); ++elIter)
+            {
+                std::vector<unsigned>& indices = elIter->getIndices();
+                if (indices.empty())
+                {
+                    continue;
+                }
+
+                IndexDataList ranges;
+                if (!addIndexRanges(*elIter, offset, mesh.getVertices().size(), ranges))
+                {
+                    std::cout << "ERROR: Mesh " << mesh.instanceName() << " has an index outside of its vertex array." << std::endl;
+                    return false;
+                }
+                cachedMesh.m_indexRanges.insert(cachedMesh.m_indexRanges.end(), ranges.begin(), ranges.end());
+
+                if (elIter->getClusters().empty())
+                {
+                    cachedMesh.m_unclusteredRanges.insert(cachedMesh.m_unclusteredRanges.end(), ranges.begin(), ranges.end());
+                }
+                else
+                {
+                    addClusterRanges(*elIter, offset, cachedMesh);
+                }
+
+                ibo.write(offset, &indices.front(), indices.size() * sizeof(unsigned));
+                offset += indices.size() * sizeof(unsigned);
+            }
+            cachedMesh.m_indexData = ibo;
+        }
+
+        if (m_extensions.hasVertexArrayObjects())
+        {
+            m_extensions.glGenVertexArrays(1, &cachedMesh.m_vertexArray);
+            m_extensions.glBindVertexArray(cachedMesh.m_vertexArray);
+            bindVertexAttributes(cachedMesh);
+            m_extensions.glBindVertexArray(0);
+        }
+
+        // The element array binding is part of vertex array state, so release it only
+        // after the vertex array has been unbound.
+        QGLBuffer::release(QGLBuffer::IndexBuffer);
+        QGLBuffer::release(QGLBuffer::VertexBuffer);
+
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * \param elements     The element list being uploaded.
+     * \param offset       Byte offset of the list's first index in the index buffer.
+     * \param numVertices  Number of vertices in the mesh, for range checking.
+     * \param ranges       The list to append the drawable ranges of the element list to.
+     * \return False if any index refers past the end of the vertex array.
+     *
+     * Each list normally becomes one range. Strips are split at each restart index
+     * instead when the context can't restart primitives itself.
+     */
+    bool  GLRendererImpl::addIndexRanges(const ElementList& elements, size_t offset, size_t numVertices, IndexDataList& ranges) const
+    {
+        const std::vector<unsigned>& indices = elements.getIndices();
+        bool splitStrips = elements.getElementType() == ElementList::TRI_STRIP && !m_extensions.hasPrimitiveRestart();
+
+        size_t first = 0;
+        GLuint minVertex = ElementList::RESTART_INDEX;
+        GLuint maxVertex = 0;
+        for (size_t i = 0; i <= indices.size(); ++i)
+        {
+            bool endOfRange = i == indices.size() || (splitStrips && indices[i] == ElementList::RESTART_INDEX);
+            if (endOfRange)
+            {
+                // Skip empty ranges, such as those between consecutive restart indices.
+                if (minVertex <= maxVertex)
+                {
+                    ranges.push_back( IndexBufferData(elements.getElementType(), offset + first * sizeof(unsigned),
+                                                      i - first, minVertex, maxVertex) );
+                }
+                first = i + 1;
+                minVertex = ElementList::RESTART_INDEX;
+                maxVertex = 0;
+                continue;
+            }
+
+            GLuint index = indices[i];
+            if (index == ElementList::RESTART_INDEX)
+            {
+                continue;
+            }
+            if (index >= numVertices)
+            {
+                return false;
+            }
+            minVertex = std::min(minVertex, index);
+            maxVertex = std::max(maxVertex, index);
+        }
+
+        return true;
+    }
+
+
+    /**
+     * \param elements    A clustered triangle list being uploaded.
+     * \param offset      Byte offset of the list's first index in the index buffer.
+     * \param cachedMesh  The cache entry to add the clusters and their ranges to.
+     *
+     * \pre The indices of the list have already been range checked.
+     */
+    void  GLRendererImpl::addClusterRanges(const ElementList& elements, size_t offset, CachedMesh& cachedMesh) const
+    {
+        const std::vector<unsigned>& indices = elements.getIndices();
+        const MeshClusterList& clusters = elements.getClusters();
+        for (MeshClusterList::const_iterator cIter = clusters.begin(); cIter != clusters.end(); ++cIter)
+        {
+            unsigned first = cIter->getFirstIndex();
+            unsigned end = std::min(first + cIter->getNumIndices(), static_cast<unsigned>(indices.size()));
+            if (first >= end)
+            {
+                continue;
+            }
+
+            GLuint minVertex = indices[first];
+            GLuint maxVertex = indices[first];
+            for (unsigned i = first + 1; i < end; ++i)
+            {
+                minVertex = std::min(minVertex, indices[i]);
+                maxVertex = std::max(maxVertex, indices[i]);
+            }
+
+            cachedMesh.m_clusters.push_back(*cIter);
+            cachedMesh.m_clusterRanges.push_back(IndexBufferData(ElementList::TRI_LIST, offset + first * sizeof(unsigned),
+                                                                 end - first, minVertex, maxVertex));
+        }
+    }
+
+
+    /**
+     * \param cachedMesh  The mesh whose buffers should be bound.
+     *
+     * Binds the vertex and index buffers of the mesh and points the vertex attributes at
+     * them. When a vertex array is bound this records the state into it; otherwise it is
+     * what has to happen before every draw.
+     */
+    void  GLRendererImpl::bindVertexAttributes(CachedMesh& cachedMesh)
+    {
+        // Bind our vertex data to the appropriate attribute locations.
+        int stride = 8 * sizeof(GLfloat);
+        cachedMesh.m_vertexData.bind();
+        glVertexAttribPointer(GLRenderer::Position, 3, GL_FLOAT, false, stride, 0);
+        glVertexAttribPointer(GLRenderer::Normal, 3, GL_FLOAT, false, stride, (GLvoid*)(3 * sizeof(GLfloat)));
+        glEnableVertexAttribArray(GLRenderer::Position);
+        glEnableVertexAttribArray(GLRenderer::Normal);
+        cachedMesh.m_indexData.bind();
+    }
+
+
+    /**
+     *
+     */
+    bool  GLRendererImpl::preRender(Scene& scene)
+    {
+        // Make sure the relevant initialization has taken place prior to performing any rendering.
+        assert(m_initialized);
+
+        // Ensure we have a camera set
+        if (!m_camera)
+        {
+            return false;
+        }
+
+        // Need to setup the view and projection matrices in preparation for rendering.
+        if (!setupMatrices(scene))
+            return false;
+
+#ifndef NDEBUG
+#ifdef Q_OS_OSX
+        // On newer versions of OSX, it's possible (somehow) to create a widget before creating
+        // a main framebuffer. This causes OpenGL to return the GL_FRAMEBUFFER_UNDEFINED
+        // error, and god knows what problems this causes if we continue to render to a context
+        // with no current draw framebuffer.
+        GLenum framebufferStatus = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER);
+        assert(framebufferStatus != GL_FRAMEBUFFER_UNDEFINED);
+#endif
+#endif
+
+        // Clear the buffers in preparation for redrawing the scene.
+        const QColor& bc = QColor(255, 255, 255, 255);
+        glClearColor( bc.redF(), bc.greenF(), bc.blueF(), bc.alphaF() );
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     *
+     */
+    bool  GLRendererImpl::renderScene(Scene &scene)
+    {
+        // The occluders are drawn on worker threads while the shaders are prepared.
+        ++m_frame;
+
+        // Instances drawn into the pick may have left the scene since, and their addresses
+        // been given to new ones, so it finds nothing.
+        if (m_pickFence && (&scene != m_pickScene || scene.getIndex().getGeneration() != m_pickGeneration))
+        {
+            m_pickInstances.clear();
+        }
+        readPickResult();
+        if (m_frame % s_lodStateLifetime == 0)
+        {
+            releaseLodStates();
+        }
+
+        m_occludedCount = 0;
+        beginOcclusionBuffer(scene);
+        prepareShaders();
+
+        // Processing the scene only queues the items to draw. They are submitted afterwards,
+        // which lets indirect submission group them by shader.
+        m_renderQueue.clear();
+        m_visibleRanges.clear();
+        m_culledClusterCount = 0;
+        if (!scene.getRootNode().draw(&m_renderer))
+        {
+            std::cout << "ERROR: Failed to draw scene." << std::endl;
+            return false;
+        }
+
+        removePendingItems();
+
+        bool success = useIndirectSubmission() ? submitIndirect(scene) : submitDirect(scene);
+        if (!success)
+        {
+            std::cout << "ERROR: Failed to submit draws." << std::endl;
+            return false;
+        }
+
+        // Only one pick is in flight at a time; a later request waits for it to finish.
+        if (m_pickRequested && !m_pickFence)
+        {
+            if (!canPick())
+            {
+                m_pickRequested = false;
+                m_hasPickResult = true;
+                m_pickResult = 0;
+            }
+            else if (m_idShader->isReady())
+            {
+                m_pickScene = &scene;
+                m_pickGeneration = scene.getIndex().getGeneration();
+                if (!drawPickPass())
+                {
+                    std::cout << "ERROR: Failed to draw the picking pass." << std::endl;
+                    return false;
+                }
+            }
+        }
+
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * \param x  Horizontal position in the view, in pixels from the left edge.
+     * \param y  Vertical position in the view, in pixels from the top edge.
+     * \return False if the context can't pick.
+     *
+     * The pick is drawn at the end of the next frame, and its result read back in a later
+     * one, once the GPU has finished with it.
+     */
+    bool  GLRendererImpl::requestPick(int x, int y)
+    {
+        // The shader is only checked when the pick is drawn, with the context current.
+        if (!m_initialized || !m_idShader || m_pickTargetsFailed)
+        {
+            return false;
+        }
+
+        m_pickRequested = true;
+        m_pickX = x;
+        m_pickY = y;
+        return true;
+    }
+
+
+    /**
+     * \return True unless the context is missing something picking needs, or the ID shader
+     *         or render targets failed to build. The shader may still be being built.
+     */
+    bool  GLRendererImpl::canPick()
+    {
+        return m_initialized && m_extensions.hasAsyncReadback() && !m_pickTargetsFailed &&
+               m_idShader && m_idShader->prepare();
+    }
+
+
+    /**
+     * Creates the framebuffer the picking pass draws into, and the pixel buffer its result
+     * is copied to. Only the pixel under the cursor is drawn, so both hold a single pixel.
+     */
+    bool  GLRendererImpl::createPickTargets()
+    {
+        if (m_pickFramebuffer)
+        {
+            return true;
+        }
+
+        glGenRenderbuffers(1, &m_pickColorBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_pickColorBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_R32UI, 1, 1);
+        glGenRenderbuffers(1, &m_pickDepthBuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_pickDepthBuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 1, 1);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &m_pickFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_pickFramebuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_pickColorBuffer);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_pickDepthBuffer);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+        glGenBuffers(1, &m_pickPixelBuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pickPixelBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(GLuint), 0, GL_STREAM_READ);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::cout << "ERROR: Picking framebuffer is incomplete (status " << status << ")." << std::endl;
+            releasePickTargets();
+            m_pickTargetsFailed = true;
+            return false;
+        }
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     *
+     */
+    void  GLRendererImpl::releasePickTargets()
+    {
+        if (m_pickFence)
+        {
+            m_extensions.glDeleteSync(m_pickFence);
+            m_pickFence = 0;
+        }
+        if (m_pickFramebuffer)
+        {
+            glDeleteFramebuffers(1, &m_pickFramebuffer);
+            m_pickFramebuffer = 0;
+        }
+        if (m_pickColorBuffer)
+        {
+            glDeleteRenderbuffers(1, &m_pickColorBuffer);
+            m_pickColorBuffer = 0;
+        }
+        if (m_pickDepthBuffer)
+        {
+            glDeleteRenderbuffers(1, &m_pickDepthBuffer);
+            m_pickDepthBuffer = 0;
+        }
+        if (m_pickPixelBuffer)
+        {
+            glDeleteBuffers(1, &m_pickPixelBuffer);
+            m_pickPixelBuffer = 0;
+        }
+    }
+
+
+    /**
+     * Draws every queued item with its index into m_pickInstances, plus one, as its ID.
+     * The projection is narrowed to the pixel under the cursor, so the single pixel
+     * target holds whatever is nearest there, and items outside it are skipped. The pixel
+     * is then copied into the pixel buffer, and a fence placed after it, so that the
+     * result can be read once the GPU has got that far, without stalling the pipeline.
      */
-    bool  GLRendererImpl::process(const MeshInstance& instance)
+    bool  GLRendererImpl::drawPickPass()
     {
-        PtrMesh ptrMesh = instance.getMesh();
-        if (ptrMesh.isNull())
+        if (!createPickTargets())
         {
-            std::cout << "ERROR: Mesh " << instance.instanceName() << " contents are invalid." << std::endl;
             return false;
         }
-        Mesh& mesh = *ptrMesh;
 
-        // For both our vertices and all our primitives, we check to see whether a buffer exists
-        // for our data, and if not, we create one.
-        MeshDataCache::iterator meshIter = m_meshCache.find(mesh.instanceName());
-        if (m_meshCache.end() == meshIter)
+        GLint previousFramebuffer = 0;
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_pickFramebuffer);
+        setupViewport(0, 0, 1, 1);
+
+        // The frame may have finished with depth writes off, after a depth pre-pass.
+        GLboolean depthMask = GL_TRUE;
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+        glDepthMask(GL_TRUE);
+
+        const GLuint background[4] = { 0, 0, 0, 0 };
+        m_extensions.glClearBufferuiv(GL_COLOR, 0, background);
+        glClear(GL_DEPTH_BUFFER_BIT);
+
+        // Scale and shift clip space so that the pixel's footprint fills it.
+        Matrix4f matPick;
+        matPick.toIdentity();
+        matPick(0,0) = static_cast<float>(m_width);
+        matPick(0,3) = m_width - 2.0f * (m_pickX + 0.5f);
+        matPick(1,1) = static_cast<float>(m_height);
+        matPick(1,3) = 2.0f * (m_pickY + 0.5f) - m_height;
+
+        const Matrix4f matProj = m_matProj;
+        m_matProj = matPick * matProj;
+        const Matrix4f matViewProj = m_matProj * m_matViewRelative;
+
+        m_pickInstances.clear();
+        bool success = m_idShader->activate(m_matView);
+        for (RenderQueue::const_iterator iter = m_renderQueue.begin(); success && iter != m_renderQueue.end(); ++iter)
         {
-            CachedMesh cachedMesh(mesh.instanceName());
-
-            // Qt does shallow copy, so we can copy buffers around in "shallow" manner.
-            // Start by creating our vertex data.
+            const BoundingBox bound = getRelativeBound(iter->m_instance->getWorldBound());
+            if (!bound.isEmpty() && isOutsideFrustum(bound, matViewProj))
             {
-                QGLBuffer vbo(QGLBuffer::VertexBuffer);
-                vbo.setUsagePattern(QGLBuffer::StreamDraw);
-                if ( !vbo.create() )
-                {
-                    std::cout << "ERROR: Failed to create vertex buffer object." << std::endl;
-                    return false;
-                }
-
-                vbo.bind();
-                std::vector<Vertex>& vertices = mesh.getVertices();
-                vbo.allocate(&vertices.front(), vertices.size() * sizeof(Vertex));
-                cachedMesh.m_vertexData = vbo;
+                continue;
             }
 
-            // Now process the elements.
-            std::list<ElementList>& elementLists = mesh.getElementLists();
-            for (std::list<ElementList>::iterator elIter = elementLists.begin(); elIter != elementLists.end(); ++elIter)
-            {
-                QGLBuffer vbo(QGLBuffer::IndexBuffer);
-                vbo.setUsagePattern(QGLBuffer::StreamDraw);
-                if ( !vbo.create() )
-                {
-                    std::cout << "ERROR: Failed to create index buffer object." << std::endl;
-                    return false;
-                }
-
-                vbo.bind();
-                std::vector<unsigned>& indices = elIter->getIndices();
-                vbo.allocate(&indices.front(), indices.size() * sizeof(unsigned));
-                cachedMesh.m_indexData.push_front( IndexBufferData(elIter->getElementType(), vbo, indices.size()) );
-            }
+            m_pickInstances.push_back(iter->m_instance);
+            success = m_idShader->setId(static_cast<GLuint>(m_pickInstances.size())) && drawDirect(*iter, *m_idShader);
+        }
+        m_matProj = matProj;
 
-            meshIter = m_meshCache.insert(mesh.instanceName(), cachedMesh);
+        if (success)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pickPixelBuffer);
+            glReadPixels(0, 0, 1, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, 0);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            m_pickFence = m_extensions.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_pickRequested = false;
         }
 
-        // Now that we've created the data, we can bind and render it.
-        CachedMesh& glMesh = *meshIter;
+        glDepthMask(depthMask);
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        setupViewport(0, 0, m_width, m_height);
+        return success && GL_GOOD_STATE();
+    }
+
 
-        // Activate the shader
-        const PtrShader& ptrShader = instance.getShader();
-        if (ptrShader.isNull())
+    /**
+     * Takes the result of the pick in flight, if the GPU has finished drawing it. Never
+     * waits; if it isn't done yet, it is checked again next frame.
+     */
+    void  GLRendererImpl::readPickResult()
+    {
+        if (!m_pickFence)
         {
-            std::cout << "ERROR: Mesh instance must have a valid shader in order to be rendered." << std::endl;
-            return false;
+            return;
         }
 
-        // Compute our matrices, starting by obtaining the world matrix.
-        Matrix4f matWorld;
-        instance.getWorldTransformation().toMatrix(matWorld);
-        Matrix4f matWorldView(m_matView * matWorld);
-        Matrix4f matWorldViewInvTranspose(matWorldView.inverse().transpose());
-        Matrix4f matWorldViewProj(m_matProj * matWorldView);
-        if (!ptrShader->activate(m_matView, matWorldView, matWorldViewInvTranspose, matWorldViewProj))
+        GLint status = GL_UNSIGNALED;
+        m_extensions.glGetSynciv(m_pickFence, GL_SYNC_STATUS, 1, 0, &status);
+        if (status != GL_SIGNALED)
         {
-            std::cout << "ERROR: Failed to activate shader." << std::endl;
-            return false;
+            return;
         }
+        m_extensions.glDeleteSync(m_pickFence);
+        m_pickFence = 0;
 
-        // Bind our vertex data to the appropriate attribute locations.
-        int stride = 8 * sizeof(GLfloat);
-        glMesh.m_vertexData.bind();
-        glVertexAttribPointer(GLRenderer::Position, 3, GL_FLOAT, false, stride, 0);
-        glVertexAttribPointer(GLRenderer::Normal, 3, GL_FLOAT, false, stride, (GLvoid*)(3 * sizeof(GLfloat)));
-        glEnableVertexAttribArray(GLRenderer::Position);
-        glEnableVertexAttribArray(GLRenderer::Normal);
-
-        // Now render each set of elements.
-        IndexBufferData* indices = 0;
-        for (std::list<IndexBufferData>::iterator iIter = glMesh.m_indexData.begin(); iIter != glMesh.m_indexData.end(); ++iIter)
+        GLuint id = 0;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pickPixelBuffer);
+        const GLvoid* data = m_extensions.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(GLuint), GL_MAP_READ_BIT);
+        if (data)
         {
-            indices = &*iIter;
-            indices->m_indexData.bind();
-            switch (indices->m_type)
-            {
-            case ElementList::TRI_LIST:
-                glDrawElements(indices->m_type, 3 * indices->m_numIndices, GL_UNSIGNED_INT, 0);
-                break;
-            default:
-                std::cout << "ERROR: Unable to render element type " << indices->m_type << std::endl;
-            }
+            std::memcpy(&id, data, sizeof(GLuint));
+            m_extensions.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
         }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-        return GL_GOOD_STATE();
+        m_pickResult = (id > 0 && id <= m_pickInstances.size()) ? m_pickInstances[id - 1] : 0;
+        m_hasPickResult = true;
+        m_pickInstances.clear();
     }
 
 
     /**
-     *
+     * Starts building the programs of every shader registered since the last frame, so
+     * that they all compile in parallel rather than one after another as they are drawn.
+     * Also picks up shaders reloaded from disk; being at the start of the frame, every
+     * draw in it uses either the old or the new version of a shader, never both.
      */
-    bool  GLRendererImpl::preRender(Scene& scene)
+    void  GLRendererImpl::prepareShaders()
     {
-        // Make sure the relevant initialization has taken place prior to performing any rendering.
-        assert(m_initialized);
+        m_hasPendingReloads = ShaderReloader::instance().update();
 
-        // Ensure we have a camera set
-        if (!m_camera)
+        for (std::vector<PtrShader>::iterator iter = m_shadersToPrepare.begin(); iter != m_shadersToPrepare.end(); ++iter)
         {
-            return false;
+            (*iter)->prepare();
         }
-
-        // Need to setup the view and projection matrices in preparation for rendering.
-        if (!setupMatrices(scene))
-            return false;
-
-#ifndef NDEBUG
-#ifdef Q_OS_OSX
-        // On newer versions of OSX, it's possible (somehow) to create a widget before creating
-        // a main framebuffer. This causes OpenGL to return the GL_FRAMEBUFFER_UNDEFINED
-        // error, and god knows what problems this causes if we continue to render to a context
-        // with no current draw framebuffer.
-        GLenum framebufferStatus = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER);
-        assert(framebufferStatus != GL_FRAMEBUFFER_UNDEFINED);
-#endif
-#endif
-
-        // Clear the buffers in preparation for redrawing the scene.
-        const QColor& bc = QColor(255, 255, 255, 255);
-        glClearColor( bc.redF(), bc.greenF(), bc.blueF(), bc.alphaF() );
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        return GL_GOOD_STATE();
+        m_shadersToPrepare.clear();
     }
 
 
     /**
-     *
+     * Takes items whose shader is still being built out of the queue, so the frame never
+     * waits on the shader compiler. The items are drawn with the fallback material instead
+     * if it has one that is ready. Items whose shader failed to build are dropped.
      */
-    bool  GLRendererImpl::renderScene(Scene &scene)
+    void  GLRendererImpl::removePendingItems()
     {
-        // Currently, we are rendering directly as we process each item in the scene. This is less than ideal,
-        // as what we'd really like to do is sort each item so that we can efficiently render them. The best way
-        // to do this is to generate a queue of items, sorted according to some pre-generated key.
-        if (!scene.getRootNode().draw(&m_renderer))
+        m_hasPendingShaders = m_hasPendingReloads;
+
+        Shader* fallbackShader = 0;
+        if (m_fallbackMaterial && m_fallbackMaterial->getShader() &&
+            m_fallbackMaterial->getShader()->prepare() && m_fallbackMaterial->getShader()->isReady())
         {
-            std::cout << "ERROR: Failed to draw scene." << std::endl;
-            return false;
+            fallbackShader = m_fallbackMaterial->getShader().data();
         }
 
-        return GL_GOOD_STATE();
+        RenderQueue::iterator output = m_renderQueue.begin();
+        for (RenderQueue::iterator iter = m_renderQueue.begin(); iter != m_renderQueue.end(); ++iter)
+        {
+            // Shaders that were never registered are started here, the first time they're seen.
+            if (!iter->m_shader->prepare())
+            {
+                continue;
+            }
+
+            if (!iter->m_shader->isReady())
+            {
+                m_hasPendingShaders = true;
+                if (!fallbackShader)
+                {
+                    continue;
+                }
+                iter->m_material = m_fallbackMaterial.data();
+                iter->m_shader = fallbackShader;
+            }
+
+            *output++ = *iter;
+        }
+        m_renderQueue.erase(output, m_renderQueue.end());
     }
 
 
@@ -355,6 +2172,10 @@ namespace GLDemo
             return true;
 
         initializeGLFunctions();
+        if (!m_extensions.initialize(QGLContext::currentContext()))
+        {
+            return false;
+        }
 
         // Set up our 'permanently' enabled GL states.
         glEnable(GL_DEPTH_TEST);
@@ -362,6 +2183,22 @@ namespace GLDemo
         glCullFace(GL_BACK);
         glFrontFace(GL_CCW);
 
+        if (m_extensions.hasPrimitiveRestart())
+        {
+            m_extensions.enablePrimitiveRestart(ElementList::RESTART_INDEX);
+        }
+
+        // Built alongside the scene's own shaders, in case a scene asks for a pre-pass.
+        m_depthShader = QSharedPointer<DepthShader>(new DepthShader());
+        m_shadersToPrepare.push_back(m_depthShader);
+
+        // The ID shader needs integer outputs, so is only built if picking is possible.
+        if (m_extensions.hasAsyncReadback())
+        {
+            m_idShader = QSharedPointer<IdShader>(new IdShader());
+            m_shadersToPrepare.push_back(m_idShader);
+        }
+
         m_initialized = true;
         return GL_GOOD_STATE();
     }
@@ -375,6 +2212,11 @@ namespace GLDemo
         m_width  = width;
         m_height = height;
 
+        if (width > 0 && height > 0)
+        {
+            m_occlusionBuffer.setSize(s_occlusionBufferWidth, std::max(1, s_occlusionBufferWidth * height / width));
+        }
+
         setupViewport(0, 0, width, height);
 
         return true;
@@ -505,11 +2347,261 @@ namespace GLDemo
     }
 
 
+    /**
+     * \param mode  The way draws should be handed to OpenGL. Indirect submission silently
+     *              falls back to direct submission on contexts that do not support it.
+     */
+    void GLRenderer::setSubmissionMode(SubmissionMode mode)
+    {
+        m_pImpl->m_submissionMode = mode;
+        warnIfOcclusionCullingIgnored(m_pImpl->m_submissionMode, m_pImpl->m_occlusionCulling);
+    }
+
+
+    /**
+     *
+     */
+    GLRenderer::SubmissionMode GLRenderer::getSubmissionMode() const
+    {
+        return m_pImpl->m_submissionMode;
+    }
+
+
+    /**
+     * \pre The renderer must have been initialized.
+     * \return True if the context supports indirect submission.
+     */
+    bool GLRenderer::supportsIndirectSubmission() const
+    {
+        return m_pImpl->m_extensions.hasMultiDrawIndirect();
+    }
+
+
+    /**
+     * \param enabled  True to leave out items hidden behind others, as found by occlusion
+     *                 queries. Only affects direct submission, and has no effect on
+     *                 contexts without occlusion queries. Indirect submission ignores
+     *                 it, and a warning is printed if both are asked for.
+     *
+     * Each item is tested against the depth of the items drawn before it, using the
+     * result of its query from an earlier frame so that nothing waits on the GPU. Items
+     * found hidden are drawn last, and only if their bounding box passes a query issued
+     * against everything else in the frame. Where the context supports conditional
+     * rendering, that decision is made on the GPU within the frame, so an item never
+     * appears late; otherwise it is left out until the query result arrives.
+     */
+    void GLRenderer::setOcclusionCulling(bool enabled)
+    {
+        m_pImpl->m_occlusionCulling = enabled;
+        warnIfOcclusionCullingIgnored(m_pImpl->m_submissionMode, m_pImpl->m_occlusionCulling);
+    }
+
+
+    /**
+     *
+     */
+    bool GLRenderer::isOcclusionCullingEnabled() const
+    {
+        return m_pImpl->m_occlusionCulling;
+    }
+
+
+    /**
+     * \param enabled  True to cull items hidden behind the scene's occluders (see
+     *                 Scene::addOccluder()) on the CPU, before they reach the GPU.
+     *
+     * The occluders are rasterized into a small depth buffer on worker threads, and the
+     * world bound of every other item is tested against it as the scene is processed.
+     * Unlike setOcclusionCulling(), this needs nothing from the context.
+     */
+    void GLRenderer::setSoftwareOcclusionCulling(bool enabled)
+    {
+        m_pImpl->m_softwareCulling = enabled;
+    }
+
+
+    /**
+     *
+     */
+    bool GLRenderer::isSoftwareOcclusionCullingEnabled() const
+    {
+        return m_pImpl->m_softwareCulling;
+    }
+
+
+    /**
+     * \pre The renderer must have been initialized.
+     * \return True if the context supports occlusion queries.
+     */
+    bool GLRenderer::supportsOcclusionCulling() const
+    {
+        return m_pImpl->m_extensions.hasOcclusionQueries();
+    }
+
+
+    /**
+     * \return The number of items the last frame treated as hidden, by either kind of
+     *         occlusion culling. With conditional rendering, the GPU may still have drawn
+     *         some of them if they came into view.
+     */
+    int GLRenderer::getOccludedCount() const
+    {
+        return m_pImpl->m_occludedCount;
+    }
+
+
+    /**
+     * \param enabled  True to leave out the clusters of clustered meshes that face away
+     *                 from the camera or lie outside the view (see
+     *                 MeshCluster::buildClusters()). On by default; has no effect on
+     *                 meshes without clusters.
+     */
+    void GLRenderer::setClusterCulling(bool enabled)
+    {
+        m_pImpl->m_clusterCulling = enabled;
+    }
+
+
+    /**
+     *
+     */
+    bool GLRenderer::isClusterCullingEnabled() const
+    {
+        return m_pImpl->m_clusterCulling;
+    }
+
+
+    /**
+     * \return The number of clusters the last frame left out.
+     */
+    int GLRenderer::getCulledClusterCount() const
+    {
+        return m_pImpl->m_culledClusterCount;
+    }
+
+
+    /**
+     * \param pixels  How far, in pixels, the surface of a simplified level of detail may
+     *                appear from that of the full mesh (see Mesh::addLod()). Zero to always
+     *                draw meshes in full.
+     */
+    void GLRenderer::setLodThreshold(float pixels)
+    {
+        m_pImpl->m_lodThreshold = pixels;
+    }
+
+
+    /**
+     *
+     */
+    float GLRenderer::getLodThreshold() const
+    {
+        return m_pImpl->m_lodThreshold;
+    }
+
+
+    /**
+     * \return True if the context can read back instance identifiers without stalling
+     *         (GL 3.2, or GL 3.0 with ARB_sync).
+     */
+    bool GLRenderer::supportsIdPicking() const
+    {
+        return m_pImpl->m_extensions.hasAsyncReadback();
+    }
+
+
+    /**
+     * \param x  Horizontal position in the view, in pixels from the left edge.
+     * \param y  Vertical position in the view, in pixels from the top edge.
+     * \return False if picking isn't supported.
+     *
+     * Asks for the instance drawn at a pixel. The pick is drawn with the next frame, into
+     * an integer render target holding an identifier per instance, and read back a frame
+     * or two later, once the GPU has caught up, without waiting for it. Poll for the result
+     * with takePickResult() after each frame. If entities enter or leave the scene while a
+     * pick is pending, it finds nothing.
+     */
+    bool GLRenderer::requestPick(int x, int y)
+    {
+        return m_pImpl->requestPick(x, y);
+    }
+
+
+    /**
+     * \return True if a pick has been requested whose result has not yet arrived. More
+     *         frames must be drawn for it to.
+     */
+    bool GLRenderer::hasPendingPick() const
+    {
+        return m_pImpl->m_pickRequested || m_pImpl->m_pickFence;
+    }
+
+
+    /**
+     * \param instance  Set to the instance picked, or null if there was nothing at the pixel.
+     * \return True if the result of a pick has arrived since it was last taken.
+     */
+    bool GLRenderer::takePickResult(const MeshInstance*& instance)
+    {
+        if (!m_pImpl->m_hasPickResult)
+        {
+            return false;
+        }
+
+        instance = m_pImpl->m_pickResult;
+        m_pImpl->m_hasPickResult = false;
+        m_pImpl->m_pickResult = 0;
+        return true;
+    }
+
+
+    /**
+     * \param shader  A shader the scene will be drawn with.
+     *
+     * Registered shaders start building at the beginning of the next frame, in parallel.
+     * Shaders that are not registered start building the first time they're drawn, which
+     * delays when they first appear.
+     */
+    void GLRenderer::registerShader(const PtrShader& shader)
+    {
+        m_pImpl->m_shadersToPrepare.push_back(shader);
+    }
+
+
+    /**
+     * \param material  The material to draw items with while their own shader is still
+     *                  being built, or null to leave those items out of the frame.
+     */
+    void GLRenderer::setFallbackMaterial(const PtrMaterial& material)
+    {
+        m_pImpl->m_fallbackMaterial = material;
+        if (material && material->getShader())
+        {
+            m_pImpl->m_shadersToPrepare.push_back(material->getShader());
+        }
+    }
+
+
+    /**
+     * \return True if the last frame left anything out, or drew it with the fallback
+     *         material, because its shader wasn't ready. Another frame should be drawn
+     *         once the shader has been built.
+     */
+    bool GLRenderer::hasPendingShaders() const
+    {
+        return m_pImpl->m_hasPendingShaders;
+    }
+
+
     /**
      *
      */
     bool  GLRenderer::process(const MeshInstance& instance)
     {
+        if (m_pImpl->isHiddenByOccluders(instance))
+        {
+            return true;
+        }
         return m_pImpl->process(instance);
     }
 
@@ -1,7 +1,9 @@
 #ifndef GLDEMO_GLRENDERER_H
 #define GLDEMO_GLRENDERER_H
 
+#include "material.h"
 #include "renderer.h"
+#include "shader.h"
 
 class QPaintDevice;
 
@@ -23,6 +25,25 @@ namespace GLDemo
             Normal = 1
         };
 
+        enum BufferBinding
+        {
+            PerDrawData = 0,    // Storage buffer of per-draw transforms, indexed by gl_DrawID
+            MaterialData = 1    // Storage buffer of the parameters of each material drawn in the frame
+        };
+
+        /**
+         * How queued draws are handed to OpenGL. Indirect submission places every mesh in a
+         * shared buffer and issues a single multi-draw call per shader, which needs GL 4.3
+         * and ARB_shader_draw_parameters; if these are missing, draws are submitted directly.
+         * Indirect submission always draws nearest first and doesn't do occlusion culling
+         * (setOcclusionCulling()); only direct submission honours the two.
+         */
+        enum SubmissionMode
+        {
+            DirectSubmission,
+            IndirectSubmission
+        };
+
         GLRenderer(QPaintDevice& device);
         virtual ~GLRenderer();
 
@@ -37,6 +58,33 @@ namespace GLDemo
         int    getWidth() const;
         int    getHeight() const;
 
+        void            setSubmissionMode(SubmissionMode mode);
+        SubmissionMode  getSubmissionMode() const;
+        bool            supportsIndirectSubmission() const;
+
+        void            registerShader(const PtrShader& shader);
+        void            setFallbackMaterial(const PtrMaterial& material);
+        bool            hasPendingShaders() const;
+
+        void            setOcclusionCulling(bool enabled);
+        bool            isOcclusionCullingEnabled() const;
+        bool            supportsOcclusionCulling() const;
+        void            setSoftwareOcclusionCulling(bool enabled);
+        bool            isSoftwareOcclusionCullingEnabled() const;
+        int             getOccludedCount() const;
+
+        void            setClusterCulling(bool enabled);
+        bool            isClusterCullingEnabled() const;
+        int             getCulledClusterCount() const;
+
+        void            setLodThreshold(float pixels);
+        float           getLodThreshold() const;
+
+        bool            supportsIdPicking() const;
+        bool            requestPick(int x, int y);
+        bool            hasPendingPick() const;
+        bool            takePickResult(const MeshInstance*& instance);
+
         virtual bool process(const MeshInstance& instance);
 
     private:
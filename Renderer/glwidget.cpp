@@ -45,6 +45,10 @@ namespace GLDemo
     /**
      * \param camera The camera representing the viewpoint from which the scene is to
      * be rendered.
+     *
+     * A camera kept out of the scene graph is moved without waiting for the frame loop,
+     * if there is one. Moving one inside it waits for the loop's worker and throws away
+     * the ticks it has simulated.
      */
     void  GLWidget::setCamera(Camera* camera)
     {
@@ -52,6 +56,79 @@ namespace GLDemo
     }
 
 
+    /**
+     * \param shader  A shader the scene will be drawn with, to be compiled in the
+     *                background before it is first needed.
+     */
+    void  GLWidget::registerShader(const PtrShader& shader)
+    {
+        m_pImpl->registerShader(shader);
+    }
+
+
+    /**
+     * \param material  The material used in place of any whose shader isn't ready yet.
+     */
+    void  GLWidget::setFallbackMaterial(const PtrMaterial& material)
+    {
+        m_pImpl->setFallbackMaterial(material);
+    }
+
+
+    /**
+     * \param enabled  True to leave out items hidden behind others. Can be changed at
+     *                 any time; the next frame is drawn with the new setting.
+     */
+    void  GLWidget::setOcclusionCulling(bool enabled)
+    {
+        m_pImpl->setOcclusionCulling(enabled);
+    }
+
+
+    /**
+     * \param enabled  True to cull items hidden behind the scene's occluders on the CPU.
+     */
+    void  GLWidget::setSoftwareOcclusionCulling(bool enabled)
+    {
+        m_pImpl->setSoftwareOcclusionCulling(enabled);
+    }
+
+
+    /**
+     * \param pixels  The largest error, in pixels, allowed of a simplified level of
+     *                detail, or zero to always draw meshes in full.
+     */
+    void  GLWidget::setLodThreshold(float pixels)
+    {
+        m_pImpl->setLodThreshold(pixels);
+    }
+
+
+    /**
+     * \param enabled  True to pick by reading back the instance drawn under the cursor,
+     *                 where the context supports it, rather than by tracing a ray through
+     *                 the scene on the CPU.
+     */
+    void  GLWidget::setGpuPicking(bool enabled)
+    {
+        m_pImpl->setGpuPicking(enabled);
+    }
+
+
+    /**
+     * \param loop  The loop to advance before each frame, or null to draw frames only
+     *              when something changes. The widget doesn't take ownership of it.
+     *
+     * While a loop is set, frames are drawn continuously, at the rate of the display
+     * where the context waits for vertical sync. The loop is given the time in seconds
+     * since it was set, so tracks should be started on that clock.
+     */
+    void  GLWidget::setFrameLoop(FrameLoop* loop)
+    {
+        m_pImpl->setFrameLoop(loop);
+    }
+
+
     /**
      *
      */
@@ -7,14 +7,18 @@
 #include <QSize>
 
 #include "Math/vector3.h"
+#include "material.h"
+#include "shader.h"
 
 class QString;
 
 namespace GLDemo
 {
+    class FrameLoop;
     class GLWidgetImpl;
     class Scene;
     class Camera;
+    class MeshInstance;
 
     /**
      * \brief Widget for interactive rendering of a Scene object using OpenGL
@@ -31,6 +35,13 @@ namespace GLDemo
 
         void  setScene(Scene* scene);
         void  setCamera(Camera* camera);
+        void  registerShader(const PtrShader& shader);
+        void  setFallbackMaterial(const PtrMaterial& material);
+        void  setOcclusionCulling(bool enabled);
+        void  setSoftwareOcclusionCulling(bool enabled);
+        void  setLodThreshold(float pixels);
+        void  setGpuPicking(bool enabled);
+        void  setFrameLoop(FrameLoop* loop);
 
         virtual QSize sizeHint() const;
 
@@ -38,6 +49,20 @@ namespace GLDemo
         void   widthChanged(int width);
         void   heightChanged(int width);
 
+        /**
+         * Emitted after each frame drawn with either kind of occlusion culling, with the
+         * number of items that were found to be hidden.
+         */
+        void   occlusionCulled(int count);
+
+        /**
+         * Emitted when the scene is clicked with the left mouse button and no modifiers,
+         * with the mesh instance and triangle under the cursor. The instance is null if
+         * there is nothing there. With GPU picking, the instance arrives a frame or two
+         * after the press, and the triangle is always -1.
+         */
+        void   instancePicked(const GLDemo::MeshInstance* instance, int triangle);
+
     private:
         GLWidgetImpl*  m_pImpl;
     };
@@ -1,24 +1,70 @@
 #include <Qt>
 #include <QEvent>
 #include <QMouseEvent>
+#include <QTimer>
 
 #include "Scene/transformation.h"
 #include "Scene/camera.h"
+#include "Scene/frameloop.h"
+#include "Scene/scene.h"
 #include "glrenderer.h"
+#include "shaderreloader.h"
 #include "glwidgetimpl.h"
 
 namespace GLDemo
 {
+    namespace
+    {
+        // Milliseconds between frames while waiting for shaders to be built, or for the
+        // result of a pick.
+        const int s_pendingShaderInterval = 15;
+
+        // Furthest the mouse can move between press and release for it to count as a click.
+        const int s_clickTolerance = 3;
+
+        // Milliseconds between frames of a frame loop, where swapping buffers doesn't
+        // wait for vertical sync.
+        const int s_unsyncedFrameInterval = 16;
+
+
+        /**
+         * \internal Asks for buffer swaps to wait for vertical sync, which paces frames
+         *           drawn continuously to the rate of the display.
+         */
+        QGLFormat syncedFormat()
+        {
+            QGLFormat format(QGLFormat::defaultFormat());
+            format.setSwapInterval(1);
+            return format;
+        }
+    }
+
+
     /**
      *
      */
     GLWidgetImpl::GLWidgetImpl(GLWidget& widget) :
-        QGLWidget(&widget),
+        QGLWidget(syncedFormat(), &widget),
         m_glWidget(widget),
         m_renderer(0),
-        m_scene(0)
+        m_scene(0),
+        m_lastMousePos(),
+        m_mousePosOnPress(),
+        m_gpuPicking(false),
+        m_frameLoop(0),
+        m_frameTimer(0),
+        m_frameClock()
     {
         m_renderer = new GLRenderer(*this);
+
+        // With a frame loop, a frame is drawn as soon as the last has been presented.
+        m_frameTimer = new QTimer(this);
+        m_frameTimer->setTimerType(Qt::PreciseTimer);
+        m_frameTimer->setInterval(0);
+        connect(m_frameTimer, SIGNAL(timeout()), this, SLOT(updateGL()));
+
+        // Draw a frame as soon as a shader changes on disk, so that the change shows up.
+        connect(&ShaderReloader::instance(), SIGNAL(sourcesChanged()), this, SLOT(updateGL()));
     }
 
 
@@ -27,6 +73,10 @@ namespace GLDemo
      */
     GLWidgetImpl::~GLWidgetImpl()
     {
+        if (m_frameLoop)
+        {
+            m_frameLoop->wait();
+        }
         delete m_renderer;
     }
 
@@ -57,6 +107,12 @@ namespace GLDemo
             // TODO: More effective error handling here.
             std::cout << "ERROR: Failed to initialize GL renderer" << std::endl;
         }
+
+        // Without vertical sync, nothing holds back a continuous stream of frames.
+        if (format().swapInterval() < 1)
+        {
+            m_frameTimer->setInterval(s_unsyncedFrameInterval);
+        }
     }
 
 
@@ -71,12 +127,36 @@ namespace GLDemo
             return;
         }
 
+        // The ticks the loop starts on are evaluated while this frame is drawn.
+        if (m_frameLoop)
+        {
+            m_frameLoop->advance(m_frameClock.nsecsElapsed() * 1e-9);
+        }
+
         // Display the loading screen if our render is loading a model,
         // is busy, or another widget is updating shared data somewhere.
         if (!m_renderer->renderScene(*m_scene))
         {
             std::cout << "ERROR: Failed to render the scene" << std::endl;
         }
+
+        if (m_renderer->isOcclusionCullingEnabled() || m_renderer->isSoftwareOcclusionCullingEnabled())
+        {
+            emit m_glWidget.occlusionCulled(m_renderer->getOccludedCount());
+        }
+
+        const MeshInstance* picked = 0;
+        if (m_renderer->takePickResult(picked))
+        {
+            emit m_glWidget.instancePicked(picked, -1);
+        }
+
+        // Keep drawing until every shader has been built, so that items left out of
+        // this frame show up as soon as they're ready, and until any pick has come back.
+        if (m_renderer->hasPendingShaders() || m_renderer->hasPendingPick())
+        {
+            QTimer::singleShot(s_pendingShaderInterval, this, SLOT(updateGL()));
+        }
     }
 
 
@@ -110,6 +190,95 @@ namespace GLDemo
     }
 
 
+    /**
+     *
+     */
+    void  GLWidgetImpl::registerShader(const PtrShader& shader)
+    {
+        m_renderer->registerShader(shader);
+    }
+
+
+    /**
+     *
+     */
+    void  GLWidgetImpl::setFallbackMaterial(const PtrMaterial& material)
+    {
+        m_renderer->setFallbackMaterial(material);
+    }
+
+
+    /**
+     *
+     */
+    void  GLWidgetImpl::setOcclusionCulling(bool enabled)
+    {
+        m_renderer->setOcclusionCulling(enabled);
+        updateGL();
+    }
+
+
+    /**
+     *
+     */
+    void  GLWidgetImpl::setSoftwareOcclusionCulling(bool enabled)
+    {
+        m_renderer->setSoftwareOcclusionCulling(enabled);
+        updateGL();
+    }
+
+
+    /**
+     *
+     */
+    void  GLWidgetImpl::setLodThreshold(float pixels)
+    {
+        m_renderer->setLodThreshold(pixels);
+        updateGL();
+    }
+
+
+    /**
+     *
+     */
+    void  GLWidgetImpl::setGpuPicking(bool enabled)
+    {
+        m_gpuPicking = enabled;
+    }
+
+
+    /**
+     *
+     */
+    void  GLWidgetImpl::setFrameLoop(FrameLoop* loop)
+    {
+        if (m_frameLoop)
+        {
+            m_frameLoop->wait();
+        }
+
+        m_frameLoop = loop;
+        if (m_frameLoop)
+        {
+            m_frameClock.start();
+            m_frameTimer->start();
+        }
+        else
+        {
+            m_frameTimer->stop();
+        }
+    }
+
+
+    /**
+     * \return True if clicks are picked on the GPU, which needs the context to support it.
+     */
+    bool  GLWidgetImpl::usesGpuPicking() const
+    {
+        return m_gpuPicking && m_renderer->supportsIdPicking();
+    }
+
+
     /**
      *
      */
@@ -118,6 +287,14 @@ namespace GLDemo
         event->accept();
         m_lastMousePos = event->pos();
         m_mousePosOnPress = m_lastMousePos;
+
+        // On the GPU, the pick goes out with the next frame, and is reported when it
+        // comes back, rather than waiting for the button to be released.
+        if (event->button() == Qt::LeftButton && event->modifiers() == Qt::NoModifier &&
+            usesGpuPicking() && m_renderer->requestPick(event->x(), event->y()))
+        {
+            updateGL();
+        }
     }
 
 
@@ -144,6 +321,13 @@ namespace GLDemo
                     return;
                 }
 
+                // A camera in the scene graph can't move while a tick may be reading
+                // it, and ticks simulated before it moved would show it where it was.
+                if (m_frameLoop && camera->getParent())
+                {
+                    m_frameLoop->invalidate();
+                }
+
                 // Rotation speed is dependent on the viewport size.
                 float xDist = static_cast<float>(dx) / width();
                 float yDist = static_cast<float>(dy) / height();
@@ -171,6 +355,10 @@ namespace GLDemo
 
                 // Update the camera view.
                 camera->setCameraView(cameraPosition, upVector, target);
+                if (!camera->getParent())
+                {
+                    camera->updateGeometricState(0.0, true);
+                }
                 updateGL();
             }
             else if (event->modifiers() == Qt::ShiftModifier)
@@ -185,6 +373,44 @@ namespace GLDemo
     }
 
 
+    /**
+     * A left click with no modifiers picks whatever is under the cursor, unless that was
+     * already done on the GPU when the button was pressed.
+     */
+    void GLWidgetImpl::mouseReleaseEvent(QMouseEvent *event)
+    {
+        event->accept();
+
+        if (usesGpuPicking() || event->button() != Qt::LeftButton || event->modifiers() != Qt::NoModifier ||
+            (event->pos() - m_mousePosOnPress).manhattanLength() > s_clickTolerance)
+        {
+            return;
+        }
+
+        Camera* camera = m_renderer->getCamera();
+        if (!m_scene || !camera || width() <= 0 || height() <= 0)
+        {
+            return;
+        }
+
+        // Aim through the centre of the pixel clicked.
+        float x = 2.0f * (event->x() + 0.5f) / width() - 1.0f;
+        float y = 1.0f - 2.0f * (event->y() + 0.5f) / height();
+        Ray ray = camera->getRay(x, y, static_cast<float>(width()) / height());
+
+        // The hierarchy is built on the first pick, and kept up to date after that.
+        if (m_scene->getBvh().getNumInstances() == 0)
+        {
+            m_scene->buildBvh();
+        }
+        m_scene->updateBvh();
+
+        PickResult result;
+        m_scene->pick(ray, result);
+        emit m_glWidget.instancePicked(result.m_instance, result.m_triangle);
+    }
+
+
     /**
      *
      */
@@ -3,6 +3,7 @@
 
 #include <queue>
 
+#include <QElapsedTimer>
 #include <QGLWidget>
 #include <QString>
 #include <QPoint>
@@ -10,10 +11,15 @@
 #include <iostream>
 
 #include "glwidget.h"
+#include "material.h"
+#include "shader.h"
+
+class QTimer;
 
 namespace GLDemo
 {
     class Camera;
+    class FrameLoop;
     class GLRenderer;
 
     /**
@@ -29,6 +35,13 @@ namespace GLDemo
 
         void  setScene(Scene* scene);
         void  setCamera(Camera* camera);
+        void  registerShader(const PtrShader& shader);
+        void  setFallbackMaterial(const PtrMaterial& material);
+        void  setOcclusionCulling(bool enabled);
+        void  setSoftwareOcclusionCulling(bool enabled);
+        void  setLodThreshold(float pixels);
+        void  setGpuPicking(bool enabled);
+        void  setFrameLoop(FrameLoop* loop);
 
     protected:
         virtual void  initializeGL();
@@ -38,14 +51,21 @@ namespace GLDemo
         virtual bool  event(QEvent* event);
         virtual void  mousePressEvent(QMouseEvent* event);
         virtual void  mouseMoveEvent(QMouseEvent* event);
+        virtual void  mouseReleaseEvent(QMouseEvent* event);
         virtual void  wheelEvent(QWheelEvent* event);
 
     private:
+        bool  usesGpuPicking() const;
+
         GLWidget&         m_glWidget;
         GLRenderer*       m_renderer;
         Scene*            m_scene;
         QPoint            m_lastMousePos;
         QPoint            m_mousePosOnPress;
+        bool              m_gpuPicking;
+        FrameLoop*        m_frameLoop;
+        QTimer*           m_frameTimer;
+        QElapsedTimer     m_frameClock;
 
         //typedef std::queue<QueuedInteraction*> InteractionQueue;
         //InteractionQueue interactionQueue_;
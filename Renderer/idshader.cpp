@@ -0,0 +1,139 @@
+#include "idshader.h"
+#include "glutils.h"
+
+namespace GLDemo
+{
+    IdShader::IdShader() :
+        Shader(),
+        m_failed(false),
+        m_foundUniforms(false),
+        m_locMatWorldViewProj(-1),
+        m_locId(-1)
+    {
+    }
+
+
+    IdShader::~IdShader()
+    {
+    }
+
+
+    /**
+     * Binds the program, waiting for it if it is still being built.
+     */
+    bool IdShader::activate(const Matrix4f& view)
+    {
+        Q_UNUSED(view);
+
+        if (!m_foundUniforms)
+        {
+            if (!prepare() || !waitForProgram(m_program) || !isReady())
+            {
+                m_failed = true;
+                return false;
+            }
+        }
+
+        m_program->bind();
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * Starts building the program in the background.
+     */
+    bool IdShader::prepare()
+    {
+        if (m_failed)
+        {
+            return false;
+        }
+
+        if (!m_program)
+        {
+            initializeGLFunctions();
+            if (!beginCompileAndLink(m_program, ":/shaders/idshader.vert", ":/shaders/idshader.frag"))
+            {
+                m_failed = true;
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+
+    /**
+     *
+     */
+    bool IdShader::isReady()
+    {
+        if (m_foundUniforms)
+        {
+            return true;
+        }
+
+        if (!m_program || m_failed)
+        {
+            return false;
+        }
+
+        switch (getProgramStatus(m_program))
+        {
+        case ProgramPending:
+            return false;
+        case ProgramLinked:
+            m_locMatWorldViewProj = m_program->uniformLocation("matWorldViewProj");
+            m_locId = m_program->uniformLocation("id");
+            m_foundUniforms = true;
+            return true;
+        default:
+            m_failed = true;
+            return false;
+        }
+    }
+
+
+    /**
+     *
+     */
+    void IdShader::programsReloaded()
+    {
+        m_failed = false;
+        m_foundUniforms = false;
+        isReady();
+    }
+
+
+    /**
+     * Identifiers don't depend on the material, so there is nothing to set.
+     */
+    bool IdShader::setMaterial(const Material&)
+    {
+        return true;
+    }
+
+
+    /**
+     * \pre The shader must be active.
+     */
+    bool IdShader::setTransforms(const Matrix4f&, const Matrix4f&, const Matrix4f& worldViewProj)
+    {
+        glUniformMatrix4fv(m_locMatWorldViewProj, 1, false, worldViewProj.toPointer());
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * \param id  The identifier to write for everything drawn until it is next set.
+     * \pre The shader must be active.
+     */
+    bool IdShader::setId(GLuint id)
+    {
+        // Passed as a signed integer, since QGLShaderProgram sets unsigned values with
+        // glUniform1i, which unsigned uniforms don't accept.
+        m_program->setUniformValue(m_locId, static_cast<GLint>(id));
+        return GL_GOOD_STATE();
+    }
+
+}
@@ -0,0 +1,13 @@
+#version 130
+
+/**
+ * Writes the identifier of the item being drawn. Zero is left for the background.
+ */
+uniform int id;
+
+out uint fragId;
+
+void main()
+{
+    fragId = uint(id);
+}
@@ -0,0 +1,50 @@
+#ifndef GLDEMO_IDSHADER_H
+#define GLDEMO_IDSHADER_H
+
+#include <QGLShaderProgram>
+#include <QGLFunctions>
+
+#include "shader.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \brief Writes an integer identifying the item drawn, for the renderer's picking pass.
+     *
+     * Draws into an unsigned integer color target. Like DepthShader, it ignores materials,
+     * and of the transforms only uses the world-view-projection matrix. There is no
+     * indirect variant, since each draw needs its own identifier.
+     */
+    class IdShader : public Shader, protected QGLFunctions
+    {
+    public:
+        IdShader();
+        ~IdShader();
+
+        virtual bool activate(const Matrix4f& view);
+        virtual bool setMaterial(const Material& material);
+        virtual bool setTransforms(const Matrix4f& worldView,
+                                   const Matrix4f& worldViewInvTranspose,
+                                   const Matrix4f& worldViewProj);
+        virtual bool prepare();
+        virtual bool isReady();
+
+        bool setId(GLuint id);
+
+    protected:
+        virtual void programsReloaded();
+
+    private:
+        bool m_failed;
+        bool m_foundUniforms;
+        int  m_locMatWorldViewProj;
+        int  m_locId;
+
+        IdShader(const IdShader&);
+        IdShader& operator=(const IdShader&);
+    };
+
+}
+
+#endif
@@ -0,0 +1,16 @@
+#version 130
+
+/**
+ * Transforms positions only, exactly as depthshader.vert does, so that the picking pass
+ * finds the same nearest surface as the main pass.
+ */
+invariant gl_Position;
+
+uniform mat4 matWorldViewProj;
+
+in vec4 vertPosition;
+
+void main()
+{
+    gl_Position = matWorldViewProj * vertPosition;
+}
@@ -1,17 +1,24 @@
 #include "lambertshader.h"
 #include "glutils.h"
 #include "glrenderer.h"
+#include "material.h"
 
 namespace GLDemo
 {
     LambertShader::LambertShader() :
         Shader(),
-        m_color(255, 0, 0, 255),
+        m_failed(false),
+        m_foundUniforms(false),
         m_locMatWorldView(-1),
         m_locMatWorldViewProj(-1),
         m_locMatWorldViewInvTranspose(-1),
         m_locColor(-1),
-        m_locLightPos(-1)
+        m_locAmbientColor(-1),
+        m_locLightPos(-1),
+        m_indirectProgram(),
+        m_indirectFailed(false),
+        m_locIndirectLightPos(-1),
+        m_locIndirectDrawOffset(-1)
     {
     }
 
@@ -21,43 +28,185 @@ namespace GLDemo
     }
 
 
-    bool LambertShader::activate(const Matrix4f& view,
-                                 const Matrix4f& worldView,
-                                 const Matrix4f& worldViewInvTranspose,
-                                 const Matrix4f& worldViewProj)
+    /**
+     * Binds the program and sets the light position, which is the same for every material.
+     * Waits for the program if it is still being built.
+     */
+    bool LambertShader::activate(const Matrix4f& view)
     {
+        if (!m_foundUniforms)
+        {
+            if (!prepare() || !waitForProgram(m_program) || !findUniforms())
+            {
+                m_failed = true;
+                return false;
+            }
+        }
+
+        m_program->bind();
+        Vector4f lightPos(view * Vector4f(0.0f, 0.0f, 0.0f, 1.0f));
+        glUniform3f(m_locLightPos, lightPos.x(), lightPos.y(), lightPos.z());
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * Starts building the program in the background.
+     */
+    bool LambertShader::prepare()
+    {
+        if (m_failed)
+        {
+            return false;
+        }
+
         if (!m_program)
         {
             initializeGLFunctions();
-
-            if (!compileAndLink(":/shaders/lambertshader.vert", ":/shaders/lambertshader.frag"))
+            if (!beginCompileAndLink(m_program, ":/shaders/lambertshader.vert", ":/shaders/lambertshader.frag"))
             {
+                m_failed = true;
                 return false;
             }
-            assert(m_program->isLinked());
-
-            // Bind the vertex attribute locations
-            m_program->bindAttributeLocation("vertPosition", GLRenderer::Position);
-            m_program->bindAttributeLocation("vertNormal", GLRenderer::Normal);
-
-            // Store the uniform locations so we don't have to look them up each time.
-            m_program->bind();
-            m_locMatWorldView = m_program->uniformLocation("matWorldView");
-            m_locMatWorldViewProj = m_program->uniformLocation("matWorldViewProj");
-            m_locMatWorldViewInvTranspose = m_program->uniformLocation("matWorldViewInvTranspose");
-            m_locColor = m_program->uniformLocation("diffuseColor");
-            m_locLightPos = m_program->uniformLocation("lightPos");
         }
 
-        // Set uniform values. Use the native GL functions for matrices, as Qt doesn't
+        return true;
+    }
+
+
+    /**
+     *
+     */
+    bool LambertShader::isReady()
+    {
+        if (m_foundUniforms)
+        {
+            return true;
+        }
+
+        if (!m_program || m_failed)
+        {
+            return false;
+        }
+
+        switch (getProgramStatus(m_program))
+        {
+        case ProgramPending:
+            return false;
+        case ProgramLinked:
+            return findUniforms();
+        default:
+            m_failed = true;
+            return false;
+        }
+    }
+
+
+    /**
+     * \internal Stores the uniform locations so we don't have to look them up each time.
+     * \pre The program must be linked.
+     */
+    bool LambertShader::findUniforms()
+    {
+        assert(m_program->isLinked());
+        m_locMatWorldView = m_program->uniformLocation("matWorldView");
+        m_locMatWorldViewProj = m_program->uniformLocation("matWorldViewProj");
+        m_locMatWorldViewInvTranspose = m_program->uniformLocation("matWorldViewInvTranspose");
+        m_locColor = m_program->uniformLocation("diffuseColor");
+        m_locAmbientColor = m_program->uniformLocation("ambientColor");
+        m_locLightPos = m_program->uniformLocation("lightPos");
+        m_foundUniforms = true;
+        return true;
+    }
+
+
+    /**
+     * \internal Stores the uniform locations of the indirect variant.
+     */
+    void LambertShader::findIndirectUniforms()
+    {
+        m_locIndirectLightPos = m_indirectProgram->uniformLocation("lightPos");
+        m_locIndirectDrawOffset = m_indirectProgram->uniformLocation("drawOffset");
+    }
+
+
+    /**
+     * Uniform locations may differ between the old and new programs. A reload may also
+     * have fixed a program that previously failed to build.
+     */
+    void LambertShader::programsReloaded()
+    {
+        m_failed = false;
+        if (m_program && m_program->isLinked())
+        {
+            findUniforms();
+        }
+
+        if (m_indirectProgram)
+        {
+            m_indirectFailed = false;
+            findIndirectUniforms();
+        }
+    }
+
+
+    /**
+     * \pre The shader must be active.
+     */
+    bool LambertShader::setMaterial(const Material& material)
+    {
+        m_program->setUniformValue(m_locColor, material.getDiffuseColor());
+        m_program->setUniformValue(m_locAmbientColor, material.getAmbientColor());
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * \pre The shader must be active.
+     */
+    bool LambertShader::setTransforms(const Matrix4f& worldView,
+                                      const Matrix4f& worldViewInvTranspose,
+                                      const Matrix4f& worldViewProj)
+    {
+        // Use the native GL functions for matrices, as Qt doesn't
         // appear to offer us an equivalent function for a matrix.
-        m_program->bind();
         glUniformMatrix4fv(m_locMatWorldView, 1, false, worldView.toPointer());
         glUniformMatrix4fv(m_locMatWorldViewInvTranspose, 1, false, worldViewInvTranspose.toPointer());
         glUniformMatrix4fv(m_locMatWorldViewProj, 1, false, worldViewProj.toPointer());
-        m_program->setUniformValue(m_locColor, m_color);
+        return GL_GOOD_STATE();
+    }
+
+
+    /**
+     * Binds the indirect variant of the program, which fetches its transforms and material
+     * from the per-draw and material storage buffers. The variant is only compiled the first time it is needed,
+     * and a failed compile is not retried every frame.
+     */
+    bool LambertShader::activateIndirect(const Matrix4f& view, int firstDraw)
+    {
+        if (!m_indirectProgram)
+        {
+            if (m_indirectFailed)
+            {
+                return false;
+            }
+
+            initializeGLFunctions();
+
+            if (!compileAndLink(m_indirectProgram, ":/shaders/lambertshader_indirect.vert", ":/shaders/lambertshader_indirect.frag"))
+            {
+                m_indirectProgram.clear();
+                m_indirectFailed = true;
+                return false;
+            }
+
+            findIndirectUniforms();
+        }
+
+        m_indirectProgram->bind();
+        m_indirectProgram->setUniformValue(m_locIndirectDrawOffset, firstDraw);
         Vector4f lightPos(view * Vector4f(0.0f, 0.0f, 0.0f, 1.0f));
-        glUniform3f(m_locLightPos, lightPos.x(), lightPos.y(), lightPos.z());
+        glUniform3f(m_locIndirectLightPos, lightPos.x(), lightPos.y(), lightPos.z());
         return GL_GOOD_STATE();
     }
 
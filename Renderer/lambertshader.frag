@@ -14,6 +14,7 @@ vec4 calcRadianceLambert(in vec4 cDiff, in vec3 n, in vec3 l, in vec4 El)
 }
 
 uniform vec4 diffuseColor;
+uniform vec4 ambientColor;
 uniform vec3 lightPos;
 
 varying vec3 worldViewPos;
@@ -25,6 +26,6 @@ void main()
     vec3 normal = normalize(worldViewNormal);
     vec3 lightVec = normalize(lightPos - worldViewPos);
     vec4 color = calcRadianceLambert(diffuseColor, normal, lightVec, vec4(1.0,1.0,1.0,1.0));
+    color.rgb += ambientColor.rgb * diffuseColor.rgb;
     gl_FragColor = color;
-    gl_FragDepth = gl_FragCoord.z;
 }
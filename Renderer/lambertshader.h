@@ -1,7 +1,6 @@
 #ifndef GLDEMO_LAMBERTSHADER_H
 #define GLDEMO_LAMBERTSHADER_H
 
-#include <QColor>
 #include <QGLShaderProgram>
 #include <QGLFunctions>
 
@@ -20,22 +19,37 @@ namespace GLDemo
         LambertShader();
         ~LambertShader();
 
-        virtual bool activate(const Matrix4f& view,
-                              const Matrix4f& worldView,
-                              const Matrix4f& worldViewInvTranspose,
-                              const Matrix4f& worldViewProj);
+        virtual bool activate(const Matrix4f& view);
+        virtual bool setMaterial(const Material& material);
+        virtual bool setTransforms(const Matrix4f& worldView,
+                                   const Matrix4f& worldViewInvTranspose,
+                                   const Matrix4f& worldViewProj);
+        virtual bool activateIndirect(const Matrix4f& view, int firstDraw);
+        virtual bool prepare();
+        virtual bool isReady();
 
-        void setColor(const QColor& color) { m_color = color; }
+    protected:
+        virtual void programsReloaded();
 
     private:
-        QColor            m_color;
+        bool findUniforms();
+        void findIndirectUniforms();
 
+        bool m_failed;
+        bool m_foundUniforms;
         int m_locMatWorldView;
         int m_locMatWorldViewProj;
         int m_locMatWorldViewInvTranspose;
         int m_locColor;
+        int m_locAmbientColor;
         int m_locLightPos;
 
+        // Variant of the program used for multi-draw indirect submission.
+        PtrShaderProgram  m_indirectProgram;
+        bool              m_indirectFailed;
+        int               m_locIndirectLightPos;
+        int               m_locIndirectDrawOffset;
+
         LambertShader(const LambertShader&);
         LambertShader& operator=(const LambertShader&);
     };
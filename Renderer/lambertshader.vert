@@ -1,5 +1,8 @@
 #version 120
 
+// Must match depthshader.vert, so the depth pre-pass leaves exactly the depth drawn here.
+invariant gl_Position;
+
 uniform mat4 matWorldView;
 uniform mat4 matWorldViewProj;
 uniform mat4 matWorldViewInvTranspose;
@@ -0,0 +1,44 @@
+#version 430
+
+/**
+ * Calculates the radiance contribution for a single light source L. Uses the lambertian
+ * BRDF, and assumes that the light irradiance has been pre-multiplied by PI.
+ *
+ * \pre Assumes n has already been normalized.
+ * \pre Assumes l has already been normalized.
+ * \pre Assumes El has already been multiplied by 1/PI (lambertian BRDF)
+ */
+vec4 calcRadianceLambert(in vec4 cDiff, in vec3 n, in vec3 l, in vec4 El)
+{
+    return cDiff * El * clamp( dot(n, l), 0.0, 1.0 );
+}
+
+// Parameters of every material drawn this frame, written once per frame by the renderer.
+struct MaterialData
+{
+    vec4 diffuseColor;
+    vec4 ambientColor;
+};
+
+layout(std430, binding = 1) readonly buffer Materials
+{
+    MaterialData materials[];
+};
+
+uniform vec3 lightPos;
+
+in vec3 worldViewPos;
+in vec3 worldViewNormal;
+flat in int materialIndex;
+
+out vec4 fragColor;
+
+void main()
+{
+    // Re-normalize the normal, as it has been interpolated across the primitive
+    vec3 normal = normalize(worldViewNormal);
+    vec3 lightVec = normalize(lightPos - worldViewPos);
+    MaterialData material = materials[materialIndex];
+    fragColor = calcRadianceLambert(material.diffuseColor, normal, lightVec, vec4(1.0,1.0,1.0,1.0));
+    fragColor.rgb += material.ambientColor.rgb * material.diffuseColor.rgb;
+}
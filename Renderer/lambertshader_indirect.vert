@@ -0,0 +1,42 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+/**
+ * Variant of lambertshader.vert for multi-draw indirect submission. The transforms of
+ * each draw are read from the per-draw storage buffer rather than from uniforms, as a
+ * single call covers many mesh instances, which may each use a different material.
+ */
+invariant gl_Position;
+
+struct DrawData
+{
+    mat4 matWorldView;
+    mat4 matWorldViewInvTranspose;
+    mat4 matWorldViewProj;
+    int  materialIndex;
+};
+
+layout(std430, binding = 0) readonly buffer PerDrawData
+{
+    DrawData draws[];
+};
+
+// Index of the batch's first draw within the storage buffer. gl_DrawID restarts
+// from zero for every multi-draw call.
+uniform int drawOffset;
+
+in vec4 vertPosition;
+in vec3 vertNormal;
+
+out vec3 worldViewPos;
+out vec3 worldViewNormal;
+flat out int materialIndex;
+
+void main()
+{
+    DrawData draw = draws[drawOffset + gl_DrawIDARB];
+    gl_Position = draw.matWorldViewProj * vertPosition;
+    worldViewPos = (draw.matWorldView * vertPosition).xyz;
+    worldViewNormal = normalize((draw.matWorldViewInvTranspose * vec4(vertNormal, 0)).xyz);
+    materialIndex = draw.materialIndex;
+}
@@ -0,0 +1,17 @@
+#include "material.h"
+
+namespace GLDemo
+{
+    /**
+     * \param shader  The shader used to draw surfaces with this material.
+     *
+     * Creates a red material without an ambient term.
+     */
+    Material::Material(const PtrShader& shader) :
+        m_shader(shader),
+        m_diffuseColor(255, 0, 0, 255),
+        m_ambientColor(0, 0, 0, 255)
+    {
+    }
+
+}
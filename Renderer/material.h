@@ -0,0 +1,47 @@
+#ifndef GLDEMO_MATERIAL_H
+#define GLDEMO_MATERIAL_H
+
+#include <QColor>
+#include <QSharedPointer>
+
+#include "shader.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \brief The parameters a surface is shaded with, along with the shader that uses them.
+     *
+     * Many materials can share the one shader. The renderer groups draws by shader and then
+     * by material, so a scene with hundreds of colors but only a couple of shading models
+     * only ever switches between a couple of programs.
+     */
+    class Material
+    {
+    public:
+        Material(const PtrShader& shader);
+
+        PtrShader&       getShader()                  { return m_shader; }
+        const PtrShader& getShader() const            { return m_shader; }
+        void setShader(const PtrShader& shader)       { m_shader = shader; }
+
+        const QColor& getDiffuseColor() const         { return m_diffuseColor; }
+        void setDiffuseColor(const QColor& color)     { m_diffuseColor = color; }
+
+        /**
+         * The light reflected regardless of the direction of the light source, used to
+         * keep surfaces facing away from the light from going completely black.
+         */
+        const QColor& getAmbientColor() const         { return m_ambientColor; }
+        void setAmbientColor(const QColor& color)     { m_ambientColor = color; }
+
+    private:
+        PtrShader m_shader;
+        QColor    m_diffuseColor;
+        QColor    m_ambientColor;
+    };
+
+    typedef QSharedPointer<Material> PtrMaterial;
+}
+
+#endif
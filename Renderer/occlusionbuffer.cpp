@@ -0,0 +1,489 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include "Scene/boundingbox.h"
+#include "Scene/mesh.h"
+#include "occlusionbuffer.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GLDEMO_OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace GLDemo
+{
+    namespace
+    {
+        // Bands thinner than this aren't worth handing to another thread.
+        const int s_minBandHeight = 16;
+
+        // Depth of an empty pixel; the far plane.
+        const float s_clearDepth = 1.0f;
+    }
+
+
+    /**
+     * \internal Rasterizes one band of rows on a worker thread.
+     */
+    class OcclusionBuffer::BandTask : public QRunnable
+    {
+    public:
+        BandTask(OcclusionBuffer& buffer, int firstRow, int endRow) :
+            m_buffer(buffer),
+            m_firstRow(firstRow),
+            m_endRow(endRow)
+        {
+        }
+
+        virtual void run()
+        {
+            m_buffer.rasterizeBand(m_firstRow, m_endRow);
+            m_buffer.m_bandsDone.release();
+        }
+
+    private:
+        OcclusionBuffer& m_buffer;
+        int              m_firstRow;
+        int              m_endRow;
+    };
+
+
+    /**
+     * \param width   Width of the buffer in pixels. Rounded up to a multiple of four.
+     * \param height  Height of the buffer in pixels.
+     */
+    OcclusionBuffer::OcclusionBuffer(int width, int height) :
+        m_width(0),
+        m_height(0),
+        m_depth(),
+        m_triangles(),
+        m_viewProj(),
+        m_positions(),
+        m_clipPositions(),
+        m_clipW(),
+        m_clipVertices(),
+        m_bandsDone(0),
+        m_pendingBands(0)
+    {
+        setSize(width, height);
+    }
+
+
+    /**
+     * Waits for any rasterization still in progress, as it writes to this object.
+     */
+    OcclusionBuffer::~OcclusionBuffer()
+    {
+        wait();
+    }
+
+
+    /**
+     * \param width   Width of the buffer in pixels. Rounded up to a multiple of four.
+     * \param height  Height of the buffer in pixels.
+     *
+     * Clears the buffer, so that nothing is occluded until the next begin().
+     */
+    void OcclusionBuffer::setSize(int width, int height)
+    {
+        wait();
+        m_width = std::max(4, (width + 3) & ~3);
+        m_height = std::max(1, height);
+        m_depth.assign(m_width * m_height, s_clearDepth);
+    }
+
+
+    /**
+     * \param viewProj   The projection matrix multiplied by the view matrix.
+     * \param occluders  The meshes to draw. Their data must not change until wait() has
+     *                   been called, but the list itself may.
+     *
+     * Clears the buffer and starts drawing the occluders into it, returning as soon as
+     * the work has been handed to the thread pool. Call wait() before testing anything.
+     */
+    void OcclusionBuffer::begin(const Matrix4f& viewProj, const OccluderList& occluders)
+    {
+        wait();
+
+        m_viewProj = viewProj;
+        m_triangles.clear();
+        for (OccluderList::const_iterator iter = occluders.begin(); iter != occluders.end(); ++iter)
+        {
+            addTriangles(*iter);
+        }
+
+        int numBands = std::max(1, std::min(QThread::idealThreadCount(), m_height / s_minBandHeight));
+        if (numBands == 1)
+        {
+            rasterizeBand(0, m_height);
+            return;
+        }
+
+        m_pendingBands = numBands;
+        for (int band = 0; band < numBands; ++band)
+        {
+            int firstRow = m_height * band / numBands;
+            int endRow = m_height * (band + 1) / numBands;
+            QThreadPool::globalInstance()->start(new BandTask(*this, firstRow, endRow));
+        }
+    }
+
+
+    /**
+     * Blocks until the drawing started by begin() has finished.
+     */
+    void OcclusionBuffer::wait()
+    {
+        if (m_pendingBands > 0)
+        {
+            m_bandsDone.acquire(m_pendingBands);
+            m_pendingBands = 0;
+        }
+    }
+
+
+    /**
+     * \param box  A world-space bounding box.
+     * \return True if every pixel the box covers holds an occluder nearer than the nearest
+     *         point of the box. Boxes crossing the near plane or entirely off screen are
+     *         never reported as occluded.
+     *
+     * \pre Drawing must have finished; see wait().
+     */
+    bool OcclusionBuffer::isOccluded(const BoundingBox& box) const
+    {
+        assert(!isBusy());
+        if (box.isEmpty())
+        {
+            return false;
+        }
+
+        const Vector3f& minimum = box.getMinimum();
+        const Vector3f& maximum = box.getMaximum();
+        float minX = static_cast<float>(m_width);
+        float maxX = 0.0f;
+        float minY = static_cast<float>(m_height);
+        float maxY = 0.0f;
+        float minZ = s_clearDepth;
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            Vector4f clip(m_viewProj * Vector4f((corner & 1) ? maximum.x() : minimum.x(),
+                                                (corner & 2) ? maximum.y() : minimum.y(),
+                                                (corner & 4) ? maximum.z() : minimum.z(),
+                                                1.0f));
+            if (clip.z() < -clip.w() || clip.w() <= 0.0f)
+            {
+                return false;
+            }
+
+            float invW = 1.0f / clip.w();
+            float x = (clip.x() * invW * 0.5f + 0.5f) * m_width;
+            float y = (clip.y() * invW * 0.5f + 0.5f) * m_height;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            minZ = std::min(minZ, clip.z() * invW * 0.5f + 0.5f);
+        }
+
+        if (maxX < 0.0f || maxY < 0.0f || minX >= m_width || minY >= m_height)
+        {
+            return false;
+        }
+
+        // Widening the columns to a multiple of four only tests extra pixels, which can
+        // make a box visible but never hides one.
+        int firstColumn = std::max(0, static_cast<int>(std::floor(minX))) & ~3;
+        int endColumn = std::min(m_width, (static_cast<int>(std::floor(maxX)) + 4) & ~3);
+        int firstRow = std::max(0, static_cast<int>(std::floor(minY)));
+        int endRow = std::min(m_height, static_cast<int>(std::floor(maxY)) + 1);
+
+        for (int y = firstRow; y < endRow; ++y)
+        {
+            const float* row = &m_depth[y * m_width];
+#ifdef GLDEMO_OCCLUSION_SSE2
+            __m128 boxDepth = _mm_set1_ps(minZ);
+            for (int x = firstColumn; x < endColumn; x += 4)
+            {
+                if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(row + x), boxDepth)))
+                {
+                    return false;
+                }
+            }
+#else
+            for (int x = firstColumn; x < endColumn; ++x)
+            {
+                if (row[x] >= minZ)
+                {
+                    return false;
+                }
+            }
+#endif
+        }
+
+        return true;
+    }
+
+
+    /**
+     * \return The depth at a pixel, counting rows from the bottom of the screen.
+     * \pre Drawing must have finished; see wait().
+     */
+    float OcclusionBuffer::getDepth(int x, int y) const
+    {
+        assert(!isBusy());
+        assert(x >= 0 && x < m_width && y >= 0 && y < m_height);
+        return m_depth[y * m_width + x];
+    }
+
+
+    /**
+     * \internal Transforms the vertices of an occluder to clip space, and adds its
+     *           triangles to those to draw.
+     */
+    void OcclusionBuffer::addTriangles(const Occluder& occluder)
+    {
+        const Mesh& mesh = *occluder.m_mesh;
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+        Matrix4f matrix = m_viewProj * occluder.m_world;
+
+        // Transformed in bulk, then interleaved again for clipping.
+        const int numVertices = static_cast<int>(vertices.size());
+        m_positions.gather(numVertices > 0 ? &vertices[0].m_position : 0, numVertices, sizeof(Vertex));
+        m_positions.transformPoints(matrix, m_clipPositions, m_clipW);
+
+        m_clipVertices.resize(vertices.size());
+        const float* clipX = m_clipPositions.x();
+        const float* clipY = m_clipPositions.y();
+        const float* clipZ = m_clipPositions.z();
+        for (int i = 0; i < numVertices; ++i)
+        {
+            Vector4f& clip = m_clipVertices[i];
+            clip.x() = clipX[i];
+            clip.y() = clipY[i];
+            clip.z() = clipZ[i];
+            clip.w() = m_clipW[i];
+        }
+
+        const std::list<ElementList>& elementLists = mesh.getElementLists();
+        for (std::list<ElementList>::const_iterator elIter = elementLists.begin(); elIter != elementLists.end(); ++elIter)
+        {
+            const std::vector<unsigned>& indices = elIter->getIndices();
+            if (elIter->getElementType() == ElementList::TRI_LIST)
+            {
+                for (size_t i = 0; i + 2 < indices.size(); i += 3)
+                {
+                    addClippedTriangle(m_clipVertices[indices[i]], m_clipVertices[indices[i + 1]], m_clipVertices[indices[i + 2]]);
+                }
+            }
+            else if (elIter->getElementType() == ElementList::TRI_STRIP)
+            {
+                // Winding doesn't matter, as both sides of an occluder are drawn.
+                size_t stripStart = 0;
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    if (indices[i] == ElementList::RESTART_INDEX)
+                    {
+                        stripStart = i + 1;
+                    }
+                    else if (i >= stripStart + 2)
+                    {
+                        addClippedTriangle(m_clipVertices[indices[i - 2]], m_clipVertices[indices[i - 1]], m_clipVertices[indices[i]]);
+                    }
+                }
+            }
+        }
+    }
+
+
+    /**
+     * \internal Clips a clip-space triangle against the near plane. Only the near plane
+     *           matters, as it is the only one that can put vertices behind the camera.
+     */
+    void OcclusionBuffer::addClippedTriangle(const Vector4f& a, const Vector4f& b, const Vector4f& c)
+    {
+        const Vector4f* input[3] = { &a, &b, &c };
+        float distance[3];
+        int numInside = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            distance[i] = input[i]->z() + input[i]->w();
+            if (distance[i] >= 0.0f)
+            {
+                ++numInside;
+            }
+        }
+
+        if (numInside == 3)
+        {
+            Vector4f vertices[3] = { a, b, c };
+            addScreenTriangle(vertices);
+            return;
+        }
+        if (numInside == 0)
+        {
+            return;
+        }
+
+        // Clipping a triangle against one plane leaves at most four vertices.
+        Vector4f polygon[4];
+        int numVertices = 0;
+        for (int i = 0; i < 3; ++i)
+        {
+            int next = (i + 1) % 3;
+            if (distance[i] >= 0.0f)
+            {
+                polygon[numVertices++] = *input[i];
+            }
+            if ((distance[i] >= 0.0f) != (distance[next] >= 0.0f))
+            {
+                float t = distance[i] / (distance[i] - distance[next]);
+                polygon[numVertices++] = *input[i] + (*input[next] - *input[i]) * t;
+            }
+        }
+
+        for (int i = 1; i + 1 < numVertices; ++i)
+        {
+            Vector4f vertices[3] = { polygon[0], polygon[i], polygon[i + 1] };
+            addScreenTriangle(vertices);
+        }
+    }
+
+
+    /**
+     * \internal Projects a triangle in front of the near plane onto the screen.
+     */
+    void OcclusionBuffer::addScreenTriangle(const Vector4f* vertices)
+    {
+        ScreenTriangle triangle;
+        float minX = static_cast<float>(m_width);
+        float maxX = 0.0f;
+        for (int i = 0; i < 3; ++i)
+        {
+            float invW = 1.0f / vertices[i].w();
+            triangle.m_x[i] = (vertices[i].x() * invW * 0.5f + 0.5f) * m_width;
+            triangle.m_y[i] = (vertices[i].y() * invW * 0.5f + 0.5f) * m_height;
+            triangle.m_z[i] = vertices[i].z() * invW * 0.5f + 0.5f;
+            minX = std::min(minX, triangle.m_x[i]);
+            maxX = std::max(maxX, triangle.m_x[i]);
+        }
+        triangle.m_minY = std::min(triangle.m_y[0], std::min(triangle.m_y[1], triangle.m_y[2]));
+        triangle.m_maxY = std::max(triangle.m_y[0], std::max(triangle.m_y[1], triangle.m_y[2]));
+
+        if (maxX >= 0.0f && minX < m_width && triangle.m_maxY >= 0.0f && triangle.m_minY < m_height)
+        {
+            m_triangles.push_back(triangle);
+        }
+    }
+
+
+    /**
+     * \internal Clears rows \a firstRow up to \a endRow and draws every triangle
+     *           overlapping them. Bands don't share any pixels, so they can be drawn
+     *           concurrently.
+     */
+    void OcclusionBuffer::rasterizeBand(int firstRow, int endRow)
+    {
+        std::fill(m_depth.begin() + firstRow * m_width, m_depth.begin() + endRow * m_width, s_clearDepth);
+
+        for (std::vector<ScreenTriangle>::const_iterator iter = m_triangles.begin(); iter != m_triangles.end(); ++iter)
+        {
+            if (iter->m_maxY >= firstRow && iter->m_minY < endRow)
+            {
+                rasterizeTriangle(*iter, firstRow, endRow);
+            }
+        }
+    }
+
+
+    /**
+     * \internal Draws the pixels of a triangle within a band, keeping the nearest depth.
+     *           A pixel is covered if its centre is inside the triangle.
+     */
+    void OcclusionBuffer::rasterizeTriangle(const ScreenTriangle& t, int firstRow, int endRow)
+    {
+        float det = (t.m_x[1] - t.m_x[0]) * (t.m_y[2] - t.m_y[0]) - (t.m_x[2] - t.m_x[0]) * (t.m_y[1] - t.m_y[0]);
+        if (det == 0.0f)
+        {
+            return;
+        }
+
+        // Edge i is opposite vertex i, and is positive on the inside of the triangle.
+        float sign = det > 0.0f ? 1.0f : -1.0f;
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            int from = (i + 1) % 3;
+            int to = (i + 2) % 3;
+            edgeA[i] = -(t.m_y[to] - t.m_y[from]) * sign;
+            edgeB[i] = (t.m_x[to] - t.m_x[from]) * sign;
+            edgeC[i] = -(edgeA[i] * t.m_x[from] + edgeB[i] * t.m_y[from]);
+        }
+
+        // Depth is linear in screen space, so it can be stepped like the edges.
+        float depthA = ((t.m_z[1] - t.m_z[0]) * (t.m_y[2] - t.m_y[0]) - (t.m_z[2] - t.m_z[0]) * (t.m_y[1] - t.m_y[0])) / det;
+        float depthB = ((t.m_z[2] - t.m_z[0]) * (t.m_x[1] - t.m_x[0]) - (t.m_z[1] - t.m_z[0]) * (t.m_x[2] - t.m_x[0])) / det;
+        float depthC = t.m_z[0] - depthA * t.m_x[0] - depthB * t.m_y[0];
+
+        float minX = std::min(t.m_x[0], std::min(t.m_x[1], t.m_x[2]));
+        float maxX = std::max(t.m_x[0], std::max(t.m_x[1], t.m_x[2]));
+        int firstColumn = std::max(0, static_cast<int>(std::floor(minX))) & ~3;
+        int endColumn = std::min(m_width, static_cast<int>(std::ceil(maxX)));
+        int first = std::max(firstRow, static_cast<int>(std::floor(t.m_minY)));
+        int end = std::min(endRow, static_cast<int>(std::ceil(t.m_maxY)));
+
+        for (int y = first; y < end; ++y)
+        {
+            float py = y + 0.5f;
+            float* row = &m_depth[y * m_width];
+#ifdef GLDEMO_OCCLUSION_SSE2
+            const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+            const __m128 zero = _mm_setzero_ps();
+            __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(firstColumn)), offsets);
+            __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[0]), px), _mm_set1_ps(edgeB[0] * py + edgeC[0]));
+            __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[1]), px), _mm_set1_ps(edgeB[1] * py + edgeC[1]));
+            __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(edgeA[2]), px), _mm_set1_ps(edgeB[2] * py + edgeC[2]));
+            __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthA), px), _mm_set1_ps(depthB * py + depthC));
+            const __m128 step0 = _mm_set1_ps(edgeA[0] * 4.0f);
+            const __m128 step1 = _mm_set1_ps(edgeA[1] * 4.0f);
+            const __m128 step2 = _mm_set1_ps(edgeA[2] * 4.0f);
+            const __m128 stepZ = _mm_set1_ps(depthA * 4.0f);
+
+            for (int x = firstColumn; x < endColumn; x += 4)
+            {
+                __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside))
+                {
+                    __m128 current = _mm_loadu_ps(row + x);
+                    __m128 nearest = _mm_min_ps(current, z);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+                }
+
+                e0 = _mm_add_ps(e0, step0);
+                e1 = _mm_add_ps(e1, step1);
+                e2 = _mm_add_ps(e2, step2);
+                z = _mm_add_ps(z, stepZ);
+            }
+#else
+            for (int x = firstColumn; x < endColumn; ++x)
+            {
+                float px = x + 0.5f;
+                if (edgeA[0] * px + edgeB[0] * py + edgeC[0] >= 0.0f &&
+                    edgeA[1] * px + edgeB[1] * py + edgeC[1] >= 0.0f &&
+                    edgeA[2] * px + edgeB[2] * py + edgeC[2] >= 0.0f)
+                {
+                    row[x] = std::min(row[x], depthA * px + depthB * py + depthC);
+                }
+            }
+#endif
+        }
+    }
+
+}
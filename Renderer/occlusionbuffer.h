@@ -0,0 +1,105 @@
+#ifndef GLDEMO_OCCLUSIONBUFFER_H
+#define GLDEMO_OCCLUSIONBUFFER_H
+
+#include <vector>
+
+#include <QSemaphore>
+
+#include "Math/matrix4.h"
+#include "Math/vector3soa.h"
+#include "Math/vector4.h"
+
+namespace GLDemo
+{
+    class BoundingBox;
+    class Mesh;
+
+    /**
+     * \brief A low resolution depth buffer, rasterized on the CPU, for culling objects
+     *        hidden behind a few large occluders before they are handed to the GPU.
+     *
+     * Occluders are usually simplified stand-ins for walls and other large objects. Only
+     * their triangle lists and strips are drawn. Rasterization is split into horizontal
+     * bands, each drawn by a worker thread from the global thread pool, and uses SSE2 to
+     * fill four pixels at a time where the compiler targets it.
+     *
+     * Depths are stored as in an OpenGL depth buffer, from 0 at the near plane to 1 at
+     * the far plane, using the same projection as the renderer.
+     */
+    class OcclusionBuffer
+    {
+    public:
+        /**
+         * \brief A mesh to draw into the buffer, with the world transform of its instance.
+         */
+        class Occluder
+        {
+        public:
+            Occluder(const Mesh* mesh, const Matrix4f& world) :
+                m_mesh(mesh),
+                m_world(world)
+            {
+            }
+
+            const Mesh* m_mesh;
+            Matrix4f    m_world;
+        };
+
+        typedef std::vector<Occluder> OccluderList;
+
+        OcclusionBuffer(int width = 256, int height = 128);
+        ~OcclusionBuffer();
+
+        void setSize(int width, int height);
+        int  getWidth() const  { return m_width; }
+        int  getHeight() const { return m_height; }
+
+        void begin(const Matrix4f& viewProj, const OccluderList& occluders);
+        void wait();
+        bool isBusy() const { return m_pendingBands > 0; }
+
+        bool  isOccluded(const BoundingBox& box) const;
+        float getDepth(int x, int y) const;
+
+    private:
+        /**
+         * \internal A triangle in screen space, with x and y in pixels.
+         */
+        class ScreenTriangle
+        {
+        public:
+            float m_x[3];
+            float m_y[3];
+            float m_z[3];
+            float m_minY;
+            float m_maxY;
+        };
+
+        class BandTask;
+        friend class BandTask;
+
+        void addTriangles(const Occluder& occluder);
+        void addClippedTriangle(const Vector4f& a, const Vector4f& b, const Vector4f& c);
+        void addScreenTriangle(const Vector4f* vertices);
+        void rasterizeBand(int firstRow, int endRow);
+        void rasterizeTriangle(const ScreenTriangle& triangle, int firstRow, int endRow);
+
+        int                          m_width;       // Always a multiple of four
+        int                          m_height;
+        std::vector<float>           m_depth;       // Row by row, from the bottom of the screen
+        std::vector<ScreenTriangle>  m_triangles;
+        Matrix4f                     m_viewProj;
+        Vector3SoA                   m_positions;   // Of the occluder being added
+        Vector3SoA                   m_clipPositions;
+        std::vector<float>           m_clipW;
+        std::vector<Vector4f>        m_clipVertices;
+        QSemaphore                   m_bandsDone;
+        int                          m_pendingBands;
+
+        OcclusionBuffer(const OcclusionBuffer&);
+        OcclusionBuffer& operator=(const OcclusionBuffer&);
+    };
+
+}
+
+#endif
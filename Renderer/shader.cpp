@@ -5,18 +5,31 @@
 
 #include "Scene/helpers.h"
 #include "shader.h"
+#include "shadercompiler.h"
+#include "shaderreloader.h"
 
 namespace GLDemo
 {
     Shader::Shader() :
-        m_program(0)
+        m_program()
     {
     }
 
 
     Shader::~Shader()
     {
-        delete m_program;
+        ShaderReloader::instance().forget(*this);
+    }
+
+
+    /**
+     * The default implementation has no indirect variant.
+     */
+    bool Shader::activateIndirect(const Matrix4f& view, int firstDraw)
+    {
+        Q_UNUSED(view);
+        Q_UNUSED(firstDraw);
+        return false;
     }
 
 
@@ -27,15 +40,70 @@ namespace GLDemo
      */
     bool Shader::compileAndLink(const QString& vertexShaderFileName, const QString& fragmentShaderFileName)
     {
-        if (!m_program)
+        return compileAndLink(m_program, vertexShaderFileName, fragmentShaderFileName);
+    }
+
+
+    /**
+     * \param program The program to compile into. Replaced with the shared program if
+     *                another shader has already built one from the same sources.
+     * \param vertexShaderFileName The name of the vertex shader file to compile.
+     * \param fragmentShaderFileName The name of the fragment shader to compile.
+     * \return true if the shader program was compiled and linked successfully, false otherwise.
+     *
+     * Allows subclasses to build additional programs besides the main one, such as a
+     * variant for indirect submission. Waits for the program to finish building.
+     */
+    bool Shader::compileAndLink(PtrShaderProgram& program, const QString& vertexShaderFileName, const QString& fragmentShaderFileName)
+    {
+        return beginCompileAndLink(program, vertexShaderFileName, fragmentShaderFileName) &&
+               waitForProgram(program);
+    }
+
+
+    /**
+     * \param program The program to compile into. Replaced with the shared program if
+     *                another shader has already built one from the same sources.
+     * \param vertexShaderFileName The name of the vertex shader file to compile.
+     * \param fragmentShaderFileName The name of the fragment shader to compile.
+     * \return false if the sources could not be read. Compile and link errors are only
+     *         known once the program has finished building.
+     *
+     * Starts building a program without waiting for it. Programs are looked up in the
+     * ShaderProgramCache before anything is compiled, so shaders must not rely on uniform
+     * values persisting between activations.
+     */
+    bool Shader::beginCompileAndLink(PtrShaderProgram& program, const QString& vertexShaderFileName, const QString& fragmentShaderFileName)
+    {
+        // Remember where the program came from, in case its files are reloaded.
+        ProgramSourceList::iterator iter = m_sources.begin();
+        while (iter != m_sources.end() && iter->m_program != &program)
         {
-            m_program = new QGLShaderProgram();
+            ++iter;
         }
+        if (iter == m_sources.end())
+        {
+            m_sources.push_back(ProgramSource(&program, vertexShaderFileName, fragmentShaderFileName));
+        }
+        else
+        {
+            iter->m_vertexFileName = vertexShaderFileName;
+            iter->m_fragmentFileName = fragmentShaderFileName;
+        }
+
+        ShaderReloader& reloader = ShaderReloader::instance();
+        reloader.watch(*this, reloader.resolveFileName(vertexShaderFileName));
+        reloader.watch(*this, reloader.resolveFileName(fragmentShaderFileName));
 
-        // Make sure we remove any shaders that have already been attached to this program.
-        // We also need to clear any uniforms we have indexed to make sure that we're only using what we need to.
-        m_program->removeAllShaders();
+        return startProgram(program, vertexShaderFileName, fragmentShaderFileName);
+    }
 
+
+    /**
+     * \internal Starts building a program without recording where it came from.
+     */
+    bool Shader::startProgram(PtrShaderProgram& program, const QString& vertexShaderFileName, const QString& fragmentShaderFileName)
+    {
         // We must have at a minimum a vertex and fragment shader
         if (vertexShaderFileName.isEmpty() ||
             fragmentShaderFileName.isEmpty())
@@ -44,58 +112,168 @@ namespace GLDemo
             return false;
         }
 
-        if (!addShaderToProgram(vertexShaderFileName, QGLShader::Vertex))
+        QString vertexSource;
+        QString fragmentSource;
+        if (!readShaderSource(vertexShaderFileName, vertexSource) ||
+            !readShaderSource(fragmentShaderFileName, fragmentSource))
         {
             return false;
         }
 
-        if (!addShaderToProgram(fragmentShaderFileName, QGLShader::Fragment))
+        ShaderProgramCache& cache = ShaderProgramCache::instance();
+        QByteArray key = cache.makeKey(vertexSource, fragmentSource);
+        program = cache.findProgram(key);
+        if (program)
         {
-            return false;
+            return true;
         }
 
-        if (!m_program->link())
+        program = PtrShaderProgram(new QGLShaderProgram());
+        if (!cache.loadBinary(key, *program))
         {
-            std::cout << "ERROR: Could not link shader program. Log follows:" << std::endl;
-            std::cout << m_program->log() << std::endl;
-            return false;
+            ShaderCompiler::instance().compileAndLink(program, key,
+                                                      vertexSource, vertexShaderFileName,
+                                                      fragmentSource, fragmentShaderFileName);
         }
 
+        cache.addProgram(key, program);
         return true;
     }
 
 
     /**
-     * \param filename  The filename of the shader program to load.
-     * \param type      The type of shader to compile.
+     * \return Whether a program started with beginCompileAndLink() has finished building.
+     *         Never waits for the compiler.
+     */
+    Shader::ProgramStatus Shader::getProgramStatus(const PtrShaderProgram& program) const
+    {
+        if (!program)
+        {
+            return ProgramFailed;
+        }
+
+        switch (ShaderCompiler::instance().getStatus(*program))
+        {
+        case ShaderCompiler::Pending:   return ProgramPending;
+        case ShaderCompiler::Linked:    return ProgramLinked;
+        default:                        return ProgramFailed;
+        }
+    }
+
+
+    /**
+     * \return True if the program linked successfully, once it has finished building.
+     */
+    bool Shader::waitForProgram(const PtrShaderProgram& program)
+    {
+        return program && ShaderCompiler::instance().wait(*program);
+    }
+
+
+    /**
+     * \param fileName  A source file that has changed, as returned by
+     *                  ShaderReloader::resolveFileName().
+     * \return True if any programs are being rebuilt.
      *
-     * Adds a shader to the shader program of this shader.
+     * Starts rebuilding every program built from the file. The current programs stay in
+     * use until swapReloadedPrograms() finds the new ones ready.
+     */
+    bool Shader::reload(const QString& fileName)
+    {
+        ShaderReloader& reloader = ShaderReloader::instance();
+        bool reloading = false;
+        for (ProgramSourceList::iterator iter = m_sources.begin(); iter != m_sources.end(); ++iter)
+        {
+            if (reloader.resolveFileName(iter->m_vertexFileName) == fileName ||
+                reloader.resolveFileName(iter->m_fragmentFileName) == fileName)
+            {
+                iter->m_reloaded.clear();
+                if (startProgram(iter->m_reloaded, iter->m_vertexFileName, iter->m_fragmentFileName))
+                {
+                    reloading = true;
+                }
+                else
+                {
+                    iter->m_reloaded.clear();
+                }
+            }
+        }
+
+        return reloading;
+    }
+
+
+    /**
+     * Replaces programs with their rebuilt versions once these have linked. Rebuilds that
+     * failed are discarded, leaving the current program in place.
      *
-     * \pre The internal shader program object must have been created prior to invoking this function.
+     * \return True if any rebuilds are still in progress.
      */
-    bool Shader::addShaderToProgram(const QString& filename, QGLShader::ShaderType type)
+    bool Shader::swapReloadedPrograms()
     {
-        assert(m_program);
-        QString sourceText;
-        if (!readShaderSource(filename, sourceText))
+        bool pending = false;
+        bool swapped = false;
+        for (ProgramSourceList::iterator iter = m_sources.begin(); iter != m_sources.end(); ++iter)
         {
-            return false;
+            if (!iter->m_reloaded)
+            {
+                continue;
+            }
+
+            switch (getProgramStatus(iter->m_reloaded))
+            {
+            case ProgramPending:
+                pending = true;
+                break;
+            case ProgramLinked:
+                *iter->m_program = iter->m_reloaded;
+                iter->m_reloaded.clear();
+                swapped = true;
+                break;
+            default:
+                iter->m_reloaded.clear();
+                break;
+            }
         }
 
-        if (!m_program->addShaderFromSourceCode(type, sourceText))
+        if (swapped)
         {
-            std::cout << QString("ERROR: Could not add shader from source file \"%1\"").arg(filename) << std::endl;
-            QStringList errors( m_program->log().split("\n", QString::SkipEmptyParts) );
-            std::cout << errors.join("\n") << std::endl;;
-            return false;
+            programsReloaded();
         }
 
+        return pending;
+    }
+
+
+    /**
+     * The default implementation has nothing to look up again.
+     */
+    void Shader::programsReloaded()
+    {
+    }
+
+
+    /**
+     * The default implementation builds its programs when first activated.
+     */
+    bool Shader::prepare()
+    {
+        return true;
+    }
+
+
+    /**
+     * The default implementation builds its programs when first activated.
+     */
+    bool Shader::isReady()
+    {
         return true;
     }
 
 
     /**
-     * \param sourceFileName The name of the source file to read.
+     * \param sourceFileName The name of the source file to read. Read from the ShaderReloader's
+     *                       source directory instead of the resources when one is set.
      * \param sourceOut      A string to which the contents of the source file will be written.
      *
      * This function exists so that in the future, we can add additional processes here
@@ -105,7 +283,7 @@ namespace GLDemo
      */
     bool Shader::readShaderSource(const QString& sourceFileName, QString& sourceOut)
     {
-        QFile sourceFile(sourceFileName);
+        QFile sourceFile(ShaderReloader::instance().resolveFileName(sourceFileName));
         if (!sourceFile.open(QIODevice::ReadOnly | QIODevice::Text))
         {
             std::cout << QString("ERROR: Could not read shader source from file \"%1\".").arg(sourceFileName) + "\n";
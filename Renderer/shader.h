@@ -1,19 +1,28 @@
 #ifndef GLDEMO_SHADER_H
 #define GLDEMO_SHADER_H
 
+#include <list>
+
 #include <QGLShaderProgram>
 #include <QSharedPointer>
 
 #include "Math/matrix4.h"
+#include "shaderprogramcache.h"
 
 class QString;
 
 namespace GLDemo
 {
+    class Material;
     class Renderer;
 
     /**
      * \brief Used for shading a model with a particular algorithm.
+     *
+     * The parameters of the algorithm belong to a Material, so the one shader can be used
+     * with any number of materials. Drawing happens in three steps: the shader is activated
+     * once, then for each material setMaterial() is called followed by setTransforms() for
+     * each model drawn with it.
      */
     class Shader
     {
@@ -24,21 +33,104 @@ namespace GLDemo
          * Activates a shader, causing models that are subsequently drawn to be
          * rendered with its effect.
          */
-        virtual bool activate(const Matrix4f& view,
-                              const Matrix4f& worldView,
-                              const Matrix4f& worldViewInvTranspose,
-                              const Matrix4f& worldViewProj) = 0;
+        virtual bool activate(const Matrix4f& view) = 0;
+
+        /**
+         * Sets the parameters of models subsequently drawn with the active shader.
+         */
+        virtual bool setMaterial(const Material& material) = 0;
+
+        /**
+         * Sets the transforms of the next model drawn with the active shader.
+         */
+        virtual bool setTransforms(const Matrix4f& worldView,
+                                   const Matrix4f& worldViewInvTranspose,
+                                   const Matrix4f& worldViewProj) = 0;
+
+        /**
+         * Activates the shader for a batch of draws submitted with a single multi-draw
+         * indirect call. Rather than taking transforms and material parameters as uniforms,
+         * the shader reads them from the GLRenderer::PerDrawData storage buffer at index
+         * \a firstDraw + gl_DrawID, and from the GLRenderer::MaterialData storage buffer at
+         * the material index given there. Shaders without an indirect variant return false.
+         */
+        virtual bool activateIndirect(const Matrix4f& view, int firstDraw);
+
+        /**
+         * Starts building the shader's programs, without waiting for them to finish.
+         * Returns false if they can't be built. Calling it again has no further effect.
+         */
+        virtual bool prepare();
+
+        /**
+         * Returns true once activate() can be called without waiting for the compiler.
+         * Never waits itself.
+         */
+        virtual bool isReady();
+
+        bool reload(const QString& fileName);
+        bool swapReloadedPrograms();
 
     protected:
-        QGLShaderProgram* m_program;
+        enum ProgramStatus
+        {
+            ProgramPending,
+            ProgramLinked,
+            ProgramFailed
+        };
+
+        PtrShaderProgram m_program;
 
         Shader();
         bool compileAndLink(const QString& vertexShaderFilename,
                             const QString& fragmentShaderFilename);
+        bool compileAndLink(PtrShaderProgram& program,
+                            const QString& vertexShaderFilename,
+                            const QString& fragmentShaderFilename);
+        bool beginCompileAndLink(PtrShaderProgram& program,
+                                 const QString& vertexShaderFilename,
+                                 const QString& fragmentShaderFilename);
+        ProgramStatus getProgramStatus(const PtrShaderProgram& program) const;
+        bool waitForProgram(const PtrShaderProgram& program);
+
+        /**
+         * Called after reloaded programs have been swapped in, so that anything looked up
+         * from the old programs, such as uniform locations, can be looked up again.
+         */
+        virtual void programsReloaded();
 
     private:
-        bool addShaderToProgram(const QString& fileName, QGLShader::ShaderType type);
+        /**
+         * \internal The files a program was built from, and its replacement while the
+         *           files are being reloaded.
+         */
+        class ProgramSource
+        {
+        public:
+            ProgramSource(PtrShaderProgram* program, const QString& vertexFileName, const QString& fragmentFileName) :
+                m_program(program),
+                m_vertexFileName(vertexFileName),
+                m_fragmentFileName(fragmentFileName)
+            {
+            }
+
+            PtrShaderProgram*  m_program;
+            QString            m_vertexFileName;
+            QString            m_fragmentFileName;
+            PtrShaderProgram   m_reloaded;
+        };
+
+        typedef std::list<ProgramSource> ProgramSourceList;
+
+        ProgramSourceList m_sources;
+
+        bool startProgram(PtrShaderProgram& program,
+                          const QString& vertexShaderFilename,
+                          const QString& fragmentShaderFilename);
         bool readShaderSource(const QString& sourceFileName, QString& sourceOut);
+
+        Shader(const Shader&);
+        Shader& operator=(const Shader&);
     };
 
     typedef QSharedPointer<Shader> PtrShader;
@@ -0,0 +1,531 @@
+#include <algorithm>
+#include <iostream>
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QGLContext>
+#include <QMutexLocker>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QThread>
+
+#include "Scene/helpers.h"
+#include "glrenderer.h"
+#include "shadercompiler.h"
+
+namespace GLDemo
+{
+    /**
+     * \internal A program being built, along with everything needed to report on it.
+     */
+    class ShaderCompileJob
+    {
+    public:
+        ShaderCompileJob() :
+            m_programId(0),
+            m_vertexShader(0),
+            m_fragmentShader(0),
+            m_linked(false),
+            m_finished(0)
+        {
+        }
+
+        QByteArray  m_key;
+        QByteArray  m_vertexSource;
+        QByteArray  m_fragmentSource;
+        QString     m_vertexName;
+        QString     m_fragmentName;
+        GLuint      m_programId;
+        GLuint      m_vertexShader;
+        GLuint      m_fragmentShader;
+
+        // Written by whichever thread builds the program, then published through m_finished.
+        bool        m_linked;
+        QString     m_log;
+        QAtomicInt  m_finished;
+    };
+
+
+    /**
+     * \internal A thread compiling queued programs in its own shared context.
+     */
+    class ShaderCompileWorker : public QThread
+    {
+    public:
+        ShaderCompileWorker(ShaderCompiler& compiler, QOpenGLContext* context, QOffscreenSurface* surface) :
+            m_compiler(compiler),
+            m_context(context),
+            m_surface(surface)
+        {
+        }
+
+        ~ShaderCompileWorker()
+        {
+            delete m_context;
+            delete m_surface;
+        }
+
+    protected:
+        virtual void run();
+
+    private:
+        ShaderCompiler&     m_compiler;
+        QOpenGLContext*     m_context;
+        QOffscreenSurface*  m_surface;
+    };
+
+
+    namespace
+    {
+        /**
+         * \internal Compiles the job's shaders and links them into its program, without
+         *           querying any results. Querying would make a driver compiling in the
+         *           background wait for it to finish.
+         */
+        void startBuild(QGLFunctions& gl, ShaderCompileJob& job)
+        {
+            const char* vertexSource = job.m_vertexSource.constData();
+            job.m_vertexShader = gl.glCreateShader(GL_VERTEX_SHADER);
+            gl.glShaderSource(job.m_vertexShader, 1, &vertexSource, 0);
+            gl.glCompileShader(job.m_vertexShader);
+
+            const char* fragmentSource = job.m_fragmentSource.constData();
+            job.m_fragmentShader = gl.glCreateShader(GL_FRAGMENT_SHADER);
+            gl.glShaderSource(job.m_fragmentShader, 1, &fragmentSource, 0);
+            gl.glCompileShader(job.m_fragmentShader);
+
+            gl.glAttachShader(job.m_programId, job.m_vertexShader);
+            gl.glAttachShader(job.m_programId, job.m_fragmentShader);
+
+            // Attribute locations only take effect at link time, and must match the locations
+            // the renderer records in its vertex arrays, so bind them to the standard names here.
+            gl.glBindAttribLocation(job.m_programId, GLRenderer::Position, "vertPosition");
+            gl.glBindAttribLocation(job.m_programId, GLRenderer::Normal, "vertNormal");
+
+            gl.glLinkProgram(job.m_programId);
+        }
+
+
+        /**
+         * \internal Appends the info log of a shader to \a log, if it has one.
+         */
+        void appendShaderLog(QGLFunctions& gl, GLuint shader, const QString& name, QString& log)
+        {
+            GLint compiled = 0;
+            GLint length = 0;
+            gl.glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+            gl.glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+            if (compiled && length <= 1)
+            {
+                return;
+            }
+
+            QByteArray text(std::max(length, 1), 0);
+            gl.glGetShaderInfoLog(shader, length, 0, text.data());
+            log += QString("Shader \"%1\":\n%2\n").arg(name).arg(QString(text));
+        }
+
+
+        /**
+         * \internal Collects the results of a build started with startBuild(). This waits
+         *           for the driver if the build is still in progress.
+         */
+        void finishBuild(QGLFunctions& gl, ShaderCompileJob& job)
+        {
+            GLint linked = 0;
+            gl.glGetProgramiv(job.m_programId, GL_LINK_STATUS, &linked);
+            job.m_linked = linked != 0;
+
+            if (!job.m_linked)
+            {
+                appendShaderLog(gl, job.m_vertexShader, job.m_vertexName, job.m_log);
+                appendShaderLog(gl, job.m_fragmentShader, job.m_fragmentName, job.m_log);
+
+                GLint length = 0;
+                gl.glGetProgramiv(job.m_programId, GL_INFO_LOG_LENGTH, &length);
+                if (length > 1)
+                {
+                    QByteArray text(length, 0);
+                    gl.glGetProgramInfoLog(job.m_programId, length, 0, text.data());
+                    job.m_log += QString(text);
+                }
+            }
+
+            // The program keeps its executable once linked, so the shaders are no longer needed.
+            gl.glDetachShader(job.m_programId, job.m_vertexShader);
+            gl.glDetachShader(job.m_programId, job.m_fragmentShader);
+            gl.glDeleteShader(job.m_vertexShader);
+            gl.glDeleteShader(job.m_fragmentShader);
+            job.m_vertexShader = job.m_fragmentShader = 0;
+        }
+    }
+
+
+    /**
+     * Builds queued jobs until the compiler shuts down.
+     */
+    void ShaderCompileWorker::run()
+    {
+        if (!m_context->makeCurrent(m_surface))
+        {
+            std::cout << "ERROR: Could not make shader compiler context current." << std::endl;
+            return;
+        }
+
+        QGLContext* glContext = QGLContext::fromOpenGLContext(m_context);
+        QGLFunctions gl(glContext);
+
+        bool stop = false;
+        while (!stop)
+        {
+            QSharedPointer<ShaderCompileJob> job = m_compiler.takeQueuedJob(stop);
+            if (job)
+            {
+                startBuild(gl, *job);
+                finishBuild(gl, *job);
+
+                // Objects changed in one context are only guaranteed to be complete in the
+                // others sharing with it once the commands changing them have finished.
+                glFinish();
+                job->m_finished.storeRelease(1);
+                m_compiler.jobFinished();
+            }
+        }
+
+        m_context->doneCurrent();
+        delete glContext;
+
+        // Hand the context back so it can be deleted along with this thread.
+        m_context->moveToThread(QCoreApplication::instance()->thread());
+    }
+
+
+    //=============================//
+
+
+    /**
+     * \return The compiler used by every shader in the application.
+     */
+    ShaderCompiler& ShaderCompiler::instance()
+    {
+        static ShaderCompiler compiler;
+        return compiler;
+    }
+
+
+    /**
+     *
+     */
+    ShaderCompiler::ShaderCompiler() :
+        m_mode(Immediate),
+        m_initialized(false),
+        m_extensions(),
+        m_jobs(),
+        m_stopping(false)
+    {
+    }
+
+
+    /**
+     * \note shutdown() should already have been called while the context was still
+     *       current; the threads are only stopped here as a last resort.
+     */
+    ShaderCompiler::~ShaderCompiler()
+    {
+        shutdown();
+    }
+
+
+    /**
+     * \param program         A program with no shaders attached, to build into.
+     * \param key             The key of the program in the ShaderProgramCache, for saving
+     *                        its binary once linked.
+     * \param vertexSource    The source of the vertex shader.
+     * \param vertexName      The name of the vertex shader, for error reporting.
+     * \param fragmentSource  The source of the fragment shader.
+     * \param fragmentName    The name of the fragment shader, for error reporting.
+     *
+     * Starts building the program. Use getStatus() to find out when it's ready, or
+     * wait() to block until it is.
+     */
+    void ShaderCompiler::compileAndLink(const PtrShaderProgram& program, const QByteArray& key,
+                                        const QString& vertexSource, const QString& vertexName,
+                                        const QString& fragmentSource, const QString& fragmentName)
+    {
+        initialize();
+
+        PtrJob job(new ShaderCompileJob());
+        job->m_key = key;
+        job->m_vertexSource = vertexSource.toUtf8();
+        job->m_fragmentSource = fragmentSource.toUtf8();
+        job->m_vertexName = vertexName;
+        job->m_fragmentName = fragmentName;
+
+        // The program object itself is created here, in the context it will be used in.
+        job->m_programId = program->programId();
+        ShaderProgramCache::instance().prepareForBinary(*program);
+        m_jobs.insert(program.data(), job);
+
+        switch (m_mode)
+        {
+        case WorkerThreads:
+            {
+                // A worker's context is only sure to see the program, and the hint set on
+                // it, once the commands that made them have been flushed.
+                glFlush();
+
+                QMutexLocker lock(&m_mutex);
+                m_queue.push_back(job);
+                m_jobQueued.wakeOne();
+            }
+            break;
+
+        case DriverThreads:
+            startBuild(*this, *job);
+            break;
+
+        case Immediate:
+            startBuild(*this, *job);
+            finishBuild(*this, *job);
+            job->m_finished.storeRelease(1);
+            break;
+        }
+    }
+
+
+    /**
+     * \param program  The program to check.
+     * \return Pending if the program is still being built, otherwise whether it linked.
+     *         Never waits for the compiler.
+     */
+    ShaderCompiler::Status ShaderCompiler::getStatus(QGLShaderProgram& program)
+    {
+        JobMap::iterator iter = m_jobs.find(&program);
+        if (iter == m_jobs.end())
+        {
+            return program.isLinked() ? Linked : Failed;
+        }
+
+        ShaderCompileJob& job = **iter;
+        if (m_mode == DriverThreads)
+        {
+            GLint complete = 0;
+            glGetProgramiv(job.m_programId, GL_COMPLETION_STATUS_KHR, &complete);
+            if (!complete)
+            {
+                return Pending;
+            }
+            finishBuild(*this, job);
+        }
+        else if (!job.m_finished.loadAcquire())
+        {
+            return Pending;
+        }
+
+        return complete(iter);
+    }
+
+
+    /**
+     * \param program  The program to wait for.
+     * \return True if the program linked successfully.
+     */
+    bool ShaderCompiler::wait(QGLShaderProgram& program)
+    {
+        JobMap::iterator iter = m_jobs.find(&program);
+        if (iter == m_jobs.end())
+        {
+            return program.isLinked();
+        }
+
+        ShaderCompileJob& job = **iter;
+        if (m_mode == DriverThreads)
+        {
+            finishBuild(*this, job);
+        }
+        else if (m_mode == WorkerThreads)
+        {
+            QMutexLocker lock(&m_mutex);
+            while (!job.m_finished.loadAcquire())
+            {
+                m_jobFinished.wait(&m_mutex);
+            }
+        }
+
+        return complete(iter) == Linked;
+    }
+
+
+    /**
+     * Stops the worker threads, abandoning any programs they have not started on yet.
+     * Must be called before the context the compiler was initialized with is destroyed.
+     * The compiler initializes itself again if it is used afterwards.
+     */
+    void ShaderCompiler::shutdown()
+    {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_stopping = true;
+            m_queue.clear();
+            m_jobQueued.wakeAll();
+        }
+
+        for (std::vector<ShaderCompileWorker*>::iterator iter = m_workers.begin(); iter != m_workers.end(); ++iter)
+        {
+            (*iter)->wait();
+            delete *iter;
+        }
+        m_workers.clear();
+
+        // Jobs that never ran can't complete now; those that did are left to be collected.
+        for (JobMap::iterator iter = m_jobs.begin(); iter != m_jobs.end(); )
+        {
+            if ((*iter)->m_finished.loadAcquire())
+            {
+                ++iter;
+            }
+            else
+            {
+                iter = m_jobs.erase(iter);
+            }
+        }
+
+        m_stopping = false;
+        m_initialized = false;
+    }
+
+
+    /**
+     * \internal Picks how programs are built, based on what the current context supports.
+     */
+    bool ShaderCompiler::initialize()
+    {
+        if (m_initialized)
+        {
+            return true;
+        }
+
+        initializeGLFunctions();
+        m_extensions.initialize(QGLContext::currentContext());
+
+        if (m_extensions.hasParallelShaderCompile())
+        {
+            // Let the driver use as many threads as it sees fit.
+            m_extensions.glMaxShaderCompilerThreads(0xFFFFFFFFu);
+            m_mode = DriverThreads;
+        }
+        else if (startWorkers())
+        {
+            m_mode = WorkerThreads;
+        }
+        else
+        {
+            m_mode = Immediate;
+        }
+
+        m_initialized = true;
+        return true;
+    }
+
+
+    /**
+     * \internal Creates the worker threads and their contexts.
+     * \return False if the platform can't use contexts on other threads.
+     */
+    bool ShaderCompiler::startWorkers()
+    {
+        const QGLContext* context = QGLContext::currentContext();
+        if (!context || !context->contextHandle() || !QOpenGLContext::supportsThreadedOpenGL())
+        {
+            return false;
+        }
+
+        // Keep a core free for the GUI thread, and don't bother with more than a few workers,
+        // as drivers tend to serialize parts of the compile anyway.
+        int numWorkers = std::max(1, std::min(QThread::idealThreadCount() - 1, 4));
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            // Contexts and surfaces have to be created on the GUI thread.
+            QOffscreenSurface* surface = new QOffscreenSurface();
+            surface->setFormat(context->contextHandle()->format());
+            surface->create();
+
+            QOpenGLContext* workerContext = new QOpenGLContext();
+            workerContext->setFormat(context->contextHandle()->format());
+            workerContext->setShareContext(context->contextHandle());
+            if (!surface->isValid() || !workerContext->create())
+            {
+                delete workerContext;
+                delete surface;
+                break;
+            }
+
+            ShaderCompileWorker* worker = new ShaderCompileWorker(*this, workerContext, surface);
+            workerContext->moveToThread(worker);
+            m_workers.push_back(worker);
+            worker->start();
+        }
+
+        return !m_workers.empty();
+    }
+
+
+    /**
+     * \internal Called by workers to get their next job, waiting until there is one.
+     * \param stop  Set to true when the worker should exit instead.
+     */
+    ShaderCompiler::PtrJob ShaderCompiler::takeQueuedJob(bool& stop)
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_queue.empty() && !m_stopping)
+        {
+            m_jobQueued.wait(&m_mutex);
+        }
+
+        stop = m_stopping;
+        if (stop)
+        {
+            return PtrJob();
+        }
+
+        PtrJob job = m_queue.front();
+        m_queue.pop_front();
+        return job;
+    }
+
+
+    /**
+     * \internal Called by workers after finishing a job, to wake anyone waiting on it.
+     */
+    void ShaderCompiler::jobFinished()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_jobFinished.wakeAll();
+    }
+
+
+    /**
+     * \internal Hands a finished program over to Qt, reports any errors, and saves the
+     *           program's binary.
+     */
+    ShaderCompiler::Status ShaderCompiler::complete(JobMap::iterator iter)
+    {
+        QGLShaderProgram& program = *iter.key();
+        PtrJob job = *iter;
+        m_jobs.erase(iter);
+
+        // Linking a program with no shaders attached through Qt just picks up the
+        // result of the link we did ourselves.
+        if (!job->m_linked || !program.link())
+        {
+            std::cout << "ERROR: Could not build shader program from \"" << job->m_vertexName
+                      << "\" and \"" << job->m_fragmentName << "\". Log follows:" << std::endl;
+            std::cout << job->m_log << std::endl;
+            return Failed;
+        }
+
+        ShaderProgramCache::instance().saveBinary(job->m_key, program);
+        return Linked;
+    }
+
+}
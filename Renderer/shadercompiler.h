@@ -0,0 +1,99 @@
+#ifndef GLDEMO_SHADERCOMPILER_H
+#define GLDEMO_SHADERCOMPILER_H
+
+#include <deque>
+#include <vector>
+
+#include <QByteArray>
+#include <QGLFunctions>
+#include <QGLShaderProgram>
+#include <QMap>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QWaitCondition>
+
+#include "glextensions.h"
+#include "shaderprogramcache.h"
+
+namespace GLDemo
+{
+    class ShaderCompileJob;
+    class ShaderCompileWorker;
+
+    /**
+     * \brief Compiles and links shader programs without blocking the thread that asks for them.
+     *
+     * Where the driver supports KHR_parallel_shader_compile, programs are built on the
+     * calling thread and the driver is left to finish them in the background. Otherwise,
+     * programs are built by worker threads, each with its own context sharing objects with
+     * the one the compiler was initialized in. If neither is possible, programs are built
+     * immediately, and are already finished by the time compileAndLink() returns.
+     *
+     * Every function must be called from the thread owning the context the compiler was
+     * first used with, while that context is current.
+     */
+    class ShaderCompiler : protected QGLFunctions
+    {
+    public:
+        enum Status
+        {
+            Pending,
+            Linked,
+            Failed
+        };
+
+        static ShaderCompiler& instance();
+        ~ShaderCompiler();
+
+        void   compileAndLink(const PtrShaderProgram& program, const QByteArray& key,
+                              const QString& vertexSource, const QString& vertexName,
+                              const QString& fragmentSource, const QString& fragmentName);
+        Status getStatus(QGLShaderProgram& program);
+        bool   wait(QGLShaderProgram& program);
+        bool   hasPendingPrograms() const { return !m_jobs.isEmpty(); }
+
+        void   shutdown();
+
+    private:
+        friend class ShaderCompileWorker;
+
+        enum Mode
+        {
+            Immediate,
+            DriverThreads,
+            WorkerThreads
+        };
+
+        typedef QSharedPointer<ShaderCompileJob>    PtrJob;
+        typedef QMap<QGLShaderProgram*, PtrJob>     JobMap;
+
+        ShaderCompiler();
+
+        bool   initialize();
+        bool   startWorkers();
+        PtrJob takeQueuedJob(bool& stop);
+        void   jobFinished();
+        Status complete(JobMap::iterator iter);
+
+        Mode          m_mode;
+        bool          m_initialized;
+        GLExtensions  m_extensions;
+        JobMap        m_jobs;
+
+        // Shared with the worker threads, guarded by m_mutex.
+        QMutex              m_mutex;
+        QWaitCondition      m_jobQueued;
+        QWaitCondition      m_jobFinished;
+        std::deque<PtrJob>  m_queue;
+        bool                m_stopping;
+
+        std::vector<ShaderCompileWorker*> m_workers;
+
+        ShaderCompiler(const ShaderCompiler&);
+        ShaderCompiler& operator=(const ShaderCompiler&);
+    };
+
+}
+
+#endif
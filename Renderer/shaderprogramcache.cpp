@@ -0,0 +1,230 @@
+#include <cstring>
+#include <iostream>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QGLContext>
+#include <QIODevice>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "Scene/helpers.h"
+#include "glrenderer.h"
+#include "shaderprogramcache.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        // Bump this whenever something that affects linking, such as the attribute
+        // bindings made in Shader::compileAndLink, changes without the sources changing.
+        const char* const s_cacheVersion = "1";
+    }
+
+
+    /**
+     * \return The cache used by every shader in the application.
+     */
+    ShaderProgramCache& ShaderProgramCache::instance()
+    {
+        static ShaderProgramCache cache;
+        return cache;
+    }
+
+
+    /**
+     * Binaries are kept in the user's cache directory by default.
+     */
+    ShaderProgramCache::ShaderProgramCache() :
+        m_programs(),
+        m_binaryDirectory(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath("shaders")),
+        m_extensions(),
+        m_initialized(false)
+    {
+    }
+
+
+    /**
+     * \param vertexSource    The source of the vertex shader.
+     * \param fragmentSource  The source of the fragment shader.
+     * \return A key identifying the program built from the sources by the current driver.
+     *
+     * \pre A context must be current.
+     */
+    QByteArray ShaderProgramCache::makeKey(const QString& vertexSource, const QString& fragmentSource)
+    {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(s_cacheVersion);
+        hash.addData(vertexSource.toUtf8());
+        hash.addData("\0", 1);
+        hash.addData(fragmentSource.toUtf8());
+
+        // A binary is only guaranteed to load on the driver that produced it.
+        const GLubyte* strings[] = { glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION) };
+        for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); ++i)
+        {
+            hash.addData("\0", 1);
+            if (strings[i])
+            {
+                hash.addData(reinterpret_cast<const char*>(strings[i]));
+            }
+        }
+
+        return hash.result().toHex();
+    }
+
+
+    /**
+     * \return The program previously added with \a key, or null if there is none or
+     *         every shader using it has since been destroyed.
+     */
+    PtrShaderProgram ShaderProgramCache::findProgram(const QByteArray& key) const
+    {
+        ProgramMap::const_iterator iter = m_programs.find(key);
+        if (iter == m_programs.end())
+        {
+            return PtrShaderProgram();
+        }
+        return iter->toStrongRef();
+    }
+
+
+    /**
+     * \param key      The key the program's sources produced with makeKey().
+     * \param program  A linked program to share with later shaders using the same sources.
+     *
+     * Only a weak reference is held, so the program is still deleted along with the last
+     * shader using it.
+     */
+    void ShaderProgramCache::addProgram(const QByteArray& key, const PtrShaderProgram& program)
+    {
+        m_programs.insert(key, QWeakPointer<QGLShaderProgram>(program));
+    }
+
+
+    /**
+     * \param key      The key of the program to load.
+     * \param program  A program with no shaders attached, which receives the binary.
+     * \return True if a binary was found and the driver accepted it, in which case the
+     *         program is linked and ready for use.
+     */
+    bool ShaderProgramCache::loadBinary(const QByteArray& key, QGLShaderProgram& program)
+    {
+        if (!initialize() || !m_extensions.hasProgramBinary())
+        {
+            return false;
+        }
+
+        QFile file(binaryFileName(key));
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        QByteArray contents = file.readAll();
+        file.close();
+
+        GLenum format = 0;
+        if (contents.size() <= static_cast<int>(sizeof(format)))
+        {
+            return false;
+        }
+        std::memcpy(&format, contents.constData(), sizeof(format));
+
+        // Requesting the id creates the program object without attaching anything to it.
+        // Linking a program with no shaders then just reports the result of the binary load.
+        GLuint programId = program.programId();
+        m_extensions.glProgramBinary(programId, format, contents.constData() + sizeof(format), contents.size() - sizeof(format));
+        if (!program.link())
+        {
+            std::cout << "WARNING: Discarding stale shader binary \"" << file.fileName() << "\"." << std::endl;
+            QFile::remove(file.fileName());
+            return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * \param program  A program about to be linked from source.
+     *
+     * Asks the driver to keep the binary around for saveBinary(). Without the hint, some
+     * drivers only produce a binary after the program has been used for drawing.
+     */
+    void ShaderProgramCache::prepareForBinary(QGLShaderProgram& program)
+    {
+        if (initialize() && m_extensions.hasProgramBinary() && m_extensions.glProgramParameteri)
+        {
+            m_extensions.glProgramParameteri(program.programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+    }
+
+
+    /**
+     * \param key      The key of the program.
+     * \param program  The linked program to store.
+     *
+     * Failing to save is not an error; the program will just be compiled again next time.
+     */
+    void ShaderProgramCache::saveBinary(const QByteArray& key, QGLShaderProgram& program)
+    {
+        if (!initialize() || !m_extensions.hasProgramBinary())
+        {
+            return;
+        }
+
+        GLuint programId = program.programId();
+        GLint length = 0;
+        glGetProgramiv(programId, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+        {
+            return;
+        }
+
+        GLenum format = 0;
+        QByteArray contents(sizeof(format) + length, 0);
+        m_extensions.glGetProgramBinary(programId, length, &length, &format, contents.data() + sizeof(format));
+        std::memcpy(contents.data(), &format, sizeof(format));
+        contents.resize(sizeof(format) + length);
+
+        if (!QDir().mkpath(m_binaryDirectory))
+        {
+            std::cout << "WARNING: Could not create shader cache directory \"" << m_binaryDirectory << "\"." << std::endl;
+            return;
+        }
+
+        // Write to a temporary file first, so that a crash can't leave a truncated binary behind.
+        QSaveFile file(binaryFileName(key));
+        if (!file.open(QIODevice::WriteOnly) ||
+            file.write(contents) != contents.size() ||
+            !file.commit())
+        {
+            std::cout << "WARNING: Could not write shader binary \"" << binaryFileName(key) << "\"." << std::endl;
+        }
+    }
+
+
+    /**
+     * \internal Resolves the program binary entry points the first time they are needed.
+     */
+    bool ShaderProgramCache::initialize()
+    {
+        if (!m_initialized)
+        {
+            initializeGLFunctions();
+            m_initialized = m_extensions.initialize(QGLContext::currentContext());
+        }
+        return m_initialized;
+    }
+
+
+    /**
+     * \internal
+     */
+    QString ShaderProgramCache::binaryFileName(const QByteArray& key) const
+    {
+        return QDir(m_binaryDirectory).filePath(QString(key) + ".bin");
+    }
+
+}
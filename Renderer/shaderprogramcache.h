@@ -0,0 +1,67 @@
+#ifndef GLDEMO_SHADERPROGRAMCACHE_H
+#define GLDEMO_SHADERPROGRAMCACHE_H
+
+#include <QByteArray>
+#include <QGLFunctions>
+#include <QGLShaderProgram>
+#include <QMap>
+#include <QSharedPointer>
+#include <QString>
+#include <QWeakPointer>
+
+#include "glextensions.h"
+
+namespace GLDemo
+{
+    typedef QSharedPointer<QGLShaderProgram> PtrShaderProgram;
+
+    /**
+     * \brief Shares linked shader programs between shaders and keeps their binaries on disk.
+     *
+     * Programs are identified by a key hashed from their sources and the driver that
+     * compiled them. Shaders built from the same sources get the same program object for
+     * as long as any of them holds on to it. Where the context supports program binaries,
+     * linked programs are also written to the binary directory, so that later runs can
+     * skip the shader compiler entirely. A binary the driver rejects (after a driver update,
+     * for example) is simply rebuilt from source and replaced.
+     *
+     * Program objects are only valid in the context they were created in and the contexts
+     * sharing with it, so the cache assumes all shaders are used with a single share group.
+     */
+    class ShaderProgramCache : protected QGLFunctions
+    {
+    public:
+        static ShaderProgramCache& instance();
+
+        void setBinaryDirectory(const QString& directory) { m_binaryDirectory = directory; }
+        const QString& getBinaryDirectory() const          { return m_binaryDirectory; }
+
+        QByteArray makeKey(const QString& vertexSource, const QString& fragmentSource);
+
+        PtrShaderProgram findProgram(const QByteArray& key) const;
+        void addProgram(const QByteArray& key, const PtrShaderProgram& program);
+
+        bool loadBinary(const QByteArray& key, QGLShaderProgram& program);
+        void prepareForBinary(QGLShaderProgram& program);
+        void saveBinary(const QByteArray& key, QGLShaderProgram& program);
+
+    private:
+        typedef QMap<QByteArray, QWeakPointer<QGLShaderProgram> > ProgramMap;
+
+        ShaderProgramCache();
+
+        bool    initialize();
+        QString binaryFileName(const QByteArray& key) const;
+
+        ProgramMap    m_programs;
+        QString       m_binaryDirectory;
+        GLExtensions  m_extensions;
+        bool          m_initialized;
+
+        ShaderProgramCache(const ShaderProgramCache&);
+        ShaderProgramCache& operator=(const ShaderProgramCache&);
+    };
+
+}
+
+#endif
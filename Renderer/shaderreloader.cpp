@@ -0,0 +1,152 @@
+#include <QDir>
+#include <QFile>
+
+#include "shader.h"
+#include "shaderreloader.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        // Resource prefix of the shader sources, as given in shaders.qrc.
+        const char* const s_resourcePrefix = ":/shaders/";
+    }
+
+
+    /**
+     * \return The reloader used by every shader in the application.
+     */
+    ShaderReloader& ShaderReloader::instance()
+    {
+        static ShaderReloader reloader;
+        return reloader;
+    }
+
+
+    /**
+     *
+     */
+    ShaderReloader::ShaderReloader() :
+        QObject(),
+        m_sourceDirectory(),
+        m_watcher(),
+        m_shaders(),
+        m_changedFiles(),
+        m_reloading()
+    {
+        connect(&m_watcher, SIGNAL(fileChanged(QString)), this, SLOT(fileChanged(QString)));
+    }
+
+
+    /**
+     * \param directory  The directory holding the files listed in shaders.qrc, or an empty
+     *                   string to use the compiled-in resources.
+     *
+     * Only affects shaders built after the call.
+     */
+    void ShaderReloader::setSourceDirectory(const QString& directory)
+    {
+        m_sourceDirectory = directory;
+    }
+
+
+    /**
+     * \param fileName  The name of a shader source, usually a resource path.
+     * \return The file the source should be read from.
+     */
+    QString ShaderReloader::resolveFileName(const QString& fileName) const
+    {
+        if (isEnabled() && fileName.startsWith(s_resourcePrefix))
+        {
+            return QDir(m_sourceDirectory).filePath(fileName.mid(QString(s_resourcePrefix).length()));
+        }
+        return fileName;
+    }
+
+
+    /**
+     * \param shader    A shader built from the file.
+     * \param fileName  The file, as returned by resolveFileName().
+     */
+    void ShaderReloader::watch(Shader& shader, const QString& fileName)
+    {
+        if (!isEnabled() || fileName.startsWith(":"))
+        {
+            return;
+        }
+
+        m_shaders[fileName].insert(&shader);
+        m_watcher.addPath(fileName);
+    }
+
+
+    /**
+     * \param shader  A shader being destroyed, which must no longer be reloaded.
+     */
+    void ShaderReloader::forget(Shader& shader)
+    {
+        for (ShaderMap::iterator iter = m_shaders.begin(); iter != m_shaders.end(); ++iter)
+        {
+            iter->remove(&shader);
+        }
+        m_reloading.remove(&shader);
+    }
+
+
+    /**
+     * Starts rebuilding the shaders affected by any files changed since the last call, and
+     * swaps in the programs of earlier rebuilds that have since finished. Call this only
+     * between frames, so a frame is never drawn with a mix of old and new programs.
+     *
+     * \return True if any rebuilds are still in progress.
+     */
+    bool ShaderReloader::update()
+    {
+        for (QSet<QString>::const_iterator fileIter = m_changedFiles.begin(); fileIter != m_changedFiles.end(); ++fileIter)
+        {
+            ShaderMap::const_iterator shaderIter = m_shaders.find(*fileIter);
+            if (shaderIter == m_shaders.end())
+            {
+                continue;
+            }
+
+            for (QSet<Shader*>::const_iterator iter = shaderIter->begin(); iter != shaderIter->end(); ++iter)
+            {
+                if ((*iter)->reload(*fileIter))
+                {
+                    m_reloading.insert(*iter);
+                }
+            }
+        }
+        m_changedFiles.clear();
+
+        QSet<Shader*> stillReloading;
+        for (QSet<Shader*>::const_iterator iter = m_reloading.begin(); iter != m_reloading.end(); ++iter)
+        {
+            if ((*iter)->swapReloadedPrograms())
+            {
+                stillReloading.insert(*iter);
+            }
+        }
+        m_reloading = stillReloading;
+
+        return !m_reloading.isEmpty();
+    }
+
+
+    /**
+     * \internal Records the change until the next update().
+     */
+    void ShaderReloader::fileChanged(const QString& path)
+    {
+        // Many editors save by replacing the file, which removes it from the watcher.
+        if (QFile::exists(path) && !m_watcher.files().contains(path))
+        {
+            m_watcher.addPath(path);
+        }
+
+        m_changedFiles.insert(path);
+        emit sourcesChanged();
+    }
+
+}
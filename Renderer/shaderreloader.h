@@ -0,0 +1,69 @@
+#ifndef GLDEMO_SHADERRELOADER_H
+#define GLDEMO_SHADERRELOADER_H
+
+#include <QFileSystemWatcher>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QString>
+
+namespace GLDemo
+{
+    class Shader;
+
+    /**
+     * \brief Reloads shaders from disk when their source files change.
+     *
+     * Disabled by default, in which case shaders are read from the compiled-in resources.
+     * Once a source directory is set, shader sources under ":/shaders/" are read from that
+     * directory instead, and the files are watched for changes. Changes are only acted on
+     * when the renderer calls update() at the start of a frame: the affected shaders start
+     * rebuilding their programs in the background, and keep drawing with the old ones until
+     * the new ones have linked. A program that fails to build is reported and ignored, so
+     * a typo in a shader never takes down a running scene.
+     */
+    class ShaderReloader : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        static ShaderReloader& instance();
+
+        void setSourceDirectory(const QString& directory);
+        const QString& getSourceDirectory() const { return m_sourceDirectory; }
+        bool isEnabled() const                    { return !m_sourceDirectory.isEmpty(); }
+
+        QString resolveFileName(const QString& fileName) const;
+
+        void watch(Shader& shader, const QString& fileName);
+        void forget(Shader& shader);
+
+        bool update();
+
+    signals:
+        /**
+         * Emitted when a watched file changes, so that views can draw a new frame.
+         */
+        void sourcesChanged();
+
+    private slots:
+        void fileChanged(const QString& path);
+
+    private:
+        typedef QMap<QString, QSet<Shader*> > ShaderMap;
+
+        ShaderReloader();
+
+        QString             m_sourceDirectory;
+        QFileSystemWatcher  m_watcher;
+        ShaderMap           m_shaders;          // Shaders using each watched file, by path on disk
+        QSet<QString>       m_changedFiles;
+        QSet<Shader*>       m_reloading;
+
+        ShaderReloader(const ShaderReloader&);
+        ShaderReloader& operator=(const ShaderReloader&);
+    };
+
+}
+
+#endif
@@ -0,0 +1,213 @@
+#include <cmath>
+#include <vector>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Math/mathdefs.h"
+#include "Scene/animator.h"
+#include "Scene/scene.h"
+#include "Scene/scenenode.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestAnimator : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        /**
+         * A one second track moving from the origin to (10, 0, 0), turning a quarter turn
+         * about z and doubling in size.
+         */
+        std::vector<Keyframe> createKeys()
+        {
+            Quaternionf turned;
+            turned.fromAxisAngle(Math<float>::PI / 2, Vector3f(0.0f, 0.0f, 1.0f));
+
+            std::vector<Keyframe> keys;
+            keys.push_back(Keyframe(0.0f, Vector3f(0.0f, 0.0f, 0.0f), Quaternionf(), Vector3f(1.0f, 1.0f, 1.0f)));
+            keys.push_back(Keyframe(0.5f, Vector3f(4.0f, 0.0f, 0.0f), Quaternionf(), Vector3f(1.0f, 1.0f, 1.0f)));
+            keys.push_back(Keyframe(1.0f, Vector3f(10.0f, 0.0f, 0.0f), turned, Vector3f(2.0f, 2.0f, 2.0f)));
+            return keys;
+        }
+
+
+        bool isTranslation(const SpatialEntity& entity, float x)
+        {
+            const Vector3f t = entity.getLocalTransformation().getTranslation();
+            return Math<float>::FEqual(t.x(), x) && Math<float>::FEqual(t.y(), 0.0f) && Math<float>::FEqual(t.z(), 0.0f);
+        }
+
+    private slots:
+        /**
+         * Keys are hit exactly, and values between them blended.
+         */
+        void testInterpolation()
+        {
+            Animator animator;
+            int track = animator.addTrack(createKeys());
+            QCOMPARE(track, 0);
+            QVERIFY(Math<float>::FEqual(animator.getDuration(track), 1.0f));
+
+            SceneNode node("Animated");
+            QVERIFY(animator.play(node, track, 10.0, false));
+            QVERIFY(animator.isPlaying(node));
+
+            animator.update(10.0);
+            QVERIFY(isTranslation(node, 0.0f));
+            animator.update(10.25);
+            QVERIFY(isTranslation(node, 2.0f));
+            animator.update(10.5);
+            QVERIFY(isTranslation(node, 4.0f));
+            animator.update(10.75);
+            QVERIFY(isTranslation(node, 7.0f));
+            QVERIFY(Math<float>::FEqual(node.getLocalTransformation().getUniformScale(), 1.5f));
+
+            animator.update(11.0);
+            QVERIFY(isTranslation(node, 10.0f));
+            Vector3f x = node.getLocalTransformation().getRotationQuaternion().rotate(Vector3f(1.0f, 0.0f, 0.0f));
+            QVERIFY(std::fabs(x.x()) < 1e-5f);
+            QVERIFY(std::fabs(x.y() - 1.0f) < 1e-5f);
+
+            // Going back in time finds the earlier keys again.
+            animator.update(10.25);
+            QVERIFY(isTranslation(node, 2.0f));
+        }
+
+
+        /**
+         * Tracks hold their ends, unless they loop.
+         */
+        void testLooping()
+        {
+            Animator animator;
+            int track = animator.addTrack(createKeys());
+            SceneNode held("Held");
+            SceneNode looped("Looped");
+            animator.play(held, track, 0.0, false);
+            animator.play(looped, track, 0.0, true);
+
+            animator.update(-1.0);
+            QVERIFY(isTranslation(held, 0.0f));
+            animator.update(3.25);
+            QVERIFY(isTranslation(held, 10.0f));
+            QVERIFY(isTranslation(looped, 2.0f));
+        }
+
+
+        /**
+         * Stopping an entity leaves the others playing, and playing again replaces the
+         * track.
+         */
+        void testStop()
+        {
+            Animator animator;
+            int track = animator.addTrack(createKeys());
+            SceneNode a("A");
+            SceneNode b("B");
+            SceneNode c("C");
+            animator.play(a, track, 0.0, false);
+            animator.play(b, track, 0.0, false);
+            animator.play(c, track, 0.5, false);
+            QCOMPARE(animator.getNumChannels(), 3);
+
+            animator.stop(a);
+            animator.stop(a);
+            QCOMPARE(animator.getNumChannels(), 2);
+            QVERIFY(!animator.isPlaying(a));
+
+            animator.play(b, track, 0.5, false);
+            QCOMPARE(animator.getNumChannels(), 2);
+            animator.update(0.75);
+            QVERIFY(isTranslation(a, 0.0f));
+            QVERIFY(isTranslation(b, 2.0f));
+            QVERIFY(isTranslation(c, 2.0f));
+        }
+
+
+        /**
+         * Tracks without keys, or with keys out of order, are refused.
+         */
+        void testInvalidTracks()
+        {
+            Animator animator;
+            QCOMPARE(animator.addTrack(std::vector<Keyframe>()), -1);
+
+            std::vector<Keyframe> keys = createKeys();
+            std::swap(keys[0], keys[2]);
+            QCOMPARE(animator.addTrack(keys), -1);
+
+            SceneNode node;
+            QVERIFY(!animator.play(node, 0, 0.0, false));
+            QCOMPARE(animator.getNumTracks(), 0);
+        }
+
+
+        /**
+         * Splitting the channels between threads gives the same result, and the scene's
+         * update carries the animation into world space.
+         */
+        void testThreadedScene()
+        {
+            Scene scene;
+            Animator& animator = scene.getAnimator();
+            int track = animator.addTrack(createKeys());
+
+            const int count = 5000;
+            std::vector<SceneNode*> nodes;
+            for (int i = 0; i < count; ++i)
+            {
+                nodes.push_back(new SceneNode(QString("Node %1").arg(i)));
+                scene.getRootNode().addChild(*nodes.back());
+                animator.play(*nodes.back(), track, -0.00004 * i, false);
+            }
+
+            animator.setThreaded(true);
+            scene.update(0.25);
+            for (int i = 0; i < count; ++i)
+            {
+                const float expected = 2.0f + 8.0f * 0.00004f * i;
+                QVERIFY(std::fabs(nodes[i]->getWorldTransformation().getTranslation().x() - expected) < 1e-3f);
+            }
+
+            for (int i = 0; i < count; ++i)
+            {
+                animator.stop(*nodes[i]);
+            }
+            QCOMPARE(animator.getNumChannels(), 0);
+        }
+
+
+        /**
+         *
+         */
+        void benchmarkUpdate()
+        {
+            Animator animator;
+            int track = animator.addTrack(createKeys());
+            std::vector<SceneNode> nodes(10000);
+            for (int i = 0; i < int(nodes.size()); ++i)
+            {
+                animator.play(nodes[i], track, 0.0001 * i, true);
+            }
+
+            double time = 0.0;
+            QBENCHMARK
+            {
+                time += 1.0 / 60.0;
+                animator.update(time);
+            }
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestAnimator)
+#include "test_animator.moc"
@@ -0,0 +1,107 @@
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Math/mathdefs.h"
+#include "Math/matrix3.h"
+#include "Scene/boundingbox.h"
+#include "Scene/transformation.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestBoundingBox : public QObject
+    {
+        Q_OBJECT
+
+    private slots:
+        /**
+         *
+         */
+        void testDefaultConstructor()
+        {
+            BoundingBox box;
+            QVERIFY(box.isEmpty());
+            QVERIFY(!box.contains(Vector3f()));
+        }
+
+
+        /**
+         *
+         */
+        void testExtend()
+        {
+            BoundingBox box;
+            box.extend(Vector3f(1.0f, 2.0f, 3.0f));
+            QVERIFY(!box.isEmpty());
+            QVERIFY(box.getMinimum() == Vector3f(1.0f, 2.0f, 3.0f));
+            QVERIFY(box.getMaximum() == Vector3f(1.0f, 2.0f, 3.0f));
+
+            box.extend(Vector3f(-1.0f, 4.0f, 0.0f));
+            QVERIFY(box.getMinimum() == Vector3f(-1.0f, 2.0f, 0.0f));
+            QVERIFY(box.getMaximum() == Vector3f(1.0f, 4.0f, 3.0f));
+            QVERIFY(box.getCenter() == Vector3f(0.0f, 3.0f, 1.5f));
+            QVERIFY(box.getExtents() == Vector3f(1.0f, 1.0f, 1.5f));
+            QCOMPARE(box.getSurfaceArea(), 2.0f * (2.0f * 2.0f + 2.0f * 3.0f + 3.0f * 2.0f));
+            QCOMPARE(BoundingBox().getSurfaceArea(), 0.0f);
+
+            // Empty boxes contribute nothing.
+            BoundingBox before(box);
+            box.extend(BoundingBox());
+            QVERIFY(box.getMinimum() == before.getMinimum());
+            QVERIFY(box.getMaximum() == before.getMaximum());
+        }
+
+
+        /**
+         *
+         */
+        void testIntersects()
+        {
+            BoundingBox a(Vector3f(0.0f, 0.0f, 0.0f), Vector3f(1.0f, 1.0f, 1.0f));
+            BoundingBox b(Vector3f(1.0f, 0.5f, 0.5f), Vector3f(2.0f, 2.0f, 2.0f));
+            BoundingBox c(Vector3f(1.5f, 0.0f, 0.0f), Vector3f(2.0f, 1.0f, 1.0f));
+            QVERIFY(a.intersects(b));
+            QVERIFY(!a.intersects(c));
+            QVERIFY(!a.intersects(BoundingBox()));
+            QVERIFY(a.contains(Vector3f(0.5f, 1.0f, 0.0f)));
+            QVERIFY(!a.contains(Vector3f(0.5f, 1.5f, 0.0f)));
+        }
+
+
+        /**
+         *
+         */
+        void testTransformed()
+        {
+            BoundingBox box(Vector3f(-1.0f, -1.0f, -1.0f), Vector3f(1.0f, 1.0f, 1.0f));
+
+            Transformation t;
+            t.setTranslation(Vector3f(5.0f, 0.0f, 0.0f));
+            t.setScale(Vector3f(2.0f, 1.0f, 1.0f));
+            BoundingBox moved = box.transformed(t);
+            QVERIFY(moved.getMinimum() == Vector3f(3.0f, -1.0f, -1.0f));
+            QVERIFY(moved.getMaximum() == Vector3f(7.0f, 1.0f, 1.0f));
+
+            // A rotated box is enclosed by a larger axis-aligned one.
+            Transformation r;
+            Matrix3f rotation;
+            rotation.fromAxisAngle(Math<float>::PI / 4, Vector3f(0.0f, 0.0f, 1.0f));
+            r.setRotation(rotation);
+            BoundingBox rotated = box.transformed(r);
+            float s = Math<float>::Sqrt(2.0f);
+            QVERIFY(rotated.getMinimum() == Vector3f(-s, -s, -1.0f));
+            QVERIFY(rotated.getMaximum() == Vector3f(s, s, 1.0f));
+
+            QVERIFY(BoundingBox().transformed(t).isEmpty());
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestBoundingBox)
+#include "test_boundingbox.moc"
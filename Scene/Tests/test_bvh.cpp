@@ -0,0 +1,281 @@
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Math/mathdefs.h"
+#include "Scene/camera.h"
+#include "Scene/cubemesh.h"
+#include "Scene/mesh.h"
+#include "Scene/meshbvh.h"
+#include "Scene/meshinstance.h"
+#include "Scene/scene.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal A rippled square grid of triangles in the xy plane, drawn as strips.
+     */
+    class RippleMesh : public Mesh
+    {
+    public:
+        RippleMesh(int cells) :
+            Mesh("Ripple")
+        {
+            for (int j = 0; j <= cells; ++j)
+            {
+                for (int i = 0; i <= cells; ++i)
+                {
+                    float x = float(i) / cells;
+                    float y = float(j) / cells;
+                    float z = 0.1f * std::sin(6.0f * x) * std::cos(5.0f * y);
+                    m_vertices.push_back(Vertex(x, y, z, 0.0f, 0.0f, 1.0f, x, y));
+                }
+            }
+
+            std::vector<unsigned>& indices = addElementList(ElementList::TRI_STRIP).getIndices();
+            for (int j = 0; j < cells; ++j)
+            {
+                for (int i = 0; i <= cells; ++i)
+                {
+                    indices.push_back((j + 1) * (cells + 1) + i);
+                    indices.push_back(j * (cells + 1) + i);
+                }
+                indices.push_back(static_cast<unsigned>(ElementList::RESTART_INDEX));
+            }
+            updateBound();
+        }
+
+        virtual RippleMesh* clone() const { return new RippleMesh(*this); }
+    };
+
+
+    /**
+     * \internal
+     */
+    class TestBvh : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        static float random(float minimum, float maximum)
+        {
+            return minimum + (maximum - minimum) * std::rand() / RAND_MAX;
+        }
+
+
+        /**
+         * Distance along a ray to a triangle, or infinity if it misses.
+         */
+        static float intersectTriangle(const Ray& ray, const Vector3f& p0, const Vector3f& p1, const Vector3f& p2)
+        {
+            // Find where the ray meets the plane of the triangle, then check that point is
+            // on the inner side of each edge.
+            Vector3f normal = (p1 - p0).cross(p2 - p0);
+            float denominator = normal.dot(ray.m_direction);
+            if (denominator == 0.0f)
+            {
+                return std::numeric_limits<float>::infinity();
+            }
+
+            float t = normal.dot(p0 - ray.m_origin) / denominator;
+            Vector3f p = ray.getPoint(t);
+            if (t < 0.0f || normal.dot((p1 - p0).cross(p - p0)) < 0.0f ||
+                normal.dot((p2 - p1).cross(p - p1)) < 0.0f || normal.dot((p0 - p2).cross(p - p2)) < 0.0f)
+            {
+                return std::numeric_limits<float>::infinity();
+            }
+            return t;
+        }
+
+
+        static MeshInstance* addCube(SceneNode& root, const PtrMesh& mesh, const Vector3f& position, float scale)
+        {
+            PtrMesh instanceMesh(mesh);
+            MeshInstance* instance = new MeshInstance("Cube", instanceMesh);
+            instance->getLocalTransformation().setTranslation(position);
+            instance->getLocalTransformation().setUniformScale(scale);
+            root.addChild(*instance);
+            return instance;
+        }
+
+    private slots:
+        /**
+         * Every ray finds the same nearest triangle as testing them all would.
+         */
+        void testMeshBvh()
+        {
+            RippleMesh mesh(16);
+            const MeshBvh& bvh = mesh.getBvh();
+            QCOMPARE(bvh.getNumTriangles(), 16 * 16 * 2);
+            QCOMPARE(&mesh.getBvh(), &bvh);
+
+            const std::vector<Vertex>& vertices = mesh.getVertices();
+            std::srand(1);
+            int hits = 0;
+            for (int r = 0; r < 500; ++r)
+            {
+                Ray ray(Vector3f(random(-0.2f, 1.2f), random(-0.2f, 1.2f), 1.0f),
+                        Vector3f(random(-0.5f, 0.5f), random(-0.5f, 0.5f), -1.0f));
+
+                float expected = std::numeric_limits<float>::infinity();
+                for (int t = 0; t < bvh.getNumTriangles(); ++t)
+                {
+                    const unsigned* corners = bvh.getTriangle(t);
+                    expected = std::min(expected, intersectTriangle(ray, vertices[corners[0]].m_position,
+                                                                    vertices[corners[1]].m_position,
+                                                                    vertices[corners[2]].m_position));
+                }
+
+                float distance = std::numeric_limits<float>::max();
+                int triangle = -1;
+                bool hit = bvh.intersect(ray, distance, triangle);
+                QCOMPARE(hit, expected < std::numeric_limits<float>::infinity());
+                if (hit)
+                {
+                    QVERIFY(std::fabs(distance - expected) < 1.0e-4f);
+                    QVERIFY(triangle >= 0 && triangle < bvh.getNumTriangles());
+                    ++hits;
+                }
+            }
+            QVERIFY(hits > 100);
+
+            // Nothing beyond the distance given is hit.
+            float distance = 0.5f;
+            int triangle = -1;
+            QVERIFY(!bvh.intersect(Ray(Vector3f(0.5f, 0.5f, 1.0f), Vector3f(0.0f, 0.0f, -1.0f)), distance, triangle));
+        }
+
+
+        /**
+         * The hierarchy follows changes to the mesh, and is shared by copies.
+         */
+        void testMeshBvhShared()
+        {
+            RippleMesh mesh(4);
+            const MeshBvh* bvh = &mesh.getBvh();
+            RippleMesh copy(mesh);
+            QCOMPARE(&copy.getBvh(), bvh);
+
+            mesh.getElementLists().clear();
+            mesh.updateBound();
+            QCOMPARE(mesh.getBvh().getNumTriangles(), 0);
+            QCOMPARE(copy.getBvh().getNumTriangles(), 4 * 4 * 2);
+        }
+
+
+        /**
+         *
+         */
+        void testScenePick()
+        {
+            Scene scene;
+            PtrMesh cube(new CubeMesh("Cube"));
+            MeshInstance* nearCube = addCube(scene.getRootNode(), cube, Vector3f(0.0f, 0.0f, 0.0f), 1.0f);
+            MeshInstance* farCube = addCube(scene.getRootNode(), cube, Vector3f(0.0f, 0.0f, -5.0f), 2.0f);
+            MeshInstance* sideCube = addCube(scene.getRootNode(), cube, Vector3f(4.0f, 0.0f, 0.0f), 1.0f);
+            Matrix3f rotation;
+            rotation.fromAxisAngle(0.25f * Math<float>::PI, Vector3f(0.0f, 1.0f, 0.0f));
+            sideCube->getLocalTransformation().setRotation(rotation);
+            scene.getRootNode().updateGeometricState(0.0, true);
+            scene.buildBvh();
+            QCOMPARE(scene.getBvh().getNumInstances(), 3);
+
+            PickResult result;
+            QVERIFY(scene.pick(Ray(Vector3f(0.0f, 0.0f, 10.0f), Vector3f(0.0f, 0.0f, -1.0f)), result));
+            QCOMPARE(result.m_instance, static_cast<const MeshInstance*>(nearCube));
+            QVERIFY(std::fabs(result.m_distance - 9.0f) < 1.0e-4f);
+            QVERIFY((result.m_point - Vector3f(0.0f, 0.0f, 1.0f)).length() < 1.0e-4f);
+            QVERIFY(result.m_triangle >= 0 && result.m_triangle < 12);
+
+            // Passes above the near cube, but not the larger one behind it.
+            QVERIFY(scene.pick(Ray(Vector3f(0.0f, 1.5f, 10.0f), Vector3f(0.0f, 0.0f, -1.0f)), result));
+            QCOMPARE(result.m_instance, static_cast<const MeshInstance*>(farCube));
+            QVERIFY((result.m_point - Vector3f(0.0f, 1.5f, -3.0f)).length() < 1.0e-4f);
+
+            // Hits the edge of the rotated cube, which sticks out towards the ray.
+            QVERIFY(scene.pick(Ray(Vector3f(4.0f, 0.0f, 10.0f), Vector3f(0.0f, 0.0f, -2.0f)), result));
+            QCOMPARE(result.m_instance, static_cast<const MeshInstance*>(sideCube));
+            QVERIFY(std::fabs(result.m_point.z() - std::sqrt(2.0f)) < 1.0e-4f);
+            QVERIFY(std::fabs(result.m_distance - 0.5f * (10.0f - std::sqrt(2.0f))) < 1.0e-4f);
+
+            QVERIFY(!scene.pick(Ray(Vector3f(0.0f, 5.0f, 10.0f), Vector3f(0.0f, 0.0f, -1.0f)), result));
+            QVERIFY(!scene.pick(Ray(Vector3f(0.0f, 0.0f, 10.0f), Vector3f(0.0f, 0.0f, 1.0f)), result));
+
+            // A ray through the middle of the default camera's view picks the cube it looks at.
+            Camera camera;
+            Ray ray = camera.getRay(0.0f, 0.0f, 1.5f);
+            QVERIFY((ray.m_direction - Vector3f(0.0f, 0.0f, -1.0f)).length() < 1.0e-5f);
+            QVERIFY(scene.pick(ray, result));
+            QCOMPARE(result.m_instance, static_cast<const MeshInstance*>(nearCube));
+        }
+
+
+
+        /**
+         * Instances that move, or are deleted, are still found where they now are.
+         */
+        void testSceneBvhUpdate()
+        {
+            const int side = 16;
+            Scene scene;
+            PtrMesh cube(new CubeMesh("Cube"));
+            std::vector<MeshInstance*> instances;
+            std::vector<Vector3f> positions;
+            for (int i = 0; i < side * side; ++i)
+            {
+                positions.push_back(Vector3f(3.0f * (i % side), 3.0f * (i / side), 0.0f));
+                instances.push_back(addCube(scene.getRootNode(), cube, positions.back(), 0.5f));
+            }
+            scene.getRootNode().updateGeometricState(0.0, true);
+            scene.buildBvh();
+            QCOMPARE(scene.getBvh().getNumInstances(), side * side);
+
+            // Instances were inserted in order along each row, which must not leave the
+            // tree badly unbalanced.
+            QVERIFY(scene.getBvh().getHeight() <= 24);
+
+            std::srand(2);
+            for (int step = 0; step < 50; ++step)
+            {
+                // Swap the places of a few instances at a time.
+                for (int k = 0; k < 5; ++k)
+                {
+                    int a = std::rand() % instances.size();
+                    int b = std::rand() % instances.size();
+                    std::swap(instances[a], instances[b]);
+                    instances[a]->getLocalTransformation().setTranslation(positions[a]);
+                    instances[b]->getLocalTransformation().setTranslation(positions[b]);
+                    instances[a]->updateGeometricState(0.0, true);
+                    instances[b]->updateGeometricState(0.0, true);
+                }
+                scene.updateBvh();
+
+                for (size_t i = 0; i < instances.size(); i += 7)
+                {
+                    PickResult result;
+                    QVERIFY(scene.pick(Ray(positions[i] + Vector3f(0.0f, 0.0f, 10.0f), Vector3f(0.0f, 0.0f, -1.0f)), result));
+                    QCOMPARE(result.m_instance, static_cast<const MeshInstance*>(instances[i]));
+                }
+            }
+            QVERIFY(scene.getBvh().getHeight() <= 24);
+            QVERIFY(scene.getBvh().getCost() > 0.0f);
+
+            // Deleted instances take themselves out of the tree.
+            delete &scene.getRootNode().detachChild(*instances[0]);
+            QCOMPARE(scene.getBvh().getNumInstances(), side * side - 1);
+            PickResult result;
+            QVERIFY(!scene.pick(Ray(positions[0] + Vector3f(0.0f, 0.0f, 10.0f), Vector3f(0.0f, 0.0f, -1.0f)), result));
+            QVERIFY(scene.pick(Ray(positions[1] + Vector3f(0.0f, 0.0f, 10.0f), Vector3f(0.0f, 0.0f, -1.0f)), result));
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestBvh)
+#include "test_bvh.moc"
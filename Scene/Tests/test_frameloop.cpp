@@ -0,0 +1,237 @@
+#include <cmath>
+#include <vector>
+
+#include <QSemaphore>
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Scene/animator.h"
+#include "Scene/controller.h"
+#include "Scene/frameloop.h"
+#include "Scene/scene.h"
+#include "Scene/scenenode.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestFrameLoop : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        /**
+         * A track moving from the origin to (10, 0, 0) over one second.
+         */
+        int addTrack(Animator& animator)
+        {
+            std::vector<Keyframe> keys;
+            keys.push_back(Keyframe(0.0f, Vector3f(0.0f, 0.0f, 0.0f), Quaternionf(), Vector3f(1.0f, 1.0f, 1.0f)));
+            keys.push_back(Keyframe(1.0f, Vector3f(10.0f, 0.0f, 0.0f), Quaternionf(), Vector3f(1.0f, 1.0f, 1.0f)));
+            return animator.addTrack(keys);
+        }
+
+
+        bool isAt(const SpatialEntity& entity, float x)
+        {
+            return std::fabs(entity.getWorldTransformation().getTranslation().x() - x) < 1e-4f;
+        }
+
+        /**
+         * Records the times it is updated at.
+         */
+        class RecordingController : public Controller
+        {
+        public:
+            virtual void update(double time) { m_times.push_back(time); }
+
+            std::vector<double> m_times;
+        };
+
+
+        /**
+         * Holds up every tick after the first until it is let go.
+         */
+        class BlockingController : public Controller
+        {
+        public:
+            virtual void update(double time)
+            {
+                if (time > 0.0)
+                {
+                    m_gate.acquire();
+                }
+            }
+
+            QSemaphore m_gate;
+        };
+
+    private slots:
+        /**
+         * Frames show the scene one step behind, blended between the ticks either side.
+         * Only the first frame, with nothing simulated yet, waits for a tick.
+         */
+        void testInterpolation()
+        {
+            Scene scene;
+            SceneNode* node = new SceneNode("Node");
+            scene.getRootNode().addChild(*node);
+            scene.getAnimator().play(*node, addTrack(scene.getAnimator()), 0.0, false);
+
+            FrameLoop loop(scene);
+            loop.setTimeStep(0.125);
+            for (int frame = 0; frame <= 24; ++frame)
+            {
+                const double time = frame * 0.0625;
+                loop.wait();
+                loop.advance(time);
+                QVERIFY(isAt(*node, std::min(1.0, std::max(0.0, time - 0.125)) * 10.0f));
+                if (frame == 9)
+                {
+                    QCOMPARE(loop.getShownTime(), 0.4375);
+                    QVERIFY(std::fabs(loop.getBlend() - 0.5f) < 1e-6f);
+                }
+            }
+            QCOMPARE(loop.getNumLateTicks(), 1);
+
+            loop.wait();
+            scene.getAnimator().stop(*node);
+        }
+
+
+        /**
+         * Controllers run once a tick, at the time of the tick.
+         */
+        void testControllersOnTicks()
+        {
+            Scene scene;
+            SceneNode* node = new SceneNode("Node");
+            scene.getRootNode().addChild(*node);
+            RecordingController* recorder = new RecordingController;
+            PtrController controller(recorder);
+            node->addController(controller);
+
+            FrameLoop loop(scene);
+            loop.setTimeStep(0.125);
+            for (int frame = 0; frame <= 10; ++frame)
+            {
+                loop.advance(frame * 0.1);
+            }
+            loop.wait();
+
+            QVERIFY(!recorder->m_times.empty());
+            for (size_t i = 0; i < recorder->m_times.size(); ++i)
+            {
+                const double tick = recorder->m_times[i] / 0.125;
+                QVERIFY(std::fabs(tick - std::floor(tick + 0.5)) < 1e-9);
+                QVERIFY(i == 0 || recorder->m_times[i] > recorder->m_times[i - 1]);
+            }
+            node->removeController(controller);
+        }
+
+
+        /**
+         * Frames go on showing the ticks they have while the worker is held up.
+         */
+        void testFramesDontWait()
+        {
+            Scene scene;
+            SceneNode* node = new SceneNode("Node");
+            scene.getRootNode().addChild(*node);
+            BlockingController* blocker = new BlockingController;
+            PtrController controller(blocker);
+            node->addController(controller);
+
+            FrameLoop loop(scene);
+            loop.setTimeStep(0.125);
+            loop.advance(0.0);
+            loop.advance(0.0625);
+            for (int frame = 2; frame <= 8; ++frame)
+            {
+                loop.advance(frame * 0.0625);
+                QCOMPARE(loop.getShownTime(), 0.0);
+            }
+            QCOMPARE(loop.getNumLateTicks(), 1);
+
+            blocker->m_gate.release(1000);
+            loop.wait();
+            node->removeController(controller);
+        }
+
+
+        /**
+         * Entities added or removed between frames are picked up by the next one, which
+         * ignores the ticks simulated before the change.
+         */
+        void testStructureChange()
+        {
+            Scene scene;
+            Animator& animator = scene.getAnimator();
+            const int track = addTrack(animator);
+            SceneNode* first = new SceneNode("First");
+            scene.getRootNode().addChild(*first);
+            animator.play(*first, track, 0.0, false);
+
+            FrameLoop loop(scene);
+            loop.setTimeStep(0.125);
+            for (int frame = 0; frame <= 4; ++frame)
+            {
+                loop.wait();
+                loop.advance(frame * 0.0625);
+            }
+
+            // The frame shows the time it would have, rather than the ticks after those
+            // simulated before the change.
+            loop.wait();
+            SceneNode* second = new SceneNode("Second");
+            first->addChild(*second);
+            second->getLocalTransformation().setTranslation(Vector3f(0.0f, 1.0f, 0.0f));
+            loop.advance(0.3125);
+            QCOMPARE(loop.getNumLateTicks(), 3);
+            QCOMPARE(loop.getShownTime(), 0.1875);
+            QVERIFY(isAt(*second, 1.875f));
+            QVERIFY(std::fabs(second->getWorldTransformation().getTranslation().y() - 1.0f) < 1e-4f);
+
+            loop.wait();
+            animator.stop(*first);
+            delete &scene.getRootNode().detachChild(*first);
+            loop.advance(0.375);
+            QCOMPARE(loop.getNumLateTicks(), 4);
+            QCOMPARE(loop.getShownTime(), 0.25);
+            loop.wait();
+        }
+
+
+        /**
+         * Changes made after invalidate() show up in the very next frame.
+         */
+        void testInvalidate()
+        {
+            Scene scene;
+            SceneNode* node = new SceneNode("Node");
+            scene.getRootNode().addChild(*node);
+
+            FrameLoop loop(scene);
+            loop.setTimeStep(0.125);
+            for (int frame = 0; frame <= 4; ++frame)
+            {
+                loop.advance(frame * 0.0625);
+            }
+
+            loop.invalidate();
+            node->getLocalTransformation().setTranslation(Vector3f(5.0f, 0.0f, 0.0f));
+            loop.advance(0.3125);
+            QCOMPARE(loop.getShownTime(), 0.1875);
+            QVERIFY(isAt(*node, 5.0f));
+            loop.wait();
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestFrameLoop)
+#include "test_frameloop.moc"
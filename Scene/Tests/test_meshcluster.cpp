@@ -0,0 +1,140 @@
+#include <algorithm>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Scene/cubemesh.h"
+#include "Scene/mesh.h"
+#include "Scene/meshcluster.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal A flat square grid of triangles in the xy plane, facing +z, drawn as strips.
+     */
+    class StripGridMesh : public Mesh
+    {
+    public:
+        StripGridMesh(int cells) :
+            Mesh("Grid")
+        {
+            for (int j = 0; j <= cells; ++j)
+            {
+                for (int i = 0; i <= cells; ++i)
+                {
+                    m_vertices.push_back(Vertex(float(i), float(j), 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f));
+                }
+            }
+
+            std::vector<unsigned>& indices = addElementList(ElementList::TRI_STRIP).getIndices();
+            for (int j = 0; j < cells; ++j)
+            {
+                for (int i = 0; i <= cells; ++i)
+                {
+                    indices.push_back((j + 1) * (cells + 1) + i);
+                    indices.push_back(j * (cells + 1) + i);
+                }
+                indices.push_back(static_cast<unsigned>(ElementList::RESTART_INDEX));
+            }
+            updateBound();
+        }
+
+        virtual StripGridMesh* clone() const { return new StripGridMesh(*this); }
+    };
+
+
+    /**
+     * \internal
+     */
+    class TestMeshCluster : public QObject
+    {
+        Q_OBJECT
+
+    private slots:
+        /**
+         *
+         */
+        void testPartition()
+        {
+            StripGridMesh grid(20);
+            MeshCluster::buildClusters(grid, 64);
+
+            QCOMPARE(static_cast<int>(grid.getElementLists().size()), 1);
+            const ElementList& elements = grid.getElementLists().front();
+            QCOMPARE(elements.getElementType(), ElementList::TRI_LIST);
+            QCOMPARE(static_cast<int>(elements.getIndices().size()), 20 * 20 * 2 * 3);
+
+            // Clusters follow on from each other, and together cover the whole list.
+            const MeshClusterList& clusters = elements.getClusters();
+            QVERIFY(clusters.size() >= 800 / 64);
+            unsigned next = 0;
+            for (MeshClusterList::const_iterator iter = clusters.begin(); iter != clusters.end(); ++iter)
+            {
+                QCOMPARE(iter->getFirstIndex(), next);
+                QVERIFY(iter->getNumIndices() > 0 && iter->getNumIndices() <= 64 * 3);
+                QVERIFY(iter->getConeAngle() < 1.0e-3f);
+                next += iter->getNumIndices();
+
+                for (unsigned i = iter->getFirstIndex(); i < next; ++i)
+                {
+                    QVERIFY(iter->getBound().contains(grid.getVertices()[elements.getIndices()[i]].m_position));
+                }
+            }
+            QCOMPARE(next, static_cast<unsigned>(elements.getIndices().size()));
+
+            // Triangles keep their winding, so still face +z.
+            const std::vector<unsigned>& indices = elements.getIndices();
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                const Vector3f& p0 = grid.getVertices()[indices[i]].m_position;
+                Vector3f normal = (grid.getVertices()[indices[i + 1]].m_position - p0).cross(grid.getVertices()[indices[i + 2]].m_position - p0);
+                QVERIFY(normal.z() > 0.0f);
+            }
+        }
+
+
+        /**
+         *
+         */
+        void testBackFacing()
+        {
+            CubeMesh cube("Cube");
+            MeshCluster::buildClusters(cube, 2);
+
+            // Each face of the cube ends up in a cluster of its own.
+            const MeshClusterList& clusters = cube.getElementLists().front().getClusters();
+            QCOMPARE(static_cast<int>(clusters.size()), 6);
+
+            int backFacing = 0;
+            for (MeshClusterList::const_iterator iter = clusters.begin(); iter != clusters.end(); ++iter)
+            {
+                QVERIFY(!iter->isBackFacing(Vector3f(0.0f, 0.0f, 0.0f)));
+                if (iter->isBackFacing(Vector3f(0.0f, 0.0f, 5.0f)))
+                {
+                    QVERIFY(iter->getConeAxis() == Vector3f(0.0f, 0.0f, -1.0f));
+                    ++backFacing;
+                }
+            }
+            QCOMPARE(backFacing, 1);
+        }
+
+
+        /**
+         * Clusters are kept by copies of the mesh.
+         */
+        void testCopy()
+        {
+            StripGridMesh grid(4);
+            MeshCluster::buildClusters(grid, 8);
+            StripGridMesh copy(grid);
+            QCOMPARE(copy.getElementLists().front().getClusters().size(), grid.getElementLists().front().getClusters().size());
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestMeshCluster)
+#include "test_meshcluster.moc"
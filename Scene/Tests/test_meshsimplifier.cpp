@@ -0,0 +1,155 @@
+#include <cmath>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Scene/cubemesh.h"
+#include "Scene/mesh.h"
+#include "Scene/meshsimplifier.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal A square grid of triangles in the xy plane, optionally with ripples in z.
+     */
+    class GridMesh : public Mesh
+    {
+    public:
+        GridMesh(int cells, float ripple) :
+            Mesh("Grid")
+        {
+            for (int j = 0; j <= cells; ++j)
+            {
+                for (int i = 0; i <= cells; ++i)
+                {
+                    float x = float(i) / cells;
+                    float y = float(j) / cells;
+                    float z = ripple * std::sin(6.0f * x) * std::cos(5.0f * y);
+                    m_vertices.push_back(Vertex(x, y, z, 0.0f, 0.0f, 1.0f, x, y));
+                }
+            }
+
+            std::vector<unsigned>& indices = addElementList(ElementList::TRI_LIST).getIndices();
+            for (int j = 0; j < cells; ++j)
+            {
+                for (int i = 0; i < cells; ++i)
+                {
+                    unsigned a = j * (cells + 1) + i;
+                    unsigned c = a + cells + 1;
+                    unsigned quad[6] = { a, a + 1, c + 1, a, c + 1, c };
+                    indices.insert(indices.end(), quad, quad + 6);
+                }
+            }
+            updateBound();
+        }
+
+        virtual GridMesh* clone() const { return new GridMesh(*this); }
+    };
+
+
+    /**
+     * \internal
+     */
+    class TestMeshSimplifier : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        static int countTriangles(const Mesh& mesh)
+        {
+            int count = 0;
+            const std::list<ElementList>& lists = mesh.getElementLists();
+            for (std::list<ElementList>::const_iterator iter = lists.begin(); iter != lists.end(); ++iter)
+            {
+                count += static_cast<int>(iter->getIndices().size()) / 3;
+            }
+            return count;
+        }
+
+    private slots:
+        /**
+         * A flat grid can be reduced to two triangles without moving its surface or border.
+         */
+        void testFlatGrid()
+        {
+            GridMesh grid(10, 0.0f);
+            MeshSimplifier simplifier(grid);
+            QCOMPARE(simplifier.getNumTriangles(), 200);
+
+            float error = simplifier.simplify(2);
+            QCOMPARE(simplifier.getNumTriangles(), 2);
+            QVERIFY(error < 1.0e-4f);
+
+            PtrMesh simplified = simplifier.createMesh("Grid Simplified");
+            QCOMPARE(countTriangles(*simplified), 2);
+            QCOMPARE(static_cast<int>(simplified->getVertices().size()), 4);
+            QVERIFY(simplified->getBound().getMinimum() == grid.getBound().getMinimum());
+            QVERIFY(simplified->getBound().getMaximum() == grid.getBound().getMaximum());
+        }
+
+
+        /**
+         * A closed mesh must never be turned inside out.
+         */
+        void testClosedMesh()
+        {
+            CubeMesh cube("Cube");
+            MeshSimplifier simplifier(cube);
+            QCOMPARE(simplifier.getNumTriangles(), 12);
+
+            simplifier.simplify(0);
+            PtrMesh simplified = simplifier.createMesh("Cube Simplified");
+            QVERIFY(countTriangles(*simplified) > 0);
+
+            // Each remaining face still points away from the centre of the cube.
+            const std::vector<Vertex>& vertices = simplified->getVertices();
+            const std::vector<unsigned>& indices = simplified->getElementLists().front().getIndices();
+            for (size_t i = 0; i < indices.size(); i += 3)
+            {
+                const Vector3f& p0 = vertices[indices[i]].m_position;
+                Vector3f normal = (vertices[indices[i + 1]].m_position - p0).cross(vertices[indices[i + 2]].m_position - p0);
+                Vector3f center = (p0 + vertices[indices[i + 1]].m_position + vertices[indices[i + 2]].m_position) / 3.0f;
+                QVERIFY(normal.dot(center) > 0.0f);
+            }
+        }
+
+
+        /**
+         *
+         */
+        void testGenerateLods()
+        {
+            GridMesh grid(40, 0.1f);
+            MeshSimplifier::generateLods(grid, 4, 0.5f, 16);
+            QCOMPARE(grid.getNumLods(), 5);
+            QCOMPARE(&grid.getLod(0), static_cast<Mesh*>(&grid));
+            QCOMPARE(grid.getLodError(0), 0.0f);
+
+            for (int level = 1; level < grid.getNumLods(); ++level)
+            {
+                QVERIFY(countTriangles(grid.getLod(level)) < countTriangles(grid.getLod(level - 1)));
+                QVERIFY(grid.getLodError(level) >= grid.getLodError(level - 1));
+                QVERIFY(grid.getLodError(level) < 0.1f);
+                QVERIFY(grid.getLod(level).instanceName() != grid.getLod(level - 1).instanceName());
+            }
+        }
+
+
+        /**
+         * Too few triangles to be worth simplifying.
+         */
+        void testGenerateNoLods()
+        {
+            CubeMesh cube("Cube");
+            MeshSimplifier::generateLods(cube);
+            QCOMPARE(cube.getNumLods(), 1);
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestMeshSimplifier)
+#include "test_meshsimplifier.moc"
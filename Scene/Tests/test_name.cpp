@@ -0,0 +1,108 @@
+#include <QHash>
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Scene/cubemesh.h"
+#include "Scene/meshinstance.h"
+#include "Scene/name.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestName : public QObject
+    {
+        Q_OBJECT
+
+    private slots:
+        /**
+         * Equal strings give the same name, and different strings different names.
+         */
+        void testInterning()
+        {
+            Name a("Sphere");
+            Name b(QString("Sphere"));
+            Name c("Cube");
+            QVERIFY(a == b);
+            QCOMPARE(a.id(), b.id());
+            QVERIFY(a != c);
+            QCOMPARE(a.toString(), QString("Sphere"));
+            QCOMPARE(c.toString(), QString("Cube"));
+            QCOMPARE(a.hash(), qHash(QString("Sphere")));
+        }
+
+
+        /**
+         * The empty name is id zero, whichever way it is made.
+         */
+        void testEmpty()
+        {
+            Name empty;
+            QVERIFY(empty.isEmpty());
+            QCOMPARE(empty.id(), 0u);
+            QVERIFY(Name("") == empty);
+            QVERIFY(Name(QString()) == empty);
+            QVERIFY(empty.toString().isEmpty());
+            QVERIFY(!Name("Root").isEmpty());
+        }
+
+
+        /**
+         * A string is only added to the table the first time it is seen.
+         */
+        void testTableGrowth()
+        {
+            const int before = Name::getNumInterned();
+            Name first("Only once");
+            QCOMPARE(Name::getNumInterned(), before + 1);
+            Name second("Only once");
+            QCOMPARE(Name::getNumInterned(), before + 1);
+            QVERIFY(first == second);
+        }
+
+
+        /**
+         * Names can be used as hash keys.
+         */
+        void testHashKeys()
+        {
+            QHash<Name, int> values;
+            values.insert(Name("One"), 1);
+            values.insert(Name("Two"), 2);
+            values.insert(Name(QString("One")), 3);
+            QCOMPARE(values.size(), 2);
+            QCOMPARE(values.value(Name("One")), 3);
+            QCOMPARE(values.value(Name("Two")), 2);
+            QVERIFY(!values.contains(Name("Three")));
+        }
+
+
+        /**
+         * Copies of objects share the name, without interning it again.
+         */
+        void testObjectNames()
+        {
+            PtrMesh mesh(new CubeMesh("Cube"));
+            MeshInstance instance("Instance", mesh);
+            const int before = Name::getNumInterned();
+
+            MeshInstance* copy = instance.clone();
+            QVERIFY(copy->getName() == instance.getName());
+            QCOMPARE(copy->instanceName(), QString("Instance"));
+            QVERIFY(mesh->getName() == Name("Cube"));
+            QCOMPARE(Name::getNumInterned(), before);
+            delete copy;
+
+            instance.setInstanceName("Renamed");
+            QCOMPARE(instance.instanceName(), QString("Renamed"));
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestName)
+#include "test_name.moc"
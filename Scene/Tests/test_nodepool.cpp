@@ -0,0 +1,146 @@
+#include <set>
+#include <vector>
+
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Scene/cubemesh.h"
+#include "Scene/meshinstance.h"
+#include "Scene/nodepool.h"
+#include "Scene/scenenode.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal A subclass without a pool of its own, which is larger than SceneNode.
+     */
+    class LabelledNode : public SceneNode
+    {
+    public:
+        LabelledNode() : SceneNode("Labelled"), m_label(7) {}
+        virtual LabelledNode* clone() const { return new LabelledNode(*this); }
+
+        int m_label;
+    };
+
+
+    /**
+     * \internal
+     */
+    class TestNodePool : public QObject
+    {
+        Q_OBJECT
+
+    private slots:
+        /**
+         * Deleting nodes hands their memory back to be used by the next ones created.
+         */
+        void testReuse()
+        {
+            const int before = NodePool<SceneNode>::getNumAllocated();
+            std::vector<SceneNode*> nodes;
+            std::set<SceneNode*> addresses;
+            for (int i = 0; i < 100; ++i)
+            {
+                nodes.push_back(new SceneNode(QString("Node %1").arg(i)));
+                addresses.insert(nodes.back());
+            }
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), before + 100);
+
+            for (int i = 0; i < 100; ++i)
+            {
+                delete nodes[i];
+            }
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), before);
+
+            const int capacity = NodePool<SceneNode>::getCapacity();
+            for (int i = 0; i < 100; ++i)
+            {
+                nodes[i] = new SceneNode();
+                QVERIFY(addresses.count(nodes[i]) == 1);
+            }
+            QCOMPARE(NodePool<SceneNode>::getCapacity(), capacity);
+            for (int i = 0; i < 100; ++i)
+            {
+                delete nodes[i];
+            }
+        }
+
+
+        /**
+         * Cloning a tree allocates the copies from the pools, and deleting the root frees
+         * every one of them.
+         */
+        void testCloneAndTeardown()
+        {
+            PtrMesh mesh(new CubeMesh("Cube"));
+            const int nodesBefore = NodePool<SceneNode>::getNumAllocated();
+            const int instancesBefore = NodePool<MeshInstance>::getNumAllocated();
+
+            NodePool<MeshInstance>::reserve(10);
+            SceneNode* root = new SceneNode("Root");
+            for (int i = 0; i < 5; ++i)
+            {
+                SceneNode* group = new SceneNode(QString("Group %1").arg(i));
+                group->addChild(*new MeshInstance("A", mesh));
+                group->addChild(*new MeshInstance("B", mesh));
+                root->addChild(*group);
+            }
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), nodesBefore + 6);
+            QCOMPARE(NodePool<MeshInstance>::getNumAllocated(), instancesBefore + 10);
+
+            SceneNode* copy = root->clone();
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), nodesBefore + 12);
+            QCOMPARE(NodePool<MeshInstance>::getNumAllocated(), instancesBefore + 20);
+
+            delete root;
+            delete copy;
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), nodesBefore);
+            QCOMPARE(NodePool<MeshInstance>::getNumAllocated(), instancesBefore);
+        }
+
+
+        /**
+         * Subclasses of a pooled class still work, taking their memory from the heap.
+         */
+        void testSubclass()
+        {
+            const int before = NodePool<SceneNode>::getNumAllocated();
+            SceneNode* root = new SceneNode("Root");
+            root->addChild(*new LabelledNode());
+            SceneNode* copy = root->clone();
+            QCOMPARE(static_cast<LabelledNode&>(copy->getChild(0)).m_label, 7);
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), before + 2);
+
+            delete root;
+            delete copy;
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), before);
+        }
+
+
+        /**
+         * Slabs can be returned to the heap once nothing is allocated from them.
+         */
+        void testReleaseUnused()
+        {
+            SceneNode* node = new SceneNode();
+            QVERIFY(!NodePool<SceneNode>::releaseUnused());
+            QVERIFY(NodePool<SceneNode>::getCapacity() > 0);
+
+            delete node;
+            QVERIFY(NodePool<SceneNode>::releaseUnused());
+            QCOMPARE(NodePool<SceneNode>::getCapacity(), 0);
+
+            node = new SceneNode();
+            QCOMPARE(NodePool<SceneNode>::getNumAllocated(), 1);
+            delete node;
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestNodePool)
+#include "test_nodepool.moc"
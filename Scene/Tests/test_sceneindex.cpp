@@ -0,0 +1,151 @@
+#include <QString>
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "Scene/cubemesh.h"
+#include "Scene/meshinstance.h"
+#include "Scene/scene.h"
+#include "Scene/sceneindex.h"
+#include "Scene/scenenode.h"
+
+
+namespace GLDemo
+{
+
+    /**
+     * \internal
+     */
+    class TestSceneIndex : public QObject
+    {
+        Q_OBJECT
+
+    private:
+        /**
+         * Builds "Floor i/Room j/Lamp" for a few floors and rooms, unattached.
+         */
+        SceneNode* createBuilding(PtrMesh& mesh, int numFloors, int numRooms)
+        {
+            SceneNode* building = new SceneNode("Building");
+            for (int i = 0; i < numFloors; ++i)
+            {
+                SceneNode* floor = new SceneNode(QString("Floor %1").arg(i));
+                for (int j = 0; j < numRooms; ++j)
+                {
+                    SceneNode* room = new SceneNode(QString("Room %1.%2").arg(i).arg(j));
+                    room->addChild(*new MeshInstance("Lamp", mesh));
+                    floor->addChild(*room);
+                }
+                building->addChild(*floor);
+            }
+            return building;
+        }
+
+    private slots:
+        /**
+         * Adding a subtree indexes everything in it, and detaching it removes it all.
+         */
+        void testAttachDetach()
+        {
+            PtrMesh mesh(new CubeMesh("Cube"));
+            Scene scene;
+            SceneNode* building = createBuilding(mesh, 2, 3);
+            QCOMPARE(scene.getIndex().getNumEntities(), 0);
+
+            scene.getRootNode().addChild(*building);
+            QCOMPARE(scene.getIndex().getNumEntities(), 1 + 2 + 6 + 6);
+            QVERIFY(scene.getIndex().findByName("Building") == building);
+            QVERIFY(building->getScene() == &scene);
+
+            SpatialEntity* room = scene.getIndex().findByName("Room 1.2");
+            QVERIFY(room != 0);
+            QCOMPARE(SceneIndex::getPath(*room), QString("Building/Floor 1/Room 1.2"));
+            QVERIFY(scene.getIndex().findByPath("Building/Floor 1/Room 1.2") == room);
+            QVERIFY(scene.getIndex().findByPath("Building/Floor 1/Room 1.2/Lamp") != 0);
+            QVERIFY(scene.getIndex().findByPath("Floor 1/Room 1.2") == 0);
+
+            scene.getRootNode().detachChild(*building);
+            QCOMPARE(scene.getIndex().getNumEntities(), 0);
+            QVERIFY(scene.getIndex().findByName("Room 1.2") == 0);
+            QVERIFY(room->getScene() == 0);
+            QVERIFY(building->getParent() == 0);
+            delete building;
+        }
+
+
+        /**
+         * Nodes added below a node already in the scene are indexed too, and detaching them
+         * removes them from the index.
+         */
+        void testAddToAttachedNode()
+        {
+            PtrMesh mesh(new CubeMesh("Cube"));
+            Scene scene;
+            SceneNode* group = new SceneNode("Group");
+            scene.getRootNode().addChild(*group);
+
+            MeshInstance* instance = new MeshInstance("Instance", mesh);
+            group->addChild(*instance);
+            QVERIFY(scene.getIndex().findByPath("Group/Instance") == instance);
+
+            delete &group->detachChildAt(0);
+            QVERIFY(scene.getIndex().findByPath("Group/Instance") == 0);
+            QCOMPARE(scene.getIndex().getNumEntities(), 1);
+
+            // Everything below a detached node leaves the index with it.
+            group->addChild(*new SceneNode("Child"));
+            QCOMPARE(scene.getIndex().getNumEntities(), 2);
+            delete &scene.getRootNode().detachChild(*group);
+            QCOMPARE(scene.getIndex().getNumEntities(), 0);
+        }
+
+
+        /**
+         * Names shared by several entities find all of them, and prefixes find whole
+         * subtrees.
+         */
+        void testQueries()
+        {
+            PtrMesh mesh(new CubeMesh("Cube"));
+            Scene scene;
+            scene.getRootNode().addChild(*createBuilding(mesh, 3, 4));
+
+            SceneIndex::EntityList lamps;
+            scene.getIndex().findAllByName("Lamp", lamps);
+            QCOMPARE(int(lamps.size()), 12);
+
+            SceneIndex::EntityList floor;
+            scene.getIndex().findByPathPrefix("Building/Floor 2/", floor);
+            QCOMPARE(int(floor.size()), 8);
+            QCOMPARE(SceneIndex::getPath(*floor.front()), QString("Building/Floor 2/Room 2.0"));
+
+            SceneIndex::EntityList none;
+            scene.getIndex().findByPathPrefix("Garage", none);
+            QVERIFY(none.empty());
+        }
+
+
+        /**
+         * Copies of a subtree are not in any scene until they are added to one.
+         */
+        void testClone()
+        {
+            PtrMesh mesh(new CubeMesh("Cube"));
+            Scene scene;
+            SceneNode* building = createBuilding(mesh, 1, 1);
+            scene.getRootNode().addChild(*building);
+
+            SceneNode* copy = building->clone();
+            QVERIFY(copy->getScene() == 0);
+            QCOMPARE(scene.getIndex().getNumEntities(), 4);
+
+            copy->setInstanceName("Copy");
+            scene.getRootNode().addChild(*copy);
+            QCOMPARE(scene.getIndex().getNumEntities(), 8);
+            QVERIFY(scene.getIndex().findByPath("Copy/Floor 0/Room 0.0/Lamp") != 0);
+        }
+
+    };
+}
+
+QTEST_MAIN(GLDemo::TestSceneIndex)
+#include "test_sceneindex.moc"
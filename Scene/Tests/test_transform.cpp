@@ -1,4 +1,6 @@
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 #include <QString>
 #include <QObject>
@@ -329,10 +331,27 @@ namespace GLDemo
 
             // Create a transform and apply it to a vector
             Transformation t;
-            t.fromMatrix(inputMatrix);
+            QVERIFY(t.fromMatrix(inputMatrix));
             QVERIFY(t.getRotation() == rotationMatrix3x3);
             QVERIFY(t.getScale() == Vector3f(2.0f, 2.0f, 2.0f));
             QVERIFY(t.getTranslation() == Vector3f(1.0f, 2.0f, 3.0f));
+
+            // Each axis can be scaled differently, and the matrix is rebuilt exactly.
+            scaleMatrix(0,0) = 3.0f;
+            scaleMatrix(2,2) = 0.5f;
+            inputMatrix = translationMatrix * rotationMatrix4x4 * scaleMatrix;
+            QVERIFY(t.fromMatrix(inputMatrix));
+            QVERIFY(t.getScale() == Vector3f(3.0f, 2.0f, 0.5f));
+            QVERIFY(t.getRotation() == rotationMatrix3x3);
+            Matrix4f rebuilt;
+            t.toMatrix(rebuilt);
+            QVERIFY(rebuilt == inputMatrix);
+
+            // Shear can't be kept, which is reported.
+            Matrix4f shearMatrix;
+            shearMatrix.toIdentity();
+            shearMatrix(0,1) = 1.0f;
+            QVERIFY(!t.fromMatrix(inputMatrix * shearMatrix));
         }
 
 
@@ -389,6 +408,129 @@ namespace GLDemo
             QVERIFY(mResult == expResult);
         }
 
+
+        /**
+         * A uniform scale combined with a non-uniform one isn't uniform, so the inverse
+         * still undoes each axis separately.
+         */
+        void testCombineNonUniformScale()
+        {
+            Transformation t1, t2;
+            Matrix3f rotation;
+            rotation.fromAxisAngle(Math<float>::PI / 6, Vector3f(0.0f, 0.0f, 1.0f));
+            t1.setRotation(rotation);
+            t1.setUniformScale(2.0f);
+            t1.setTranslation(Vector3f(1.0f, 2.0f, 3.0f));
+            t2.setScale(Vector3f(1.0f, 3.0f, 0.5f));
+            t2.setTranslation(Vector3f(0.0f, 1.0f, 0.0f));
+
+            Transformation result;
+            result.combine(t1, t2);
+
+            const Vector3f v(1.0f, 2.0f, 3.0f);
+            const Vector3f expected = t1.apply(t2.apply(v));
+            QVERIFY(result.apply(v) == expected);
+            QVERIFY(result.applyInverse(expected) == v);
+            QVERIFY(result.getScale() == Vector3f(2.0f, 6.0f, 1.0f));
+        }
+
+
+        /**
+         * Matrices made relative to a point keep the precision of the offset from it, and
+         * match the absolute matrix once that point is added back.
+         */
+        void testRelativeMatrix()
+        {
+            Transformation t;
+            Matrix3f rotation;
+            rotation.fromAxisAngle(0.5f, Vector3f(0.0f, 1.0f, 0.0f));
+            t.setRotation(rotation);
+            t.setTranslation(Vector3f(20000.25f, 10.0f, -15000.5f));
+
+            const WorldVector3 origin(Vector3f(20000.0f, 0.0f, -15000.0f));
+            Matrix4f relative;
+            Matrix4f absolute;
+            t.toMatrix(relative, origin);
+            t.toMatrix(absolute);
+            QCOMPARE(relative(0,3), 0.25f);
+            QCOMPARE(relative(1,3), 10.0f);
+            QCOMPARE(relative(2,3), -0.5f);
+            for (int row = 0; row < 3; ++row)
+            {
+                QCOMPARE(relative(row,3) + static_cast<float>(origin[row]), absolute(row,3));
+                for (int col = 0; col < 3; ++col)
+                {
+                    QCOMPARE(relative(row,col), absolute(row,col));
+                }
+            }
+
+#ifdef GLDEMO_DOUBLE_PRECISION_WORLD
+            // Far enough out that single precision can't tell a millimetre apart.
+            Transformation parent;
+            parent.setTranslation(Vector3d(12345678.0, 0.0, 87654321.0));
+            Transformation child;
+            child.setTranslation(Vector3f(0.001f, 0.0f, 0.002f));
+            Transformation world;
+            world.combine(parent, child);
+            world.toMatrix(relative, parent.getPreciseTranslation());
+            QVERIFY(std::fabs(relative(0,3) - 0.001f) < 1.0e-6f);
+            QVERIFY(std::fabs(relative(2,3) - 0.002f) < 1.0e-6f);
+#endif
+        }
+
+
+        /**
+         * The cost of updating world transformations, as the scene graph does each frame.
+         * Compare builds with and without GLDEMO_DOUBLE_PRECISION_WORLD.
+         */
+        void benchmarkCombine()
+        {
+            const int count = 1000;
+            std::vector<Transformation> locals(count);
+            for (int i = 0; i < count; ++i)
+            {
+                Matrix3f rotation;
+                rotation.fromAxisAngle(0.01f * i, Vector3f(1.0f, 1.0f, 0.0f).unitVector());
+                locals[i].setRotation(rotation);
+                locals[i].setTranslation(Vector3f(1000.0f * i, 1.0f, -2.0f));
+            }
+
+            std::vector<Transformation> worlds(count);
+            QBENCHMARK
+            {
+                for (int i = 1; i < count; ++i)
+                {
+                    worlds[i].combine(worlds[i - 1], locals[i]);
+                }
+            }
+        }
+
+
+        /**
+         * The cost of building each instance's matrix relative to the camera, as the
+         * renderer does for every instance it draws.
+         */
+        void benchmarkRelativeMatrix()
+        {
+            const int count = 1000;
+            std::vector<Transformation> worlds(count);
+            for (int i = 0; i < count; ++i)
+            {
+                worlds[i].setUniformScale(2.0f);
+                worlds[i].setTranslation(Vector3f(1000.0f * i, 1.0f, -2.0f));
+            }
+
+            const WorldVector3 eye(Vector3f(500000.0f, 0.0f, 0.0f));
+            std::vector<Matrix4f> matrices(count);
+            QBENCHMARK
+            {
+                for (int i = 0; i < count; ++i)
+                {
+                    worlds[i].toMatrix(matrices[i], eye);
+                }
+            }
+        }
+
     };
 }
 
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include <QRunnable>
+#include <QThreadPool>
+
+#include "animator.h"
+#include "spatialentity.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \internal Updates one run of channels on a worker thread.
+     */
+    class Animator::ChannelTask : public QRunnable
+    {
+    public:
+        ChannelTask(Animator& animator, int first, int end, double time) :
+            m_animator(animator),
+            m_first(first),
+            m_end(end),
+            m_time(time)
+        {
+        }
+
+        virtual void run()
+        {
+            m_animator.updateChannels(m_first, m_end, m_time);
+            m_animator.m_tasksDone.release();
+        }
+
+    private:
+        Animator& m_animator;
+        int       m_first;
+        int       m_end;
+        double    m_time;
+    };
+
+
+    /**
+     *
+     */
+    Animator::Animator() :
+        m_keyTimes(),
+        m_keyTranslations(),
+        m_keyRotations(),
+        m_keyScales(),
+        m_tracks(),
+        m_targets(),
+        m_channelTracks(),
+        m_startTimes(),
+        m_looping(),
+        m_cursors(),
+        m_channelIndices(),
+        m_threaded(true),
+        m_threadPool(),
+        m_tasksDone(0)
+    {
+    }
+
+
+    /**
+     *
+     */
+    Animator::~Animator()
+    {
+    }
+
+
+    /**
+     * \param keys  The keys of the track, in order of time. The first is usually at time
+     *              zero; before it, and after the last, the nearest key holds.
+     * \return The id of the new track, or -1 if there are no keys or they are out of order.
+     */
+    int Animator::addTrack(const std::vector<Keyframe>& keys)
+    {
+        if (keys.empty())
+        {
+            std::cout << "ERROR: An animation track needs at least one key." << std::endl;
+            return -1;
+        }
+        for (std::vector<Keyframe>::const_iterator iter = keys.begin() + 1; iter != keys.end(); ++iter)
+        {
+            if (iter->m_time < (iter - 1)->m_time)
+            {
+                std::cout << "ERROR: The keys of an animation track must be in order of time." << std::endl;
+                return -1;
+            }
+        }
+
+        Track track;
+        track.m_firstKey = static_cast<int>(m_keyTimes.size());
+        track.m_numKeys = static_cast<int>(keys.size());
+        track.m_duration = keys.back().m_time;
+        for (std::vector<Keyframe>::const_iterator iter = keys.begin(); iter != keys.end(); ++iter)
+        {
+            m_keyTimes.push_back(iter->m_time);
+            m_keyTranslations.push_back(iter->m_translation);
+            m_keyRotations.push_back(iter->m_rotation);
+            m_keyScales.push_back(iter->m_scale);
+        }
+        m_tracks.push_back(track);
+        return static_cast<int>(m_tracks.size()) - 1;
+    }
+
+
+    /**
+     * \return The time of the last key of the track, which is when looping tracks start
+     *         again.
+     */
+    float Animator::getDuration(int track) const
+    {
+        return m_tracks[track].m_duration;
+    }
+
+
+    /**
+     * \param entity     The entity whose local transformation the track sets. Whatever it
+     *                   was playing before is stopped.
+     * \param track      The id returned by addTrack().
+     * \param startTime  The time, as passed to update(), at which the track starts.
+     * \param loop       Whether the track starts again when it reaches its end, rather
+     *                   than holding its last key.
+     * \return False if there is no such track.
+     */
+    bool Animator::play(SpatialEntity& entity, int track, double startTime, bool loop)
+    {
+        if (track < 0 || track >= getNumTracks())
+        {
+            std::cout << "ERROR: No animation track " << track << "." << std::endl;
+            return false;
+        }
+
+        QHash<const SpatialEntity*, int>::const_iterator iter = m_channelIndices.constFind(&entity);
+        if (iter != m_channelIndices.constEnd())
+        {
+            const int channel = iter.value();
+            m_channelTracks[channel] = track;
+            m_startTimes[channel] = startTime;
+            m_looping[channel] = loop;
+            m_cursors[channel] = 0;
+            return true;
+        }
+
+        m_channelIndices.insert(&entity, static_cast<int>(m_targets.size()));
+        m_targets.push_back(&entity);
+        m_channelTracks.push_back(track);
+        m_startTimes.push_back(startTime);
+        m_looping.push_back(loop);
+        m_cursors.push_back(0);
+        return true;
+    }
+
+
+    /**
+     * Leaves the entity with the transformation it was last given. Does nothing if it
+     * isn't playing anything.
+     */
+    void Animator::stop(const SpatialEntity& entity)
+    {
+        QHash<const SpatialEntity*, int>::const_iterator iter = m_channelIndices.constFind(&entity);
+        if (iter == m_channelIndices.constEnd())
+        {
+            return;
+        }
+
+        // The last channel takes the place of the one stopped.
+        const int channel = iter.value();
+        const int last = getNumChannels() - 1;
+        m_channelIndices.remove(&entity);
+        if (channel != last)
+        {
+            m_targets[channel] = m_targets[last];
+            m_channelTracks[channel] = m_channelTracks[last];
+            m_startTimes[channel] = m_startTimes[last];
+            m_looping[channel] = m_looping[last];
+            m_cursors[channel] = m_cursors[last];
+            m_channelIndices.insert(m_targets[channel], channel);
+        }
+        m_targets.pop_back();
+        m_channelTracks.pop_back();
+        m_startTimes.pop_back();
+        m_looping.pop_back();
+        m_cursors.pop_back();
+    }
+
+
+    /**
+     * \param time  The current time, in seconds, on the same clock as the start times
+     *              passed to play().
+     *
+     * Sets the local transformation of every entity playing a track. Returns once they
+     * have all been set, even when the work is split between threads.
+     */
+    void Animator::update(double time)
+    {
+        const int numChannels = getNumChannels();
+        int numTasks = 1;
+        if (m_threaded)
+        {
+            numTasks = std::max(1, std::min(m_threadPool.maxThreadCount(), numChannels / s_minChannelsPerTask));
+        }
+
+        // This thread takes the first run itself.
+        for (int task = 1; task < numTasks; ++task)
+        {
+            int first = numChannels * task / numTasks;
+            int end = numChannels * (task + 1) / numTasks;
+            m_threadPool.start(new ChannelTask(*this, first, end, time));
+        }
+        updateChannels(0, numChannels / numTasks, time);
+        m_tasksDone.acquire(numTasks - 1);
+    }
+
+
+    /**
+     * \internal Evaluates the tracks of the channels in [first, end), and writes the
+     *           results into the local transformations of their entities.
+     */
+    void Animator::updateChannels(int first, int end, double time)
+    {
+        for (int channel = first; channel < end; ++channel)
+        {
+            const Track& track = m_tracks[m_channelTracks[channel]];
+            const float* times = &m_keyTimes[track.m_firstKey];
+
+            float t = static_cast<float>(time - m_startTimes[channel]);
+            if (m_looping[channel] && track.m_duration > 0.0f)
+            {
+                t = std::fmod(t, track.m_duration);
+                if (t < 0.0f)
+                {
+                    t += track.m_duration;
+                }
+            }
+            t = std::max(times[0], std::min(t, track.m_duration));
+
+            // Find the pair of keys around t, starting from those used last time, which
+            // are usually the same or the next ones along.
+            int key = 0;
+            float blend = 0.0f;
+            if (track.m_numKeys > 1)
+            {
+                key = m_cursors[channel];
+                if (times[key] > t)
+                {
+                    key = 0;
+                }
+                while (key < track.m_numKeys - 2 && times[key + 1] <= t)
+                {
+                    ++key;
+                }
+                m_cursors[channel] = key;
+
+                const float span = times[key + 1] - times[key];
+                blend = span > 0.0f ? std::min(1.0f, (t - times[key]) / span) : 1.0f;
+            }
+
+            const int a = track.m_firstKey + key;
+            const int b = track.m_numKeys > 1 ? a + 1 : a;
+            const Vector3f translation = m_keyTranslations[a] + (m_keyTranslations[b] - m_keyTranslations[a]) * blend;
+            const Vector3f scale = m_keyScales[a] + (m_keyScales[b] - m_keyScales[a]) * blend;
+            const Quaternionf rotation = Quaternionf::nlerp(m_keyRotations[a], m_keyRotations[b], blend);
+
+            Transformation& local = m_targets[channel]->getLocalTransformation();
+            local.setTranslation(translation);
+            local.setRotation(rotation);
+            if (scale.x() == scale.y() && scale.y() == scale.z())
+            {
+                local.setUniformScale(scale.x());
+            }
+            else
+            {
+                local.setScale(scale);
+            }
+        }
+    }
+
+}
@@ -0,0 +1,132 @@
+#ifndef GLDEMO_ANIMATOR_H
+#define GLDEMO_ANIMATOR_H
+
+#include <vector>
+
+#include <QHash>
+#include <QSemaphore>
+#include <QThreadPool>
+
+#include "Math/quaternion.h"
+#include "Math/vector3.h"
+
+namespace GLDemo
+{
+    class SpatialEntity;
+
+    /**
+     * \brief The local transformation of an entity at one moment of an animation.
+     */
+    class Keyframe
+    {
+    public:
+        Keyframe() :
+            m_time(0.0f),
+            m_translation(),
+            m_rotation(),
+            m_scale(1.0f, 1.0f, 1.0f)
+        {
+        }
+
+        Keyframe(float time, const Vector3f& translation, const Quaternionf& rotation, const Vector3f& scale) :
+            m_time(time),
+            m_translation(translation),
+            m_rotation(rotation),
+            m_scale(scale)
+        {
+        }
+
+        float       m_time;         // In seconds from the start of the track
+        Vector3f    m_translation;
+        Quaternionf m_rotation;
+        Vector3f    m_scale;
+    };
+
+
+    /**
+     * \brief Plays keyframed tracks on the local transformations of many entities at once.
+     *
+     * Tracks are added once, and their keys are kept together in flat arrays shared by
+     * every entity that plays them. Each entity playing a track is a channel, and the
+     * channels are also kept in flat arrays, so update() is one pass over contiguous
+     * memory, with no virtual calls, that writes the translation, rotation and scale of
+     * each entity straight into its local transformation. Large numbers of channels are
+     * split between the threads of a pool of the animator's own. The calling thread waits
+     * for them, so they can't come from a pool it may itself be running in.
+     *
+     * update() is meant to be called once a frame, before the geometric update of the
+     * scene, which then carries the new local transformations into world space; see
+     * Scene::update(). Between keys, translations and scales are blended linearly and
+     * rotations by normalized linear interpolation, which is close to slerp for keys as
+     * dense as animations usually have. A FrameLoop calls update() on a worker thread
+     * instead, once a tick; tracks are then only played and stopped between ticks.
+     *
+     * An entity plays at most one track at a time, and must be stopped before it is
+     * deleted.
+     */
+    class Animator
+    {
+    public:
+        Animator();
+        ~Animator();
+
+        int  addTrack(const std::vector<Keyframe>& keys);
+        int  getNumTracks() const { return static_cast<int>(m_tracks.size()); }
+        float getDuration(int track) const;
+
+        bool play(SpatialEntity& entity, int track, double startTime, bool loop);
+        void stop(const SpatialEntity& entity);
+        bool isPlaying(const SpatialEntity& entity) const { return m_channelIndices.contains(&entity); }
+        int  getNumChannels() const { return static_cast<int>(m_targets.size()); }
+
+        void setThreaded(bool threaded) { m_threaded = threaded; }
+        bool isThreaded() const         { return m_threaded; }
+
+        void update(double time);
+
+    private:
+        /**
+         * \internal Where the keys of a track are, in the key arrays.
+         */
+        class Track
+        {
+        public:
+            int   m_firstKey;
+            int   m_numKeys;
+            float m_duration;
+        };
+
+        class ChannelTask;
+        friend class ChannelTask;
+
+        Animator(const Animator&);
+        Animator& operator=(const Animator&);
+
+        void updateChannels(int first, int end, double time);
+
+        // Keys of every track, one track after another
+        std::vector<float>       m_keyTimes;
+        std::vector<Vector3f>    m_keyTranslations;
+        std::vector<Quaternionf> m_keyRotations;
+        std::vector<Vector3f>    m_keyScales;
+        std::vector<Track>       m_tracks;
+
+        // One entry per channel
+        std::vector<SpatialEntity*> m_targets;
+        std::vector<int>            m_channelTracks;
+        std::vector<double>         m_startTimes;
+        std::vector<char>           m_looping;
+        std::vector<int>            m_cursors;      // Key last played, where the search starts
+
+        QHash<const SpatialEntity*, int> m_channelIndices;
+        bool                             m_threaded;
+        QThreadPool                      m_threadPool;  // Runs the channel tasks
+        QSemaphore                       m_tasksDone;
+
+        // Channels are only split between threads in runs of at least this many.
+        static const int s_minChannelsPerTask = 1024;
+    };
+
+}
+
+#endif
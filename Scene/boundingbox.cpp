@@ -0,0 +1,179 @@
+#include <algorithm>
+
+#include "Math/vector3soa.h"
+#include "boundingbox.h"
+#include "transformation.h"
+
+namespace GLDemo
+{
+    /**
+     * Creates an empty box.
+     */
+    BoundingBox::BoundingBox() :
+        m_minimum(),
+        m_maximum(),
+        m_empty(true)
+    {
+    }
+
+
+    /**
+     * \param minimum  The corner with the smallest coordinates.
+     * \param maximum  The corner with the largest coordinates.
+     */
+    BoundingBox::BoundingBox(const Vector3f& minimum, const Vector3f& maximum) :
+        m_minimum(minimum),
+        m_maximum(maximum),
+        m_empty(false)
+    {
+    }
+
+
+    /**
+     * \pre The box must not be empty.
+     */
+    Vector3f BoundingBox::getCenter() const
+    {
+        return (m_minimum + m_maximum) * 0.5f;
+    }
+
+
+    /**
+     * \return Half the size of the box along each axis.
+     * \pre The box must not be empty.
+     */
+    Vector3f BoundingBox::getExtents() const
+    {
+        return (m_maximum - m_minimum) * 0.5f;
+    }
+
+
+    /**
+     * \return The total area of the six faces of the box, or zero if it is empty.
+     */
+    float BoundingBox::getSurfaceArea() const
+    {
+        if (m_empty)
+        {
+            return 0.0f;
+        }
+
+        Vector3f size = m_maximum - m_minimum;
+        return 2.0f * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+    }
+
+
+    /**
+     * \param point  A point the box should contain.
+     */
+    void BoundingBox::extend(const Vector3f& point)
+    {
+        if (m_empty)
+        {
+            m_minimum = point;
+            m_maximum = point;
+            m_empty = false;
+            return;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            m_minimum[i] = std::min(m_minimum[i], point[i]);
+            m_maximum[i] = std::max(m_maximum[i], point[i]);
+        }
+    }
+
+
+    /**
+     * \param box  A box this one should contain. Extending by an empty box has no effect.
+     */
+    void BoundingBox::extend(const BoundingBox& box)
+    {
+        if (!box.m_empty)
+        {
+            extend(box.m_minimum);
+            extend(box.m_maximum);
+        }
+    }
+
+
+    /**
+     * \param points  Points this box should contain, bounded in bulk.
+     */
+    void BoundingBox::extend(const Vector3SoA& points)
+    {
+        Vector3f minimum;
+        Vector3f maximum;
+        if (points.computeBound(minimum, maximum))
+        {
+            extend(BoundingBox(minimum, maximum));
+        }
+    }
+
+
+    /**
+     * \return True if the point lies inside or on the surface of the box.
+     */
+    bool BoundingBox::contains(const Vector3f& point) const
+    {
+        if (m_empty)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (point[i] < m_minimum[i] || point[i] > m_maximum[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    /**
+     * \return True if the boxes overlap or touch.
+     */
+    bool BoundingBox::intersects(const BoundingBox& box) const
+    {
+        if (m_empty || box.m_empty)
+        {
+            return false;
+        }
+
+        for (int i = 0; i < 3; ++i)
+        {
+            if (box.m_maximum[i] < m_minimum[i] || box.m_minimum[i] > m_maximum[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    /**
+     * \param t  The transformation to apply.
+     * \return The smallest axis-aligned box containing this box once transformed. Under
+     *         a rotation this is larger than the box itself.
+     */
+    BoundingBox BoundingBox::transformed(const Transformation& t) const
+    {
+        BoundingBox result;
+        if (m_empty)
+        {
+            return result;
+        }
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            Vector3f point((corner & 1) ? m_maximum.x() : m_minimum.x(),
+                           (corner & 2) ? m_maximum.y() : m_minimum.y(),
+                           (corner & 4) ? m_maximum.z() : m_minimum.z());
+            result.extend(t.apply(point));
+        }
+        return result;
+    }
+
+}
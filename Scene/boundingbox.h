@@ -0,0 +1,49 @@
+#ifndef GLDEMO_BOUNDINGBOX_H
+#define GLDEMO_BOUNDINGBOX_H
+
+#include "Math/vector3.h"
+
+namespace GLDemo
+{
+    class Transformation;
+    class Vector3SoA;
+
+    /**
+     * \brief An axis-aligned box enclosing a set of points.
+     *
+     * A default constructed box is empty; it contains nothing, and extending it by a
+     * point gives a box containing just that point.
+     */
+    class BoundingBox
+    {
+    public:
+        BoundingBox();
+        BoundingBox(const Vector3f& minimum, const Vector3f& maximum);
+
+        bool isEmpty() const { return m_empty; }
+        void setEmpty()      { m_empty = true; }
+
+        const Vector3f& getMinimum() const { return m_minimum; }
+        const Vector3f& getMaximum() const { return m_maximum; }
+        Vector3f        getCenter() const;
+        Vector3f        getExtents() const;
+        float           getSurfaceArea() const;
+
+        void extend(const Vector3f& point);
+        void extend(const BoundingBox& box);
+        void extend(const Vector3SoA& points);
+
+        bool contains(const Vector3f& point) const;
+        bool intersects(const BoundingBox& box) const;
+
+        BoundingBox transformed(const Transformation& t) const;
+
+    private:
+        Vector3f m_minimum;
+        Vector3f m_maximum;
+        bool     m_empty;
+    };
+
+}
+
+#endif
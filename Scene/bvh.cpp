@@ -0,0 +1,260 @@
+#include "Math/mathdefs.h"
+#include "bvh.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        const int NUM_BINS = 16;
+
+        /**
+         * \internal The primitives whose centroids fall in one slice of a node's centroid
+         *           bound along an axis.
+         */
+        class Bin
+        {
+        public:
+            Bin() : m_bound(), m_count(0) {}
+
+            BoundingBox m_bound;
+            int         m_count;
+        };
+
+
+        /**
+         * \internal The bin a centroid falls in along an axis.
+         */
+        int binOf(float centroid, float minimum, float binScale)
+        {
+            int bin = static_cast<int>((centroid - minimum) * binScale);
+            return std::min(std::max(bin, 0), NUM_BINS - 1);
+        }
+
+
+        /**
+         * \internal Predicate to partition primitives into those left of a split.
+         */
+        class LeftOfSplit
+        {
+        public:
+            LeftOfSplit(const std::vector<Vector3f>& centroids, int axis, float minimum, float binScale, int split) :
+                m_centroids(centroids),
+                m_axis(axis),
+                m_minimum(minimum),
+                m_binScale(binScale),
+                m_split(split)
+            {
+            }
+
+            bool operator()(int primitive) const
+            {
+                return binOf(m_centroids[primitive][m_axis], m_minimum, m_binScale) < m_split;
+            }
+
+        private:
+            const std::vector<Vector3f>& m_centroids;
+            int   m_axis;
+            float m_minimum;
+            float m_binScale;
+            int   m_split;
+        };
+    }
+
+
+    /**
+     * Creates an empty hierarchy.
+     */
+    Bvh::Bvh() :
+        m_nodes(),
+        m_primitives(),
+        m_maxLeafSize(4)
+    {
+    }
+
+
+    /**
+     * \param bounds       The bound of each primitive, indexed by primitive.
+     * \param maxLeafSize  Nodes with no more primitives than this are never split.
+     *
+     * Replaces the hierarchy with one over the given primitives.
+     */
+    void Bvh::build(const std::vector<BoundingBox>& bounds, int maxLeafSize)
+    {
+        clear();
+        m_maxLeafSize = std::max(maxLeafSize, 1);
+
+        std::vector<Vector3f> centroids(bounds.size());
+        for (size_t i = 0; i < bounds.size(); ++i)
+        {
+            if (!bounds[i].isEmpty())
+            {
+                centroids[i] = bounds[i].getCenter();
+                m_primitives.push_back(static_cast<int>(i));
+            }
+        }
+        if (m_primitives.empty())
+        {
+            return;
+        }
+
+        m_nodes.reserve(2 * m_primitives.size());
+        m_nodes.push_back(Node());
+        subdivide(0, 0, static_cast<int>(m_primitives.size()), 0, bounds, centroids);
+    }
+
+
+    /**
+     * Removes all nodes and primitives.
+     */
+    void Bvh::clear()
+    {
+        m_nodes.clear();
+        m_primitives.clear();
+    }
+
+
+    /**
+     * \internal Fills in a node for a run of primitives, splitting it in two if the surface
+     *           area heuristic says that is cheaper than testing them all.
+     */
+    void Bvh::subdivide(int nodeIndex, int first, int count, int depth,
+                        const std::vector<BoundingBox>& bounds, const std::vector<Vector3f>& centroids)
+    {
+        BoundingBox bound;
+        BoundingBox centroidBound;
+        for (int i = first; i < first + count; ++i)
+        {
+            bound.extend(bounds[m_primitives[i]]);
+            centroidBound.extend(centroids[m_primitives[i]]);
+        }
+        m_nodes[nodeIndex].m_bound = bound;
+        m_nodes[nodeIndex].m_first = first;
+        m_nodes[nodeIndex].m_count = count;
+
+        if (count <= m_maxLeafSize || depth >= s_maxDepth)
+        {
+            return;
+        }
+
+        // Costs are relative to testing a single primitive, with traversing a node costing
+        // the same. A split is scored by the chance of a ray through the node hitting each
+        // child, which is in proportion to their surface areas.
+        const float area = std::max(bound.getSurfaceArea(), Math<float>::Epsilon());
+        float bestCost = static_cast<float>(count);
+        int bestAxis = -1;
+        int bestSplit = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            const float minimum = centroidBound.getMinimum()[axis];
+            const float extent = centroidBound.getMaximum()[axis] - minimum;
+            if (extent <= 0.0f)
+            {
+                continue;
+            }
+
+            const float binScale = NUM_BINS / extent;
+            Bin bins[NUM_BINS];
+            for (int i = first; i < first + count; ++i)
+            {
+                Bin& bin = bins[binOf(centroids[m_primitives[i]][axis], minimum, binScale)];
+                bin.m_bound.extend(bounds[m_primitives[i]]);
+                ++bin.m_count;
+            }
+
+            // Sweep from the right to find the cost of everything right of each split,
+            // then from the left to add the cost of what is left of it.
+            float rightCost[NUM_BINS];
+            BoundingBox rightBound;
+            int rightCount = 0;
+            for (int split = NUM_BINS - 1; split > 0; --split)
+            {
+                rightBound.extend(bins[split].m_bound);
+                rightCount += bins[split].m_count;
+                rightCost[split] = rightBound.getSurfaceArea() * rightCount;
+            }
+
+            BoundingBox leftBound;
+            int leftCount = 0;
+            for (int split = 1; split < NUM_BINS; ++split)
+            {
+                leftBound.extend(bins[split - 1].m_bound);
+                leftCount += bins[split - 1].m_count;
+                if (leftCount == 0 || leftCount == count)
+                {
+                    continue;
+                }
+
+                float cost = 1.0f + (leftBound.getSurfaceArea() * leftCount + rightCost[split]) / area;
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        if (bestAxis < 0)
+        {
+            return;
+        }
+
+        const float minimum = centroidBound.getMinimum()[bestAxis];
+        const float binScale = NUM_BINS / (centroidBound.getMaximum()[bestAxis] - minimum);
+        std::vector<int>::iterator middle = std::partition(m_primitives.begin() + first, m_primitives.begin() + first + count,
+                                                           LeftOfSplit(centroids, bestAxis, minimum, binScale, bestSplit));
+        const int leftCount = static_cast<int>(middle - m_primitives.begin()) - first;
+
+        const int left = static_cast<int>(m_nodes.size());
+        m_nodes.push_back(Node());
+        m_nodes.push_back(Node());
+        m_nodes[nodeIndex].m_first = left;
+        m_nodes[nodeIndex].m_count = 0;
+
+        subdivide(left, first, leftCount, depth + 1, bounds, centroids);
+        subdivide(left + 1, first + leftCount, count - leftCount, depth + 1, bounds, centroids);
+    }
+
+
+    /**
+     * \param box           The box to test.
+     * \param origin        The start of the ray.
+     * \param invDirection  The reciprocal of each component of the ray's direction.
+     * \param maxDistance   How far along the ray to look.
+     * \param entry         Set to the distance at which the ray enters the box, or zero if
+     *                      it starts inside it.
+     * \return True if the ray passes through the box within \a maxDistance.
+     */
+    bool Bvh::intersectBox(const BoundingBox& box, const Vector3f& origin, const Vector3f& invDirection,
+                           float maxDistance, float& entry)
+    {
+        if (box.isEmpty())
+        {
+            return false;
+        }
+
+        float nearest = 0.0f;
+        float furthest = maxDistance;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            float t0 = (box.getMinimum()[axis] - origin[axis]) * invDirection[axis];
+            float t1 = (box.getMaximum()[axis] - origin[axis]) * invDirection[axis];
+            if (t0 > t1)
+            {
+                std::swap(t0, t1);
+            }
+
+            // Written so that NaNs, from a ray lying in the plane of a face, are ignored.
+            nearest = t0 > nearest ? t0 : nearest;
+            furthest = t1 < furthest ? t1 : furthest;
+            if (nearest > furthest)
+            {
+                return false;
+            }
+        }
+
+        entry = nearest;
+        return true;
+    }
+
+}
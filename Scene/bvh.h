@@ -0,0 +1,151 @@
+#ifndef GLDEMO_BVH_H
+#define GLDEMO_BVH_H
+
+#include <algorithm>
+#include <vector>
+
+#include "boundingbox.h"
+#include "ray.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \brief A bounding volume hierarchy over a set of primitives, known only by their
+     *        bounds and an index.
+     *
+     * The tree is built top down, splitting each node where the surface area heuristic
+     * estimates rays will be cheapest to trace, with candidate splits binned along each
+     * axis. What the primitives are is up to the user: MeshBvh uses triangles, and
+     * SceneBvh mesh instances. Primitives with empty bounds are left out of the tree.
+     */
+    class Bvh
+    {
+    public:
+        /**
+         * \brief A node of the tree. Interior nodes have two children, stored next to
+         *        each other; leaves hold a run of primitives.
+         */
+        class Node
+        {
+        public:
+            Node() : m_bound(), m_first(0), m_count(0) {}
+
+            bool isLeaf() const { return m_count > 0; }
+
+            BoundingBox m_bound;
+            int         m_first;    // First primitive of a leaf, or the left child of an interior node
+            int         m_count;    // Number of primitives in a leaf, zero for interior nodes
+        };
+
+        Bvh();
+
+        void build(const std::vector<BoundingBox>& bounds, int maxLeafSize = 4);
+        void clear();
+
+        bool isEmpty() const                     { return m_nodes.empty(); }
+        const std::vector<Node>& getNodes() const { return m_nodes; }
+        int  getPrimitive(int i) const           { return m_primitives[i]; }
+
+        template<class Intersector>
+        bool intersect(const Ray& ray, float& distance, Intersector& intersector) const;
+
+        static bool intersectBox(const BoundingBox& box, const Vector3f& origin, const Vector3f& invDirection,
+                                 float maxDistance, float& entry);
+
+    private:
+        // Leaves are forced past this depth, so traversal can use a fixed size stack.
+        static const int s_maxDepth = 60;
+
+        void subdivide(int nodeIndex, int first, int count, int depth,
+                       const std::vector<BoundingBox>& bounds, const std::vector<Vector3f>& centroids);
+
+        std::vector<Node> m_nodes;
+        std::vector<int>  m_primitives;
+        int               m_maxLeafSize;
+    };
+
+
+    /**
+     * \param ray          The ray to trace.
+     * \param distance     On entry, how far along the ray to look. On return, the distance
+     *                     to the nearest hit, if there was one.
+     * \param intersector  Called as intersector(primitive, ray, distance) for each
+     *                     primitive in a leaf the ray reaches. It should return true, and
+     *                     lower distance, if it finds a nearer hit.
+     * \return True if the intersector found any hit.
+     *
+     * Nearer children are visited first, so that once a hit is found, nodes beyond it
+     * are skipped.
+     */
+    template<class Intersector>
+    bool Bvh::intersect(const Ray& ray, float& distance, Intersector& intersector) const
+    {
+        if (m_nodes.empty())
+        {
+            return false;
+        }
+
+        const Vector3f invDirection(1.0f / ray.m_direction.x(), 1.0f / ray.m_direction.y(), 1.0f / ray.m_direction.z());
+
+        float entry = 0.0f;
+        if (!intersectBox(m_nodes[0].m_bound, ray.m_origin, invDirection, distance, entry))
+        {
+            return false;
+        }
+
+        int   stack[s_maxDepth + 2];
+        float stackEntry[s_maxDepth + 2];
+        int   top = 0;
+        stack[top] = 0;
+        stackEntry[top++] = entry;
+
+        bool hit = false;
+        while (top > 0)
+        {
+            --top;
+            if (stackEntry[top] > distance)
+            {
+                continue;
+            }
+
+            const Node& node = m_nodes[stack[top]];
+            if (node.isLeaf())
+            {
+                for (int i = node.m_first; i < node.m_first + node.m_count; ++i)
+                {
+                    hit = intersector(m_primitives[i], ray, distance) || hit;
+                }
+                continue;
+            }
+
+            float leftEntry = 0.0f;
+            float rightEntry = 0.0f;
+            bool hitLeft = intersectBox(m_nodes[node.m_first].m_bound, ray.m_origin, invDirection, distance, leftEntry);
+            bool hitRight = intersectBox(m_nodes[node.m_first + 1].m_bound, ray.m_origin, invDirection, distance, rightEntry);
+
+            // Push the further child first, so the nearer one is visited next.
+            if (hitLeft && hitRight && leftEntry < rightEntry)
+            {
+                stack[top] = node.m_first + 1;
+                stackEntry[top++] = rightEntry;
+                hitRight = false;
+            }
+            if (hitLeft)
+            {
+                stack[top] = node.m_first;
+                stackEntry[top++] = leftEntry;
+            }
+            if (hitRight)
+            {
+                stack[top] = node.m_first + 1;
+                stackEntry[top++] = rightEntry;
+            }
+        }
+
+        return hit;
+    }
+
+}
+
+#endif
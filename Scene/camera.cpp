@@ -1,3 +1,4 @@
+#include "Math/mathdefs.h"
 #include "Math/vector3.h"
 #include "Math/matrix3.h"
 #include "Math/matrix4.h"
@@ -159,6 +160,28 @@ namespace GLDemo
     }
 
 
+    /**
+     * \param x            Horizontal position on the view, from -1 at the left edge to 1
+     *                     at the right.
+     * \param y            Vertical position on the view, from -1 at the bottom edge to 1
+     *                     at the top.
+     * \param aspectRatio  The width of the view divided by its height.
+     * \return The ray in world space from the eye through the given point of the view,
+     *         with a direction one unit long in the camera's coordinate frame.
+     */
+    Ray Camera::getRay(float x, float y, float aspectRatio) const
+    {
+        const float tanHalfFov = Math<float>::Tan(m_fov * Math<float>::PI / 360.0f);
+        const Vector3f local(x * tanHalfFov * aspectRatio, y * tanHalfFov, -1.0f);
+
+        const Transformation& world = getWorldTransformation();
+        Vector3f origin = world.apply(Vector3f(0.0f, 0.0f, 0.0f));
+        Vector3f direction = world.apply(local) - origin;
+        direction.normalize();
+        return Ray(origin, direction);
+    }
+
+
     /**
      * \return A new copy of this camera object.
      */
@@ -3,6 +3,7 @@
 
 #include "Math/vector3.h"
 #include "Math/matrix4.h"
+#include "ray.h"
 #include "spatialentity.h"
 
 namespace GLDemo
@@ -34,6 +35,8 @@ namespace GLDemo
       const Vector3f& getLookAt() const;
       void toViewMatrix(Matrix4f& view) const;
 
+      Ray getRay(float x, float y, float aspectRatio) const;
+
       virtual Camera* clone() const;
 
   private:
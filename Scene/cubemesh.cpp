@@ -13,6 +13,7 @@ namespace GLDemo
     {
         createVertices();
         createIndices();
+        updateBound();
     }
 
 
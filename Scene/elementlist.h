@@ -6,12 +6,18 @@
 
 #include <QGLFunctions>
 
+#include "meshcluster.h"
+
 namespace GLDemo
 {
 
     /**
      * \brief Represents a collection of primitives of a particular type. Multiple
      *        primitive collections make up a mesh.
+     *
+     * A TRI_STRIP list may hold several strips, separated by RESTART_INDEX. A TRI_LIST
+     * may also be divided into clusters that can be culled separately; see
+     * MeshCluster::buildClusters(). Changing the indices of such a list invalidates them.
      */
     class ElementList
     {
@@ -20,9 +26,16 @@ namespace GLDemo
         {
             POINTS      = GL_POINTS,
             LINE_LIST   = GL_LINES,
-            TRI_LIST    = GL_TRIANGLES
+            TRI_LIST    = GL_TRIANGLES,
+            TRI_STRIP   = GL_TRIANGLE_STRIP
         };
 
+        /**
+         * Index value that ends the current strip and starts a new one. This is the
+         * fixed restart index OpenGL uses for unsigned int indices.
+         */
+        static const unsigned RESTART_INDEX = 0xFFFFFFFFu;
+
 
         /**
          * \param type The type of element list to create.
@@ -31,7 +44,8 @@ namespace GLDemo
          */
         ElementList(ElementType type) :
             m_indices(),
-            m_primitiveType(type)
+            m_primitiveType(type),
+            m_clusters()
         {
         }
 
@@ -43,7 +57,8 @@ namespace GLDemo
          * Creates a new element list of the specified type from the input array.
          */
         ElementList(const std::vector<int>& indices, ElementType pType) :
-            m_primitiveType(pType)
+            m_primitiveType(pType),
+            m_clusters()
         {
             m_indices.resize(indices.size());
             std::copy(indices.begin(), indices.end(), m_indices.begin());
@@ -55,18 +70,67 @@ namespace GLDemo
          */
         ElementList(const ElementList& pCol) :
             m_indices(pCol.m_indices),
-            m_primitiveType(pCol.m_primitiveType)
+            m_primitiveType(pCol.m_primitiveType),
+            m_clusters(pCol.m_clusters)
         {
         }
 
-        std::vector<unsigned>& getIndices() { return m_indices; }
+        std::vector<unsigned>&       getIndices()       { return m_indices; }
+        const std::vector<unsigned>& getIndices() const { return m_indices; }
 
         ElementType  getElementType() const    { return m_primitiveType; }
         void setElementType(ElementType pType) { m_primitiveType = pType; }
 
+        MeshClusterList&       getClusters()       { return m_clusters; }
+        const MeshClusterList& getClusters() const { return m_clusters; }
+
+
+        /**
+         * \param corners  Array to append three vertex indices to for each triangle.
+         *
+         * Appends the triangles of a list or strip, wound as they would be drawn, leaving
+         * out those with repeated corners. Does nothing for other types of list.
+         */
+        void appendTriangles(std::vector<unsigned>& corners) const
+        {
+            if (m_primitiveType == TRI_LIST)
+            {
+                for (size_t i = 0; i + 2 < m_indices.size(); i += 3)
+                {
+                    corners.push_back(m_indices[i]);
+                    corners.push_back(m_indices[i + 1]);
+                    corners.push_back(m_indices[i + 2]);
+                }
+                return;
+            }
+            if (m_primitiveType != TRI_STRIP)
+            {
+                return;
+            }
+
+            size_t stripStart = 0;
+            for (size_t i = 0; i < m_indices.size(); ++i)
+            {
+                if (m_indices[i] == RESTART_INDEX)
+                {
+                    stripStart = i + 1;
+                }
+                else if (i >= stripStart + 2 && m_indices[i - 1] != RESTART_INDEX &&
+                         m_indices[i] != m_indices[i - 1] && m_indices[i] != m_indices[i - 2] && m_indices[i - 1] != m_indices[i - 2])
+                {
+                    // Every other triangle of a strip is wound the other way.
+                    bool even = (i - stripStart) % 2 == 0;
+                    corners.push_back(m_indices[even ? i - 2 : i - 1]);
+                    corners.push_back(m_indices[even ? i - 1 : i - 2]);
+                    corners.push_back(m_indices[i]);
+                }
+            }
+        }
+
     private:
         std::vector<unsigned> m_indices;
         ElementType           m_primitiveType;
+        MeshClusterList       m_clusters;
     };
 
 }
@@ -0,0 +1,335 @@
+#include <algorithm>
+#include <cmath>
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include "frameloop.h"
+#include "scene.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        /**
+         * \internal Sets \a out part way between two world transformations, blending them
+         *           the way the Animator blends keys.
+         */
+        void blendTransformations(const Transformation& from, const Transformation& to, float blend, Transformation& out)
+        {
+            const WorldVector3& t0 = from.getPreciseTranslation();
+            const Vector3f& s0 = from.getScale();
+            const Vector3f scale = s0 + (to.getScale() - s0) * blend;
+
+            out.setTranslation(t0 + (to.getPreciseTranslation() - t0) * blend);
+            out.setRotation(Quaternionf::nlerp(from.getRotationQuaternion(), to.getRotationQuaternion(), blend));
+            if (scale.x() == scale.y() && scale.y() == scale.z())
+            {
+                out.setUniformScale(scale.x());
+            }
+            else
+            {
+                out.setScale(scale);
+            }
+        }
+    }
+
+
+    /**
+     * \internal Simulates the ticks handed to the worker.
+     */
+    class FrameLoop::TickTask : public QRunnable
+    {
+    public:
+        TickTask(FrameLoop& loop) :
+            m_loop(loop)
+        {
+        }
+
+        virtual void run()
+        {
+            m_loop.simulateTicks();
+            m_loop.m_ticksDone.release();
+        }
+
+    private:
+        FrameLoop& m_loop;
+    };
+
+
+    /**
+     * \param scene  The scene to simulate. It must outlive the loop.
+     */
+    FrameLoop::FrameLoop(Scene& scene) :
+        m_scene(scene),
+        m_timeStep(1.0 / 60.0),
+        m_startTime(0.0),
+        m_lastTime(0.0),
+        m_shownTime(0.0),
+        m_blend(1.0f),
+        m_started(false),
+        m_numLateTicks(0),
+        m_mutex(),
+        m_front(),
+        m_frontPrevious(),
+        m_hasFront(false),
+        m_back(),
+        m_nextTick(0),
+        m_lastTick(-1),
+        m_previous(),
+        m_latest(),
+        m_ticksDone(0),
+        m_inFlight(false)
+    {
+    }
+
+
+    /**
+     * Waits for any ticks still being simulated, as they write to the scene.
+     */
+    FrameLoop::~FrameLoop()
+    {
+        wait();
+    }
+
+
+    /**
+     * \param seconds  The time between ticks. The loop starts again from the next call
+     *                 to advance().
+     */
+    void FrameLoop::setTimeStep(double seconds)
+    {
+        wait();
+        m_timeStep = seconds;
+        m_started = false;
+        forgetTicks();
+    }
+
+
+    /**
+     * \param time  The current time, in seconds, on the clock that the tracks of the
+     *              animator were started on. Should not go backwards. The first call sets
+     *              the time of tick zero.
+     *
+     * Sets the world data of the scene for a frame about to be drawn, from the ticks the
+     * worker has simulated so far, then hands it the ticks the next frame will need.
+     */
+    void FrameLoop::advance(double time)
+    {
+        if (m_inFlight && m_ticksDone.tryAcquire())
+        {
+            m_inFlight = false;
+        }
+        if (!m_started)
+        {
+            m_startTime = time;
+            m_lastTime = time;
+            m_nextTick = 0;
+            m_started = true;
+        }
+
+        takeTicks();
+        if (!isCurrent(m_latest))
+        {
+            // With nothing to show, the frame has to wait for the ticks around the time it
+            // shows. It simulates them itself, rather than carry on after the ticks thrown
+            // away, which may be ahead of the clock.
+            wait();
+            takeTicks();
+            if (!isCurrent(m_latest))
+            {
+                const double shownTime = std::max(m_startTime, time - m_timeStep);
+                const qint64 tick = getTickAt(shownTime);
+                simulate(tick, m_latest);
+                ++m_numLateTicks;
+                if (getTickTime(tick) < shownTime)
+                {
+                    std::swap(m_previous, m_latest);
+                    simulate(tick + 1, m_latest);
+                    ++m_numLateTicks;
+                }
+                m_nextTick = m_latest.m_tick + 1;
+            }
+        }
+        showTicks(time);
+
+        // Assume the next frame comes as long after this one as this one did after the last.
+        const qint64 last = getTickAt(2.0 * time - m_lastTime);
+        m_lastTime = time;
+        if (!m_inFlight && last >= m_nextTick)
+        {
+            m_nextTick = std::max(m_nextTick, last - s_maxTicksPerTask + 1);
+            m_lastTick = last;
+            m_inFlight = true;
+            QThreadPool::globalInstance()->start(new TickTask(*this));
+        }
+    }
+
+
+    /**
+     * Blocks until the ticks handed to the worker are done. Must be called before the
+     * scene is changed by anything but the loop itself.
+     */
+    void FrameLoop::wait()
+    {
+        if (m_inFlight)
+        {
+            m_ticksDone.acquire();
+            m_inFlight = false;
+        }
+    }
+
+
+    /**
+     * Waits for the worker, like wait(), and throws away the ticks it has simulated, so
+     * that the next advance() simulates the scene as it is then. Call before a change that
+     * should show up in the next frame, such as moving a camera in the scene graph.
+     */
+    void FrameLoop::invalidate()
+    {
+        wait();
+        forgetTicks();
+    }
+
+
+    /**
+     * \internal The tick at or before a time; never before tick zero.
+     */
+    qint64 FrameLoop::getTickAt(double time) const
+    {
+        return std::max<qint64>(0, static_cast<qint64>(std::floor((time - m_startTime) / m_timeStep)));
+    }
+
+
+    /**
+     * \internal Whether a state holds a tick simulated since the shape of the scene last
+     *           changed, and so has an entry for every entity, and none that are gone.
+     */
+    bool FrameLoop::isCurrent(const WorldState& state) const
+    {
+        return state.m_tick >= 0 && state.m_generation == m_scene.getIndex().getGeneration();
+    }
+
+
+    /**
+     * \internal Plays the animator and runs the controllers at the time of a tick, and
+     *           works out the world transformations of the scene into \a state.
+     */
+    void FrameLoop::simulate(qint64 tick, WorldState& state)
+    {
+        const double time = getTickTime(tick);
+        m_scene.getAnimator().update(time);
+        m_scene.getRootNode().simulate(time, state);
+        state.m_tick = tick;
+        state.m_generation = m_scene.getIndex().getGeneration();
+    }
+
+
+    /**
+     * \internal Runs on the worker thread, publishing each tick as soon as it is done.
+     */
+    void FrameLoop::simulateTicks()
+    {
+        for (qint64 tick = m_nextTick; tick <= m_lastTick; ++tick)
+        {
+            simulate(tick, m_back);
+            publish();
+        }
+        m_nextTick = m_lastTick + 1;
+    }
+
+
+    /**
+     * \internal Swaps the tick just simulated into the front buffer.
+     */
+    void FrameLoop::publish()
+    {
+        QMutexLocker locker(&m_mutex);
+        std::swap(m_frontPrevious, m_front);
+        std::swap(m_front, m_back);
+        m_hasFront = true;
+    }
+
+
+    /**
+     * \internal Swaps the latest ticks published, if there are any new ones, out of the
+     *           front buffer.
+     */
+    void FrameLoop::takeTicks()
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_hasFront)
+        {
+            return;
+        }
+
+        // The tick before the latest was published with it if the worker simulated both
+        // since the last frame; otherwise it is the latest this thread already had.
+        if (m_frontPrevious.m_tick == m_front.m_tick - 1 && m_frontPrevious.m_tick > m_latest.m_tick)
+        {
+            std::swap(m_previous, m_frontPrevious);
+        }
+        else
+        {
+            std::swap(m_previous, m_latest);
+        }
+        std::swap(m_latest, m_front);
+        m_hasFront = false;
+    }
+
+
+    /**
+     * \internal Sets the world data of the scene to the time one step behind \a time,
+     *           blended between the ticks either side of it. Frames can't go past the
+     *           latest tick, as what comes after it isn't known yet.
+     */
+    void FrameLoop::showTicks(double time)
+    {
+        const double latestTime = getTickTime(m_latest.m_tick);
+        m_shownTime = std::max(m_startTime, time - m_timeStep);
+        if (isCurrent(m_previous) && m_previous.m_tick < m_latest.m_tick && m_shownTime < latestTime)
+        {
+            const double previousTime = getTickTime(m_previous.m_tick);
+            m_shownTime = std::max(m_shownTime, previousTime);
+            m_blend = static_cast<float>((m_shownTime - previousTime) / (latestTime - previousTime));
+        }
+        else
+        {
+            m_shownTime = latestTime;
+            m_blend = 1.0f;
+        }
+
+        // Children come after their parents, so going backwards updates the bound of each
+        // entity after those of everything below it.
+        for (int i = static_cast<int>(m_latest.m_entities.size()) - 1; i >= 0; --i)
+        {
+            SpatialEntity& entity = *m_latest.m_entities[i];
+            if (m_blend < 1.0f)
+            {
+                blendTransformations(m_previous.m_worlds[i], m_latest.m_worlds[i], m_blend, entity.getWorldTransformation());
+            }
+            else
+            {
+                entity.setWorldTransformation(m_latest.m_worlds[i]);
+            }
+            entity.updateWorldBound();
+        }
+    }
+
+
+    /**
+     * \internal Throws away every tick simulated, so that the next advance() simulates
+     *           one of its own. The worker must not be running.
+     */
+    void FrameLoop::forgetTicks()
+    {
+        QMutexLocker locker(&m_mutex);
+        m_front.m_tick = -1;
+        m_frontPrevious.m_tick = -1;
+        m_hasFront = false;
+        m_previous.m_tick = -1;
+        m_latest.m_tick = -1;
+    }
+
+}
@@ -0,0 +1,107 @@
+#ifndef GLDEMO_FRAMELOOP_H
+#define GLDEMO_FRAMELOOP_H
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QtGlobal>
+
+#include "worldstate.h"
+
+namespace GLDemo
+{
+    class Scene;
+
+    /**
+     * \brief Simulates a scene at a fixed rate on a worker thread, and shows it smoothly at
+     *        whatever rate frames are drawn.
+     *
+     * Each tick, a fixed time step apart, plays the scene's animator and runs the
+     * controllers of its entities on a thread of the global thread pool. It then works out
+     * the world transformation of every entity into a back buffer, and swaps it with the
+     * front buffer under a lock. The world data of the entities themselves is only written
+     * by the thread that calls advance(), and so draws the scene.
+     *
+     * advance() is called once for each frame drawn. It swaps the latest ticks out of the
+     * front buffer under the same lock, blends the two around the time shown, one step
+     * behind the time passed in, and sets the world transformations and bounds of the
+     * entities from them. It then hands the ticks the next frame will need to the worker,
+     * which simulates them while the frame is drawn. A frame never waits for a tick unless
+     * there is nothing current to show at all, as on the first frame, or when the shape of
+     * the scene has changed.
+     *
+     * While a tick is running, the worker owns the local transformations, the controllers
+     * and the animator of the scene, and controllers must touch nothing else. The thread
+     * that draws the scene can read world data, draw and pick freely, but must call
+     * wait() before changing the scene in any other way, including adding and removing
+     * entities and playing tracks. invalidate() also throws away the ticks simulated
+     * before the change, so that it shows up in the next frame. The frame after a change
+     * simulates the tick it shows itself, so controllers may see the times of the ticks
+     * thrown away again.
+     */
+    class FrameLoop
+    {
+    public:
+        FrameLoop(Scene& scene);
+        ~FrameLoop();
+
+        void   setTimeStep(double seconds);
+        double getTimeStep() const          { return m_timeStep; }
+
+        void advance(double time);
+        void wait();
+        void invalidate();
+
+        double getShownTime() const         { return m_shownTime; }
+        float  getBlend() const             { return m_blend; }
+        int    getNumLateTicks() const      { return m_numLateTicks; }   // Simulated by advance() itself
+
+    private:
+        class TickTask;
+        friend class TickTask;
+
+        FrameLoop(const FrameLoop&);
+        FrameLoop& operator=(const FrameLoop&);
+
+        double getTickTime(qint64 tick) const { return m_startTime + tick * m_timeStep; }
+        qint64 getTickAt(double time) const;
+        bool   isCurrent(const WorldState& state) const;
+        void   simulate(qint64 tick, WorldState& state);
+        void   simulateTicks();
+        void   publish();
+        void   takeTicks();
+        void   showTicks(double time);
+        void   forgetTicks();
+
+        Scene&     m_scene;
+        double     m_timeStep;
+        double     m_startTime;         // Of tick zero
+        double     m_lastTime;          // Passed to the last advance()
+        double     m_shownTime;
+        float      m_blend;
+        bool       m_started;
+        int        m_numLateTicks;
+
+        // Handed from the worker to advance() under the lock
+        QMutex     m_mutex;
+        WorldState m_front;             // The latest tick simulated
+        WorldState m_frontPrevious;     // The tick simulated before it
+        bool       m_hasFront;          // Until advance() takes them
+
+        // Belong to the worker while ticks are in flight
+        WorldState m_back;
+        qint64     m_nextTick;          // The first tick not yet simulated
+        qint64     m_lastTick;          // The last tick handed to the worker
+
+        // Belong to the thread calling advance()
+        WorldState m_previous;
+        WorldState m_latest;
+        QSemaphore m_ticksDone;
+        bool       m_inFlight;
+
+        // The most ticks handed to the worker at once; after a pause, older ones are skipped.
+        static const int s_maxTicksPerTask = 8;
+    };
+
+}
+
+#endif
@@ -1,3 +1,6 @@
+#include <cassert>
+
+#include "Math/vector3soa.h"
 #include "mesh.h"
 
 namespace GLDemo
@@ -9,22 +12,29 @@ namespace GLDemo
      *
      * Creates a new instance of a mesh with the specified unique name.
      */
-    Mesh::Mesh(const QString& name) :
+    Mesh::Mesh(const Name& name) :
         Object(name),
         m_vertices(),
-        m_elements()
+        m_elements(),
+        m_bound(),
+        m_lods(),
+        m_bvh()
     {
     }
 
 
     /**
      * Creates a copy of the mesh. This will perform a deep copy of the data, including
-     * all vertices and elements.
+     * all vertices and elements. Levels of detail, and the triangle hierarchy if it has
+     * been built, are shared with the original.
      */
     Mesh::Mesh(const Mesh& mesh) :
         Object(mesh),
         m_vertices(mesh.m_vertices),
-        m_elements()
+        m_elements(),
+        m_bound(mesh.m_bound),
+        m_lods(mesh.m_lods),
+        m_bvh(mesh.m_bvh)
     {
         const std::list<ElementList>& meshElems = mesh.m_elements;
         for (std::list<ElementList>::const_iterator eIter = meshElems.begin(); eIter != meshElems.end(); ++eIter)
@@ -41,4 +51,51 @@ namespace GLDemo
     {
     }
 
+
+    /**
+     * Recomputes the bound of the mesh from its vertices. Must be called whenever the
+     * vertices or elements are changed, since it also discards the triangle hierarchy,
+     * which is rebuilt the next time it is needed.
+     */
+    void Mesh::updateBound()
+    {
+        m_bvh.clear();
+
+        const int numVertices = static_cast<int>(m_vertices.size());
+        Vector3SoA positions;
+        positions.gather(numVertices > 0 ? &m_vertices[0].m_position : 0, numVertices, sizeof(Vertex));
+
+        m_bound.setEmpty();
+        m_bound.extend(positions);
+    }
+
+
+    /**
+     * \return A hierarchy over the triangles of the mesh, for tracing rays against it.
+     *
+     * The hierarchy is built the first time it is asked for, and kept until updateBound()
+     * is next called. Building it is not thread safe.
+     */
+    const MeshBvh& Mesh::getBvh() const
+    {
+        if (m_bvh.isNull())
+        {
+            m_bvh = QSharedPointer<MeshBvh>(new MeshBvh(*this));
+        }
+        return *m_bvh;
+    }
+
+
+    /**
+     * \param mesh   A simplified version of this mesh, coarser than the last level added.
+     *               Its name must be unique, as with any other mesh.
+     * \param error  The furthest the simplified surface lies from this one, in the units
+     *               of the mesh. Must not be less than the error of the last level added.
+     */
+    void Mesh::addLod(const PtrMesh& mesh, float error)
+    {
+        assert(!mesh.isNull() && error >= getLodError(getNumLods() - 1));
+        m_lods.push_back(Lod(mesh, error));
+    }
+
 }
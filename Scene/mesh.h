@@ -7,26 +7,51 @@
 #include <QString>
 #include <QSharedPointer>
 
+#include "boundingbox.h"
 #include "object.h"
 #include "vertex.h"
 #include "elementlist.h"
+#include "meshbvh.h"
 
 namespace GLDemo
 {
 
+    class Mesh;
+    typedef QSharedPointer<Mesh> PtrMesh;
+
     /**
      * \brief Represents a mesh dataset containing vertices and elements that connect them.
+     *
+     * A mesh may also hold a chain of simplified versions of itself for drawing at a
+     * distance, such as those generated by MeshSimplifier. Level 0 is always the mesh
+     * itself, and each further level is coarser than the one before it.
      */
     class Mesh : public Object
     {
     public:
-        Mesh(const QString& name);
+        Mesh(const Name& name);
         Mesh(const Mesh& mesh);
         ~Mesh();
 
         std::vector<Vertex>&     getVertices()     { return m_vertices; }
         std::list<ElementList>&  getElementLists() { return m_elements; }
 
+        const std::vector<Vertex>&     getVertices() const     { return m_vertices; }
+        const std::list<ElementList>&  getElementLists() const { return m_elements; }
+
+        const BoundingBox& getBound() const { return m_bound; }
+        void updateBound();
+
+        const MeshBvh& getBvh() const;
+
+        void addLod(const PtrMesh& mesh, float error);
+        void clearLods() { m_lods.clear(); }
+
+        int   getNumLods() const            { return static_cast<int>(m_lods.size()) + 1; }
+        Mesh& getLod(int level)             { return level == 0 ? *this : *m_lods[level - 1].m_mesh; }
+        const Mesh& getLod(int level) const { return level == 0 ? *this : *m_lods[level - 1].m_mesh; }
+        float getLodError(int level) const  { return level == 0 ? 0.0f : m_lods[level - 1].m_error; }
+
         /**
          * \param type The type of element list to add
          * \return A reference to the newly created element list.
@@ -38,11 +63,31 @@ namespace GLDemo
         }
 
     protected:
+        /**
+         * \internal A simplified version of the mesh, and how far its surface may lie from
+         *           that of the full mesh, in the mesh's own units.
+         */
+        class Lod
+        {
+        public:
+            Lod(const PtrMesh& mesh, float error) :
+                m_mesh(mesh),
+                m_error(error)
+            {
+            }
+
+            PtrMesh m_mesh;
+            float   m_error;
+        };
+
         std::vector<Vertex>    m_vertices;
         std::list<ElementList> m_elements;
-    };
+        BoundingBox            m_bound;
+        std::vector<Lod>       m_lods;
 
-    typedef QSharedPointer<Mesh> PtrMesh;
+    private:
+        mutable QSharedPointer<MeshBvh> m_bvh;   // Built on first use
+    };
 
 }
 
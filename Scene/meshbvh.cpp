@@ -0,0 +1,118 @@
+#include "mesh.h"
+#include "meshbvh.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        /**
+         * \internal Traces a ray against the triangles of a MeshBvh, keeping the nearest.
+         *
+         * Triangles are hit from either side, since a pick should find whatever is under
+         * the cursor even if it faces away.
+         */
+        class TriangleIntersector
+        {
+        public:
+            TriangleIntersector(const std::vector<Vector3f>& positions) :
+                m_positions(positions),
+                m_triangle(-1)
+            {
+            }
+
+            bool operator()(int triangle, const Ray& ray, float& distance)
+            {
+                const Vector3f& p0 = m_positions[triangle * 3];
+                Vector3f edge1 = m_positions[triangle * 3 + 1] - p0;
+                Vector3f edge2 = m_positions[triangle * 3 + 2] - p0;
+
+                Vector3f p = ray.m_direction.cross(edge2);
+                float determinant = edge1.dot(p);
+                if (determinant == 0.0f)
+                {
+                    return false;
+                }
+
+                float invDeterminant = 1.0f / determinant;
+                Vector3f s = ray.m_origin - p0;
+                float u = s.dot(p) * invDeterminant;
+                if (u < 0.0f || u > 1.0f)
+                {
+                    return false;
+                }
+
+                Vector3f q = s.cross(edge1);
+                float v = ray.m_direction.dot(q) * invDeterminant;
+                if (v < 0.0f || u + v > 1.0f)
+                {
+                    return false;
+                }
+
+                float t = edge2.dot(q) * invDeterminant;
+                if (t < 0.0f || t >= distance)
+                {
+                    return false;
+                }
+
+                distance = t;
+                m_triangle = triangle;
+                return true;
+            }
+
+            int getTriangle() const { return m_triangle; }
+
+        private:
+            const std::vector<Vector3f>& m_positions;
+            int m_triangle;
+        };
+    }
+
+
+    /**
+     * \param mesh  The mesh whose triangle lists and strips to build the hierarchy over.
+     *              The hierarchy does not refer back to it.
+     */
+    MeshBvh::MeshBvh(const Mesh& mesh) :
+        m_positions(),
+        m_corners(),
+        m_bvh()
+    {
+        const std::list<ElementList>& elementLists = mesh.getElementLists();
+        for (std::list<ElementList>::const_iterator eIter = elementLists.begin(); eIter != elementLists.end(); ++eIter)
+        {
+            eIter->appendTriangles(m_corners);
+        }
+
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+        std::vector<BoundingBox> bounds(getNumTriangles());
+        m_positions.reserve(m_corners.size());
+        for (size_t i = 0; i < m_corners.size(); ++i)
+        {
+            m_positions.push_back(vertices[m_corners[i]].m_position);
+            bounds[i / 3].extend(m_positions.back());
+        }
+
+        m_bvh.build(bounds);
+    }
+
+
+    /**
+     * \param ray       The ray to trace, in the space of the mesh.
+     * \param distance  On entry, how far along the ray to look. On return, the distance to
+     *                  the nearest hit, if there was one.
+     * \param triangle  Set to the triangle hit, if there was one.
+     * \return True if the ray hits a triangle within \a distance.
+     */
+    bool MeshBvh::intersect(const Ray& ray, float& distance, int& triangle) const
+    {
+        TriangleIntersector intersector(m_positions);
+        if (!m_bvh.intersect(ray, distance, intersector))
+        {
+            return false;
+        }
+
+        triangle = intersector.getTriangle();
+        return true;
+    }
+
+}
@@ -0,0 +1,39 @@
+#ifndef GLDEMO_MESHBVH_H
+#define GLDEMO_MESHBVH_H
+
+#include <vector>
+
+#include "bvh.h"
+#include "ray.h"
+
+namespace GLDemo
+{
+    class Mesh;
+
+    /**
+     * \brief A bounding volume hierarchy over the triangles of a mesh, for tracing rays
+     *        against it in the mesh's own space.
+     *
+     * Triangles are numbered in the order they are found in the mesh's triangle lists and
+     * strips. Use Mesh::getBvh() rather than building one directly, so that it is shared by
+     * every instance of the mesh.
+     */
+    class MeshBvh
+    {
+    public:
+        MeshBvh(const Mesh& mesh);
+
+        int getNumTriangles() const { return static_cast<int>(m_corners.size() / 3); }
+        const unsigned* getTriangle(int triangle) const { return &m_corners[triangle * 3]; }
+
+        bool intersect(const Ray& ray, float& distance, int& triangle) const;
+
+    private:
+        std::vector<Vector3f> m_positions;  // The corners of each triangle in turn
+        std::vector<unsigned> m_corners;    // The vertex index of each corner
+        Bvh                   m_bvh;
+    };
+
+}
+
+#endif
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <map>
+
+#include "Math/mathdefs.h"
+#include "mesh.h"
+#include "meshcluster.h"
+
+namespace GLDemo
+{
+    /**
+     * Creates an empty cluster.
+     */
+    MeshCluster::MeshCluster() :
+        m_firstIndex(0),
+        m_numIndices(0),
+        m_bound(),
+        m_coneAxis(),
+        m_coneAngle(Math<float>::PI)
+    {
+    }
+
+
+    /**
+     * \param eye  The point the cluster is viewed from, in the space of the mesh.
+     * \return True if every triangle of the cluster faces away from the eye, wherever in
+     *         the cluster's bound the triangle lies.
+     *
+     * The direction from the eye to any point of the bound is within the angle the bound
+     * subtends of the direction to its centre, and each normal is within the cone's angle
+     * of its axis. If those angles, along with the angle between the axis and the
+     * direction to the centre, add up to less than a right angle, no triangle can face
+     * the eye.
+     */
+    bool MeshCluster::isBackFacing(const Vector3f& eye) const
+    {
+        if (m_coneAngle >= Math<float>::HALF_PI || m_bound.isEmpty())
+        {
+            return false;
+        }
+
+        Vector3f toCenter = m_bound.getCenter() - eye;
+        float radius = m_bound.getExtents().length();
+        float distance = toCenter.length();
+        if (distance <= radius)
+        {
+            return false;
+        }
+
+        float cosViewAngle = std::min(std::max(toCenter.dot(m_coneAxis) / distance, -1.0f), 1.0f);
+        float viewAngle = Math<float>::ACos(cosViewAngle);
+        float boundAngle = Math<float>::ASin(radius / distance);
+        return viewAngle + m_coneAngle + boundAngle < Math<float>::HALF_PI;
+    }
+
+
+    /**
+     * \param mesh          The mesh to partition.
+     * \param maxTriangles  The most triangles to put in a cluster.
+     *
+     * Replaces all the triangle lists and strips of the mesh with a single triangle list,
+     * ordered cluster by cluster. Other element lists are left as they are. Clusters are
+     * grown from a seed triangle across shared vertex positions, taking the neighbour
+     * whose normal best matches the cluster's and that lies nearest its centre, so that
+     * clusters are both compact and as flat as the surface allows.
+     */
+    void MeshCluster::buildClusters(Mesh& mesh, int maxTriangles)
+    {
+        std::vector<unsigned> corners;
+        std::list<ElementList>& elementLists = mesh.getElementLists();
+        std::list<ElementList>::iterator eIter = elementLists.begin();
+        while (eIter != elementLists.end())
+        {
+            if (eIter->getElementType() == ElementList::TRI_LIST || eIter->getElementType() == ElementList::TRI_STRIP)
+            {
+                eIter->appendTriangles(corners);
+                eIter = elementLists.erase(eIter);
+            }
+            else
+            {
+                ++eIter;
+            }
+        }
+
+        const std::vector<Vertex>& vertices = mesh.getVertices();
+        const int numTriangles = static_cast<int>(corners.size() / 3);
+        if (numTriangles == 0)
+        {
+            return;
+        }
+
+        // Triangles are neighbours if they share a vertex position, even if not a vertex.
+        typedef std::map<Vector3f, int> PointMap;
+        PointMap pointMap;
+        std::vector<int> pointOf(vertices.size(), -1);
+        std::vector<std::vector<int> > pointTriangles;
+        std::vector<Vector3f> normals(numTriangles);
+        std::vector<Vector3f> centroids(numTriangles);
+        for (int t = 0; t < numTriangles; ++t)
+        {
+            const Vector3f* p[3];
+            for (int i = 0; i < 3; ++i)
+            {
+                unsigned vertex = corners[t * 3 + i];
+                if (pointOf[vertex] < 0)
+                {
+                    PointMap::iterator pIter = pointMap.find(vertices[vertex].m_position);
+                    if (pIter == pointMap.end())
+                    {
+                        pIter = pointMap.insert(std::make_pair(vertices[vertex].m_position, static_cast<int>(pointTriangles.size()))).first;
+                        pointTriangles.push_back(std::vector<int>());
+                    }
+                    pointOf[vertex] = pIter->second;
+                }
+                pointTriangles[pointOf[vertex]].push_back(t);
+                p[i] = &vertices[vertex].m_position;
+            }
+
+            normals[t] = (*p[1] - *p[0]).cross(*p[2] - *p[0]);
+            normals[t].normalize();
+            centroids[t] = (*p[0] + *p[1] + *p[2]) / 3.0f;
+        }
+
+        std::vector<unsigned>& indices = mesh.addElementList(ElementList::TRI_LIST).getIndices();
+        MeshClusterList& clusters = elementLists.front().getClusters();
+        indices.reserve(corners.size());
+
+        std::vector<bool> assigned(numTriangles, false);
+        std::vector<int> frontierOf(numTriangles, -1);
+        std::vector<int> frontier;
+        int nextSeed = 0;
+        while (true)
+        {
+            // Carry on from where the last cluster left off, so neighbouring clusters are
+            // also near each other in the index buffer.
+            int seed = -1;
+            for (std::vector<int>::const_iterator fIter = frontier.begin(); seed < 0 && fIter != frontier.end(); ++fIter)
+            {
+                seed = assigned[*fIter] ? -1 : *fIter;
+            }
+            while (seed < 0 && nextSeed < numTriangles)
+            {
+                seed = assigned[nextSeed] ? -1 : nextSeed;
+                ++nextSeed;
+            }
+            if (seed < 0)
+            {
+                break;
+            }
+
+            const int clusterIndex = static_cast<int>(clusters.size());
+            MeshCluster cluster;
+            cluster.m_firstIndex = static_cast<unsigned>(indices.size());
+
+            Vector3f normalSum;
+            Vector3f centroidSum;
+            std::vector<int> members;
+            frontier.clear();
+            frontier.push_back(seed);
+            while (static_cast<int>(members.size()) < maxTriangles && !frontier.empty())
+            {
+                // Pick the best of the untaken neighbours of the cluster.
+                Vector3f axis = normalSum;
+                axis.normalize();
+                Vector3f center = members.empty() ? centroids[seed] : centroidSum / static_cast<float>(members.size());
+                float scale = std::max(cluster.m_bound.isEmpty() ? 0.0f : cluster.m_bound.getExtents().length(), Math<float>::Epsilon());
+
+                int best = -1;
+                float bestScore = 0.0f;
+                for (size_t i = 0; i < frontier.size(); ++i)
+                {
+                    int t = frontier[i];
+                    if (assigned[t])
+                    {
+                        continue;
+                    }
+
+                    float score = normals[t].dot(axis) - (centroids[t] - center).length() / scale;
+                    if (best < 0 || score > bestScore)
+                    {
+                        best = static_cast<int>(i);
+                        bestScore = score;
+                    }
+                }
+                if (best < 0)
+                {
+                    break;
+                }
+
+                int t = frontier[best];
+                frontier[best] = frontier.back();
+                frontier.pop_back();
+
+                assigned[t] = true;
+                members.push_back(t);
+                normalSum += normals[t];
+                centroidSum += centroids[t];
+                for (int i = 0; i < 3; ++i)
+                {
+                    unsigned vertex = corners[t * 3 + i];
+                    indices.push_back(vertex);
+                    cluster.m_bound.extend(vertices[vertex].m_position);
+
+                    const std::vector<int>& neighbours = pointTriangles[pointOf[vertex]];
+                    for (std::vector<int>::const_iterator nIter = neighbours.begin(); nIter != neighbours.end(); ++nIter)
+                    {
+                        if (!assigned[*nIter] && frontierOf[*nIter] != clusterIndex)
+                        {
+                            frontierOf[*nIter] = clusterIndex;
+                            frontier.push_back(*nIter);
+                        }
+                    }
+                }
+            }
+
+            cluster.m_numIndices = static_cast<unsigned>(indices.size()) - cluster.m_firstIndex;
+
+            // The cone is only useful if every normal is within a right angle of its axis.
+            cluster.m_coneAxis = normalSum;
+            if (cluster.m_coneAxis.normalize() > 0.0f)
+            {
+                float minCosine = 1.0f;
+                for (std::vector<int>::const_iterator mIter = members.begin(); mIter != members.end(); ++mIter)
+                {
+                    if (normals[*mIter].squaredLength() > 0.0f)
+                    {
+                        minCosine = std::min(minCosine, normals[*mIter].dot(cluster.m_coneAxis));
+                    }
+                }
+                cluster.m_coneAngle = Math<float>::ACos(std::min(std::max(minCosine, -1.0f), 1.0f));
+            }
+
+            clusters.push_back(cluster);
+        }
+
+        // Triangles have been renumbered, so anything derived from them is out of date.
+        mesh.updateBound();
+    }
+
+}
@@ -0,0 +1,49 @@
+#ifndef GLDEMO_MESHCLUSTER_H
+#define GLDEMO_MESHCLUSTER_H
+
+#include <vector>
+
+#include "Math/vector3.h"
+#include "boundingbox.h"
+
+namespace GLDemo
+{
+    class Mesh;
+
+    /**
+     * \brief A small, contiguous run of the triangles of a triangle list, with what is
+     *        needed to cull it on its own: a bound, and a cone containing the normals of
+     *        all its triangles.
+     *
+     * Clusters are made by buildClusters(), which also orders the triangles so that each
+     * cluster's are next to each other. They are stored with their ElementList.
+     */
+    class MeshCluster
+    {
+    public:
+        MeshCluster();
+
+        unsigned getFirstIndex() const { return m_firstIndex; }
+        unsigned getNumIndices() const { return m_numIndices; }
+
+        const BoundingBox& getBound() const { return m_bound; }
+        const Vector3f& getConeAxis() const { return m_coneAxis; }
+        float getConeAngle() const          { return m_coneAngle; }
+
+        bool isBackFacing(const Vector3f& eye) const;
+
+        static void buildClusters(Mesh& mesh, int maxTriangles = 128);
+
+    private:
+        unsigned    m_firstIndex;   // Relative to the start of the element list
+        unsigned    m_numIndices;
+        BoundingBox m_bound;
+        Vector3f    m_coneAxis;
+        float       m_coneAngle;    // Radians between the axis and the furthest normal
+    };
+
+    typedef std::vector<MeshCluster> MeshClusterList;
+
+}
+
+#endif
@@ -1,35 +1,64 @@
+#include <QAtomicInt>
+
 #include "Renderer/renderer.h"
 #include "meshinstance.h"
+#include "scenebvh.h"
 
 namespace GLDemo
 {
+    namespace
+    {
+        /**
+         * \internal Instances may be created on any thread.
+         */
+        unsigned takeId()
+        {
+            static QAtomicInt s_nextId(0);
+            return static_cast<unsigned>(s_nextId.fetchAndAddRelaxed(1));
+        }
+    }
+
+
     /**
      * \param name  The unique name of this mesh instance.
      * \param mesh  The shared mesh data associated with this instance.
      */
     MeshInstance::MeshInstance(const QString& name, PtrMesh& mesh) :
         SpatialEntity(name), 
-        m_mesh(mesh)
+        m_mesh(mesh),
+        m_id(takeId()),
+        m_sceneBvh(0),
+        m_bvhLeaf(-1)
     {
     }
 
 
     /**
      * Creates a copy of the mesh instance. Note that the shared mesh data
-     * is not copied - it is reference from the new mesh instance.
+     * and material are not copied - they are referenced from the new mesh instance.
+     * The copy is not added to any SceneBvh the original is in, and has an ID of its own.
      */
     MeshInstance::MeshInstance(const MeshInstance& ge) :
         SpatialEntity(ge), 
-        m_mesh(ge.m_mesh)
+        m_mesh(ge.m_mesh),
+        m_material(ge.m_material),
+        m_occluderMesh(ge.m_occluderMesh),
+        m_id(takeId()),
+        m_sceneBvh(0),
+        m_bvhLeaf(-1)
     {
     }
 
 
     /**
-     *
+     * Removes the instance from the SceneBvh it is in, if any.
      */
     MeshInstance::~MeshInstance()
     {
+        if (m_sceneBvh)
+        {
+            m_sceneBvh->remove(*this);
+        }
     }
 
 
@@ -54,6 +83,28 @@ namespace GLDemo
     }
 
 
+    /**
+     * The bound of an instance is the bound of its mesh, moved into world space. The
+     * SceneBvh the instance is in, if any, is told about the change.
+     */
+    void MeshInstance::updateWorldBound()
+    {
+        if (m_mesh.isNull())
+        {
+            m_worldBound.setEmpty();
+        }
+        else
+        {
+            m_worldBound = m_mesh->getBound().transformed(getWorldTransformation());
+        }
+
+        if (m_sceneBvh)
+        {
+            m_sceneBvh->markMoved(*this);
+        }
+    }
+
+
     /**
      * Override the draw command, using the visitor pattern to ensure that
      * the correct type of entity is rendered.
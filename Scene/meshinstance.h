@@ -1,14 +1,16 @@
 #ifndef GLDEMO_GEOMETRIC_ENTITY_H
 #define GLDEMO_GEOMETRIC_ENTITY_H
 
-#include "Renderer/shader.h"
+#include "Renderer/material.h"
 #include "spatialentity.h"
 #include "vertex.h"
 #include "mesh.h"
+#include "nodepool.h"
 
 namespace GLDemo
 {
     class Renderer;
+    class SceneBvh;
 
     /**
      * \brief Represents an instance of a mesh in a scene, found at a
@@ -21,21 +23,50 @@ namespace GLDemo
         MeshInstance(const MeshInstance& ge);
         ~MeshInstance();
 
+        // Allocated from a pool of their own; see NodePool.
+        static void* operator new(std::size_t size)             { return NodePool<MeshInstance>::allocate(size); }
+        static void  operator delete(void* p, std::size_t size) { NodePool<MeshInstance>::deallocate(p, size); }
+
         PtrMesh&       getMesh()       { return m_mesh; }
         const PtrMesh& getMesh() const { return m_mesh; }
 
-        PtrShader& getShader()             { return m_shader; }
-        const PtrShader& getShader() const { return m_shader; }
-        void setShader(PtrShader& shader)  { m_shader = shader; }
+        PtrMaterial& getMaterial()                 { return m_material; }
+        const PtrMaterial& getMaterial() const     { return m_material; }
+        void setMaterial(const PtrMaterial& material) { m_material = material; }
+
+        /**
+         * Sets a simplified version of the mesh to draw when the instance is used as an
+         * occluder; see Scene::addOccluder(). Null to use the mesh itself.
+         */
+        void setOccluderMesh(const PtrMesh& mesh)  { m_occluderMesh = mesh; }
+        const PtrMesh& getOccluderMesh() const     { return m_occluderMesh ? m_occluderMesh : m_mesh; }
+
+        /**
+         * \return A number no other instance has had. Unlike the address of the instance,
+         *         which its pool may give to another once it is deleted, it identifies the
+         *         instance for good.
+         */
+        unsigned getId() const { return m_id; }
 
         virtual MeshInstance* clone() const;
 
     protected:
         virtual void updateWorldData(double time);
+        virtual void updateWorldBound();
         virtual bool draw(Renderer* renderer);
 
-        PtrMesh   m_mesh;
-        PtrShader m_shader;
+        PtrMesh     m_mesh;
+        PtrMaterial m_material;
+        PtrMesh     m_occluderMesh;
+
+    private:
+        unsigned m_id;
+
+        // Where the instance is in a SceneBvh, if it is in one. Kept by the tree itself.
+        mutable SceneBvh* m_sceneBvh;
+        mutable int       m_bvhLeaf;
+
+        friend class SceneBvh;
     };
 }
 
@@ -0,0 +1,601 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "meshsimplifier.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        // How strongly the border of an open mesh resists being moved, relative to its faces.
+        const double s_borderWeight = 100.0;
+
+        // A level that doesn't remove at least this fraction of the triangles of the level
+        // before it is not worth keeping, and ends the chain.
+        const float s_minLodReduction = 0.1f;
+
+        /**
+         * \internal Concrete mesh holding a level of detail made by MeshSimplifier.
+         */
+        class SimplifiedMesh : public Mesh
+        {
+        public:
+            SimplifiedMesh(const QString& name) :
+                Mesh(name)
+            {
+            }
+
+            virtual SimplifiedMesh* clone() const
+            {
+                return new SimplifiedMesh(*this);
+            }
+        };
+
+        /**
+         * \return How well vertex b can stand in for vertex a when a's position is merged
+         *         into b's. Higher is better.
+         */
+        float vertexSimilarity(const Vertex& a, const Vertex& b)
+        {
+            return a.m_normal.dot(b.m_normal) - (a.m_texcoords - b.m_texcoords).length();
+        }
+    }
+
+
+    /**
+     *
+     */
+    MeshSimplifier::Quadric::Quadric()
+    {
+        std::fill(m_coeffs, m_coeffs + 10, 0.0);
+    }
+
+
+    /**
+     * \param normal    Unit normal of the plane.
+     * \param distance  Offset of the plane, such that normal.dot(p) + distance is zero
+     *                  for any point p on it.
+     * \param weight    Scale applied to the squared distance to the plane.
+     */
+    void MeshSimplifier::Quadric::addPlane(const Vector3f& normal, float distance, double weight)
+    {
+        const double a = normal.x();
+        const double b = normal.y();
+        const double c = normal.z();
+        const double d = distance;
+
+        m_coeffs[0] += weight * a * a;
+        m_coeffs[1] += weight * a * b;
+        m_coeffs[2] += weight * a * c;
+        m_coeffs[3] += weight * a * d;
+        m_coeffs[4] += weight * b * b;
+        m_coeffs[5] += weight * b * c;
+        m_coeffs[6] += weight * b * d;
+        m_coeffs[7] += weight * c * c;
+        m_coeffs[8] += weight * c * d;
+        m_coeffs[9] += weight * d * d;
+    }
+
+
+    /**
+     * \return The weighted sum of the squared distances from p to each plane.
+     */
+    double MeshSimplifier::Quadric::evaluate(const Vector3f& p) const
+    {
+        const double x = p.x();
+        const double y = p.y();
+        const double z = p.z();
+        const double* q = m_coeffs;
+
+        return q[0]*x*x + 2.0*q[1]*x*y + 2.0*q[2]*x*z + 2.0*q[3]*x
+                        +     q[4]*y*y + 2.0*q[5]*y*z + 2.0*q[6]*y
+                                       +     q[7]*z*z + 2.0*q[8]*z
+                                                      +     q[9];
+    }
+
+
+    /**
+     *
+     */
+    MeshSimplifier::Quadric& MeshSimplifier::Quadric::operator+=(const Quadric& q)
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            m_coeffs[i] += q.m_coeffs[i];
+        }
+        return *this;
+    }
+
+
+    /**
+     * \param mesh  The mesh to simplify. Only its triangle lists and strips are used; the
+     *              mesh itself is left unchanged.
+     */
+    MeshSimplifier::MeshSimplifier(const Mesh& mesh) :
+        m_vertices(mesh.getVertices()),
+        m_pointOf(),
+        m_points(),
+        m_triangles(),
+        m_collapses(),
+        m_numTriangles(0),
+        m_error(0.0f)
+    {
+        // Vertices at exactly the same position are moved together.
+        typedef std::map<Vector3f, int> PointMap;
+        PointMap pointMap;
+        m_pointOf.resize(m_vertices.size());
+        for (unsigned i = 0; i < m_vertices.size(); ++i)
+        {
+            PointMap::iterator pIter = pointMap.find(m_vertices[i].m_position);
+            if (pIter == pointMap.end())
+            {
+                pIter = pointMap.insert(std::make_pair(m_vertices[i].m_position, static_cast<int>(m_points.size()))).first;
+                m_points.push_back(Point(m_vertices[i].m_position));
+            }
+            m_pointOf[i] = pIter->second;
+            m_points[pIter->second].m_vertices.push_back(i);
+        }
+
+        const std::list<ElementList>& elementLists = mesh.getElementLists();
+        for (std::list<ElementList>::const_iterator eIter = elementLists.begin(); eIter != elementLists.end(); ++eIter)
+        {
+            const std::vector<unsigned>& indices = eIter->getIndices();
+            if (eIter->getElementType() == ElementList::TRI_LIST)
+            {
+                for (size_t i = 0; i + 2 < indices.size(); i += 3)
+                {
+                    addTriangle(indices[i], indices[i + 1], indices[i + 2]);
+                }
+            }
+            else if (eIter->getElementType() == ElementList::TRI_STRIP)
+            {
+                size_t stripStart = 0;
+                for (size_t i = 0; i < indices.size(); ++i)
+                {
+                    if (indices[i] == ElementList::RESTART_INDEX)
+                    {
+                        stripStart = i + 1;
+                    }
+                    else if (i >= stripStart + 2 && indices[i - 1] != ElementList::RESTART_INDEX)
+                    {
+                        // Every other triangle of a strip is wound the other way.
+                        if ((i - stripStart) % 2 == 0)
+                        {
+                            addTriangle(indices[i - 2], indices[i - 1], indices[i]);
+                        }
+                        else
+                        {
+                            addTriangle(indices[i - 1], indices[i - 2], indices[i]);
+                        }
+                    }
+                }
+            }
+        }
+
+        addBorderPlanes();
+
+        // Interior edges are seen once from each side; only queue them once.
+        std::set<std::pair<int, int> > edges;
+        for (std::vector<Triangle>::const_iterator tIter = m_triangles.begin(); tIter != m_triangles.end(); ++tIter)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                int a = m_pointOf[tIter->m_vertices[i]];
+                int b = m_pointOf[tIter->m_vertices[(i + 1) % 3]];
+                if (edges.insert(std::make_pair(std::min(a, b), std::max(a, b))).second)
+                {
+                    addCollapse(a, b);
+                }
+            }
+        }
+    }
+
+
+    /**
+     *
+     */
+    MeshSimplifier::~MeshSimplifier()
+    {
+    }
+
+
+    /**
+     * Adds a triangle of the mesh, along with its plane to the quadrics of its corners.
+     * Triangles with two corners at the same position are left out.
+     */
+    void MeshSimplifier::addTriangle(unsigned a, unsigned b, unsigned c)
+    {
+        if (a >= m_vertices.size() || b >= m_vertices.size() || c >= m_vertices.size())
+        {
+            return;
+        }
+
+        int pa = m_pointOf[a];
+        int pb = m_pointOf[b];
+        int pc = m_pointOf[c];
+        if (pa == pb || pb == pc || pa == pc)
+        {
+            return;
+        }
+
+        Triangle triangle;
+        triangle.m_vertices[0] = a;
+        triangle.m_vertices[1] = b;
+        triangle.m_vertices[2] = c;
+        triangle.m_removed = false;
+
+        int index = static_cast<int>(m_triangles.size());
+        m_triangles.push_back(triangle);
+        ++m_numTriangles;
+
+        const Vector3f& p0 = m_points[pa].m_position;
+        Vector3f normal = (m_points[pb].m_position - p0).cross(m_points[pc].m_position - p0);
+        bool hasPlane = normal.normalize() > 0.0f;
+
+        int corners[3] = { pa, pb, pc };
+        for (int i = 0; i < 3; ++i)
+        {
+            Point& point = m_points[corners[i]];
+            if (hasPlane)
+            {
+                point.m_quadric.addPlane(normal, -normal.dot(p0), 1.0);
+            }
+            point.m_triangles.push_back(index);
+        }
+    }
+
+
+    /**
+     * Edges used by only one triangle lie on the border of the mesh. Each gets a plane
+     * through it, at right angles to its triangle, which keeps the border from being
+     * pulled inwards.
+     */
+    void MeshSimplifier::addBorderPlanes()
+    {
+        typedef std::map<std::pair<int, int>, int> EdgeCountMap;
+        EdgeCountMap edgeCounts;
+        for (std::vector<Triangle>::const_iterator tIter = m_triangles.begin(); tIter != m_triangles.end(); ++tIter)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                int a = m_pointOf[tIter->m_vertices[i]];
+                int b = m_pointOf[tIter->m_vertices[(i + 1) % 3]];
+                ++edgeCounts[std::make_pair(std::min(a, b), std::max(a, b))];
+            }
+        }
+
+        for (std::vector<Triangle>::const_iterator tIter = m_triangles.begin(); tIter != m_triangles.end(); ++tIter)
+        {
+            const Vector3f& p0 = m_points[m_pointOf[tIter->m_vertices[0]]].m_position;
+            const Vector3f& p1 = m_points[m_pointOf[tIter->m_vertices[1]]].m_position;
+            const Vector3f& p2 = m_points[m_pointOf[tIter->m_vertices[2]]].m_position;
+            Vector3f faceNormal = (p1 - p0).cross(p2 - p0);
+
+            for (int i = 0; i < 3; ++i)
+            {
+                int a = m_pointOf[tIter->m_vertices[i]];
+                int b = m_pointOf[tIter->m_vertices[(i + 1) % 3]];
+                if (edgeCounts[std::make_pair(std::min(a, b), std::max(a, b))] != 1)
+                {
+                    continue;
+                }
+
+                Vector3f normal = (m_points[b].m_position - m_points[a].m_position).cross(faceNormal);
+                if (normal.normalize() > 0.0f)
+                {
+                    float distance = -normal.dot(m_points[a].m_position);
+                    m_points[a].m_quadric.addPlane(normal, distance, s_borderWeight);
+                    m_points[b].m_quadric.addPlane(normal, distance, s_borderWeight);
+                }
+            }
+        }
+    }
+
+
+    /**
+     * Queues the cheaper way of collapsing the edge between points a and b.
+     */
+    void MeshSimplifier::addCollapse(int a, int b)
+    {
+        Quadric quadric = m_points[a].m_quadric;
+        quadric += m_points[b].m_quadric;
+
+        Collapse collapse;
+        double costAtA = quadric.evaluate(m_points[a].m_position);
+        double costAtB = quadric.evaluate(m_points[b].m_position);
+        if (costAtB <= costAtA)
+        {
+            collapse.m_cost = costAtB;
+            collapse.m_from = a;
+            collapse.m_to = b;
+        }
+        else
+        {
+            collapse.m_cost = costAtA;
+            collapse.m_from = b;
+            collapse.m_to = a;
+        }
+        collapse.m_fromVersion = m_points[collapse.m_from].m_version;
+        collapse.m_toVersion = m_points[collapse.m_to].m_version;
+        m_collapses.push(collapse);
+    }
+
+
+    /**
+     * \return True if moving point \a from onto point \a to would turn any of the
+     *         remaining triangles around \a from over, or fold it onto a triangle already
+     *         at \a to, as happens when collapsing the edge of a tetrahedron.
+     */
+    bool MeshSimplifier::flipsTriangle(int from, int to) const
+    {
+        const Point& toPoint = m_points[to];
+        const Point& fromPoint = m_points[from];
+        for (std::vector<int>::const_iterator tIter = fromPoint.m_triangles.begin(); tIter != fromPoint.m_triangles.end(); ++tIter)
+        {
+            const Triangle& triangle = m_triangles[*tIter];
+            if (triangle.m_removed)
+            {
+                continue;
+            }
+
+            Vector3f before[3];
+            Vector3f after[3];
+            bool sharesEdge = false;
+            for (int i = 0; i < 3; ++i)
+            {
+                int point = m_pointOf[triangle.m_vertices[i]];
+                sharesEdge = sharesEdge || point == to;
+                before[i] = m_points[point].m_position;
+                after[i] = point == from ? m_points[to].m_position : before[i];
+            }
+
+            // Triangles on the collapsed edge disappear rather than move.
+            if (sharesEdge)
+            {
+                continue;
+            }
+
+            Vector3f normalBefore = (before[1] - before[0]).cross(before[2] - before[0]);
+            Vector3f normalAfter = (after[1] - after[0]).cross(after[2] - after[0]);
+            if (normalAfter.dot(normalBefore) <= 0.0f)
+            {
+                return true;
+            }
+
+            int others[2];
+            int numOthers = 0;
+            for (int i = 0; i < 3; ++i)
+            {
+                int point = m_pointOf[triangle.m_vertices[i]];
+                if (point != from)
+                {
+                    others[numOthers++] = point;
+                }
+            }
+
+            for (std::vector<int>::const_iterator toIter = toPoint.m_triangles.begin(); toIter != toPoint.m_triangles.end(); ++toIter)
+            {
+                const Triangle& existing = m_triangles[*toIter];
+                if (existing.m_removed)
+                {
+                    continue;
+                }
+
+                int matches = 0;
+                for (int i = 0; i < 3; ++i)
+                {
+                    int point = m_pointOf[existing.m_vertices[i]];
+                    matches += (point == others[0] || point == others[1]) ? 1 : 0;
+                }
+                if (matches == 2)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+
+    /**
+     * Moves point \a from onto point \a to. Each vertex at \a from is replaced by the most
+     * similar vertex at \a to, and triangles along the collapsed edge are removed.
+     */
+    void MeshSimplifier::collapse(int from, int to)
+    {
+        Point& fromPoint = m_points[from];
+        Point& toPoint = m_points[to];
+
+        std::map<unsigned, unsigned> replacements;
+        for (std::vector<unsigned>::const_iterator vIter = fromPoint.m_vertices.begin(); vIter != fromPoint.m_vertices.end(); ++vIter)
+        {
+            unsigned best = toPoint.m_vertices.front();
+            float bestSimilarity = vertexSimilarity(m_vertices[*vIter], m_vertices[best]);
+            for (std::vector<unsigned>::const_iterator toIter = toPoint.m_vertices.begin() + 1; toIter != toPoint.m_vertices.end(); ++toIter)
+            {
+                float similarity = vertexSimilarity(m_vertices[*vIter], m_vertices[*toIter]);
+                if (similarity > bestSimilarity)
+                {
+                    best = *toIter;
+                    bestSimilarity = similarity;
+                }
+            }
+            replacements[*vIter] = best;
+        }
+
+        for (std::vector<int>::const_iterator tIter = fromPoint.m_triangles.begin(); tIter != fromPoint.m_triangles.end(); ++tIter)
+        {
+            Triangle& triangle = m_triangles[*tIter];
+            if (triangle.m_removed)
+            {
+                continue;
+            }
+
+            bool sharesEdge = false;
+            for (int i = 0; i < 3; ++i)
+            {
+                sharesEdge = sharesEdge || m_pointOf[triangle.m_vertices[i]] == to;
+            }
+
+            if (sharesEdge)
+            {
+                triangle.m_removed = true;
+                --m_numTriangles;
+                continue;
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                if (m_pointOf[triangle.m_vertices[i]] == from)
+                {
+                    triangle.m_vertices[i] = replacements[triangle.m_vertices[i]];
+                }
+            }
+            toPoint.m_triangles.push_back(*tIter);
+        }
+
+        toPoint.m_quadric += fromPoint.m_quadric;
+        ++toPoint.m_version;
+        fromPoint.m_removed = true;
+        fromPoint.m_triangles.clear();
+
+        // Drop the removed triangles, and requeue the edges around the merged point, as
+        // their costs have all changed.
+        std::vector<int> triangles;
+        std::vector<int> neighbours;
+        for (std::vector<int>::const_iterator tIter = toPoint.m_triangles.begin(); tIter != toPoint.m_triangles.end(); ++tIter)
+        {
+            const Triangle& triangle = m_triangles[*tIter];
+            if (triangle.m_removed)
+            {
+                continue;
+            }
+
+            triangles.push_back(*tIter);
+            for (int i = 0; i < 3; ++i)
+            {
+                int point = m_pointOf[triangle.m_vertices[i]];
+                if (point != to && std::find(neighbours.begin(), neighbours.end(), point) == neighbours.end())
+                {
+                    neighbours.push_back(point);
+                }
+            }
+        }
+        toPoint.m_triangles.swap(triangles);
+
+        for (std::vector<int>::const_iterator nIter = neighbours.begin(); nIter != neighbours.end(); ++nIter)
+        {
+            addCollapse(to, *nIter);
+        }
+    }
+
+
+    /**
+     * \param targetTriangles  The number of triangles to reduce the mesh to. Fewer
+     *                         collapses are made if no more can be made without flipping
+     *                         triangles over.
+     * \return The error of the simplified mesh; see getError().
+     */
+    float MeshSimplifier::simplify(int targetTriangles)
+    {
+        while (m_numTriangles > targetTriangles && !m_collapses.empty())
+        {
+            Collapse candidate = m_collapses.top();
+            m_collapses.pop();
+
+            const Point& from = m_points[candidate.m_from];
+            const Point& to = m_points[candidate.m_to];
+            if (from.m_removed || to.m_removed ||
+                from.m_version != candidate.m_fromVersion || to.m_version != candidate.m_toVersion)
+            {
+                continue;
+            }
+
+            if (flipsTriangle(candidate.m_from, candidate.m_to))
+            {
+                continue;
+            }
+
+            collapse(candidate.m_from, candidate.m_to);
+            m_error = std::max(m_error, static_cast<float>(std::sqrt(std::max(candidate.m_cost, 0.0))));
+        }
+
+        return m_error;
+    }
+
+
+    /**
+     * \param name  The unique name of the new mesh.
+     * \return A mesh of the remaining triangles, in a single triangle list, holding only
+     *         the vertices they use.
+     */
+    PtrMesh MeshSimplifier::createMesh(const QString& name) const
+    {
+        PtrMesh mesh(new SimplifiedMesh(name));
+        std::vector<Vertex>& vertices = mesh->getVertices();
+        std::vector<unsigned>& indices = mesh->addElementList(ElementList::TRI_LIST).getIndices();
+        indices.reserve(m_numTriangles * 3);
+
+        std::vector<unsigned> newIndex(m_vertices.size(), static_cast<unsigned>(ElementList::RESTART_INDEX));
+        for (std::vector<Triangle>::const_iterator tIter = m_triangles.begin(); tIter != m_triangles.end(); ++tIter)
+        {
+            if (tIter->m_removed)
+            {
+                continue;
+            }
+
+            for (int i = 0; i < 3; ++i)
+            {
+                unsigned vertex = tIter->m_vertices[i];
+                if (newIndex[vertex] == ElementList::RESTART_INDEX)
+                {
+                    newIndex[vertex] = static_cast<unsigned>(vertices.size());
+                    vertices.push_back(m_vertices[vertex]);
+                }
+                indices.push_back(newIndex[vertex]);
+            }
+        }
+
+        mesh->updateBound();
+        return mesh;
+    }
+
+
+    /**
+     * \param mesh          The mesh to add levels of detail to, replacing any it has.
+     * \param maxLevels     The most levels to add, not counting the mesh itself.
+     * \param reduction     The fraction of the triangles of each level to keep in the next.
+     * \param minTriangles  No level is made with fewer triangles than this.
+     *
+     * Each level is named after the mesh, and records its error against the full mesh.
+     * The chain ends early once simplification stops making progress.
+     */
+    void MeshSimplifier::generateLods(Mesh& mesh, int maxLevels, float reduction, int minTriangles)
+    {
+        mesh.clearLods();
+
+        MeshSimplifier simplifier(mesh);
+        int numTriangles = simplifier.getNumTriangles();
+        for (int level = 1; level <= maxLevels; ++level)
+        {
+            int target = static_cast<int>(numTriangles * reduction);
+            if (target < minTriangles)
+            {
+                break;
+            }
+
+            float error = simplifier.simplify(target);
+            if (simplifier.getNumTriangles() > numTriangles * (1.0f - s_minLodReduction))
+            {
+                break;
+            }
+
+            numTriangles = simplifier.getNumTriangles();
+            mesh.addLod(simplifier.createMesh(QString("%1 LOD %2").arg(mesh.instanceName()).arg(level)), error);
+        }
+    }
+
+}
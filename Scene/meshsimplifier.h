@@ -0,0 +1,129 @@
+#ifndef GLDEMO_MESHSIMPLIFIER_H
+#define GLDEMO_MESHSIMPLIFIER_H
+
+#include <queue>
+#include <vector>
+
+#include <QString>
+
+#include "mesh.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \brief Reduces the number of triangles in a mesh by collapsing edges, choosing the
+     *        collapses that move the surface the least, as measured by quadric error metrics.
+     *
+     * Each collapse merges one vertex position into a neighbouring one. Vertices sharing a
+     * position, such as those either side of a hard edge, are merged as a group, so seams
+     * in normals and texture coordinates are kept. Edges on the border of an open mesh are
+     * penalised so that its outline is kept, and collapses that would flip a triangle over
+     * are never made.
+     *
+     * Simplification is progressive: simplify() can be called repeatedly with smaller
+     * targets, and createMesh() takes a snapshot of the current state each time, which is
+     * how generateLods() builds a whole chain of levels in one pass.
+     */
+    class MeshSimplifier
+    {
+    public:
+        MeshSimplifier(const Mesh& mesh);
+        ~MeshSimplifier();
+
+        int     getNumTriangles() const { return m_numTriangles; }
+        float   getError() const        { return m_error; }
+
+        float   simplify(int targetTriangles);
+        PtrMesh createMesh(const QString& name) const;
+
+        static void generateLods(Mesh& mesh, int maxLevels = 4, float reduction = 0.5f, int minTriangles = 16);
+
+    private:
+        /**
+         * \internal A symmetric 4x4 matrix summing the squared distances to a set of planes.
+         */
+        class Quadric
+        {
+        public:
+            Quadric();
+
+            void    addPlane(const Vector3f& normal, float distance, double weight);
+            double  evaluate(const Vector3f& p) const;
+            Quadric& operator+=(const Quadric& q);
+
+        private:
+            double m_coeffs[10];
+        };
+
+        /**
+         * \internal A vertex position, and all the vertices of the mesh found at it.
+         */
+        class Point
+        {
+        public:
+            Point(const Vector3f& position) :
+                m_position(position),
+                m_quadric(),
+                m_vertices(),
+                m_triangles(),
+                m_version(0),
+                m_removed(false)
+            {
+            }
+
+            Vector3f               m_position;
+            Quadric                m_quadric;
+            std::vector<unsigned>  m_vertices;
+            std::vector<int>       m_triangles;  // May include triangles since removed
+            unsigned               m_version;    // Changes whenever the point's neighbourhood does
+            bool                   m_removed;
+        };
+
+        /**
+         * \internal A triangle, referring to the vertices of the original mesh.
+         */
+        class Triangle
+        {
+        public:
+            unsigned m_vertices[3];
+            bool     m_removed;
+        };
+
+        /**
+         * \internal A candidate collapse of one point into another. Ordered so that the
+         *           cheapest collapse is at the top of the queue.
+         */
+        class Collapse
+        {
+        public:
+            bool operator<(const Collapse& other) const { return m_cost > other.m_cost; }
+
+            double   m_cost;
+            int      m_from;
+            int      m_to;
+            unsigned m_fromVersion;
+            unsigned m_toVersion;
+        };
+
+        void addTriangle(unsigned a, unsigned b, unsigned c);
+        void addBorderPlanes();
+        void addCollapse(int a, int b);
+        bool flipsTriangle(int from, int to) const;
+        void collapse(int from, int to);
+
+        std::vector<Vertex>             m_vertices;
+        std::vector<int>                m_pointOf;  // Index of the point each vertex is at
+        std::vector<Point>              m_points;
+        std::vector<Triangle>           m_triangles;
+        std::priority_queue<Collapse>   m_collapses;
+        int                             m_numTriangles;
+        float                           m_error;
+
+        MeshSimplifier(const MeshSimplifier&);
+        MeshSimplifier& operator=(const MeshSimplifier&);
+    };
+
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include <deque>
+
+#include <QHash>
+
+#include "name.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        /**
+         * \internal An interned string, with its hash.
+         */
+        struct NameEntry
+        {
+            NameEntry(const QString& string) : m_string(string), m_hash(qHash(string)) {}
+
+            QString m_string;
+            uint    m_hash;
+        };
+
+
+        /**
+         * \internal Every string interned so far. The entries are in a deque so that the
+         *           references toString() gives out stay valid as it grows.
+         */
+        struct NameTable
+        {
+            NameTable() :
+                m_ids(),
+                m_entries()
+            {
+                m_entries.push_back(NameEntry(QString()));
+            }
+
+            QHash<QString, quint32> m_ids;
+            std::deque<NameEntry>   m_entries;
+        };
+
+
+        NameTable& nameTable()
+        {
+            static NameTable s_table;
+            return s_table;
+        }
+    }
+
+
+    /**
+     * \param string  The string to intern. Equal strings give equal names.
+     */
+    Name::Name(const QString& string) :
+        m_id(intern(string))
+    {
+    }
+
+
+    /**
+     *
+     */
+    Name::Name(const char* string) :
+        m_id(intern(QString(string)))
+    {
+    }
+
+
+    /**
+     * \return The string the name was made from.
+     */
+    const QString& Name::toString() const
+    {
+        return nameTable().m_entries[m_id].m_string;
+    }
+
+
+    /**
+     * \return The hash of the string, computed when it was interned.
+     */
+    uint Name::hash() const
+    {
+        return nameTable().m_entries[m_id].m_hash;
+    }
+
+
+    /**
+     * \return The number of distinct strings interned, including the empty string.
+     */
+    int Name::getNumInterned()
+    {
+        return static_cast<int>(nameTable().m_entries.size());
+    }
+
+
+    /**
+     * \internal The id of the string, adding it to the table if it isn't there yet.
+     */
+    quint32 Name::intern(const QString& string)
+    {
+        if (string.isEmpty())
+        {
+            return 0;
+        }
+
+        NameTable& table = nameTable();
+        QHash<QString, quint32>::const_iterator iter = table.m_ids.constFind(string);
+        if (iter != table.m_ids.constEnd())
+        {
+            return iter.value();
+        }
+
+        quint32 id = static_cast<quint32>(table.m_entries.size());
+        table.m_entries.push_back(NameEntry(string));
+        table.m_ids.insert(string, id);
+        return id;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef GLDEMO_NAME_H
+#define GLDEMO_NAME_H
+
+#include <QString>
+
+namespace GLDemo
+{
+
+    /**
+     * \brief An interned string, such as the name of an object.
+     *
+     * Each distinct string is stored once, in a global table, and a Name is just its
+     * 32-bit index in that table. Copying and comparing names is copying and comparing
+     * integers, and their hashes are computed once, when the string is first interned.
+     * The string itself is only needed to show the name to someone; see toString().
+     *
+     * Interned strings are never freed, so names are best kept to things that are named
+     * once, rather than made up for each frame. Names should be created on the main
+     * thread.
+     */
+    class Name
+    {
+    public:
+        Name() : m_id(0) {}
+        Name(const QString& string);
+        Name(const char* string);
+
+        quint32 id() const      { return m_id; }
+        bool    isEmpty() const { return m_id == 0; }
+
+        const QString& toString() const;
+        uint hash() const;      // Of the string, so the same from one run to the next
+
+        bool operator==(const Name& n) const { return m_id == n.m_id; }
+        bool operator!=(const Name& n) const { return m_id != n.m_id; }
+        bool operator< (const Name& n) const { return m_id < n.m_id; }
+
+        static int getNumInterned();
+
+    private:
+        static quint32 intern(const QString& string);
+
+        quint32 m_id;   // Zero is the empty string
+    };
+
+
+    /**
+     * Lets names be used as the keys of a QHash. Each id belongs to only one string, so the
+     * id itself is a perfect hash, and needs no lookup.
+     */
+    inline uint qHash(const Name& name, uint seed = 0)
+    {
+        return name.id() ^ seed;
+    }
+
+}
+
+#endif
@@ -0,0 +1,191 @@
+#ifndef GLDEMO_NODEPOOL_H
+#define GLDEMO_NODEPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace GLDemo
+{
+
+    /**
+     * \brief Allocates memory for objects of type T from large slabs, keeping freed blocks
+     *        on a free list to be handed out again.
+     *
+     * Scene classes route their operator new and operator delete through a pool of their
+     * own type, so ordinary new and delete (including clone() and the deletion of children
+     * by SceneNode) use it without any change to callers. Once a pool has grown to the
+     * size of a scene, creating and deleting nodes costs a pointer swap rather than a heap
+     * call, and nodes created together lie together in memory, which helps traversal.
+     *
+     * Requests of any other size, such as from a subclass of T that doesn't have a pool
+     * of its own, go to the global heap.
+     *
+     * Pools are not thread safe; nodes should be created and deleted on one thread.
+     */
+    template<class T>
+    class NodePool
+    {
+    public:
+        static void* allocate(std::size_t size);
+        static void  deallocate(void* p, std::size_t size);
+
+        static void reserve(int count);
+        static bool releaseUnused();
+
+        static int getNumAllocated() { return state().m_numAllocated; }
+        static int getCapacity()     { return state().m_capacity; }
+
+    private:
+        union Block
+        {
+            Block* m_next;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+        };
+
+        struct State
+        {
+            State() : m_slabs(), m_freeList(0), m_numAllocated(0), m_capacity(0) {}
+            ~State()
+            {
+                // Nodes still alive at exit keep their slabs.
+                if (m_numAllocated == 0)
+                {
+                    freeSlabs();
+                }
+            }
+
+            void freeSlabs()
+            {
+                for (typename std::vector<Block*>::iterator iter = m_slabs.begin(); iter != m_slabs.end(); ++iter)
+                {
+                    delete[] *iter;
+                }
+                m_slabs.clear();
+                m_freeList = 0;
+                m_capacity = 0;
+            }
+
+            std::vector<Block*> m_slabs;
+            Block*              m_freeList;
+            int                 m_numAllocated;
+            int                 m_capacity;
+        };
+
+        static State& state()
+        {
+            static State s_state;
+            return s_state;
+        }
+
+        static void addSlab(int numBlocks);
+
+        static const int s_blocksPerSlab = 1024;
+    };
+
+
+    /**
+     * \param size  The size of the object being created.
+     */
+    template<class T>
+    void* NodePool<T>::allocate(std::size_t size)
+    {
+        if (size != sizeof(T))
+        {
+            return ::operator new(size);
+        }
+
+        State& s = state();
+        if (!s.m_freeList)
+        {
+            addSlab(s_blocksPerSlab);
+        }
+
+        Block* block = s.m_freeList;
+        s.m_freeList = block->m_next;
+        ++s.m_numAllocated;
+        return block;
+    }
+
+
+    /**
+     * \param p     Memory returned by allocate().
+     * \param size  The size passed to allocate().
+     */
+    template<class T>
+    void NodePool<T>::deallocate(void* p, std::size_t size)
+    {
+        if (!p)
+        {
+            return;
+        }
+        if (size != sizeof(T))
+        {
+            ::operator delete(p);
+            return;
+        }
+
+        State& s = state();
+        Block* block = static_cast<Block*>(p);
+        block->m_next = s.m_freeList;
+        s.m_freeList = block;
+        --s.m_numAllocated;
+    }
+
+
+    /**
+     * Makes room for at least \a count more objects, in one slab, so that they are
+     * allocated next to one another. Worth calling before building a large scene.
+     */
+    template<class T>
+    void NodePool<T>::reserve(int count)
+    {
+        const int available = state().m_capacity - state().m_numAllocated;
+        if (count > available)
+        {
+            addSlab(count - available);
+        }
+    }
+
+
+    /**
+     * Returns every slab to the heap, provided no objects are allocated from them.
+     *
+     * \return False, and nothing is freed, if any object is still allocated.
+     */
+    template<class T>
+    bool NodePool<T>::releaseUnused()
+    {
+        State& s = state();
+        if (s.m_numAllocated != 0)
+        {
+            return false;
+        }
+
+        s.freeSlabs();
+        return true;
+    }
+
+
+    /**
+     * \internal Adds the blocks of a new slab to the free list, so that they are handed
+     *           out in address order.
+     */
+    template<class T>
+    void NodePool<T>::addSlab(int numBlocks)
+    {
+        State& s = state();
+        Block* slab = new Block[numBlocks];
+        s.m_slabs.push_back(slab);
+        for (int i = numBlocks - 1; i >= 0; --i)
+        {
+            slab[i].m_next = s.m_freeList;
+            s.m_freeList = &slab[i];
+        }
+        s.m_capacity += numBlocks;
+    }
+
+}
+
+#endif
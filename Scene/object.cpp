@@ -11,7 +11,7 @@ namespace GLDemo
     /**
      * \param instanceName The name of this object.
      */
-    Object::Object(const QString& instanceName) :
+    Object::Object(const Name& instanceName) :
         m_instanceName(instanceName),
         m_controllers()
     {
@@ -57,12 +57,17 @@ namespace GLDemo
 
 
     /**
+     * \param time  The time of the update, passed on to each controller.
      *
+     * Controllers are for behaviour that is particular to one object. Keyframed
+     * animation of many objects is better played by an Animator.
      */
     void Object::updateControllers(double time)
     {
-        // Not yet implemented. This will iterate over all controllers and invoke the
-        // update function on them.
+        for (std::list<PtrController>::iterator iter = m_controllers.begin(); iter != m_controllers.end(); ++iter)
+        {
+            (*iter)->update(time);
+        }
     }
 }
 
@@ -6,6 +6,7 @@
 #include <QString>
 
 #include "controller.h"
+#include "name.h"
 
 namespace GLDemo
 {
@@ -17,17 +18,21 @@ namespace GLDemo
      * the names are used to uniquely identify the object. Objects are also able
      * to have \a Controller objects associated with them, which are capable of
      * manipulating their properties at regular intervals.
+     *
+     * Names are interned, so each object holds only a Name, and comparing the names of
+     * objects compares integers.
      */
     class Object
     {
     public:
-        Object(const QString& instanceName);
+        Object(const Name& instanceName);
         Object(const Object& object);
 
         virtual ~Object();
 
-        const QString& instanceName() const       { return m_instanceName; }
-        void setInstanceName(const QString& name) { m_instanceName = name; }
+        const QString& instanceName() const       { return m_instanceName.toString(); }
+        const Name&    getName() const            { return m_instanceName; }
+        void setInstanceName(const Name& name)    { m_instanceName = name; }
 
         void addController(PtrController& controller);
         void removeController(PtrController& controller);
@@ -35,7 +40,7 @@ namespace GLDemo
 
         virtual Object* clone() const = 0;
 
-        QString m_instanceName;
+        Name m_instanceName;
         std::list<PtrController > m_controllers;
     };
 
@@ -0,0 +1,35 @@
+#ifndef GLDEMO_RAY_H
+#define GLDEMO_RAY_H
+
+#include "Math/vector3.h"
+
+namespace GLDemo
+{
+
+    /**
+     * \brief A half-line, starting at an origin and heading off in a direction.
+     *
+     * The direction need not be unit length. Distances along the ray are measured in
+     * multiples of it, which keeps them comparable when the ray is moved into another
+     * space by an affine transform.
+     */
+    class Ray
+    {
+    public:
+        Ray() : m_origin(), m_direction() {}
+
+        Ray(const Vector3f& origin, const Vector3f& direction) :
+            m_origin(origin),
+            m_direction(direction)
+        {
+        }
+
+        Vector3f getPoint(float distance) const { return m_origin + m_direction * distance; }
+
+        Vector3f m_origin;
+        Vector3f m_direction;
+    };
+
+}
+
+#endif
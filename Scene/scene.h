@@ -1,8 +1,15 @@
 #ifndef GLDEMO_SCENE_H
 #define GLDEMO_SCENE_H
 
+#include <algorithm>
+#include <vector>
+
 #include <QSharedPointer>
 
+#include "animator.h"
+#include "meshinstance.h"
+#include "scenebvh.h"
+#include "sceneindex.h"
 #include "scenenode.h"
 
 namespace GLDemo
@@ -18,12 +25,116 @@ namespace GLDemo
     class Scene
     {
     public:
-        Scene() {}
+        typedef std::vector<const MeshInstance*> OccluderList;
+
+        /**
+         * The order in which opaque objects are drawn.
+         */
+        enum OpaqueSortMode
+        {
+            SortByState,        // Grouped by shader and material, nearest first within each group
+            SortFrontToBack     // Nearest first, so hidden surfaces fail the depth test early
+        };
+
+        Scene() :
+            m_index(),
+            m_rootNode(),
+            m_occluders(),
+            m_opaqueSortMode(SortByState),
+            m_depthPrePass(false),
+            m_bvh(),
+            m_animator()
+        {
+            static_cast<SpatialEntity&>(m_rootNode).setScene(this);
+        }
 
         SceneNode& getRootNode() { return m_rootNode; }
 
+        /**
+         * Finds the entities of the scene by name or path. Kept up to date as entities
+         * are added to, and detached from, the nodes of the scene.
+         */
+        SceneIndex&       getIndex()       { return m_index; }
+        const SceneIndex& getIndex() const { return m_index; }
+
+        /**
+         * Marks an instance of the scene as an occluder, which renderers may draw into a
+         * coarse depth buffer to cull whatever is hidden behind it. Large, solid objects
+         * such as walls make the best occluders. An occluder must be removed before it
+         * is deleted.
+         */
+        void addOccluder(const MeshInstance& instance) { m_occluders.push_back(&instance); }
+        void removeOccluder(const MeshInstance& instance)
+        {
+            m_occluders.erase(std::remove(m_occluders.begin(), m_occluders.end(), &instance), m_occluders.end());
+        }
+        const OccluderList& getOccluders() const { return m_occluders; }
+
+        void setOpaqueSortMode(OpaqueSortMode mode) { m_opaqueSortMode = mode; }
+        OpaqueSortMode getOpaqueSortMode() const    { return m_opaqueSortMode; }
+
+        /**
+         * When enabled, the depth of every opaque object is drawn first with a minimal
+         * shader, so that the full shaders then only run for visible fragments. Worthwhile
+         * for scenes with expensive shaders and a lot of overdraw.
+         */
+        void setDepthPrePassEnabled(bool enabled) { m_depthPrePass = enabled; }
+        bool isDepthPrePassEnabled() const        { return m_depthPrePass; }
+
+        /**
+         * Builds the hierarchy used by pick() from the scene's mesh instances, replacing
+         * what it held before. Instances added to the scene afterwards must be inserted
+         * into getBvh() themselves; instances that are deleted remove themselves.
+         */
+        void buildBvh() { m_bvh.build(m_rootNode); }
+
+        /**
+         * Brings the hierarchy used by pick() up to date with instances that have moved
+         * since the last call, and spends a little time improving its shape. Meant to be
+         * called once a frame, after the geometric update.
+         */
+        void updateBvh() { m_bvh.optimize(std::max(1, m_bvh.getNumInstances() / s_bvhOptimizeFraction)); }
+
+        SceneBvh&       getBvh()       { return m_bvh; }
+        const SceneBvh& getBvh() const { return m_bvh; }
+
+        /**
+         * Finds the nearest triangle of any mesh instance hit by a world space ray, such
+         * as one from Camera::getRay(). Returns false if nothing is hit.
+         */
+        bool pick(const Ray& ray, PickResult& result) const { return m_bvh.pick(ray, result); }
+
+        /**
+         * Plays keyframed animation on the entities of the scene; see update().
+         */
+        Animator&       getAnimator()       { return m_animator; }
+        const Animator& getAnimator() const { return m_animator; }
+
+        /**
+         * Brings the scene up to date for a frame at \a time, in seconds: plays animation
+         * into the local transformations of its entities, then carries them into world
+         * space with a geometric update from the root.
+         */
+        void update(double time)
+        {
+            m_animator.update(time);
+            m_rootNode.updateGeometricState(time, true);
+        }
+
     private:
-        SceneNode m_rootNode;
+        // Each call to updateBvh() reinserts this fraction of the instances of the scene.
+        static const int s_bvhOptimizeFraction = 64;
+
+        Scene(const Scene&);
+        Scene& operator=(const Scene&);
+
+        SceneIndex     m_index;         // Before the root node, which removes entities from it
+        SceneNode      m_rootNode;
+        OccluderList   m_occluders;
+        OpaqueSortMode m_opaqueSortMode;
+        bool           m_depthPrePass;
+        SceneBvh       m_bvh;
+        Animator       m_animator;
     };
 
 }
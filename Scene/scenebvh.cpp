@@ -0,0 +1,592 @@
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <utility>
+
+#include "Math/mathdefs.h"
+#include "Renderer/renderer.h"
+#include "bvh.h"
+#include "meshinstance.h"
+#include "scenebvh.h"
+#include "scenenode.h"
+
+namespace GLDemo
+{
+    namespace
+    {
+        /**
+         * \internal Gathers every mesh instance below a node.
+         */
+        class InstanceCollector : public Renderer
+        {
+        public:
+            InstanceCollector(std::vector<const MeshInstance*>& instances) :
+                m_instances(instances)
+            {
+            }
+
+            virtual bool process(const MeshInstance& instance)
+            {
+                if (!instance.getMesh().isNull())
+                {
+                    m_instances.push_back(&instance);
+                }
+                return true;
+            }
+
+        private:
+            std::vector<const MeshInstance*>& m_instances;
+        };
+
+
+        /**
+         * \internal The box enclosing two others.
+         */
+        BoundingBox merged(const BoundingBox& a, const BoundingBox& b)
+        {
+            BoundingBox box(a);
+            box.extend(b);
+            return box;
+        }
+
+
+        /**
+         * \internal
+         */
+        bool isSameBox(const BoundingBox& a, const BoundingBox& b)
+        {
+            if (a.isEmpty() || b.isEmpty())
+            {
+                return a.isEmpty() == b.isEmpty();
+            }
+            return a.getMinimum() == b.getMinimum() && a.getMaximum() == b.getMaximum();
+        }
+
+
+        /**
+         * \internal Traces a world space ray against the mesh of an instance.
+         *
+         * The transformation is affine, so distances along the ray are the same in either
+         * space.
+         */
+        bool intersectInstance(const MeshInstance& instance, const Ray& ray, float& distance, int& triangle)
+        {
+            const Transformation& world = instance.getWorldTransformation();
+            Ray localRay;
+            localRay.m_origin = world.applyInverse(ray.m_origin);
+            localRay.m_direction = world.applyInverse(ray.m_origin + ray.m_direction) - localRay.m_origin;
+            return instance.getMesh()->getBvh().intersect(localRay, distance, triangle);
+        }
+    }
+
+
+    /**
+     *
+     */
+    SceneBvh::Node::Node() :
+        m_bound(),
+        m_parent(-1),
+        m_instance(0),
+        m_moved(false)
+    {
+        m_children[0] = m_children[1] = -1;
+    }
+
+
+    /**
+     * Creates an empty hierarchy.
+     */
+    SceneBvh::SceneBvh() :
+        m_nodes(),
+        m_freeNodes(),
+        m_movedLeaves(),
+        m_root(-1),
+        m_numLeaves(0),
+        m_optimizeCursor(0)
+    {
+    }
+
+
+    /**
+     * Detaches any instances still in the hierarchy from it.
+     */
+    SceneBvh::~SceneBvh()
+    {
+        clear();
+    }
+
+
+    /**
+     * \param root  The node whose mesh instances to build the hierarchy over, replacing
+     *              whatever it held before. World bounds must be up to date.
+     */
+    void SceneBvh::build(SceneNode& root)
+    {
+        clear();
+
+        std::vector<const MeshInstance*> instances;
+        InstanceCollector collector(instances);
+        root.draw(&collector);
+
+        m_nodes.reserve(2 * instances.size());
+        for (std::vector<const MeshInstance*>::const_iterator iter = instances.begin(); iter != instances.end(); ++iter)
+        {
+            insert(**iter);
+        }
+    }
+
+
+    /**
+     * Removes all instances.
+     */
+    void SceneBvh::clear()
+    {
+        for (std::vector<Node>::const_iterator iter = m_nodes.begin(); iter != m_nodes.end(); ++iter)
+        {
+            if (iter->isLeaf())
+            {
+                iter->m_instance->m_sceneBvh = 0;
+                iter->m_instance->m_bvhLeaf = -1;
+            }
+        }
+
+        m_nodes.clear();
+        m_freeNodes.clear();
+        m_movedLeaves.clear();
+        m_root = -1;
+        m_numLeaves = 0;
+        m_optimizeCursor = 0;
+    }
+
+
+    /**
+     * \param instance  An instance with a mesh, not already in a hierarchy. It removes
+     *                  itself from the hierarchy when it is deleted.
+     */
+    void SceneBvh::insert(const MeshInstance& instance)
+    {
+        assert(!instance.m_sceneBvh && !instance.getMesh().isNull());
+
+        int leaf = allocateNode();
+        m_nodes[leaf].m_instance = &instance;
+        m_nodes[leaf].m_bound = instance.getWorldBound();
+        instance.m_sceneBvh = this;
+        instance.m_bvhLeaf = leaf;
+
+        insertLeaf(leaf);
+        ++m_numLeaves;
+    }
+
+
+    /**
+     * \param instance  An instance in this hierarchy.
+     */
+    void SceneBvh::remove(const MeshInstance& instance)
+    {
+        assert(instance.m_sceneBvh == this);
+
+        int leaf = instance.m_bvhLeaf;
+        removeLeaf(leaf);
+        if (m_nodes[leaf].m_moved)
+        {
+            m_movedLeaves.erase(std::find(m_movedLeaves.begin(), m_movedLeaves.end(), leaf));
+        }
+        freeNode(leaf);
+        --m_numLeaves;
+
+        instance.m_sceneBvh = 0;
+        instance.m_bvhLeaf = -1;
+    }
+
+
+    /**
+     * \param instance  An instance in this hierarchy, whose world bound has changed.
+     *
+     * Called by the instance itself. The hierarchy is brought up to date by the next
+     * refit().
+     */
+    void SceneBvh::markMoved(const MeshInstance& instance)
+    {
+        assert(instance.m_sceneBvh == this);
+
+        Node& leaf = m_nodes[instance.m_bvhLeaf];
+        if (!leaf.m_moved && !isSameBox(leaf.m_bound, instance.getWorldBound()))
+        {
+            leaf.m_moved = true;
+            m_movedLeaves.push_back(instance.m_bvhLeaf);
+        }
+    }
+
+
+    /**
+     * Updates the bounds of the instances that have moved since the last refit, and of
+     * their ancestors. Must be called before pick() if anything has moved.
+     */
+    void SceneBvh::refit()
+    {
+        for (std::vector<int>::const_iterator iter = m_movedLeaves.begin(); iter != m_movedLeaves.end(); ++iter)
+        {
+            Node& leaf = m_nodes[*iter];
+            leaf.m_bound = leaf.m_instance->getWorldBound();
+            leaf.m_moved = false;
+            refitFrom(leaf.m_parent, true);
+        }
+        m_movedLeaves.clear();
+    }
+
+
+    /**
+     * \param count  How many instances to move.
+     *
+     * Takes instances out of the tree and inserts them again, where they now fit best,
+     * working through every instance in turn over successive calls. Any pending moves
+     * are refitted first.
+     */
+    void SceneBvh::optimize(int count)
+    {
+        refit();
+
+        count = std::min(count, m_numLeaves);
+        for (int i = 0; i < count && m_numLeaves > 1; ++i)
+        {
+            if (m_optimizeCursor >= static_cast<int>(m_nodes.size()))
+            {
+                m_optimizeCursor = 0;
+            }
+            while (!m_nodes[m_optimizeCursor].isLeaf())
+            {
+                m_optimizeCursor = (m_optimizeCursor + 1) % static_cast<int>(m_nodes.size());
+            }
+
+            removeLeaf(m_optimizeCursor);
+            insertLeaf(m_optimizeCursor);
+            ++m_optimizeCursor;
+        }
+    }
+
+
+    /**
+     * \return The number of nodes on the longest path from the root to a leaf.
+     */
+    int SceneBvh::getHeight() const
+    {
+        return m_root < 0 ? 0 : getHeight(m_root);
+    }
+
+
+    /**
+     * \return The total surface area of the nodes above the leaves, relative to the area
+     *         of the root. This is in proportion to the number of nodes an average ray
+     *         through the scene would visit, so lower is better.
+     */
+    float SceneBvh::getCost() const
+    {
+        if (m_root < 0 || m_nodes[m_root].isLeaf())
+        {
+            return 0.0f;
+        }
+
+        float area = 0.0f;
+        for (std::vector<Node>::const_iterator iter = m_nodes.begin(); iter != m_nodes.end(); ++iter)
+        {
+            if (iter->m_children[0] >= 0)
+            {
+                area += iter->m_bound.getSurfaceArea();
+            }
+        }
+        return area / std::max(m_nodes[m_root].m_bound.getSurfaceArea(), Math<float>::Epsilon());
+    }
+
+
+    /**
+     * \param ray     The ray to trace, in world space.
+     * \param result  Set to what the ray hit first, if anything.
+     * \return True if the ray hits a triangle of any instance.
+     *
+     * Nearer children are visited first, so that once a hit is found, nodes beyond it
+     * are skipped.
+     */
+    bool SceneBvh::pick(const Ray& ray, PickResult& result) const
+    {
+        assert(m_movedLeaves.empty());
+        if (m_root < 0)
+        {
+            return false;
+        }
+
+        const Vector3f invDirection(1.0f / ray.m_direction.x(), 1.0f / ray.m_direction.y(), 1.0f / ray.m_direction.z());
+        float distance = std::numeric_limits<float>::max();
+        float entry = 0.0f;
+        if (!Bvh::intersectBox(m_nodes[m_root].m_bound, ray.m_origin, invDirection, distance, entry))
+        {
+            return false;
+        }
+
+        typedef std::pair<int, float> StackEntry;
+        std::vector<StackEntry> stack;
+        stack.push_back(StackEntry(m_root, entry));
+
+        PickResult hit;
+        while (!stack.empty())
+        {
+            StackEntry top = stack.back();
+            stack.pop_back();
+            if (top.second > distance)
+            {
+                continue;
+            }
+
+            const Node& node = m_nodes[top.first];
+            if (node.isLeaf())
+            {
+                int triangle = -1;
+                if (intersectInstance(*node.m_instance, ray, distance, triangle))
+                {
+                    hit.m_instance = node.m_instance;
+                    hit.m_triangle = triangle;
+                }
+                continue;
+            }
+
+            float entries[2] = { 0.0f, 0.0f };
+            bool hits[2];
+            for (int i = 0; i < 2; ++i)
+            {
+                hits[i] = Bvh::intersectBox(m_nodes[node.m_children[i]].m_bound, ray.m_origin, invDirection, distance, entries[i]);
+            }
+
+            // Push the further child first, so the nearer one is visited next.
+            int nearer = entries[1] < entries[0] ? 1 : 0;
+            if (hits[1 - nearer])
+            {
+                stack.push_back(StackEntry(node.m_children[1 - nearer], entries[1 - nearer]));
+            }
+            if (hits[nearer])
+            {
+                stack.push_back(StackEntry(node.m_children[nearer], entries[nearer]));
+            }
+        }
+
+        if (!hit.m_instance)
+        {
+            return false;
+        }
+
+        hit.m_distance = distance;
+        hit.m_point = ray.getPoint(distance);
+        result = hit;
+        return true;
+    }
+
+
+    /**
+     * \internal
+     */
+    int SceneBvh::allocateNode()
+    {
+        if (m_freeNodes.empty())
+        {
+            m_nodes.push_back(Node());
+            return static_cast<int>(m_nodes.size()) - 1;
+        }
+
+        int node = m_freeNodes.back();
+        m_freeNodes.pop_back();
+        return node;
+    }
+
+
+    /**
+     * \internal
+     */
+    void SceneBvh::freeNode(int node)
+    {
+        m_nodes[node] = Node();
+        m_freeNodes.push_back(node);
+    }
+
+
+    /**
+     * \internal Links a detached leaf into the tree, next to the node that it adds the
+     *           least surface area to pair it with.
+     *
+     * Going down the tree, pairing the leaf with a node costs the area of their new
+     * parent, plus the area each ancestor grows by to fit the leaf. The cheapest child is
+     * followed until neither child can beat pairing with the node itself.
+     */
+    void SceneBvh::insertLeaf(int leaf)
+    {
+        if (m_root < 0)
+        {
+            m_root = leaf;
+            m_nodes[leaf].m_parent = -1;
+            return;
+        }
+
+        const BoundingBox bound = m_nodes[leaf].m_bound;
+        int sibling = m_root;
+        while (!m_nodes[sibling].isLeaf())
+        {
+            const Node& node = m_nodes[sibling];
+            const float area = node.m_bound.getSurfaceArea();
+            const float pairCost = merged(node.m_bound, bound).getSurfaceArea();
+
+            // What every ancestor below this one would grow by.
+            const float inheritedCost = pairCost - area;
+
+            float childCosts[2];
+            for (int i = 0; i < 2; ++i)
+            {
+                const Node& child = m_nodes[node.m_children[i]];
+                float grownArea = merged(child.m_bound, bound).getSurfaceArea();
+                childCosts[i] = inheritedCost + (child.isLeaf() ? grownArea : grownArea - child.m_bound.getSurfaceArea());
+            }
+
+            if (pairCost <= childCosts[0] && pairCost <= childCosts[1])
+            {
+                break;
+            }
+            sibling = node.m_children[childCosts[1] < childCosts[0] ? 1 : 0];
+        }
+
+        const int oldParent = m_nodes[sibling].m_parent;
+        const int newParent = allocateNode();
+        Node& parent = m_nodes[newParent];
+        parent.m_parent = oldParent;
+        parent.m_children[0] = sibling;
+        parent.m_children[1] = leaf;
+        parent.m_bound = merged(m_nodes[sibling].m_bound, bound);
+        m_nodes[sibling].m_parent = newParent;
+        m_nodes[leaf].m_parent = newParent;
+
+        if (oldParent < 0)
+        {
+            m_root = newParent;
+        }
+        else
+        {
+            Node& grandParent = m_nodes[oldParent];
+            grandParent.m_children[grandParent.m_children[0] == sibling ? 0 : 1] = newParent;
+            refitFrom(oldParent, false);
+        }
+    }
+
+
+    /**
+     * \internal Unlinks a leaf from the tree, without freeing it. Its sibling takes the
+     *           place of their parent.
+     */
+    void SceneBvh::removeLeaf(int leaf)
+    {
+        if (leaf == m_root)
+        {
+            m_root = -1;
+            return;
+        }
+
+        const int parent = m_nodes[leaf].m_parent;
+        const int grandParent = m_nodes[parent].m_parent;
+        const int sibling = m_nodes[parent].m_children[m_nodes[parent].m_children[0] == leaf ? 1 : 0];
+        m_nodes[sibling].m_parent = grandParent;
+        m_nodes[leaf].m_parent = -1;
+        freeNode(parent);
+
+        if (grandParent < 0)
+        {
+            m_root = sibling;
+        }
+        else
+        {
+            Node& node = m_nodes[grandParent];
+            node.m_children[node.m_children[0] == parent ? 0 : 1] = sibling;
+            refitFrom(grandParent, false);
+        }
+    }
+
+
+    /**
+     * \internal Recomputes the bounds of a node and its ancestors from their children,
+     *           rotating each where that tightens it.
+     * \param stopWhenUnchanged  If true, stops at the first node whose bound is unchanged,
+     *                           since nothing above it can have changed either.
+     */
+    void SceneBvh::refitFrom(int node, bool stopWhenUnchanged)
+    {
+        while (node >= 0)
+        {
+            rotate(node);
+
+            Node& current = m_nodes[node];
+            BoundingBox bound = merged(m_nodes[current.m_children[0]].m_bound, m_nodes[current.m_children[1]].m_bound);
+            if (stopWhenUnchanged && isSameBox(bound, current.m_bound))
+            {
+                return;
+            }
+            current.m_bound = bound;
+            node = current.m_parent;
+        }
+    }
+
+
+    /**
+     * \internal Swaps one child of a node with a grandchild on the other side, if that
+     *           shrinks the child the grandchild is taken from. The node's own bound is
+     *           not affected, only how its contents are divided.
+     */
+    void SceneBvh::rotate(int node)
+    {
+        float bestGain = 0.0f;
+        int bestSide = -1;
+        int bestGrandChild = -1;
+        for (int side = 0; side < 2; ++side)
+        {
+            // Try moving the child on this side down into the other child, in exchange for
+            // one of the other child's children.
+            const Node& child = m_nodes[m_nodes[node].m_children[side]];
+            const Node& other = m_nodes[m_nodes[node].m_children[1 - side]];
+            if (other.isLeaf())
+            {
+                continue;
+            }
+
+            for (int g = 0; g < 2; ++g)
+            {
+                const Node& kept = m_nodes[other.m_children[1 - g]];
+                float gain = other.m_bound.getSurfaceArea() - merged(child.m_bound, kept.m_bound).getSurfaceArea();
+                if (gain > bestGain)
+                {
+                    bestGain = gain;
+                    bestSide = side;
+                    bestGrandChild = g;
+                }
+            }
+        }
+
+        if (bestSide < 0)
+        {
+            return;
+        }
+
+        const int child = m_nodes[node].m_children[bestSide];
+        const int other = m_nodes[node].m_children[1 - bestSide];
+        const int grandChild = m_nodes[other].m_children[bestGrandChild];
+        const int kept = m_nodes[other].m_children[1 - bestGrandChild];
+
+        m_nodes[node].m_children[bestSide] = grandChild;
+        m_nodes[grandChild].m_parent = node;
+        m_nodes[other].m_children[bestGrandChild] = child;
+        m_nodes[child].m_parent = other;
+        m_nodes[other].m_bound = merged(m_nodes[child].m_bound, m_nodes[kept].m_bound);
+    }
+
+
+    /**
+     * \internal
+     */
+    int SceneBvh::getHeight(int node) const
+    {
+        const Node& n = m_nodes[node];
+        return n.isLeaf() ? 1 : 1 + std::max(getHeight(n.m_children[0]), getHeight(n.m_children[1]));
+    }
+
+}
@@ -0,0 +1,114 @@
+#ifndef GLDEMO_SCENEBVH_H
+#define GLDEMO_SCENEBVH_H
+
+#include <vector>
+
+#include "boundingbox.h"
+#include "ray.h"
+
+namespace GLDemo
+{
+    class MeshInstance;
+    class SceneNode;
+
+    /**
+     * \brief What a ray traced through a scene hit first.
+     */
+    class PickResult
+    {
+    public:
+        PickResult() :
+            m_instance(0),
+            m_triangle(-1),
+            m_point(),
+            m_distance(0.0f)
+        {
+        }
+
+        const MeshInstance* m_instance;
+        int                 m_triangle;     // As numbered by the mesh's MeshBvh
+        Vector3f            m_point;        // In world space
+        float               m_distance;     // In multiples of the ray's direction
+    };
+
+
+    /**
+     * \brief A bounding volume hierarchy over the world bounds of the mesh instances of a
+     *        scene, for picking, that is kept up to date as instances move.
+     *
+     * The tree is a binary one with an instance at each leaf. Instances can be inserted
+     * and removed one at a time, each choosing where in the tree it would add the least
+     * surface area. An instance in the tree marks itself as moved whenever its world bound
+     * is updated, by updateGeometricState(), and refit() then grows or shrinks only the
+     * ancestors of moved instances, rotating subtrees along the way where that makes them
+     * tighter. Since the tree still drifts from the best shape as things move, optimize()
+     * takes a few instances out and puts them back where they now fit best, and is meant
+     * to be called a little at a time, every frame or so.
+     *
+     * Rays that reach an instance are moved into the space of its mesh and traced against
+     * the mesh's own triangle hierarchy, which is shared by every instance of the mesh.
+     */
+    class SceneBvh
+    {
+    public:
+        SceneBvh();
+        ~SceneBvh();
+
+        void build(SceneNode& root);
+        void clear();
+
+        void insert(const MeshInstance& instance);
+        void remove(const MeshInstance& instance);
+        void markMoved(const MeshInstance& instance);
+
+        void refit();
+        void optimize(int count);
+
+        int   getNumInstances() const { return m_numLeaves; }
+        int   getHeight() const;
+        float getCost() const;
+
+        bool pick(const Ray& ray, PickResult& result) const;
+
+    private:
+        /**
+         * \internal A node of the tree. Leaves hold an instance; other nodes have exactly
+         *           two children. Unused nodes have neither, and wait to be reused.
+         */
+        class Node
+        {
+        public:
+            Node();
+
+            bool isLeaf() const { return m_instance != 0; }
+
+            BoundingBox         m_bound;
+            int                 m_parent;
+            int                 m_children[2];
+            const MeshInstance* m_instance;
+            bool                m_moved;
+        };
+
+        // Not copyable, since instances refer back to the tree they are in.
+        SceneBvh(const SceneBvh&);
+        SceneBvh& operator=(const SceneBvh&);
+
+        int  allocateNode();
+        void freeNode(int node);
+        void insertLeaf(int leaf);
+        void removeLeaf(int leaf);
+        void refitFrom(int node, bool stopWhenUnchanged);
+        void rotate(int node);
+        int  getHeight(int node) const;
+
+        std::vector<Node> m_nodes;
+        std::vector<int>  m_freeNodes;
+        std::vector<int>  m_movedLeaves;
+        int               m_root;
+        int               m_numLeaves;
+        int               m_optimizeCursor;   // Where optimize() carries on from
+    };
+
+}
+
+#endif
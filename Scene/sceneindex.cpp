@@ -0,0 +1,117 @@
+#include "sceneindex.h"
+#include "spatialentity.h"
+
+namespace GLDemo
+{
+
+    SceneIndex::SceneIndex() :
+        m_names(),
+        m_paths(),
+        m_sortedPaths(),
+        m_generation(0)
+    {
+    }
+
+
+    /**
+     * \param entity  The entity to add. Its parent must be set, and must already be in
+     *                the scene, so that its path can be found.
+     */
+    void SceneIndex::insert(SpatialEntity& entity)
+    {
+        if (!entity.getParent())
+        {
+            return;
+        }
+
+        const QString path = getPath(entity);
+        m_names.insert(entity.getName(), &entity);
+        m_paths.insert(path, &entity);
+        m_sortedPaths.insert(path, &entity);
+        ++m_generation;
+    }
+
+
+    /**
+     * \param entity  The entity to remove, which must still have the parent it was
+     *                inserted with.
+     */
+    void SceneIndex::remove(SpatialEntity& entity)
+    {
+        if (!entity.getParent())
+        {
+            return;
+        }
+
+        const QString path = getPath(entity);
+        m_names.remove(entity.getName(), &entity);
+        m_paths.remove(path, &entity);
+        m_sortedPaths.remove(path, &entity);
+        ++m_generation;
+    }
+
+
+    /**
+     * \return An entity with the name, or null if there is none. If several have the name,
+     *         which one is returned is unspecified.
+     */
+    SpatialEntity* SceneIndex::findByName(const Name& name) const
+    {
+        return m_names.value(name, 0);
+    }
+
+
+    /**
+     * \return An entity with the path, or null if there is none.
+     */
+    SpatialEntity* SceneIndex::findByPath(const QString& path) const
+    {
+        return m_paths.value(path, 0);
+    }
+
+
+    /**
+     * \param name      The name to look for.
+     * \param entities  Every entity with the name is appended to this.
+     */
+    void SceneIndex::findAllByName(const Name& name, EntityList& entities) const
+    {
+        QMultiHash<Name, SpatialEntity*>::const_iterator iter = m_names.constFind(name);
+        for (; iter != m_names.constEnd() && iter.key() == name; ++iter)
+        {
+            entities.push_back(iter.value());
+        }
+    }
+
+
+    /**
+     * \param prefix    The start of the paths to look for. This is matched as a string, so
+     *                  "Floor 1" also matches "Floor 10"; "Floor 1/" matches only what is
+     *                  below "Floor 1".
+     * \param entities  Every entity whose path starts with the prefix is appended to this,
+     *                  in order of path.
+     */
+    void SceneIndex::findByPathPrefix(const QString& prefix, EntityList& entities) const
+    {
+        QMultiMap<QString, SpatialEntity*>::const_iterator iter = m_sortedPaths.lowerBound(prefix);
+        for (; iter != m_sortedPaths.constEnd() && iter.key().startsWith(prefix); ++iter)
+        {
+            entities.push_back(iter.value());
+        }
+    }
+
+
+    /**
+     * \return The path of the entity below the root of its tree.
+     */
+    QString SceneIndex::getPath(const SpatialEntity& entity)
+    {
+        QString path = entity.instanceName();
+        for (const SpatialEntity* parent = entity.getParent(); parent && parent->getParent(); parent = parent->getParent())
+        {
+            path = parent->instanceName() + "/" + path;
+        }
+        return path;
+    }
+
+}
@@ -0,0 +1,62 @@
+#ifndef GLDEMO_SCENEINDEX_H
+#define GLDEMO_SCENEINDEX_H
+
+#include <vector>
+
+#include <QHash>
+#include <QMap>
+#include <QString>
+
+#include "name.h"
+
+namespace GLDemo
+{
+    class SpatialEntity;
+
+    /**
+     * \brief Finds the entities of a scene by name, or by path, without searching the tree.
+     *
+     * The path of an entity is the names of it and its ancestors, from the one just below
+     * the root node of the scene, separated by '/'; for example "Building/Floor 2/Lamp".
+     * The root node itself has no path and isn't indexed.
+     *
+     * A Scene keeps its index up to date as entities are added to and detached from its
+     * nodes, with everything below them. Names needn't be unique, so there may be more
+     * than one entity with a name or path. An entity must not be renamed while it is in a
+     * scene; detach it first, and add it back afterwards.
+     */
+    class SceneIndex
+    {
+    public:
+        typedef std::vector<SpatialEntity*> EntityList;
+
+        SceneIndex();
+
+        void insert(SpatialEntity& entity);
+        void remove(SpatialEntity& entity);
+
+        SpatialEntity* findByName(const Name& name) const;
+        SpatialEntity* findByPath(const QString& path) const;
+        void findAllByName(const Name& name, EntityList& entities) const;
+        void findByPathPrefix(const QString& prefix, EntityList& entities) const;
+
+        int getNumEntities() const { return m_names.size(); }
+
+        /**
+         * \return A number that changes whenever an entity enters or leaves the scene, and
+         *         so whenever the shape of its tree changes.
+         */
+        int getGeneration() const { return m_generation; }
+
+        static QString getPath(const SpatialEntity& entity);
+
+    private:
+        QMultiHash<Name, SpatialEntity*>    m_names;
+        QMultiHash<QString, SpatialEntity*> m_paths;
+        QMultiMap<QString, SpatialEntity*>  m_sortedPaths;  // For prefix queries
+        int                                 m_generation;
+    };
+
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "scenenode.h"
 #include "helpers.h"
+#include "worldstate.h"
 
 namespace GLDemo
 {
@@ -40,12 +41,14 @@ namespace GLDemo
     /**
      * \param child  The entity to add as a child of this scene node.
      * \note The SceneNode will take ownership of the child, as a SceneNode can
-     * have only a single parent.
+     * have only a single parent. If this node is in a scene, the child and everything
+     * below it are added to the scene's index.
      */
     void SceneNode::addChild(SpatialEntity& child)
     {
         child.setParent(this);
         m_children.push_back(&child);
+        child.setScene(getScene());
     }
 
 
@@ -65,6 +68,8 @@ namespace GLDemo
      */
     SpatialEntity& SceneNode::detachChild(SpatialEntity& entity)
     {
+        entity.setScene(0);
+        entity.setParent(0);
         m_children.erase(std::remove(m_children.begin(), m_children.end(), &entity));
         return entity;
     }
@@ -79,6 +84,8 @@ namespace GLDemo
     {
         std::vector<SpatialEntity*>::iterator childIter = (m_children.begin() + index);
         SpatialEntity* child = *childIter;
+        child->setScene(0);
+        child->setParent(0);
         m_children.erase(childIter);
         return *child;
     }
@@ -124,4 +131,53 @@ namespace GLDemo
         }
     }
 
+
+    /**
+     * Simulates the node itself first, then each of its children, as updateWorldData()
+     * does.
+     */
+    void SceneNode::simulateWorldData(double time, const Transformation* parentWorld, WorldState& state)
+    {
+        SpatialEntity::simulateWorldData(time, parentWorld, state);
+
+        // Copied, as the state grows with the children.
+        const Transformation world(state.m_worlds.back());
+        for (std::vector<SpatialEntity*>::iterator i = m_children.begin(); i < m_children.end(); ++i)
+        {
+            (*i)->simulateWorldData(time, &world, state);
+        }
+    }
+
+
+    /**
+     * Moves the children of the node along with it, so that a whole subtree enters or
+     * leaves a scene's index at once.
+     */
+    void SceneNode::setScene(Scene* scene)
+    {
+        if (scene == getScene())
+        {
+            return;
+        }
+
+        SpatialEntity::setScene(scene);
+        for (std::vector<SpatialEntity*>::iterator i = m_children.begin(); i < m_children.end(); ++i)
+        {
+            (*i)->setScene(scene);
+        }
+    }
+
+
+    /**
+     * The bound of a node is the union of the bounds of its children.
+     */
+    void SceneNode::updateWorldBound()
+    {
+        m_worldBound.setEmpty();
+        for (std::vector<SpatialEntity*>::const_iterator i = m_children.begin(); i < m_children.end(); ++i)
+        {
+            m_worldBound.extend((*i)->getWorldBound());
+        }
+    }
+
 }
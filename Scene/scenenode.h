@@ -1,6 +1,7 @@
 #ifndef GLDEMO_SCENENODE_H
 #define GLDEMO_SCENENODE_H
 
+#include "nodepool.h"
 #include "spatialentity.h"
 
 #include <vector>
@@ -24,6 +25,10 @@ namespace GLDemo
         SceneNode(const QString& name);
         ~SceneNode();
 
+        // Allocated from a pool of their own; see NodePool.
+        static void* operator new(std::size_t size)             { return NodePool<SceneNode>::allocate(size); }
+        static void  operator delete(void* p, std::size_t size) { NodePool<SceneNode>::deallocate(p, size); }
+
         void addChild(SpatialEntity& child);
 
         SpatialEntity& getChild(int index);
@@ -36,6 +41,9 @@ namespace GLDemo
 
     protected:
         virtual void updateWorldData(double time);
+        virtual void updateWorldBound();
+        virtual void simulateWorldData(double time, const Transformation* parentWorld, WorldState& state);
+        virtual void setScene(Scene* scene);
 
     private:
         std::vector<SpatialEntity*> m_children;
@@ -1,16 +1,32 @@
+#include "scene.h"
 #include "spatialentity.h"
+#include "worldstate.h"
 
 namespace GLDemo
 {
+    namespace
+    {
+        /**
+         * \internal Interned once, rather than for every entity created without a name.
+         */
+        const Name& unnamed()
+        {
+            static const Name s_unnamed("Unnamed SpatialEntity");
+            return s_unnamed;
+        }
+    }
+
 
     /**
      * Creates a new spatial entity with the default name.
      */
     SpatialEntity::SpatialEntity() :
-        Object("Unnamed SpatialEntity"),
+        Object(unnamed()),
         m_parent(0),
+        m_scene(0),
         m_tLocal(),
-        m_tWorld()
+        m_tWorld(),
+        m_worldBound()
     {
     }
 
@@ -18,11 +34,13 @@ namespace GLDemo
     /**
      * \param Name  The unique name for this spatial entity.
      */
-    SpatialEntity::SpatialEntity(const QString& name) :
+    SpatialEntity::SpatialEntity(const Name& name) :
         Object(name),
         m_parent(0),
+        m_scene(0),
         m_tLocal(),
-        m_tWorld()
+        m_tWorld(),
+        m_worldBound()
     {
     }
 
@@ -31,10 +49,12 @@ namespace GLDemo
      *
      */
     SpatialEntity::SpatialEntity(const SpatialEntity& entity) :
-        Object(entity.instanceName()),
+        Object(entity.getName()),
         m_parent(entity.m_parent),
+        m_scene(0),
         m_tLocal(entity.m_tLocal),
-        m_tWorld(entity.m_tWorld)
+        m_tWorld(entity.m_tWorld),
+        m_worldBound(entity.m_worldBound)
     {
     }
 
@@ -44,6 +64,10 @@ namespace GLDemo
      */
     SpatialEntity::~SpatialEntity()
     {
+        if (m_scene)
+        {
+            m_scene->getIndex().remove(*this);
+        }
     }
 
 
@@ -57,15 +81,32 @@ namespace GLDemo
     void SpatialEntity::updateGeometricState(double time, bool initiatedUpdate)
     {
         updateWorldData(time);
-        // TODO: UpdateWorldBound();
+        updateWorldBound();
 
         if (initiatedUpdate)
         {
-            // TODO: PropagateBoundToRoot();
+            propagateBoundToRoot();
         }
     }
 
 
+    /**
+     * \param time   The time of the tick.
+     * \param state  Set to the world transformation of this entity and everything below it.
+     *
+     * The counterpart of updateGeometricState() for the ticks of a FrameLoop. Controllers
+     * are run and world transformations worked out the same way, but the transformations
+     * go into \a state, and the world data of the entities is left alone. Meant to be
+     * called on the root node of a scene.
+     */
+    void SpatialEntity::simulate(double time, WorldState& state)
+    {
+        state.m_entities.clear();
+        state.m_worlds.clear();
+        simulateWorldData(time, 0, state);
+    }
+
+
     /**
      * \param renderer  The renderer to use to draw this entity.
      *
@@ -102,4 +143,71 @@ namespace GLDemo
         }
     }
 
+
+    /**
+     * \param parentWorld  The world transformation of the parent in \a state, or null
+     *                     for the entity simulation started from.
+     *
+     * Runs the controllers of this entity, then appends it and its world transformation
+     * to \a state. Subclasses with children carry on with them.
+     */
+    void SpatialEntity::simulateWorldData(double time, const Transformation* parentWorld, WorldState& state)
+    {
+        updateControllers(time);
+
+        state.m_entities.push_back(this);
+        state.m_worlds.push_back(m_tLocal);
+        if (parentWorld)
+        {
+            state.m_worlds.back().combine(*parentWorld, m_tLocal);
+        }
+    }
+
+
+    /**
+     * \internal Moves the entity into a scene, or out of one when \a scene is null,
+     *           keeping the index of each scene up to date. Only the SceneNode subclass
+     *           should ever need to invoke this, once the entity's parent is set.
+     */
+    void SpatialEntity::setScene(Scene* scene)
+    {
+        if (scene == m_scene)
+        {
+            return;
+        }
+
+        if (m_scene)
+        {
+            m_scene->getIndex().remove(*this);
+        }
+        m_scene = scene;
+        if (m_scene)
+        {
+            m_scene->getIndex().insert(*this);
+        }
+    }
+
+
+    /**
+     * Recomputes the world bound of this entity from its world data. Entities with no
+     * geometry of their own have an empty bound; subclasses that have geometry, or
+     * children, override this.
+     */
+    void SpatialEntity::updateWorldBound()
+    {
+        m_worldBound.setEmpty();
+    }
+
+
+    /**
+     * Updates the bounds of every ancestor of this entity, after its own has changed.
+     */
+    void SpatialEntity::propagateBoundToRoot()
+    {
+        for (SpatialEntity* parent = m_parent; parent; parent = parent->m_parent)
+        {
+            parent->updateWorldBound();
+        }
+    }
+
 }
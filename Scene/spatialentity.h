@@ -3,13 +3,17 @@
 
 #include <QSharedPointer>
 
+#include "boundingbox.h"
 #include "transformation.h"
 #include "object.h"
 
 namespace GLDemo
 {
+    class FrameLoop;
     class Renderer;
+    class Scene;
     class SceneNode;
+    class WorldState;
 
 
     /**
@@ -29,34 +33,50 @@ namespace GLDemo
         const Transformation& getLocalTransformation() const { return m_tLocal; }
         Transformation&       getLocalTransformation()       { return m_tLocal; }
 
+        /**
+         * \return The world-space box enclosing the entity and everything below it, as of
+         *         the last geometric update. Empty for entities with no geometry.
+         */
+        const BoundingBox& getWorldBound() const { return m_worldBound; }
+
         SpatialEntity* getParent() const { return m_parent; }
+        Scene*         getScene() const  { return m_scene; }
 
         void updateGeometricState(double time, bool initiatedUpdate);
+        void simulate(double time, WorldState& state);
 
         virtual bool draw(Renderer* renderer);
         virtual SpatialEntity* clone() const = 0;
 
     protected:
         SpatialEntity();
-        SpatialEntity(const QString& name);
+        SpatialEntity(const Name& name);
         SpatialEntity(const SpatialEntity&);
 
         virtual void updateWorldData(double time);
+        virtual void updateWorldBound();
+        virtual void simulateWorldData(double time, const Transformation* parentWorld, WorldState& state);
+        void propagateBoundToRoot();
 
         /**
          * \internal Only the SceneNode subclass should ever need to invoke this.
          */
         void setParent(SpatialEntity* p) { m_parent = p; }
+        virtual void setScene(Scene* scene);
 
     private:
         SpatialEntity* m_parent;
+        Scene*         m_scene;
         Transformation m_tLocal;
         Transformation m_tWorld;
 
-        // TODO: Add bounding entities here, once created
-        //Bound m_bLocal;
-        //Bound m_bWorld;
+    protected:
+        BoundingBox    m_worldBound;
+
+    private:
 
+        friend class FrameLoop;
+        friend class Scene;
         friend class SceneNode;
     };
 
@@ -1,6 +1,7 @@
 #include <iostream>
 
 #include "Math/matrix4.h"
+#include "Math/vector3soa.h"
 #include "transformation.h"
 
 namespace GLDemo
@@ -11,7 +12,11 @@ namespace GLDemo
      * a 4x4 affine transformation matrix set to the identity.
      */
     Transformation::Transformation() :
+#ifdef GLDEMO_QUATERNION_ROTATION
+        m_rotation(),
+#else
         m_rotation(Matrix3f::createIdentity()),
+#endif
         m_scale(1.0f, 1.0f, 1.0f),
         m_translation(),
         m_isIdentity(true),
@@ -26,7 +31,7 @@ namespace GLDemo
     Transformation::Transformation(const Transformation& trans) :
         m_rotation(trans.m_rotation),
         m_scale(trans.m_scale),
-        m_translation(trans.m_scale),
+        m_translation(trans.m_translation),
         m_isIdentity(trans.m_isIdentity),
         m_isUniformScale(trans.m_isUniformScale)
     {
@@ -41,6 +46,83 @@ namespace GLDemo
     }
 
 
+#ifdef GLDEMO_QUATERNION_ROTATION
+    /**
+     * \return The rotation, converted to a matrix.
+     */
+    Matrix3f Transformation::getRotation() const
+    {
+        Matrix3f m;
+        m_rotation.toRotationMatrix(m);
+        return m;
+    }
+
+
+    /**
+     * \internal
+     */
+    inline Vector3f Transformation::rotate(const Vector3f& v) const
+    {
+        return m_rotation.rotate(v);
+    }
+
+
+    /**
+     * \internal
+     */
+    inline Vector3f Transformation::rotateInverse(const Vector3f& v) const
+    {
+        return m_rotation.conjugate().rotate(v);
+    }
+#else
+    /**
+     * \param q  The rotation, which is converted to a matrix.
+     */
+    void Transformation::setRotation(const Quaternionf& q)
+    {
+        q.toRotationMatrix(m_rotation);
+        m_isIdentity = false;
+    }
+
+
+    /**
+     * \internal
+     */
+    inline Vector3f Transformation::rotate(const Vector3f& v) const
+    {
+        return m_rotation * v;
+    }
+
+
+    /**
+     * \internal
+     */
+    inline Vector3f Transformation::rotateInverse(const Vector3f& v) const
+    {
+        return m_rotation.transpose() * v;
+    }
+#endif
+
+
+    /**
+     * \internal Rotates a translation, keeping the precision translations are kept in.
+     */
+    inline WorldVector3 Transformation::rotateTranslation(const WorldVector3& v) const
+    {
+#ifdef GLDEMO_DOUBLE_PRECISION_WORLD
+        const Matrix3f r = getRotation();
+        WorldVector3 out;
+        for (int row = 0; row < 3; ++row)
+        {
+            out[row] = r(row,0) * v.x() + r(row,1) * v.y() + r(row,2) * v.z();
+        }
+        return out;
+#else
+        return rotate(v);
+#endif
+    }
+
+
     /**
      * \param v The vector to pre-multiply with this transformation.
      *
@@ -61,9 +143,8 @@ namespace GLDemo
         outV.x() *= m_scale.x();
         outV.y() *= m_scale.y();
         outV.z() *= m_scale.z();
-        outV = m_rotation * outV;
-        outV += m_translation;
-        return outV;
+        outV = rotate(outV);
+        return Vector3f(WorldVector3(outV) + m_translation);
     }
 
 
@@ -84,15 +165,18 @@ namespace GLDemo
         }
 
         // Easy calculation if uniform scale - no inverse required
+        // The offset from the translation is small near the transformation, even when
+        // both are far from the origin, so find it before dropping any precision.
+        const Vector3f offset(WorldVector3(v) - m_translation);
         if (m_isUniformScale)
         {
-            return (m_rotation.transpose() * (v - m_translation)) / m_scale.x();
+            return rotateInverse(offset) / m_scale.x();
         }
 
         // More complex calculation for non-uniform scale - instead of calculating normal inverse, use knowledge
         // of the fact that m_scale is a diagonal matrix to compute inverse more efficiently (more multiplications
         // than divisions)
-        Vector3f outV = (m_rotation.transpose() * (v - m_translation));
+        Vector3f outV = rotateInverse(offset);
         float sXY = m_scale.x() * m_scale.y();
         float sYZ = m_scale.y() * m_scale.z();
         float sXZ = m_scale.x() * m_scale.z();
@@ -104,12 +188,39 @@ namespace GLDemo
     }
 
 
+    /**
+     * \param points  The points to apply this transformation to.
+     * \param out     Set to the transformed points. May be \a points itself.
+     *
+     * Batch version of apply(), for transforming many points at once.
+     */
+    void Transformation::apply(const Vector3SoA& points, Vector3SoA& out) const
+    {
+        if (m_isIdentity)
+        {
+            if (&out != &points)
+            {
+                out = points;
+            }
+            return;
+        }
+
+        Matrix4f m;
+        toMatrix(m);
+        points.transformPoints(m, out);
+    }
+
+
     /**
      * \param m1 The first transformation to combine.
      * \param m2 The second transformation.
      *
      * Combines transformation by as though multiplying 2 4x4 homogenous matrices.
-     * Order of operations is essentially (tOut = tr1 + r1 * s2 * tr2)
+     * Order of operations is essentially (tOut = tr1 + r1 * s1 * tr2)
+     *
+     * The result is exact unless \a m1 scales each axis differently and \a m2 rotates.
+     * The product then shears, which a transformation can't represent, so the scales
+     * are simply multiplied along each axis, as though \a m2 didn't rotate.
      */
     void Transformation::combine(const Transformation& m1, const Transformation& m2)
     {
@@ -131,28 +242,45 @@ namespace GLDemo
             return;
         }
 
-        // Assuming uniform scale, so r = r1 * r2 and s = s1 * s2
+        // r = r1 * r2 and s = s1 * s2. Exact when s1 is uniform, as it then commutes
+        // with r2; otherwise the shear of r1 * s1 * r2 * s2 is dropped.
         m_scale.x() = m1.m_scale.x() * m2.m_scale.x();
         m_scale.y() = m1.m_scale.y() * m2.m_scale.y();
         m_scale.z() = m1.m_scale.z() * m2.m_scale.z();
 
         m_rotation = m1.m_rotation * m2.m_rotation;
 
-        // t = t1 + r1s2t2
-        m_translation = m1.m_translation;
-        Vector3f temp = m2.m_translation;
+        // t = t1 + r1s1t2
+        WorldVector3 temp = m2.m_translation;
         temp.x() *= m1.m_scale.x();
         temp.y() *= m1.m_scale.y();
         temp.z() *= m1.m_scale.z();
-        temp = m1.m_rotation * temp;
-        m_translation += temp;
+        m_translation = m1.m_translation + m1.rotateTranslation(temp);
 
         m_isIdentity = false;
-        m_isUniformScale = m1.m_isUniformScale | m2.m_isUniformScale;
+        m_isUniformScale = m1.m_isUniformScale && m2.m_isUniformScale;
     }
 
 
+    /**
+     *
+     */
     void Transformation::toMatrix(Matrix4f& m) const
+    {
+        toMatrix(m, WorldVector3());
+    }
+
+
+    /**
+     * \param m       Set to the transformation as a 4x4 homogeneous matrix.
+     * \param origin  The point the matrix translates relative to, such as the position of
+     *                the camera.
+     *
+     * The translation is taken relative to \a origin before it is narrowed to single
+     * precision, so the matrix is precise near the origin however far it is from the
+     * world's.
+     */
+    void Transformation::toMatrix(Matrix4f& m, const WorldVector3& origin) const
     {
         Matrix3f s;
         s(0,0) = m_scale[0];
@@ -160,7 +288,7 @@ namespace GLDemo
         s(2,2) = m_scale[2];
 
         // TODO: Move the below into a function for Matrix4
-        Matrix3f rs = m_rotation * s;
+        Matrix3f rs = getRotation() * s;
         for (int i = 0; i < 3; ++i)
         {
             for (int j = 0; j < 3; ++j)
@@ -169,30 +297,33 @@ namespace GLDemo
             }
         }
 
-        m(0,3) = m_translation[0];
-        m(1,3) = m_translation[1];
-        m(2,3) = m_translation[2];
+        const Vector3f translation(m_translation - origin);
+        m(0,3) = translation[0];
+        m(1,3) = translation[1];
+        m(2,3) = translation[2];
 
         m(3,3) = 1.0f;
     }
 
 
     /**
-     * Loads the transformation from the provided 4x4 homogeneous matrix
+     * Loads the transformation from the provided 4x4 homogeneous matrix. The scale may
+     * differ along each axis. Transformations can't represent shear, so any shear in the
+     * matrix is dropped; see Matrix4::affineDecomposition().
+     *
+     * \return False if the matrix was sheared, and so is only approximated.
      */
-    void Transformation::fromMatrix(const Matrix4f& m)
+    bool Transformation::fromMatrix(const Matrix4f& m)
     {
-        Matrix3f scaleMat;
-        Matrix3f rotMat;
-        Vector3f vTranslate;
-
-        // We make the assumption of uniform scale. Very difficult to decompose otherwise.
-        m.polarDecomposition(scaleMat, m_rotation, m_translation);
-        m_scale.x() = scaleMat(0,0);
-        m_scale.y() = scaleMat(1,1);
-        m_scale.z() = scaleMat(2,2);
-        m_isUniformScale = true;
+        Matrix3f rotation;
+        Vector3f shear;
+        Vector3f translation;
+        bool exact = m.affineDecomposition(m_scale, rotation, shear, translation);
+        setRotation(rotation);
+        m_translation = WorldVector3(translation);
+        m_isUniformScale = Math<float>::FEqual(m_scale.x(), m_scale.y()) && Math<float>::FEqual(m_scale.x(), m_scale.z());
         m_isIdentity = false;
+        return exact;
     }
 }
 
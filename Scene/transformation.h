@@ -3,15 +3,36 @@
 
 #include "Math/vector3.h"
 #include "Math/matrix3.h"
+#include "Math/quaternion.h"
 
 namespace GLDemo
 {
 
     template<class Real>
     class Matrix4;
+    class Vector3SoA;
 
     /**
+     * The type translations are kept in. Built with GLDEMO_DOUBLE_PRECISION_WORLD, this is
+     * double precision, so that scenes spanning many kilometres place objects far from the
+     * origin as precisely as those near it.
+     */
+#ifdef GLDEMO_DOUBLE_PRECISION_WORLD
+    typedef Vector3d WorldVector3;
+#else
+    typedef Vector3f WorldVector3;
+#endif
+
+    /**
+     * \brief A scale, followed by a rotation, then a translation.
+     *
+     * The rotation is kept as a Matrix3f, unless built with GLDEMO_QUATERNION_ROTATION,
+     * in which case it is kept as a Quaternionf. That makes each transformation about a
+     * third smaller and cheaper to combine, at the cost of converting when the rotation
+     * is asked for as a matrix.
      *
+     * The translation is a WorldVector3, and is combined at that precision. Rotation and
+     * scale are always single precision.
      */
     class Transformation
     {
@@ -21,13 +42,29 @@ namespace GLDemo
         ~Transformation();
 
         // Access and mutation functions
+#ifdef GLDEMO_QUATERNION_ROTATION
+        void setRotation(const Matrix3f& m)     { m_rotation.fromRotationMatrix(m); m_isIdentity = false; }
+        void setRotation(const Quaternionf& q)  { m_rotation = q; m_isIdentity = false; }
+        Matrix3f getRotation() const;
+        const Quaternionf& getRotationQuaternion() const { return m_rotation; }
+#else
         void setRotation(const Matrix3f& m)  { m_rotation = m; m_isIdentity = false; }
+        void setRotation(const Quaternionf& q);
         const Matrix3f& getRotation() const  { return m_rotation; }
         Matrix3f& getRotation()              { m_isIdentity = false; return m_rotation;  }
+        Quaternionf getRotationQuaternion() const { return Quaternionf(m_rotation); }
+#endif
 
+#ifdef GLDEMO_DOUBLE_PRECISION_WORLD
+        void setTranslation(const Vector3f& t) { m_translation = WorldVector3(t); m_isIdentity = false; }
+        void setTranslation(const Vector3d& t) { m_translation = t; m_isIdentity = false; }
+        Vector3f getTranslation() const        { return Vector3f(m_translation); }
+#else
         void setTranslation(const Vector3f& t) { m_translation = t; m_isIdentity = false; }
         const Vector3f& getTranslation() const { return m_translation; }
         Vector3f& getTranslation()             { m_isIdentity = false; return m_translation; }
+#endif
+        const WorldVector3& getPreciseTranslation() const { return m_translation; }
 
         void setScale(const Vector3f& s)  { m_scale = s; m_isUniformScale = false; m_isIdentity = false; }
         const Vector3f& getScale() const  { return m_scale; }
@@ -39,17 +76,27 @@ namespace GLDemo
         bool isIdentity() const { return m_isIdentity; }
 
         void toMatrix(Matrix4<float>& m) const;
-        void fromMatrix(const Matrix4<float>& m);
+        void toMatrix(Matrix4<float>& m, const WorldVector3& origin) const;
+        bool fromMatrix(const Matrix4<float>& m);
 
         // Application functions
         Vector3f apply(const Vector3f& v) const;
         Vector3f applyInverse(const Vector3f& v) const;
+        void     apply(const Vector3SoA& points, Vector3SoA& out) const;
         void combine(const Transformation& m1, const Transformation& m2);
 
     private:
+        Vector3f rotate(const Vector3f& v) const;
+        Vector3f rotateInverse(const Vector3f& v) const;
+        WorldVector3 rotateTranslation(const WorldVector3& v) const;
+
+#ifdef GLDEMO_QUATERNION_ROTATION
+        Quaternionf m_rotation;
+#else
         Matrix3f m_rotation;
+#endif
         Vector3f m_scale;
-        Vector3f m_translation;
+        WorldVector3 m_translation;
 
         bool m_isIdentity;
         bool m_isUniformScale;
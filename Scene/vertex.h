@@ -1,6 +1,8 @@
 #ifndef GLDEMO_VERTEX_H
 #define GLDEMO_VERTEX_H
 
+#include <type_traits>
+
 #include "Math/vector3.h"
 #include "Math/vector2.h"
 
@@ -55,6 +57,9 @@ namespace GLDemo
         Vector2f m_texcoords;
     };
 
+    // Vertex arrays are copied and reallocated as raw memory, and uploaded to the GPU as is.
+    static_assert(std::is_trivially_copyable<Vertex>::value, "Vertex must be trivially copyable");
+
 }
 
 #endif //VERTEX_H
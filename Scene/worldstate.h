@@ -0,0 +1,41 @@
+#ifndef GLDEMO_WORLDSTATE_H
+#define GLDEMO_WORLDSTATE_H
+
+#include <vector>
+
+#include <QtGlobal>
+
+#include "transformation.h"
+
+namespace GLDemo
+{
+    class SpatialEntity;
+
+    /**
+     * \brief The world transformation of every entity of a scene at one tick of a
+     *        FrameLoop.
+     *
+     * Filled in by SpatialEntity::simulate(), which leaves the world data of the entities
+     * themselves alone, so that they can be drawn on another thread meanwhile. Entities
+     * come depth first, each before everything below it.
+     */
+    class WorldState
+    {
+    public:
+        WorldState() :
+            m_tick(-1),
+            m_generation(-1),
+            m_entities(),
+            m_worlds()
+        {
+        }
+
+        qint64                      m_tick;         // -1 if the state holds nothing
+        int                         m_generation;   // Of the scene's index; see SceneIndex::getGeneration()
+        std::vector<SpatialEntity*> m_entities;
+        std::vector<Transformation> m_worlds;       // One for each entity
+    };
+
+}
+
+#endif
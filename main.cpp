@@ -1,4 +1,5 @@
 #include <iostream>
+#include <vector>
 
 #include <QApplication>
 #include <QTimer>
@@ -7,9 +8,12 @@
 #include "Scene/scene.h"
 #include "Scene/camera.h"
 #include "Scene/cubemesh.h"
+#include "Scene/frameloop.h"
 #include "Scene/meshinstance.h"
 #include "Renderer/glwidget.h"
 #include "Renderer/lambertshader.h"
+#include "Renderer/material.h"
+#include "Renderer/shaderreloader.h"
 
 using namespace GLDemo;
 
@@ -17,6 +21,32 @@ int main(int argc, char* argv[])
 {
     QApplication app(argc, argv);
 
+    // Shaders can be read from disk rather than the resources, and are then reloaded
+    // whenever they are saved. Point this at the Renderer directory of the source tree.
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (QString(argv[i]) == "--shader-dir")
+        {
+            ShaderReloader::instance().setSourceDirectory(argv[i + 1]);
+        }
+    }
+    // Occlusion culling relies on queries issued per draw, so it only works with direct
+    // submission, which is what the renderer uses unless told otherwise. The software
+    // variant works with either.
+    bool occlusionCulling = false;
+    bool softwareOcclusionCulling = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (QString(argv[i]) == "--occlusion-culling")
+        {
+            occlusionCulling = true;
+        }
+        else if (QString(argv[i]) == "--software-occlusion-culling")
+        {
+            softwareOcclusionCulling = true;
+        }
+    }
+
     // Hard code the creation of our scene for now. Can move this to a file format eventually.
     Scene scene;
     Camera* camera = new Camera();
@@ -25,22 +55,23 @@ int main(int argc, char* argv[])
     camera->setFieldOfView(45.0);
 
     PtrMesh cubeMesh(new CubeMesh("Cube"));
-    PtrShader shader1(new LambertShader());
-    PtrShader shader2(new LambertShader());
-    PtrShader shader3(new LambertShader());
-    static_cast<LambertShader*>(shader2.data())->setColor(QColor(0, 0, 255, 255));
-    static_cast<LambertShader*>(shader3.data())->setColor(QColor(0, 255, 0, 255));
+    PtrShader shader(new LambertShader());
+    PtrMaterial material1(new Material(shader));
+    PtrMaterial material2(new Material(shader));
+    PtrMaterial material3(new Material(shader));
+    material2->setDiffuseColor(QColor(0, 0, 255, 255));
+    material3->setDiffuseColor(QColor(0, 255, 0, 255));
     MeshInstance* meshInstances[12];
     for (int i = 0; i < 6; ++i)
     {
         meshInstances[i] = new MeshInstance(QString("Cube Instance %1").arg(i), cubeMesh);
-        meshInstances[i]->setShader(shader1);
+        meshInstances[i]->setMaterial(material1);
         scene.getRootNode().addChild(*meshInstances[i]);
     }
     for (int i = 6; i < 12; ++i)
     {
         meshInstances[i] = new MeshInstance(QString("Cube Instance %1").arg(i), cubeMesh);
-        meshInstances[i]->setShader(shader2);
+        meshInstances[i]->setMaterial(material2);
         scene.getRootNode().addChild(*meshInstances[i]);
     }
     float distance = 5.0f;
@@ -50,8 +81,14 @@ int main(int argc, char* argv[])
     meshInstances[3]->getLocalTransformation().setTranslation(Vector3f(0,-distance,0));
     meshInstances[4]->getLocalTransformation().setTranslation(Vector3f(0,0,distance));
     meshInstances[5]->getLocalTransformation().setTranslation(Vector3f(0,0,-distance));
-    meshInstances[0]->setShader(shader3);
-    meshInstances[4]->setShader(shader2);
+    meshInstances[0]->setMaterial(material3);
+
+    // The inner cubes hide the outer ones behind them.
+    for (int i = 0; i < 6; ++i)
+    {
+        scene.addOccluder(*meshInstances[i]);
+    }
+    meshInstances[4]->setMaterial(material2);
     distance = 20.0f;
     meshInstances[6]->getLocalTransformation().setTranslation(Vector3f(distance,0,0));
     meshInstances[7]->getLocalTransformation().setTranslation(Vector3f(-distance,0,0));
@@ -60,12 +97,36 @@ int main(int argc, char* argv[])
     meshInstances[10]->getLocalTransformation().setTranslation(Vector3f(0,0,distance));
     meshInstances[11]->getLocalTransformation().setTranslation(Vector3f(0,0,-distance));
 
-    scene.getRootNode().addChild(*camera);
+    // The outer cubes turn on the spot, once every eight seconds.
+    Animator& animator = scene.getAnimator();
+    for (int i = 6; i < 12; ++i)
+    {
+        const Vector3f position(meshInstances[i]->getLocalTransformation().getTranslation());
+        std::vector<Keyframe> keys;
+        for (int key = 0; key <= 4; ++key)
+        {
+            Quaternionf rotation;
+            rotation.fromAxisAngle(key * Math<float>::PI / 2, Vector3f(0, 1, 0));
+            keys.push_back(Keyframe(2.0f * key, position, rotation, Vector3f(1, 1, 1)));
+        }
+        animator.play(*meshInstances[i], animator.addTrack(keys), 0.0, true);
+    }
+    FrameLoop frameLoop(scene);
+
+    // The camera stays out of the scene graph, so that moving it doesn't have to wait for
+    // the ticks of the frame loop.
+    camera->updateGeometricState(0.0, true);
 
     GLWidget* widget = new GLWidget();
     widget->setScene(&scene);
     widget->setCamera(camera);
-    scene.getRootNode().updateGeometricState(0.0, true);
+    widget->registerShader(shader);
+    widget->setOcclusionCulling(occlusionCulling);
+    widget->setSoftwareOcclusionCulling(softwareOcclusionCulling);
+    widget->setFrameLoop(&frameLoop);
+    scene.update(0.0);
     QTimer::singleShot(0, widget, SLOT(show()));
-    return app.exec();
+    const int result = app.exec();
+    delete camera;
+    return result;
 }